@@ -0,0 +1,54 @@
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "core/asset_pack.h"
+#include "core/block_registry.h"
+#include "core/texture.h"
+
+using minecraft::AssetImage;
+using minecraft::AssetPack;
+using minecraft::BlockRegistry;
+using minecraft::BlockTypes;
+using minecraft::Texture;
+using std::string;
+using std::vector;
+
+/// decodes the block texture atlas and the icons in an assets directory into
+/// one pack, see `asset_pack.h`. run by the build before the game
+int main(int argc, char** argv) {
+  if (argc < 3 || (argc == 4 && std::strcmp(argv[3], "--mipmaps") != 0) ||
+      argc > 4) {
+    std::cerr << "usage: minecraft-asset-packer ASSETS_DIR PACK [--mipmaps]\n";
+    return 2;
+  }
+  ci::fs::path directory(argv[1]);
+  string output = argv[2];
+  bool mipmaps = argc == 4;
+
+  try {
+    vector<AssetImage> images;
+    vector<ci::fs::path> strips;
+    for (const char* strip : BlockRegistry::kAtlasFiles) {
+      strips.push_back(directory / strip);
+    }
+    images.push_back(Texture::DecodeAtlas(strips));
+    for (size_t block = 0; block < BlockRegistry::kBlockTypesCount; ++block) {
+      const char* icon_file =
+          BlockRegistry::Get(static_cast<BlockTypes>(block)).icon_file;
+      if (icon_file != nullptr) {
+        images.push_back(
+            Texture::DecodeImage(directory / icon_file, icon_file));
+      }
+    }
+    AssetPack::Write(output, images, mipmaps);
+    std::cout << "packed " << images.size() << " images into " << output
+              << "\n";
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
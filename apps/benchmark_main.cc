@@ -0,0 +1,759 @@
+#include <fcntl.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/asset_pack.h"
+#include "core/block.h"
+#include "core/block_registry.h"
+#include "core/chunk.h"
+#include "core/chunk_io.h"
+#include "core/chunk_prefetcher.h"
+#include "core/entity_physics.h"
+#include "core/entity_scheduler.h"
+#include "core/entity_store.h"
+#include "core/headless_renderer.h"
+#include "core/packed_vertex.h"
+#include "core/pathfinder.h"
+#include "core/spatial_hash.h"
+#include "core/terrain_generator.h"
+#include "core/texture.h"
+#include "core/translucent_sorter.h"
+#include "core/world.h"
+
+using minecraft::AssetImage;
+using minecraft::AssetPack;
+using minecraft::Block;
+using minecraft::BlockRegistry;
+using minecraft::BlockBox;
+using minecraft::BlockEdit;
+using minecraft::BlockTypes;
+using minecraft::Chunk;
+using minecraft::ChunkCoordinates;
+using minecraft::ChunkIo;
+using minecraft::ChunkIoStats;
+using minecraft::ChunkPrefetcher;
+using minecraft::EntityPhysics;
+using minecraft::EntityScheduler;
+using minecraft::EntityStore;
+using minecraft::HeadlessRenderer;
+using minecraft::PackedMesh;
+using minecraft::PathRequest;
+using minecraft::PathResult;
+using minecraft::Pathfinder;
+using minecraft::PerlinTerrain;
+using minecraft::PolymorphicTerrain;
+using minecraft::PackedImage;
+using minecraft::SpatialHash;
+using minecraft::TerrainGenerator;
+using minecraft::Texture;
+using minecraft::ThreadPool;
+using minecraft::TranslucentSorter;
+using minecraft::World;
+using minecraft::WorldSnapshot;
+using std::pair;
+using std::string;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+namespace {
+
+/// a named benchmark; returns false if it found a mismatch
+struct Benchmark {
+  string name;
+  std::function<bool()> run;
+};
+
+/// \param chunks_count chunks generated per measurement
+/// \param width chunk width
+/// \param fill generates one chunk
+/// \return seconds per chunk, best of three
+double TimeChunkFills(
+    int chunks_count, int width,
+    const std::function<void(const glm::ivec3&, BlockTypes*)>& fill) {
+  vector<BlockTypes> voxels(size_t(width * width * width));
+  double best = 0;
+  for (int round = 0; round < 3; ++round) {
+    steady_clock::time_point start = steady_clock::now();
+    for (int chunk = 0; chunk < chunks_count; ++chunk) {
+      fill(glm::ivec3(chunk % 16, chunk / 16 % 4 - 2, chunk / 64) * width,
+           voxels.data());
+    }
+    double seconds =
+        duration<double>(steady_clock::now() - start).count() / chunks_count;
+    best = round == 0 ? seconds : std::min(best, seconds);
+  }
+  return best;
+}
+
+/// generates the same chunks through a virtual call per voxel, and through
+/// the template fill inlined on `PerlinTerrain`
+bool BenchmarkTerrainFill() {
+  const int width = 16;
+  const int chunks_count = 512;
+  TerrainGenerator generator(-3, 2, 10.0f, 7);
+  PerlinTerrain terrain(-3, 2, 10.0f, 7);
+
+  vector<BlockTypes> expected(size_t(width * width * width));
+  vector<BlockTypes> actual(expected.size());
+  for (int chunk = 0; chunk < 64; ++chunk) {
+    glm::ivec3 min_corner = glm::ivec3(chunk, -1, -chunk) * width;
+    minecraft::FillChunk(PolymorphicTerrain(&generator), min_corner, width,
+                         expected.data());
+    minecraft::FillChunk(terrain, min_corner, width, actual.data());
+    if (expected != actual) {
+      std::cerr << "terrain fills disagree at chunk " << chunk << "\n";
+      return false;
+    }
+  }
+
+  double virtual_seconds = TimeChunkFills(
+      chunks_count, width,
+      [&generator](const glm::ivec3& min_corner, BlockTypes* voxels) {
+        minecraft::FillChunk(PolymorphicTerrain(&generator), min_corner,
+                             width, voxels);
+      });
+  double template_seconds = TimeChunkFills(
+      chunks_count, width,
+      [&terrain](const glm::ivec3& min_corner, BlockTypes* voxels) {
+        minecraft::FillChunk(terrain, min_corner, width, voxels);
+      });
+  double voxels_count = double(width * width * width);
+  std::cout << std::fixed << std::setprecision(2)
+            << "  virtual per voxel: " << virtual_seconds * 1e6
+            << " us/chunk, " << virtual_seconds * 1e9 / voxels_count
+            << " ns/voxel\n"
+            << "  template fill:     " << template_seconds * 1e6
+            << " us/chunk, " << template_seconds * 1e9 / voxels_count
+            << " ns/voxel\n"
+            << "  speedup:           " << virtual_seconds / template_seconds
+            << "x\n";
+  return true;
+}
+
+/// compares the geometry of generated chunks as float meshes, the way each
+/// block used to keep its own, with the packed meshes chunks keep now
+bool BenchmarkPackedVertices() {
+  const int width = 16;
+  TerrainGenerator generator(-3, 2, 10.0f, 7);
+  Chunk chunk(glm::ivec3(0), width);
+  size_t float_bytes = 0;
+  size_t packed_bytes = 0;
+  size_t vertices_count = 0;
+  for (int chunk_x = 0; chunk_x < 8; ++chunk_x) {
+    for (int chunk_y = -1; chunk_y <= 0; ++chunk_y) {
+      glm::ivec3 min_corner = glm::ivec3(chunk_x, chunk_y, 0) * width;
+      chunk.MoveTo(min_corner);
+      generator.FillChunk(min_corner, width, chunk.GetVoxels().data());
+      chunk.RebuildBlocks();
+      const PackedMesh& packed = chunk.GetMesh();
+
+      ci::TriMesh mesh(ci::TriMesh::Format().positions().texCoords(2));
+      for (const Block& block : chunk.GetBlocks()) {
+        for (size_t face = 0; face < Block::kCubeFacesCount; ++face) {
+          Block::AppendFace(&mesh, block.GetType(), face, block.GetCenter(),
+                            1.0f);
+        }
+      }
+      if (packed.Unpack().getNumVertices() != mesh.getNumVertices()) {
+        std::cerr << "packed and float meshes disagree\n";
+        return false;
+      }
+      float_bytes += mesh.getNumVertices() * (sizeof(ci::vec3) +
+                                              sizeof(ci::vec2)) +
+                     mesh.getNumIndices() * sizeof(uint32_t);
+      packed_bytes += packed.GetBytes();
+      vertices_count += packed.GetVertices().size();
+    }
+  }
+  std::cout << std::fixed << std::setprecision(2)
+            << "  vertices:      " << vertices_count << "\n"
+            << "  float meshes:  " << double(float_bytes) / 1024 << " KiB\n"
+            << "  packed meshes: " << double(packed_bytes) / 1024 << " KiB\n"
+            << "  reduction:     "
+            << double(float_bytes) / double(packed_bytes) << "x\n";
+  return true;
+}
+
+/// \return the atlas and icons, decoded from the PNGs in `assets/` like the
+/// game does without a pack
+vector<AssetImage> DecodeAssets() {
+  vector<AssetImage> images;
+  vector<ci::fs::path> strips;
+  for (const char* strip : BlockRegistry::kAtlasFiles) {
+    strips.push_back(ci::fs::path("assets") / strip);
+  }
+  images.push_back(Texture::DecodeAtlas(strips));
+  for (const minecraft::BlockProperties& properties :
+       BlockRegistry::kProperties) {
+    if (properties.icon_file != nullptr) {
+      images.push_back(Texture::DecodeImage(
+          ci::fs::path("assets") / properties.icon_file,
+          properties.icon_file));
+    }
+  }
+  return images;
+}
+
+/// loads the textures by decoding the PNGs, and by mapping a pack of them.
+/// run from the repository root, so `assets/` is found
+bool BenchmarkAssetPack() {
+  const string pack_path = "/tmp/minecraft-benchmark.pack";
+  vector<AssetImage> decoded;
+  try {
+    decoded = DecodeAssets();
+    AssetPack::Write(pack_path, decoded, false);
+  } catch (const std::exception& error) {
+    std::cerr << "  could not decode assets/: " << error.what() << "\n";
+    return false;
+  }
+
+  double decode_seconds = 0;
+  double map_seconds = 0;
+  for (int round = 0; round < 3; ++round) {
+    steady_clock::time_point start = steady_clock::now();
+    vector<AssetImage> images = DecodeAssets();
+    double seconds = duration<double>(steady_clock::now() - start).count();
+    decode_seconds = round == 0 ? seconds : std::min(decode_seconds, seconds);
+
+    start = steady_clock::now();
+    AssetPack pack(pack_path);
+    // comparing reads every pixel once, as uploading them would
+    for (const AssetImage& image : images) {
+      const PackedImage* packed = pack.Find(image.name);
+      if (packed == nullptr ||
+          !std::equal(image.pixels.begin(), image.pixels.end(),
+                      packed->pixels)) {
+        std::cerr << "  pack and PNGs disagree on " << image.name << "\n";
+        return false;
+      }
+    }
+    seconds = duration<double>(steady_clock::now() - start).count();
+    map_seconds = round == 0 ? seconds : std::min(map_seconds, seconds);
+  }
+  std::remove(pack_path.c_str());
+  std::cout << std::fixed << std::setprecision(2)
+            << "  decode PNGs:   " << decode_seconds * 1e3 << " ms\n"
+            << "  map pack:      " << map_seconds * 1e3 << " ms\n"
+            << "  speedup:       " << decode_seconds / map_seconds << "x\n";
+  return true;
+}
+
+int RemoveBenchmarkFile(const char* path, const struct stat*, int,
+                        struct FTW*) {
+  return std::remove(path);
+}
+
+/// drops files from the page cache, so reading them goes to the disk
+void EvictFiles(const vector<string>& paths) {
+  for (const string& path : paths) {
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor >= 0) {
+#if defined(POSIX_FADV_DONTNEED)
+      posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+      close(descriptor);
+    }
+  }
+}
+
+bool BenchmarkChunkIo() {
+  const size_t files_count = 4096;
+  const size_t file_size = 4096;
+  char directory[] = "/tmp/minecraft-benchmark-chunks-XXXXXX";
+  if (mkdtemp(directory) == nullptr) {
+    std::cerr << "  could not create a directory in /tmp\n";
+    return false;
+  }
+  vector<string> paths;
+  vector<vector<uint8_t>> contents;
+  uint64_t expected_sum = 0;
+  for (size_t file = 0; file < files_count; ++file) {
+    paths.push_back(string(directory) + "/" + std::to_string(file));
+    contents.push_back(vector<uint8_t>(file_size));
+    for (size_t i = 0; i < file_size; ++i) {
+      contents.back()[i] = uint8_t(file * 7 + i);
+      expected_sum += contents.back()[i];
+    }
+  }
+
+  struct Mode {
+    string name;
+    ChunkIo::Backend backend;
+    size_t queue_depth;
+  };
+  const vector<Mode> modes = {
+      {"one at a time", ChunkIo::Backend::kThreadPool, 1},
+      {"thread pool", ChunkIo::Backend::kThreadPool, ChunkIo::kQueueDepth},
+      {"io_uring", ChunkIo::Backend::kIoUring, ChunkIo::kQueueDepth}};
+  bool matches = true;
+  std::cout << "  " << files_count << " chunk files of " << file_size
+            << " bytes, read cold\n";
+  for (const Mode& mode : modes) {
+    ChunkIo chunk_io(mode.backend, mode.queue_depth);
+    if (chunk_io.GetBackend() != mode.backend) {
+      std::cout << "  " << mode.name << ": not available\n";
+      continue;
+    }
+    chunk_io.WriteFiles(paths, contents);
+    EvictFiles(paths);
+    uint64_t sum = 0;
+    steady_clock::time_point start = steady_clock::now();
+    chunk_io.ReadFiles(paths, [&sum](size_t, vector<uint8_t>* bytes) {
+      for (uint8_t byte : *bytes) {
+        sum += byte;
+      }
+    });
+    double seconds = duration<double>(steady_clock::now() - start).count();
+    matches = matches && sum == expected_sum;
+    ChunkIoStats stats = chunk_io.GetStats();
+    std::cout << std::fixed << std::setprecision(2) << "  " << std::left
+              << std::setw(14) << mode.name << std::right << std::setw(9)
+              << double(files_count) / seconds << " files/s, "
+              << double(files_count * file_size) / seconds / (1 << 20)
+              << " MiB/s, read p50 " << stats.p50_read_seconds * 1e3
+              << " ms, p99 " << stats.p99_read_seconds * 1e3
+              << " ms, queue depth " << stats.max_queue_depth << "\n";
+  }
+  nftw(directory, RemoveBenchmarkFile, 16, FTW_DEPTH | FTW_PHYS);
+  if (!matches) {
+    std::cerr << "  the backends read different bytes\n";
+  }
+  return matches;
+}
+
+/// checks the broadphase against testing every pair
+///
+/// \param random source of the boxes
+/// \return false if they disagree
+bool CheckBroadphase(std::mt19937* random) {
+  std::uniform_real_distribution<float> coordinate(-16, 16);
+  vector<glm::vec3> centers;
+  for (int box = 0; box < 2000; ++box) {
+    centers.push_back(glm::vec3(coordinate(*random), coordinate(*random) / 4,
+                                coordinate(*random)));
+  }
+  vector<glm::vec3> half_extents(centers.size(), glm::vec3(0.3f, 0.9f, 0.3f));
+  SpatialHash hash(2.0f);
+  hash.Build(centers.data(), half_extents.data(), centers.size());
+  vector<pair<uint32_t, uint32_t>> pairs;
+  hash.FindPairs(&pairs);
+  std::sort(pairs.begin(), pairs.end());
+
+  vector<pair<uint32_t, uint32_t>> expected;
+  for (uint32_t first = 0; first < centers.size(); ++first) {
+    for (uint32_t second = first + 1; second < centers.size(); ++second) {
+      glm::vec3 gap = glm::abs(centers[first] - centers[second]) -
+                      2.0f * half_extents[first];
+      if (gap.x < 0 && gap.y < 0 && gap.z < 0) {
+        expected.push_back(std::make_pair(first, second));
+      }
+    }
+  }
+  if (pairs != expected) {
+    std::cerr << "  broadphase found " << pairs.size() << " pairs, not "
+              << expected.size() << "\n";
+    return false;
+  }
+  return true;
+}
+
+/// steps more and more entities wandering over generated terrain, colliding
+/// with the blocks and with each other. the time per entity should stay flat
+bool BenchmarkEntities() {
+  std::mt19937 random(5);
+  if (!CheckBroadphase(&random)) {
+    return false;
+  }
+  const float step_seconds = 1.0f / 20.0f;
+  const int steps_count = 100;
+  const glm::vec3 half_extents(0.3f, 0.9f, 0.3f);
+  TerrainGenerator generator(-3, 2, 10.0f, 7);
+  World world(&generator, glm::vec3(0), 32);
+  BlockBox bounds = world.GetLoadedBounds();
+  std::uniform_int_distribution<int> column_x(bounds.min_corner.x + 1,
+                                              bounds.max_corner.x - 1);
+  std::uniform_int_distribution<int> column_z(bounds.min_corner.z + 1,
+                                              bounds.max_corner.z - 1);
+  std::uniform_real_distribution<float> angle(0, 2 * float(M_PI));
+
+  for (size_t entities_count : {1000, 5000, 10000}) {
+    EntityStore store;
+    for (size_t entity = 0; entity < entities_count; ++entity) {
+      int x = column_x(random);
+      int z = column_z(random);
+      int top = world.GetColumnTop(x, z);
+      float y = top == World::kNoColumnTop ? 0.0f : float(top);
+      store.Create(glm::vec3(x, y + 0.5f + half_extents.y, z), half_extents);
+    }
+    EntityPhysics physics(&world, 2.0f);
+    EntityScheduler scheduler(step_seconds, 1);
+    // entities that walked into something turn around
+    scheduler.AddSystem("wander", [&random, &angle](EntityStore* entities,
+                                                    float) {
+      glm::vec3* velocities = entities->GetVelocities();
+      for (size_t slot = 0; slot < entities->GetCount(); ++slot) {
+        if (velocities[slot].x == 0 || velocities[slot].z == 0) {
+          float direction = angle(random);
+          velocities[slot].x = 4 * std::cos(direction);
+          velocities[slot].z = 4 * std::sin(direction);
+        }
+      }
+    });
+    physics.AddSystems(&scheduler);
+
+    steady_clock::time_point start = steady_clock::now();
+    size_t pairs_count = 0;
+    for (int step = 0; step < steps_count; ++step) {
+      scheduler.Step(&store);
+      pairs_count += physics.GetPairsCount();
+    }
+    double seconds =
+        duration<double>(steady_clock::now() - start).count() / steps_count;
+    std::cout << std::fixed << std::setprecision(2) << "  " << std::setw(5)
+              << entities_count << " entities: " << std::setw(7)
+              << 1 / seconds << " ticks/s, " << std::setw(6)
+              << seconds * 1e9 / double(entities_count)
+              << " ns/entity (wander " << std::setw(5)
+              << scheduler.GetSystemSeconds("wander") * 1e3 / steps_count
+              << " ms, separate " << std::setw(5)
+              << scheduler.GetSystemSeconds("separate") * 1e3 / steps_count
+              << " ms, move " << std::setw(5)
+              << scheduler.GetSystemSeconds("move") * 1e3 / steps_count
+              << " ms), " << pairs_count / steps_count
+              << " overlapping pairs per tick\n";
+  }
+  return true;
+}
+
+/// \param results answers to requests
+/// \return nodes expanded per request
+double GetMeanExpanded(const vector<PathResult>& results) {
+  size_t expanded = 0;
+  for (const PathResult& result : results) {
+    expanded += result.nodes_expanded;
+  }
+  return double(expanded) / double(results.size());
+}
+
+/// finds paths between random points of a map of 16 x 16 chunks of generated
+/// terrain, crossed by walls that leave a gap at alternating ends: with plain
+/// A* over blocks, then through the chunk hierarchy, with its graphs not
+/// built yet, built, and in batches on a thread pool
+bool BenchmarkPathfinding() {
+  const size_t requests_count = 100;
+  const int chunk_radius = 4;
+  const int width = 2 * chunk_radius;
+  const int chunks_across = 16;
+  TerrainGenerator generator(-3, 2, 10.0f, 7);
+  World world(&generator, glm::vec3(0), size_t(chunk_radius));
+  ThreadPool thread_pool(ThreadPool::GetDefaultThreadsCount());
+  Pathfinder pathfinder(&world, &thread_pool);
+
+  // blocks from -4 to 123 along x and z
+  int min_corner = -chunk_radius;
+  int max_corner = chunks_across * width - chunk_radius - 1;
+  for (int wall = 1; wall * 16 < chunks_across * width; ++wall) {
+    int z = min_corner + wall * 16;
+    bool gap_at_max = wall % 2 == 1;
+    world.FillBox(BlockBox{glm::ivec3(gap_at_max ? min_corner : min_corner + 4,
+                                      -4, z),
+                           glm::ivec3(gap_at_max ? max_corner - 4 : max_corner,
+                                      8, z)},
+                  BlockTypes::kStone);
+  }
+  std::shared_ptr<WorldSnapshot> shared_snapshot(
+      new WorldSnapshot(size_t(chunk_radius)));
+  WorldSnapshot& snapshot = *shared_snapshot;
+  for (int x = 0; x < chunks_across; ++x) {
+    for (int y = -1; y <= 1; ++y) {
+      for (int z = 0; z < chunks_across; ++z) {
+        minecraft::ChunkCoordinates chunk{x, y, z};
+        snapshot.Add(chunk, world.GetChunkSnapshot(chunk));
+      }
+    }
+  }
+
+  std::mt19937 random(3);
+  std::uniform_int_distribution<int> column(min_corner, max_corner);
+  auto pick_point = [&]() {
+    while (true) {
+      int x = column(random);
+      int z = column(random);
+      for (int y = 2 * width - chunk_radius - 2; y >= -width; --y) {
+        if (Pathfinder::CanStandAt(snapshot, glm::ivec3(x, y, z))) {
+          return glm::ivec3(x, y, z);
+        }
+      }
+    }
+  };
+  vector<PathRequest> requests;
+  while (requests.size() < requests_count) {
+    PathRequest request{pick_point(), pick_point()};
+    // across several walls
+    if (std::abs(request.goal.z - request.start.z) > 48) {
+      requests.push_back(request);
+    }
+  }
+
+  typedef std::function<vector<PathResult>()> Run;
+  auto time = [](const Run& run, vector<PathResult>* results) {
+    steady_clock::time_point start = steady_clock::now();
+    *results = run();
+    return duration<double>(steady_clock::now() - start).count();
+  };
+  auto find_each = [&](bool hierarchical) {
+    vector<PathResult> results;
+    for (const PathRequest& request : requests) {
+      results.push_back(hierarchical
+                            ? pathfinder.FindPath(snapshot, request)
+                            : Pathfinder::FindBlockPath(snapshot, request));
+    }
+    return results;
+  };
+  vector<PathResult> blocks;
+  vector<PathResult> cold;
+  vector<PathResult> warm;
+  vector<PathResult> batched;
+  double blocks_seconds = time([&]() { return find_each(false); }, &blocks);
+  double cold_seconds = time([&]() { return find_each(true); }, &cold);
+  size_t clusters_count = pathfinder.GetClustersCount();
+  double warm_seconds = time([&]() { return find_each(true); }, &warm);
+  double batched_seconds = time(
+      [&]() { return pathfinder.FindPaths(shared_snapshot, requests).Get(); },
+      &batched);
+
+  size_t found_count = 0;
+  size_t block_steps = 0;
+  size_t hierarchy_steps = 0;
+  for (size_t request = 0; request < requests.size(); ++request) {
+    if (blocks[request].found != warm[request].found ||
+        blocks[request].found != batched[request].found ||
+        warm[request].path.size() < blocks[request].path.size()) {
+      std::cerr << "  the searches disagree on request " << request << "\n";
+      return false;
+    }
+    if (blocks[request].found) {
+      ++found_count;
+      block_steps += blocks[request].path.size() - 1;
+      hierarchy_steps += warm[request].path.size() - 1;
+    }
+  }
+  double count = double(requests.size());
+  std::cout << std::fixed << std::setprecision(2) << "  " << found_count
+            << " of " << requests.size() << " paths found, "
+            << double(hierarchy_steps) / double(block_steps)
+            << "x as long as the shortest\n"
+            << "  block A*:          " << std::setw(8)
+            << count / blocks_seconds << " queries/s, " << std::setw(8)
+            << GetMeanExpanded(blocks) << " nodes/query\n"
+            << "  hierarchical cold: " << std::setw(8) << count / cold_seconds
+            << " queries/s, " << std::setw(8) << GetMeanExpanded(cold)
+            << " nodes/query, " << clusters_count << " chunk graphs built\n"
+            << "  hierarchical warm: " << std::setw(8) << count / warm_seconds
+            << " queries/s, " << std::setw(8) << GetMeanExpanded(warm)
+            << " nodes/query\n"
+            << "  batched, " << thread_pool.GetThreadsCount() << " threads: "
+            << std::setw(8) << count / batched_seconds << " queries/s\n";
+  return true;
+}
+
+/// spawns a player with the whole window generated before the first frame,
+/// and progressively: the collision neighborhood first, then the rest
+/// streamed in by the prefetcher's workers, a few chunks per frame
+bool BenchmarkSpawn() {
+  const size_t chunks_per_frame = 4;
+  const float frame_seconds = 1.0f / 60.0f;
+  const glm::vec3 origin(1, 1, 1);
+  std::cout << std::fixed << std::setprecision(2);
+  for (size_t chunk_radius : {4, 8, 16}) {
+    TerrainGenerator generator(-3, 2, 10.0f, 7);
+    steady_clock::time_point start = steady_clock::now();
+    World full(&generator, origin, chunk_radius);
+    double full_seconds = duration<double>(steady_clock::now() - start).count();
+
+    ThreadPool thread_pool(ThreadPool::GetDefaultThreadsCount());
+    start = steady_clock::now();
+    World world(&generator, origin, chunk_radius,
+                World::SpawnMode::kProgressive);
+    double interactive_seconds =
+        duration<double>(steady_clock::now() - start).count();
+    // frames paced at 60 Hz, the rest of each frame left to the workers
+    size_t frames = 0;
+    {
+      ChunkPrefetcher prefetcher(&world, &thread_pool);
+      steady_clock::time_point next_frame = steady_clock::now();
+      while (!world.GetPendingChunks().empty()) {
+        prefetcher.Update(origin, glm::vec3(1, 0, 0), frame_seconds);
+        world.StreamChunks(chunks_per_frame);
+        ++frames;
+        next_frame += std::chrono::duration_cast<steady_clock::duration>(
+            duration<double>(frame_seconds));
+        std::this_thread::sleep_until(next_frame);
+      }
+    }
+    double full_view_seconds =
+        duration<double>(steady_clock::now() - start).count();
+
+    for (int x = -1; x <= 1; ++x) {
+      for (int y = -1; y <= 1; ++y) {
+        for (int z = -1; z <= 1; ++z) {
+          ChunkCoordinates chunk{x, y, z};
+          if (world.GetChunkBlocks(chunk) != full.GetChunkBlocks(chunk)) {
+            std::cerr << "  the spawns disagree on a chunk\n";
+            return false;
+          }
+        }
+      }
+    }
+    std::cout << "  chunk width " << std::setw(2) << 2 * chunk_radius
+              << ": full " << std::setw(8) << full_seconds * 1000.0
+              << " ms, progressive interactive " << std::setw(6)
+              << interactive_seconds * 1000.0 << " ms, full view "
+              << std::setw(8) << full_view_seconds * 1000.0 << " ms over "
+              << frames << " frames\n";
+  }
+  return true;
+}
+
+/// walks over a sheet of glass covering the window, and times the frames on
+/// the main thread without the glass, with the glass sorted from scratch
+/// every frame, and with the glass re-sorted by a `TranslucentSorter`. the
+/// timed frames only count draws; every tenth frame is also rasterized,
+/// untimed, for the fragments the glass adds
+bool BenchmarkTranslucency() {
+  const size_t chunk_radius = 8;
+  const int width = 2 * int(chunk_radius);
+  const int frames = 300;
+  const int raster_interval = 10;
+  const float field_of_view = 0.8f;
+  std::cout << std::fixed << std::setprecision(3);
+  TerrainGenerator generator(-3, 2, 10.0f, 7);
+  World world(&generator, glm::vec3(1, 6, 1), chunk_radius);
+  glm::ivec3 low = world.GetChunkMinCorner(world.GetWindowCenter());
+  vector<BlockEdit> sheet;
+  for (int x = low.x - width; x < low.x + 2 * width; ++x) {
+    for (int z = low.z - width; z < low.z + 2 * width; ++z) {
+      sheet.push_back(BlockEdit{glm::ivec3(x, 4, z), BlockTypes::kGlass});
+    }
+  }
+  world.ApplyEdits(sheet);
+  size_t translucent_triangles = 0;
+  for (const PackedMesh* mesh : world.GetTranslucentMeshes()) {
+    translucent_triangles += mesh->GetTrianglesCount();
+  }
+
+  // across the center chunk at a walk, looking ahead and down at the glass
+  const glm::vec3 forward = glm::normalize(glm::vec3(1, -0.4f, 0.2f));
+  ThreadPool thread_pool(ThreadPool::GetDefaultThreadsCount());
+  const char* modes[] = {"opaque only", "sorted every frame",
+                         "incremental sorting"};
+  double opaque_seconds = 0;
+  for (int mode = 0; mode < 3; ++mode) {
+    std::unique_ptr<TranslucentSorter> sorter;
+    if (mode == 2) {
+      sorter.reset(new TranslucentSorter(&world, &thread_pool));
+    }
+    HeadlessRenderer renderer;
+    HeadlessRenderer raster(glm::ivec2(160, 120));
+    std::function<void(HeadlessRenderer*, const glm::vec3&)> draw =
+        [&world, &sorter, &forward, field_of_view, mode](
+            HeadlessRenderer* target, const glm::vec3& eye) {
+          target->Clear();
+          target->SetCamera(eye, forward);
+          world.Render(target, eye, forward, field_of_view, 1000);
+          if (mode > 0) {
+            world.RenderTranslucent(target, eye, forward, field_of_view,
+                                    1000);
+          }
+        };
+    double seconds = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+      glm::vec3 eye(float(low.x) + 2.0f +
+                        float(width - 4) * float(frame) / float(frames),
+                    7.0f, float(low.z) + 3.0f);
+      steady_clock::time_point start = steady_clock::now();
+      if (mode == 1) {
+        for (const PackedMesh* mesh : world.GetTranslucentMeshes()) {
+          PackedMesh sorted = *mesh;
+          sorted.SortBackToFront(eye);
+        }
+      } else if (sorter != nullptr) {
+        sorter->Update(eye);
+      }
+      draw(&renderer, eye);
+      seconds += duration<double>(steady_clock::now() - start).count();
+      if (frame % raster_interval == 0) {
+        draw(&raster, eye);
+      }
+    }
+    if (mode == 0) {
+      opaque_seconds = seconds;
+    }
+    const minecraft::RenderStats& stats = raster.GetStats();
+    std::cout << "  " << std::setw(20) << std::left << modes[mode]
+              << std::right << std::setw(8) << seconds / frames * 1000.0
+              << " ms/frame (+" << std::setw(6)
+              << (seconds - opaque_seconds) / frames * 1000.0 << "), "
+              << std::setw(8)
+              << renderer.GetStats().triangles / frames
+              << " triangles/frame, "
+              << stats.GetDepthComplexity() << " fragments/pixel ("
+              << std::setw(6)
+              << double(stats.blended_fragments) /
+                     double(stats.covered_pixels)
+              << " blended)";
+    if (sorter != nullptr) {
+      std::cout << ", " << sorter->GetStats().requested << " sorts, "
+                << sorter->GetStats().skipped << " skipped";
+    }
+    std::cout << "\n";
+  }
+  std::cout << "  " << translucent_triangles
+            << " translucent triangles in the window\n";
+  return true;
+}
+
+const vector<Benchmark> kBenchmarks = {
+    {"terrain-fill", BenchmarkTerrainFill},
+    {"packed-vertices", BenchmarkPackedVertices},
+    {"asset-pack", BenchmarkAssetPack},
+    {"chunk-io", BenchmarkChunkIo},
+    {"entities", BenchmarkEntities},
+    {"pathfinding", BenchmarkPathfinding},
+    {"spawn", BenchmarkSpawn},
+    {"translucency", BenchmarkTranslucency},
+};
+
+}  // namespace
+
+/// runs the benchmarks named on the command line, or all of them
+int main(int argc, char** argv) {
+  vector<string> names(argv + 1, argv + argc);
+  bool passed = true;
+  for (const Benchmark& benchmark : kBenchmarks) {
+    if (!names.empty() &&
+        std::find(names.begin(), names.end(), benchmark.name) == names.end()) {
+      continue;
+    }
+    std::cout << benchmark.name << "\n";
+    passed = benchmark.run() && passed;
+  }
+  return passed ? 0 : 1;
+}
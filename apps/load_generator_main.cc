@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "server/player_swarm.h"
+#include "server/world_server.h"
+
+using minecraft::ClientStats;
+using minecraft::PlayerSwarm;
+using minecraft::SwarmMovement;
+using minecraft::SwarmStats;
+using minecraft::WorldServer;
+using std::string;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+namespace {
+
+/// command line options, see `PrintUsage`
+struct Options {
+  string socket_path = "/tmp/minecraft-load.sock";
+  int max_players = 64;
+  int ticks_per_step = 200;
+  int tick_rate = 20;
+  int view_radius = 2;
+  string movement = "random";
+  float speed = 4.3f;
+  double edits_per_second = 0.5;
+  int seed = 0;
+};
+
+void PrintUsage() {
+  std::cerr << "usage: minecraft-load-generator [--socket PATH]"
+               " [--max-players N] [--ticks-per-step N] [--tick-rate N]"
+               " [--view-radius N] [--movement random|scripted]"
+               " [--speed BLOCKS_PER_SECOND] [--edits-per-second N]"
+               " [--seed N]\n";
+}
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    string flag = argv[i];
+    if (i + 1 >= argc) {
+      return false;
+    }
+    string value = argv[++i];
+    if (flag == "--socket") {
+      options->socket_path = value;
+    } else if (flag == "--max-players") {
+      options->max_players = std::max(1, std::atoi(value.c_str()));
+    } else if (flag == "--ticks-per-step") {
+      options->ticks_per_step = std::max(1, std::atoi(value.c_str()));
+    } else if (flag == "--tick-rate") {
+      options->tick_rate = std::max(0, std::atoi(value.c_str()));
+    } else if (flag == "--view-radius") {
+      options->view_radius = std::max(0, std::atoi(value.c_str()));
+    } else if (flag == "--movement" &&
+               (value == "random" || value == "scripted")) {
+      options->movement = value;
+    } else if (flag == "--speed") {
+      options->speed = float(std::atof(value.c_str()));
+    } else if (flag == "--edits-per-second") {
+      options->edits_per_second = std::atof(value.c_str());
+    } else if (flag == "--seed") {
+      options->seed = std::atoi(value.c_str());
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// \param samples tick durations, reordered
+/// \param percent a percentile
+/// \return the percentile of the samples
+double GetPercentile(vector<double>* samples, size_t percent) {
+  size_t rank = std::min(samples->size() - 1, samples->size() * percent / 100);
+  std::nth_element(samples->begin(), samples->begin() + rank, samples->end());
+  return (*samples)[rank];
+}
+
+void PrintHeader() {
+  std::cout << std::setw(8) << "players" << std::setw(10) << "chunks/s"
+            << std::setw(12) << "server KiB" << std::setw(12) << "client KiB"
+            << std::setw(9) << "edits/s" << std::setw(14) << "edit p50/p99"
+            << std::setw(8) << "dropped" << std::setw(22)
+            << "tick p50/p99/max ms" << "\n";
+}
+
+/// prints one line of measurements; memory is per player
+void PrintStep(const SwarmStats& swarm, const vector<ClientStats>& clients,
+               size_t chunk_bytes, vector<double>* tick_seconds) {
+  uint64_t server_bytes = 0;
+  for (const ClientStats& client : clients) {
+    server_bytes += client.memory_bytes;
+  }
+  double players = double(std::max<size_t>(1, swarm.players));
+  double max_tick = *std::max_element(tick_seconds->begin(),
+                                      tick_seconds->end());
+  std::cout << std::fixed << std::setprecision(1) << std::setw(8)
+            << swarm.players << std::setw(10)
+            << double(swarm.chunks_received) / swarm.seconds << std::setw(12)
+            << double(server_bytes) / 1024.0 / players << std::setw(12)
+            << double(swarm.chunks_held * chunk_bytes) / 1024.0 / players
+            << std::setw(9) << double(swarm.edits_confirmed) / swarm.seconds
+            << std::setw(7) << swarm.p50_edit_seconds * 1000.0 << "/"
+            << std::setw(6) << swarm.p99_edit_seconds * 1000.0 << std::setw(8)
+            << swarm.edits_dropped << std::setw(8)
+            << GetPercentile(tick_seconds, 50) * 1000.0 << "/" << std::setw(6)
+            << GetPercentile(tick_seconds, 99) * 1000.0 << "/" << std::setw(6)
+            << max_tick * 1000.0 << std::endl;
+}
+
+}  // namespace
+
+/// drives a growing swarm of simulated players through one in-process
+/// server, doubling the players every step, and prints what each step cost
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    PrintUsage();
+    return 1;
+  }
+
+  WorldServer::Settings server_settings;
+  server_settings.seed = options.seed;
+  server_settings.chunk_radius = 2;
+  server_settings.min_terrain_height = -3;
+  server_settings.max_terrain_height = 2;
+  server_settings.terrain_variance = 10.0f;
+  server_settings.max_view_radius = size_t(options.view_radius);
+  server_settings.chunks_per_tick = 16;
+  WorldServer server(server_settings);
+  server.ListenUnix(options.socket_path);
+  size_t chunk_width = 2 * server_settings.chunk_radius;
+
+  PlayerSwarm::Settings settings;
+  settings.socket_path = options.socket_path;
+  settings.movement = options.movement == "scripted"
+                          ? SwarmMovement::kScripted
+                          : SwarmMovement::kRandomWalk;
+  settings.waypoints = {ci::vec3(0, 0, 0), ci::vec3(64, 0, 0),
+                        ci::vec3(64, 0, 64), ci::vec3(0, 0, 64)};
+  settings.view_radius = uint32_t(options.view_radius);
+  settings.speed = options.speed;
+  settings.height = 4.0f;
+  settings.spawn_spread = 256.0f;
+  settings.edits_per_second = options.edits_per_second;
+  settings.reach = 4;
+  settings.edit_timeout_seconds = 5.0;
+  settings.seed = unsigned(options.seed);
+  PlayerSwarm swarm(settings);
+
+  // with no tick rate the server runs flat out, and the players move as if
+  // it ran at 20 ticks per second
+  float tick_length = 1.0f / float(options.tick_rate == 0 ? 20
+                                                          : options.tick_rate);
+  size_t capacity = 0;
+  bool within_budget = true;
+  PrintHeader();
+  for (int players = 1; players <= options.max_players; players *= 2) {
+    swarm.AddPlayers(size_t(players) - swarm.GetPlayersCount());
+    swarm.ResetStats();
+    vector<double> tick_seconds;
+    steady_clock::time_point next_tick = steady_clock::now();
+    for (int tick = 0; tick < options.ticks_per_step; ++tick) {
+      if (!swarm.Step(tick_length)) {
+        std::cerr << "the server hung up" << std::endl;
+        return 1;
+      }
+      server.Tick();
+      tick_seconds.push_back(server.GetLastTickSeconds());
+      if (options.tick_rate > 0) {
+        next_tick += std::chrono::duration_cast<steady_clock::duration>(
+            duration<double>(tick_length));
+        std::this_thread::sleep_until(next_tick);
+      }
+    }
+    PrintStep(swarm.GetStats(), server.GetClientStats(),
+              chunk_width * chunk_width * chunk_width *
+                  sizeof(minecraft::BlockTypes),
+              &tick_seconds);
+    if (GetPercentile(&tick_seconds, 99) > tick_length) {
+      within_budget = false;
+    } else if (within_budget) {
+      capacity = size_t(players);
+    }
+  }
+  std::cout << "largest swarm with a p99 tick within " << tick_length * 1000.0
+            << " ms: " << capacity << " players" << std::endl;
+  return 0;
+}
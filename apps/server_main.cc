@@ -0,0 +1,244 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/metrics.h"
+#include "core/metrics_exporter.h"
+#include "server/world_client.h"
+#include "server/world_server.h"
+
+using minecraft::ClientStats;
+using minecraft::JournalStats;
+using minecraft::MetricsExporter;
+using minecraft::MetricsRegistry;
+using minecraft::WorldClient;
+using minecraft::WorldServer;
+using minecraft::BlockEdit;
+using std::string;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace {
+
+/// command line options, see `PrintUsage`
+struct Options {
+  string socket_path = "/tmp/minecraft.sock";
+  int port = -1;
+  int seed = 0;
+  int tick_rate = 20;
+  int ticks = 0;
+  int loopback_clients = 0;
+  double report_interval = 5.0;
+  string save_directory;
+  int metrics_port = -1;
+  string metrics_file;
+};
+
+void PrintUsage() {
+  std::cerr << "usage: minecraft-server [--socket PATH | --port PORT]"
+               " [--seed N] [--tick-rate N] [--ticks N]"
+               " [--loopback-clients N] [--report-interval SECONDS]"
+               " [--save-dir PATH] [--metrics-port PORT]"
+               " [--metrics-file PATH]\n";
+}
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    string flag = argv[i];
+    if (i + 1 >= argc) {
+      return false;
+    }
+    string value = argv[++i];
+    if (flag == "--socket") {
+      options->socket_path = value;
+    } else if (flag == "--port") {
+      options->port = std::atoi(value.c_str());
+    } else if (flag == "--seed") {
+      options->seed = std::atoi(value.c_str());
+    } else if (flag == "--tick-rate") {
+      options->tick_rate = std::max(1, std::atoi(value.c_str()));
+    } else if (flag == "--ticks") {
+      options->ticks = std::atoi(value.c_str());
+    } else if (flag == "--loopback-clients") {
+      options->loopback_clients = std::atoi(value.c_str());
+    } else if (flag == "--report-interval") {
+      options->report_interval = std::atof(value.c_str());
+    } else if (flag == "--save-dir") {
+      options->save_directory = value;
+    } else if (flag == "--metrics-port") {
+      options->metrics_port = std::atoi(value.c_str());
+    } else if (flag == "--metrics-file") {
+      options->metrics_file = value;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// a simulated player that wanders around and digs/builds, to exercise the
+/// server from the same machine
+void RunLoopbackClient(const Options& options, uint16_t port, int index,
+                       const std::atomic<bool>* running) {
+  WorldClient client;
+  if (options.port >= 0) {
+    client.ConnectTcp(port);
+  } else {
+    client.ConnectUnix(options.socket_path);
+  }
+  client.SendHello(1);
+  std::mt19937 generator(static_cast<unsigned>(index));
+  std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+  std::uniform_int_distribution<int> offset(-3, 3);
+  ci::vec3 position(0, 10, 0);
+  while (running->load() && client.Poll()) {
+    position += ci::vec3(step(generator), 0, step(generator));
+    client.SendPosition(position);
+    if (generator() % 4 == 0) {
+      glm::ivec3 target(int(position.x) + offset(generator),
+                        offset(generator),
+                        int(position.z) + offset(generator));
+      BlockEdit edit = {target, generator() % 2 == 0 ? minecraft::kNone
+                                                     : minecraft::kStone};
+      client.SendEdit(edit);
+    }
+    std::this_thread::sleep_for(milliseconds(1000 / options.tick_rate));
+  }
+}
+
+void PrintReport(const WorldServer& server, const vector<ClientStats>& previous,
+                 double seconds) {
+  std::cout << "tick " << server.GetTick() << ", last tick " << std::fixed
+            << std::setprecision(3) << server.GetLastTickSeconds() * 1000.0
+            << " ms\n";
+  if (server.GetJournal() != nullptr) {
+    JournalStats journal = server.GetJournal()->GetStats();
+    std::cout << "  save: " << journal.edits_durable << "/"
+              << journal.edits_appended << " edits durable, "
+              << journal.GetThroughput() << " edits/s, p99 "
+              << journal.p99_durable_seconds * 1000.0 << " ms to disk, "
+              << journal.append_seconds * 1000.0 / double(server.GetTick())
+              << " ms/tick on the tick thread\n";
+  }
+  for (const ClientStats& stats : server.GetClientStats()) {
+    ClientStats before = ClientStats();
+    for (const ClientStats& old : previous) {
+      if (old.client_id == stats.client_id) {
+        before = old;
+      }
+    }
+    uint64_t ticks = stats.ticks - before.ticks;
+    std::cout << "  client " << stats.client_id << ": out "
+              << (stats.bytes_sent - before.bytes_sent) / 1024.0 / seconds
+              << " KiB/s, in "
+              << (stats.bytes_received - before.bytes_received) / 1024.0 /
+                     seconds
+              << " KiB/s, " << stats.chunks_sent - before.chunks_sent
+              << " chunks, " << stats.edits_received - before.edits_received
+              << " edits, "
+              << (ticks == 0 ? 0.0
+                             : (stats.service_seconds -
+                                before.service_seconds) *
+                                   1000.0 / double(ticks))
+              << " ms/tick\n";
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    PrintUsage();
+    return 1;
+  }
+
+  WorldServer::Settings settings;
+  settings.seed = options.seed;
+  settings.chunk_radius = 2;
+  settings.min_terrain_height = -3;
+  settings.max_terrain_height = 2;
+  settings.terrain_variance = 10.0f;
+  settings.max_view_radius = 4;
+  settings.chunks_per_tick = 16;
+  settings.save_directory = options.save_directory;
+  // declared before the server, whose world reports to it
+  MetricsRegistry metrics;
+  WorldServer server(settings);
+  server.GetWorld().SetMetrics(&metrics);
+  minecraft::Histogram* tick_seconds = metrics.AddHistogram(
+      "minecraft_server_tick_seconds", "Time of each server tick");
+  minecraft::Gauge* clients =
+      metrics.AddGauge("minecraft_server_clients", "Connected clients");
+  MetricsExporter metrics_exporter(&metrics);
+  if (options.metrics_port >= 0) {
+    std::cout << "metrics on http://127.0.0.1:"
+              << metrics_exporter.ServeHttp(uint16_t(options.metrics_port))
+              << MetricsExporter::kMetricsPath << std::endl;
+  }
+  if (!options.metrics_file.empty()) {
+    metrics_exporter.DumpToFile(options.metrics_file,
+                                options.report_interval);
+  }
+  if (server.GetJournal() != nullptr) {
+    minecraft::ChunkIoStats chunk_io =
+        server.GetJournal()->GetStats().chunk_io;
+    std::cout << "recovered "
+              << server.GetJournal()->GetRecoveredEdits().size()
+              << " edits from " << options.save_directory << " ("
+              << chunk_io.reads << " chunk files, queue depth "
+              << chunk_io.max_queue_depth << ", p99 read "
+              << chunk_io.p99_read_seconds * 1000.0 << " ms)" << std::endl;
+  }
+
+  uint16_t port = 0;
+  if (options.port >= 0) {
+    port = server.ListenTcp(uint16_t(options.port));
+    std::cout << "listening on 127.0.0.1:" << port << std::endl;
+  } else {
+    server.ListenUnix(options.socket_path);
+    std::cout << "listening on " << options.socket_path << std::endl;
+  }
+
+  std::atomic<bool> running(true);
+  vector<std::thread> loopback_clients;
+  for (int i = 0; i < options.loopback_clients; ++i) {
+    loopback_clients.emplace_back(RunLoopbackClient, options, port, i,
+                                  &running);
+  }
+
+  duration<double> tick_length(1.0 / options.tick_rate);
+  steady_clock::time_point next_tick = steady_clock::now();
+  steady_clock::time_point last_report = next_tick;
+  vector<ClientStats> previous_stats;
+  while (options.ticks == 0 || int(server.GetTick()) < options.ticks) {
+    server.Tick();
+    tick_seconds->Observe(server.GetLastTickSeconds());
+    clients->Set(double(server.GetClientStats().size()));
+    next_tick +=
+        std::chrono::duration_cast<steady_clock::duration>(tick_length);
+    std::this_thread::sleep_until(next_tick);
+
+    double since_report =
+        duration<double>(steady_clock::now() - last_report).count();
+    if (since_report >= options.report_interval) {
+      PrintReport(server, previous_stats, since_report);
+      previous_stats = server.GetClientStats();
+      last_report = steady_clock::now();
+    }
+  }
+
+  running = false;
+  for (std::thread& client : loopback_clients) {
+    client.join();
+  }
+  return 0;
+}
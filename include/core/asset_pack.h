@@ -0,0 +1,105 @@
+#ifndef MINECRAFT_ASSET_PACK_H
+#define MINECRAFT_ASSET_PACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace minecraft {
+
+/// a decoded image to pack: RGBA, 8 bits per channel, rows in the order they
+/// are uploaded, i.e. bottom-up for OpenGL
+struct AssetImage {
+  std::string name;
+  uint32_t width;
+  uint32_t height;
+  std::vector<uint8_t> pixels;
+};
+
+/// an image in a mapped `AssetPack`, in the layout of `AssetImage`, followed
+/// by its mipmaps if it was packed with them
+struct PackedImage {
+  uint32_t width;
+  uint32_t height;
+  /// 1 without mipmaps
+  uint32_t levels_count;
+  /// level 0, inside the mapping
+  const uint8_t* pixels;
+
+  /// \param level mip level, below `levels_count`
+  /// \return width of the level, half that of the previous one, at least 1
+  uint32_t GetWidth(uint32_t level) const;
+  /// \param level mip level, below `levels_count`
+  /// \return height of the level, half that of the previous one, at least 1
+  uint32_t GetHeight(uint32_t level) const;
+  /// \param level mip level, below `levels_count`
+  /// \return pixels of the level, inside the mapping
+  const uint8_t* GetLevel(uint32_t level) const;
+  /// \return bytes of every level
+  size_t GetBytes() const;
+};
+
+/// block textures and icons, decoded at build time into one file that is
+/// memory-mapped at runtime, so startup neither reads nor decodes PNGs and
+/// textures are uploaded straight from the page cache.
+///
+/// the file is a 16-byte header (magic "MCAP", version, images count, zero),
+/// an index of 64-byte entries (name padded with NULs to 44 bytes, width,
+/// height, levels count, 64-bit offset) and the pixels of each image at its
+/// offset, aligned to 64 bytes. integers are little-endian
+class AssetPack {
+ public:
+  /// version written by `Write` and accepted by the constructor
+  static const uint32_t kVersion;
+  /// longest image name
+  static const size_t kMaxNameLength;
+  /// name of the pack among the assets
+  static const char* const kFileName;
+  /// name of the block texture atlas in the pack, see `Texture::GetAtlas`
+  static const char* const kAtlasName;
+
+  /// maps a pack and checks its index
+  ///
+  /// \param path the pack
+  /// \throw std::runtime_error if the file cannot be mapped or is not a
+  /// valid pack
+  explicit AssetPack(const std::string& path);
+
+  /// unmaps the pack. images found in it must no longer be used
+  ~AssetPack();
+
+  AssetPack(const AssetPack&) = delete;
+  AssetPack& operator=(const AssetPack&) = delete;
+
+  /// \param name an image name
+  /// \return the image, or null if the pack has no image of that name
+  const PackedImage* Find(const std::string& name) const;
+
+  /// \return names of the images, in alphabetical order
+  std::vector<std::string> GetNames() const;
+
+  /// \return size of the file
+  size_t GetBytes() const;
+
+  /// writes a pack
+  ///
+  /// \param path file to write, replaced if it exists
+  /// \param images images to pack, with distinct names
+  /// \param mipmaps whether to append box-filtered mipmaps down to 1x1
+  /// \throw std::invalid_argument if an image's name is too long or its
+  /// pixels do not match its size
+  /// \throw std::runtime_error if the file cannot be written
+  static void Write(const std::string& path,
+                    const std::vector<AssetImage>& images, bool mipmaps);
+
+ private:
+  void* mapping_;
+  size_t bytes_;
+  std::map<std::string, PackedImage> images_;
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_ASSET_PACK_H
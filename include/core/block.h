@@ -7,30 +7,52 @@
 #include <vector>
 
 #include "block_types.h"
+#include "renderer.h"
 
 namespace minecraft {
 
 /// cinder-compatible block
 class Block {
-  /// count for use in cube faces rendering
-  static const size_t kSquareVerticesCount = 4;
   /// count for use in cube rendering
   static const size_t kCubeVerticesCount = 8;
-  /// count for use in cube rendering
-  static const size_t kCubeFacesCount = 6;
   /// the locations of vertices in a cube centered at the origin
   static const ci::vec3 kCubeVertices[kCubeVerticesCount];
+
+ public:
+  /// count for use in cube faces rendering
+  static const size_t kSquareVerticesCount = 4;
+  /// count for use in cube rendering
+  static const size_t kCubeFacesCount = 6;
   /// the faces of a cube with respect to the vertices in `kCubeVertices`
   static const ci::vec3 kCubeFaces[kCubeFacesCount][kSquareVerticesCount];
+  /// texture coordinates of the corners of a face, in `kCubeFaces` order
+  static const ci::vec2 kSquareTexCoords[kSquareVerticesCount];
 
- public:
   /// creates a block
   ///
   /// \param block_type the type of block
   /// \param center the center of this block
   Block(const BlockTypes& block_type, const ci::vec3& center);
-  /// renders this block
-  void Render() const;
+
+  /// outward direction of each face, in the face order TOP, FRONT, RIGHT,
+  /// BACK, LEFT, BOTTOM
+  static const glm::ivec3 kFaceDirections[kCubeFacesCount];
+
+  /// appends one textured face of a cube to a mesh
+  ///
+  /// \param mesh output mesh, with positions and texture coordinates
+  /// \param block_type type of the cube, for the face's atlas layer
+  /// \param face face index, see `kFaceDirections`
+  /// \param center center of the cube
+  /// \param size side length of the cube
+  static void AppendFace(ci::TriMesh* mesh, BlockTypes block_type, size_t face,
+                         const ci::vec3& center, float size);
+
+  /// renders this block. blocks keep no geometry; chunks render theirs
+  /// through `PackedMesh`
+  ///
+  /// \param renderer renderer to draw with
+  void Render(Renderer* renderer) const;
   /// \return type of this block
   BlockTypes GetType() const;
   /// \return center of this block
@@ -41,13 +63,6 @@ class Block {
   BlockTypes block_type_;
   /// center of this block
   ci::vec3 center_;
-  /// texture of this block
-  ci::gl::Texture2dRef texture_;
-  /// mesh for this block
-  ci::TriMesh mesh_;
-
-  /// sets up mesh and texture for this block
-  void SetUp();
 };
 
 }  // namespace minecraft
@@ -0,0 +1,123 @@
+#ifndef MINECRAFT_BLOCK_CHANGE_BUS_H
+#define MINECRAFT_BLOCK_CHANGE_BUS_H
+
+#include <cinder/gl/gl.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "chunk_coordinates.h"
+#include "region.h"
+
+namespace minecraft {
+
+/// the changes of one tick inside one chunk
+struct ChunkChanges {
+  ChunkCoordinates chunk;
+  /// smallest box around `changes`
+  BlockBox bounds;
+  /// at most one change per block, in the order the blocks first changed
+  std::vector<BlockChange> changes;
+};
+
+/// the changes a subscriber receives for one tick
+struct BlockChangeBatch {
+  /// the tick the changes were made in
+  uint64_t tick;
+  /// non-empty chunks, ordered by chunk coordinates
+  std::vector<ChunkChanges> chunks;
+
+  /// \return number of changes over all chunks
+  size_t GetChangesCount() const;
+};
+
+/// what a `BlockChangeBus` has done so far
+struct BlockChangeBusStats {
+  /// changes passed to `Publish`
+  uint64_t published_changes;
+  /// changes left after coalescing, summed over flushes
+  uint64_t coalesced_changes;
+  /// calls of subscribers
+  uint64_t notifications;
+};
+
+/// collects block changes over a tick and hands them to subscribers as one
+/// batch per tick, grouped by chunk. repeated changes of a block within a
+/// tick collapse into one, and a block that ends the tick as it started is
+/// dropped. so a subscriber is called at most once per tick, no matter how
+/// many edits the tick made, and only if something in its region changed
+class BlockChangeBus {
+ public:
+  /// receives the changes of a tick
+  typedef std::function<void(const BlockChangeBatch&)> Subscriber;
+
+  /// \param chunk_radius radius of the world's chunks, see `world.h`
+  explicit BlockChangeBus(size_t chunk_radius);
+
+  /// \param subscriber called with the changes of every tick that has any
+  /// \return id for `Unsubscribe`
+  size_t Subscribe(const Subscriber& subscriber);
+
+  /// \param subscriber called with the changes inside `region` of every tick
+  /// that has any
+  /// \param region the blocks the subscriber cares about
+  /// \return id for `Unsubscribe`
+  size_t Subscribe(const Subscriber& subscriber, const BlockBox& region);
+
+  /// \param subscription id returned by `Subscribe`
+  void Unsubscribe(size_t subscription);
+
+  /// adds changes to the current tick
+  ///
+  /// \param changes blocks that changed, in order
+  void Publish(const std::vector<BlockChange>& changes);
+
+  /// ends the current tick: notifies every subscriber whose region changed.
+  /// changes published by subscribers while they are notified belong to the
+  /// next tick
+  ///
+  /// \param tick the tick that ends
+  void Flush(uint64_t tick);
+
+  /// \return number of blocks changed in the current tick so far
+  size_t GetPendingCount() const;
+
+  /// \return what the bus has done so far
+  const BlockChangeBusStats& GetStats() const;
+
+ private:
+  struct Subscription {
+    size_t id;
+    Subscriber subscriber;
+    /// whether `region` applies
+    bool filtered;
+    BlockBox region;
+  };
+
+  /// method of hashing lattice points
+  struct PositionHasher {
+    size_t operator()(const glm::ivec3& key) const {
+      return size_t((key.x * 5209) ^ (key.y * 1811) ^ (key.z * 7297));
+    }
+  };
+
+  int chunk_radius_;
+  std::vector<Subscription> subscriptions_;
+  size_t next_subscription_id_;
+  /// the current tick's changes by chunk
+  std::map<ChunkCoordinates, std::vector<BlockChange>> pending_;
+  /// index of each changed block in its chunk's list in `pending_`
+  std::unordered_map<glm::ivec3, size_t, PositionHasher> pending_indices_;
+  BlockChangeBusStats stats_;
+
+  /// \param position a lattice point
+  /// \return the chunk the point is in
+  ChunkCoordinates GetChunkOf(const glm::ivec3& position) const;
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_BLOCK_CHANGE_BUS_H
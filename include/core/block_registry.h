@@ -0,0 +1,113 @@
+#ifndef MINECRAFT_BLOCK_REGISTRY_H
+#define MINECRAFT_BLOCK_REGISTRY_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "block_types.h"
+
+namespace minecraft {
+
+/// static properties of a block type
+struct BlockProperties {
+  /// whether the block has faces to draw
+  bool visible;
+  /// whether the player collides with, stands on and can target the block
+  bool solid;
+  /// whether the block completely hides the faces of its neighbors
+  bool opaque;
+  /// whether light passes through the block's faces, which are then drawn
+  /// blended, back to front, after the opaque faces (see
+  /// `World::RenderTranslucent`)
+  bool translucent;
+  /// whether the block receives random ticks, see `World::Tick`
+  bool random_ticks;
+  /// atlas layer of each face, in the face order TOP, FRONT, RIGHT, BACK,
+  /// LEFT, BOTTOM (see `Block::kCubeFaces`)
+  uint8_t face_layers[6];
+  /// UI icon asset, or `nullptr` if the block cannot be held
+  const char* icon_file;
+};
+
+/// compile-time table of block properties, indexed by `BlockTypes`. lookups
+/// are a single array index, so hot paths (generation, meshing, collision,
+/// picking) never touch a map or a string. to add a block type, append it to
+/// `BlockTypes` and append its row to `kProperties`
+class BlockRegistry {
+ public:
+  /// number of texture tiles in each strip file, one per face
+  static constexpr size_t kTilesPerStrip = 6;
+  /// texture strips making up the atlas, from top to bottom. atlas layer `l`
+  /// is tile `l % kTilesPerStrip` of strip `l / kTilesPerStrip`
+  static constexpr const char* kAtlasFiles[] = {"grass.png", "dirt.png",
+                                                "stone.png", "glass.png"};
+  /// number of strips in the atlas
+  static constexpr size_t kAtlasStripsCount =
+      sizeof(kAtlasFiles) / sizeof(kAtlasFiles[0]);
+  /// one row per block type, in `BlockTypes` order
+  static constexpr BlockProperties kProperties[] = {
+      // kNone
+      {false, false, false, false, false, {0, 0, 0, 0, 0, 0}, nullptr},
+      // kGrass
+      {true, true, true, false, true, {0, 1, 2, 3, 4, 5}, "grass_icon.png"},
+      // kDirt
+      {true, true, true, false, false, {6, 7, 8, 9, 10, 11}, "dirt_icon.png"},
+      // kStone
+      {true, true, true, false, false, {12, 13, 14, 15, 16, 17},
+       "stone_icon.png"},
+      // kGlass
+      {true, true, false, true, false, {18, 19, 20, 21, 22, 23}, nullptr}};
+  /// number of block types
+  static constexpr size_t kBlockTypesCount =
+      sizeof(kProperties) / sizeof(kProperties[0]);
+
+  /// \param block_type a block type
+  /// \return its properties
+  static constexpr const BlockProperties& Get(BlockTypes block_type) {
+    return kProperties[block_type];
+  }
+
+  /// \param block_type a block type
+  /// \return whether the block has faces to draw
+  static constexpr bool IsVisible(BlockTypes block_type) {
+    return kProperties[block_type].visible;
+  }
+
+  /// \param block_type a block type
+  /// \return whether the block can be collided with and targeted
+  static constexpr bool IsSolid(BlockTypes block_type) {
+    return kProperties[block_type].solid;
+  }
+
+  /// \param block_type a block type
+  /// \return whether the block hides its neighbors' faces
+  static constexpr bool IsOpaque(BlockTypes block_type) {
+    return kProperties[block_type].opaque;
+  }
+
+  /// \param block_type a block type
+  /// \return whether the block's faces are drawn blended
+  static constexpr bool IsTranslucent(BlockTypes block_type) {
+    return kProperties[block_type].translucent;
+  }
+
+  /// \param block_type a block type
+  /// \return whether the block receives random ticks
+  static constexpr bool HasRandomTicks(BlockTypes block_type) {
+    return kProperties[block_type].random_ticks;
+  }
+
+  /// \param block_type a block type
+  /// \param face face index, see `BlockProperties::face_layers`
+  /// \return atlas layer of the face
+  static constexpr uint8_t GetFaceLayer(BlockTypes block_type, size_t face) {
+    return kProperties[block_type].face_layers[face];
+  }
+};
+
+static_assert(BlockRegistry::kBlockTypesCount == BlockTypes::kGlass + 1,
+              "every block type needs a row in BlockRegistry::kProperties");
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_BLOCK_REGISTRY_H
@@ -1,10 +1,13 @@
 #ifndef MINECRAFT_BLOCK_TYPES_H
 #define MINECRAFT_BLOCK_TYPES_H
 
+#include <cstdint>
+
 namespace minecraft {
 
-/// the different block types in this game
-enum BlockTypes { kNone, kGrass, kDirt, kStone };
+/// the different block types in this game. the values index
+/// `BlockRegistry::kProperties`, so new types are appended at the end
+enum BlockTypes : uint8_t { kNone, kGrass, kDirt, kStone, kGlass };
 
 }  // namespace minecraft
 
@@ -5,6 +5,8 @@
 
 #include <string>
 
+#include "renderer.h"
+
 namespace minecraft {
 
 /// the player
@@ -16,9 +18,11 @@ class Camera {
   /// \param terminal_velocity minimum y velocity
   Camera(const ci::vec3& initial_position, float terminal_velocity = -6.0f);
 
-  /// sets up the cinder matrices for this camera and faces towards the current
-  /// forward vector
-  void Render() const;
+  /// sets up the renderer's matrices for this camera and faces towards the
+  /// current forward vector
+  ///
+  /// \param renderer renderer to draw with
+  void Render(Renderer* renderer) const;
 
   /// \return a unit vector in the forwards direction
   ci::vec3 GetForwardVector() const;
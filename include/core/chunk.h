@@ -0,0 +1,152 @@
+#ifndef MINECRAFT_CHUNK_H
+#define MINECRAFT_CHUNK_H
+
+#include <cinder/gl/gl.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "block.h"
+#include "block_types.h"
+#include "chunk_snapshot.h"
+#include "packed_vertex.h"
+
+namespace minecraft {
+
+/// the voxels of one loaded chunk, and the blocks and packed meshes built
+/// from them for rendering. voxels are ordered by x, then y, then z, each
+/// from low to high.
+///
+/// the chunk also keeps the highest solid voxel of each column. it is rebuilt
+/// with the render blocks after bulk writes through `GetVoxels`, and kept up
+/// to date by `SetBlock`, which only searches down a column when its top
+/// block is removed.
+///
+/// the voxels are copy-on-write: `GetSnapshot` shares them with the snapshot,
+/// and the first write afterwards copies them, so readers on other threads
+/// never see a half-applied edit and never block the owner. snapshots must
+/// be taken on the thread that edits the chunk
+class Chunk {
+ public:
+  /// `GetColumnTop` of a column without solid voxels
+  static constexpr int kNoSolidBlock = -1;
+
+  /// creates a chunk filled with air
+  ///
+  /// \param min_corner lowest lattice point in the chunk
+  /// \param width number of blocks along each axis
+  /// \throw std::invalid_argument if `width` exceeds
+  /// `PackedVertex::kMaxChunkWidth`
+  Chunk(const glm::ivec3& min_corner, int width);
+
+  /// reuses this chunk's storage for a chunk elsewhere. the voxels are kept
+  /// until they are overwritten, unless a snapshot shares them, in which case
+  /// the chunk starts over with air in an array from the pool
+  ///
+  /// \param min_corner lowest lattice point of the new chunk
+  void MoveTo(const glm::ivec3& min_corner);
+
+  /// \param position a lattice point
+  /// \return true if and only if the point is inside this chunk
+  bool Contains(const glm::ivec3& position) const;
+
+  /// \param position a lattice point inside this chunk
+  /// \return index of the point in the voxel array
+  size_t GetIndex(const glm::ivec3& position) const;
+
+  /// \param index index in the voxel array
+  /// \return lattice point of the voxel
+  glm::ivec3 GetPosition(size_t index) const;
+
+  /// \param position a lattice point inside this chunk
+  /// \return the block there
+  BlockTypes GetBlockAt(const glm::ivec3& position) const;
+
+  /// sets a voxel and updates its column's top. the render blocks are not
+  /// updated until `RebuildBlocks`, so that many edits to a chunk only
+  /// rebuild it once
+  ///
+  /// \param index index in the voxel array
+  /// \param block_type new block type
+  void SetBlock(size_t index, BlockTypes block_type);
+
+  /// \return the voxel array, copied first if a snapshot shares it. writes
+  /// through it leave the column tops stale until `RebuildBlocks`
+  VoxelArray& GetVoxels();
+  /// \return the voxel array
+  const VoxelArray& GetVoxels() const;
+
+  /// \return an immutable view of the current voxels, without copying them
+  ChunkSnapshot GetSnapshot() const;
+
+  /// \return number of times a write had to copy the voxels because a
+  /// snapshot shared them
+  uint64_t GetCopiesCount() const;
+
+  /// rebuilds the render blocks and mesh from the voxels, recounts the voxels
+  /// that receive random ticks, and rebuilds stale column tops
+  void RebuildBlocks();
+
+  /// reads the index only, never the voxels
+  ///
+  /// \param x column's x coordinate relative to the min corner
+  /// \param z column's z coordinate relative to the min corner
+  /// \return y coordinate, relative to the min corner, of the column's
+  /// highest solid voxel, or `kNoSolidBlock`
+  int GetColumnTop(int x, int z) const;
+
+  /// \return number of voxels that receive random ticks, as of the last
+  /// `RebuildBlocks`
+  size_t GetRandomTickingCount() const;
+
+  /// \return a block for every visible voxel
+  const std::vector<Block>& GetBlocks() const;
+
+  /// \return every face of every visible voxel that is not translucent, as
+  /// of the last `RebuildBlocks`
+  const PackedMesh& GetMesh() const;
+
+  /// \return every face of every translucent voxel, as of the last
+  /// `RebuildBlocks`. kept apart from `GetMesh` so that only these faces
+  /// need blending and sorting
+  const PackedMesh& GetTranslucentMesh() const;
+
+  /// \return lowest lattice point in the chunk
+  glm::ivec3 GetMinCorner() const;
+
+  /// \return number of blocks along each axis
+  int GetWidth() const;
+
+ private:
+  /// lowest lattice point in the chunk
+  glm::ivec3 min_corner_;
+  /// number of blocks along each axis
+  int width_;
+  /// `width_^3` voxels, shared with snapshots
+  std::shared_ptr<VoxelArray> voxels_;
+  /// derived from `voxels_`, see `RebuildBlocks`
+  std::vector<Block> blocks_;
+  /// derived from `voxels_`, see `RebuildBlocks`
+  PackedMesh mesh_;
+  /// derived from `voxels_`, see `RebuildBlocks`
+  PackedMesh translucent_mesh_;
+  /// see `GetColumnTop`, `width_^2` columns ordered by x, then z
+  std::vector<int8_t> column_tops_;
+  /// whether `column_tops_` may disagree with the voxels
+  bool column_tops_stale_;
+  size_t random_ticking_count_;
+  uint64_t copies_count_;
+
+  /// makes `voxels_` exclusive to this chunk before a write
+  void Detach();
+
+  /// updates a column's top after one of its voxels was set
+  ///
+  /// \param index index of the voxel in the voxel array
+  void UpdateColumnTop(size_t index);
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_CHUNK_H
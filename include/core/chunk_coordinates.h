@@ -0,0 +1,34 @@
+#ifndef MINECRAFT_CHUNK_COORDINATES_H
+#define MINECRAFT_CHUNK_COORDINATES_H
+
+namespace minecraft {
+
+/// integer coordinates of a chunk: chunk (x, y, z) is centered on the lattice
+/// point `(x, y, z) * 2 * chunk_radius`, see `World::GetChunk`
+struct ChunkCoordinates {
+  int x;
+  int y;
+  int z;
+
+  bool operator==(const ChunkCoordinates& other) const {
+    return x == other.x && y == other.y && z == other.z;
+  }
+
+  bool operator!=(const ChunkCoordinates& other) const {
+    return !(*this == other);
+  }
+
+  bool operator<(const ChunkCoordinates& other) const {
+    if (x != other.x) {
+      return x < other.x;
+    }
+    if (y != other.y) {
+      return y < other.y;
+    }
+    return z < other.z;
+  }
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_CHUNK_COORDINATES_H
@@ -0,0 +1,136 @@
+#ifndef MINECRAFT_CHUNK_IO_H
+#define MINECRAFT_CHUNK_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace minecraft {
+
+/// what a `ChunkIo` has done so far
+struct ChunkIoStats {
+  /// files read and written
+  uint64_t reads;
+  uint64_t writes;
+  uint64_t bytes_read;
+  uint64_t bytes_written;
+  /// most operations in flight at once
+  size_t max_queue_depth;
+  /// time from submitting a read until it completed, over the last
+  /// `ChunkIo::kLatencySamplesCount` reads
+  double p50_read_seconds;
+  double p99_read_seconds;
+};
+
+/// reads and writes whole chunk files in batches. up to a queue depth of
+/// operations are kept in flight, so a batch waits on the disk about once
+/// per queue depth files instead of once per file, and loading a saved area
+/// is limited by the disk's bandwidth rather than its latency.
+///
+/// on Linux the operations are submitted through an io_uring; where that is
+/// unavailable (other systems, old kernels, or sandboxes that forbid it)
+/// they are run as blocking `pread`/`pwrite` calls on a thread pool. a
+/// `ChunkIo` runs one batch at a time
+class ChunkIo {
+ public:
+  /// how operations are run
+  enum class Backend { kIoUring, kThreadPool };
+
+  /// default of `queue_depth`
+  static constexpr size_t kQueueDepth = 64;
+  /// most threads of the thread pool backend
+  static constexpr size_t kMaxThreads = 16;
+  /// number of read latencies kept for `ChunkIoStats`
+  static constexpr size_t kLatencySamplesCount = 4096;
+
+  /// called with the index of a file in the batch and its contents, which
+  /// may be taken
+  typedef std::function<void(size_t, std::vector<uint8_t>*)> ReadHandler;
+
+  /// \param backend backend to use. `kIoUring` falls back to `kThreadPool`
+  /// if the kernel does not provide it
+  /// \param queue_depth most operations in flight
+  /// \throw std::invalid_argument if the queue depth is 0
+  explicit ChunkIo(Backend backend = Backend::kIoUring,
+                   size_t queue_depth = kQueueDepth);
+
+  /// closes the ring or stops the threads
+  ~ChunkIo();
+
+  ChunkIo(const ChunkIo&) = delete;
+  ChunkIo& operator=(const ChunkIo&) = delete;
+
+  /// reads files, and returns once every one has been handled
+  ///
+  /// \param paths files to read
+  /// \param on_read called on this thread for each file as its read
+  /// completes, in no particular order
+  /// \throw std::runtime_error if a file cannot be read. the reads in flight
+  /// are waited for first
+  void ReadFiles(const std::vector<std::string>& paths,
+                 const ReadHandler& on_read);
+
+  /// replaces the contents of files and syncs them to disk
+  ///
+  /// \param paths files to write, created if missing
+  /// \param contents bytes of each file
+  /// \throw std::invalid_argument if there are not as many contents as paths
+  /// \throw std::runtime_error if a file cannot be written. the writes in
+  /// flight are waited for first
+  void WriteFiles(const std::vector<std::string>& paths,
+                  const std::vector<std::vector<uint8_t>>& contents);
+
+  /// \return the backend in use
+  Backend GetBackend() const;
+
+  /// \return most operations in flight
+  size_t GetQueueDepth() const;
+
+  /// \return what has been done so far; safe to call from any thread
+  ChunkIoStats GetStats() const;
+
+ private:
+  struct Ring;
+  struct Operation;
+
+  Backend backend_;
+  size_t queue_depth_;
+  /// the io_uring, or nullptr
+  std::unique_ptr<Ring> ring_;
+  /// the fallback, or nullptr
+  std::unique_ptr<ThreadPool> thread_pool_;
+
+  /// guards everything below
+  mutable std::mutex mutex_;
+  ChunkIoStats stats_;
+  std::deque<double> latencies_;
+
+  /// runs a batch through the ring
+  ///
+  /// \param operations the batch
+  /// \param on_done called for each operation once it is complete
+  void RunOnRing(std::vector<Operation>* operations,
+                 const std::function<void(Operation*)>& on_done);
+
+  /// runs a batch on the thread pool
+  ///
+  /// \param operations the batch
+  /// \param on_done called for each operation once it is complete
+  void RunOnThreadPool(std::vector<Operation>* operations,
+                       const std::function<void(Operation*)>& on_done);
+
+  /// \param operation a completed operation, added to the stats
+  /// \param in_flight operations in flight when it was submitted
+  void Record(const Operation& operation, size_t in_flight);
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_CHUNK_IO_H
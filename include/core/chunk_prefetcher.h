@@ -0,0 +1,158 @@
+#ifndef MINECRAFT_CHUNK_PREFETCHER_H
+#define MINECRAFT_CHUNK_PREFETCHER_H
+
+#include <cinder/gl/gl.h>
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "chunk.h"
+#include "chunk_coordinates.h"
+#include "thread_pool.h"
+
+namespace minecraft {
+
+class World;
+
+/// what a `ChunkPrefetcher` has done so far
+struct PrefetchStats {
+  /// chunks queued for building
+  uint64_t requested;
+  /// prefetched chunks the world loaded instead of building them itself
+  uint64_t useful;
+  /// useful chunks the world had to wait for, because they were still being
+  /// built
+  uint64_t late;
+  /// prefetched chunks dropped without being loaded, because the player went
+  /// elsewhere or an edit made them stale
+  uint64_t wasted;
+  /// chunks the world had to build itself while the player was moving, i.e.
+  /// chunks that popped in
+  uint64_t misses;
+};
+
+/// builds chunks on a thread pool before the player reaches them, so that
+/// crossing into a new chunk swaps in finished chunks instead of generating
+/// and meshing a slab of them on the spot.
+///
+/// the player's velocity is estimated from its recent trajectory and
+/// extrapolated over a lookahead time; the chunks that would enter the
+/// world's window at the predicted positions, and at the position the player
+/// would reach moving the same distance in the direction it looks, are
+/// queued in order of when they are needed. the lookahead adapts: it grows
+/// when chunks are missed or arrive late, and shrinks when prefetched chunks
+/// are wasted
+class ChunkPrefetcher {
+ public:
+  /// positions kept to estimate the velocity
+  static constexpr size_t kTrajectoryLength = 8;
+  /// most positions predicted along the velocity within the lookahead, a
+  /// chunk apart
+  static constexpr size_t kMaxPredictions = 8;
+  /// most chunks prefetched or being built at a time
+  static constexpr size_t kMaxPrefetched = 64;
+  /// bounds of the lookahead, in seconds
+  static const float kMinLookahead;
+  static const float kMaxLookahead;
+  /// slowest speed, in blocks per second, that counts as moving
+  static const float kMinSpeed;
+
+  /// registers with the world, which then loads prefetched chunks
+  ///
+  /// \param world world to prefetch for, which must outlive this object
+  /// \param thread_pool where chunks are built
+  ChunkPrefetcher(World* world, ThreadPool* thread_pool);
+
+  /// unregisters from the world and waits for the chunks being built
+  ~ChunkPrefetcher();
+
+  ChunkPrefetcher(const ChunkPrefetcher&) = delete;
+  ChunkPrefetcher& operator=(const ChunkPrefetcher&) = delete;
+
+  /// records the player's position, drops prefetched chunks that are no
+  /// longer ahead of the player, and queues the world's pending chunks (see
+  /// `World::StreamChunks`), nearest first, then the chunks predicted next
+  ///
+  /// \param position the player's location
+  /// \param forward the camera's forward vector
+  /// \param seconds time since the previous update
+  void Update(const ci::vec3& position, const ci::vec3& forward,
+              float seconds);
+
+  /// moves a prefetched chunk into a window slot, waiting for it if it is
+  /// still being built. called by the world for every chunk it loads
+  ///
+  /// \param chunk chunk coordinates
+  /// \param voxels the chunk's slot, already moved to the chunk
+  /// \return false if the chunk was not prefetched, and the world has to
+  /// build it
+  bool Take(const ChunkCoordinates& chunk, Chunk* voxels);
+
+  /// \param chunk chunk coordinates
+  /// \return whether the chunk is queued or being built, and not done yet
+  bool IsBuilding(const ChunkCoordinates& chunk) const;
+
+  /// marks a chunk's prefetched copy as stale, e.g. after an edit in it
+  ///
+  /// \param chunk chunk coordinates
+  void Invalidate(const ChunkCoordinates& chunk);
+
+  /// \return estimated velocity, in blocks per second
+  ci::vec3 GetVelocity() const;
+
+  /// \return current lookahead, in seconds
+  float GetLookahead() const;
+
+  /// \return number of chunks prefetched or being built
+  size_t GetPrefetchedCount() const;
+
+  /// \return what the prefetcher has done so far
+  const PrefetchStats& GetStats() const;
+
+ private:
+  /// a chunk prefetched or being built
+  struct Entry {
+    std::unique_ptr<Chunk> chunk;
+    /// ready once `chunk` is built
+    std::future<void> build;
+    /// whether an edit has changed the chunk since it was queued
+    bool stale;
+  };
+
+  World* world_;
+  ThreadPool* thread_pool_;
+  /// last positions and the seconds before each, oldest first once full
+  ci::vec3 trajectory_[kTrajectoryLength];
+  float trajectory_seconds_[kTrajectoryLength];
+  size_t trajectory_count_;
+  size_t trajectory_next_;
+  ci::vec3 velocity_;
+  float lookahead_;
+  std::map<ChunkCoordinates, Entry> entries_;
+  /// dropped entries whose builds have not finished yet
+  std::vector<Entry> retiring_;
+  /// built chunks swapped out of the window, reused for the next builds
+  std::vector<std::unique_ptr<Chunk>> spares_;
+  PrefetchStats stats_;
+
+  /// \return whether the player is moving
+  bool IsMoving() const;
+
+  /// queues a chunk unless it is queued already
+  ///
+  /// \param chunk chunk coordinates
+  void Request(const ChunkCoordinates& chunk);
+
+  /// \param factor factor to scale the lookahead by, within its bounds
+  void ScaleLookahead(float factor);
+
+  /// \param entry an entry whose chunk is to be reused once it is built
+  void Retire(Entry* entry);
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_CHUNK_PREFETCHER_H
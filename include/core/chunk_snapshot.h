@@ -0,0 +1,83 @@
+#ifndef MINECRAFT_CHUNK_SNAPSHOT_H
+#define MINECRAFT_CHUNK_SNAPSHOT_H
+
+#include <cinder/gl/gl.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "block_types.h"
+#include "chunk_coordinates.h"
+#include "memory_pool.h"
+
+namespace minecraft {
+
+/// the voxels of a chunk, allocated from `MemoryPool::GetDefault` so that
+/// unloaded chunks' arrays are recycled for the next ones
+typedef std::vector<BlockTypes, PoolAllocator<BlockTypes>> VoxelArray;
+
+/// an immutable view of a chunk's voxels at one moment. copying it only
+/// copies a reference, and it stays valid and unchanged while the chunk is
+/// edited or unloaded, so it can be handed to another thread
+class ChunkSnapshot {
+ public:
+  /// \param min_corner lowest lattice point in the chunk
+  /// \param width number of blocks along each axis
+  /// \param voxels `width^3` voxels, see `Chunk`
+  ChunkSnapshot(const glm::ivec3& min_corner, int width,
+                const std::shared_ptr<const VoxelArray>& voxels);
+
+  /// \param position a lattice point
+  /// \return true if and only if the point is inside the chunk
+  bool Contains(const glm::ivec3& position) const;
+
+  /// \param position a lattice point inside the chunk
+  /// \return the block there
+  BlockTypes GetBlockAt(const glm::ivec3& position) const;
+
+  /// \return the voxel array, ordered as in `Chunk`
+  const VoxelArray& GetVoxels() const;
+
+  /// \return lowest lattice point in the chunk
+  glm::ivec3 GetMinCorner() const;
+
+  /// \return number of blocks along each axis
+  int GetWidth() const;
+
+ private:
+  glm::ivec3 min_corner_;
+  int width_;
+  std::shared_ptr<const VoxelArray> voxels_;
+};
+
+/// snapshots of a set of chunks taken at the same moment, see `ChunkSnapshot`
+class WorldSnapshot {
+ public:
+  /// \param chunk_radius radius of the chunks, see `world.h`
+  explicit WorldSnapshot(size_t chunk_radius);
+
+  /// \param chunk chunk coordinates
+  /// \param snapshot the chunk's snapshot
+  void Add(const ChunkCoordinates& chunk, const ChunkSnapshot& snapshot);
+
+  /// \param chunk chunk coordinates
+  /// \return the chunk's snapshot, or nullptr if it is not in this snapshot
+  const ChunkSnapshot* Find(const ChunkCoordinates& chunk) const;
+
+  /// \param position a lattice point
+  /// \param block_type output block type
+  /// \return false if and only if the point's chunk is not in this snapshot
+  bool GetBlockAt(const glm::ivec3& position, BlockTypes* block_type) const;
+
+  /// \return every chunk in this snapshot
+  const std::map<ChunkCoordinates, ChunkSnapshot>& GetChunks() const;
+
+ private:
+  int chunk_radius_;
+  std::map<ChunkCoordinates, ChunkSnapshot> chunks_;
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_CHUNK_SNAPSHOT_H
@@ -0,0 +1,107 @@
+#ifndef MINECRAFT_CHUNK_WINDOW_H
+#define MINECRAFT_CHUNK_WINDOW_H
+
+#include <functional>
+#include <vector>
+
+#include "chunk.h"
+#include "chunk_coordinates.h"
+
+namespace minecraft {
+
+/// the loaded chunks: a cube of `(2 * radius + 1)^3` chunk slots around a
+/// center chunk, kept as a toroidal ring buffer. chunk `c` always lives in
+/// slot `c mod size` along each axis, so moving the center only reloads the
+/// slots that wrap around to the newly exposed side, and no slot, chunk or
+/// voxel array is ever allocated after construction
+class ChunkWindow {
+ public:
+  /// one chunk slot
+  struct Slot {
+    /// which chunk the slot holds, if it is loaded
+    ChunkCoordinates coordinates;
+    bool loaded;
+    Chunk chunk;
+  };
+
+  /// called to fill a slot with a chunk; the chunk's min corner is already
+  /// set, its voxels are those of the chunk the slot held before
+  typedef std::function<void(const ChunkCoordinates&, Chunk*)> Loader;
+
+  /// decides whether a newly exposed chunk is left for `LoadPending`
+  typedef std::function<bool(const ChunkCoordinates&)> Deferral;
+
+  /// creates a window with every slot unloaded
+  ///
+  /// \param radius chunks on each side of the center
+  /// \param chunk_radius radius of each chunk, see `World`
+  ChunkWindow(int radius, int chunk_radius);
+
+  /// moves the window so it is centered on `center`, loading only the chunks
+  /// that were not in the window before. the first call loads every slot
+  ///
+  /// \param center new center chunk
+  /// \param load fills newly exposed slots
+  /// \param defer if set, newly exposed chunks it returns true for are not
+  /// loaded but left pending, see `LoadPending`
+  void Recenter(const ChunkCoordinates& center, const Loader& load,
+                const Deferral& defer = nullptr);
+
+  /// loads a pending chunk, i.e. one in the window whose loading was
+  /// deferred
+  ///
+  /// \param coordinates a chunk
+  /// \param load fills the chunk's slot
+  /// \return false if the chunk is not pending
+  bool LoadPending(const ChunkCoordinates& coordinates, const Loader& load);
+
+  /// \return the pending chunks, in no particular order
+  std::vector<ChunkCoordinates> GetPending() const;
+
+  /// \param coordinates a chunk
+  /// \return the chunk if it is loaded, otherwise `nullptr`
+  Chunk* Find(const ChunkCoordinates& coordinates);
+
+  /// \param coordinates a chunk
+  /// \return the chunk if it is loaded, otherwise `nullptr`
+  const Chunk* Find(const ChunkCoordinates& coordinates) const;
+
+  /// \return every slot, in no particular order
+  const std::vector<Slot>& GetSlots() const;
+
+  /// \return the center chunk
+  const ChunkCoordinates& GetCenter() const;
+
+  /// \return chunks on each side of the center
+  int GetRadius() const;
+
+ private:
+  int radius_;
+  /// slots along each axis
+  int size_;
+  int chunk_radius_;
+  ChunkCoordinates center_;
+  /// whether `Recenter` has been called
+  bool centered_;
+  std::vector<Slot> slots_;
+
+  /// \param coordinates a chunk
+  /// \return whether the chunk is within `radius_` of `center_`
+  bool IsInWindow(const ChunkCoordinates& coordinates) const;
+
+  /// \param coordinates a chunk
+  /// \return index of the chunk's slot
+  size_t GetSlotIndex(const ChunkCoordinates& coordinates) const;
+
+  /// loads a chunk into its slot, or marks it pending if `defer` says so
+  void Load(const ChunkCoordinates& coordinates, const Loader& load,
+            const Deferral& defer);
+
+  /// loads the chunks with coordinates in `[low, high]` on every axis
+  void LoadRange(const ChunkCoordinates& low, const ChunkCoordinates& high,
+                 const Loader& load, const Deferral& defer);
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_CHUNK_WINDOW_H
@@ -0,0 +1,196 @@
+#ifndef MINECRAFT_EDIT_JOURNAL_H
+#define MINECRAFT_EDIT_JOURNAL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "chunk_coordinates.h"
+#include "chunk_io.h"
+#include "region.h"
+
+namespace minecraft {
+
+/// persistence cost and progress of an `EditJournal`
+struct JournalStats {
+  /// edits passed to `Append`
+  uint64_t edits_appended;
+  /// appended edits that have been synced to disk
+  uint64_t edits_durable;
+  /// bytes written to the journal file
+  uint64_t bytes_written;
+  /// number of syncs of the journal file
+  uint64_t syncs;
+  /// number of checkpoints that wrote anything, including the one made on
+  /// opening a save with a non-empty journal
+  uint64_t checkpoints;
+  /// time the writer thread spent writing, syncing and checkpointing
+  double writer_seconds;
+  /// time the appending thread spent in `Append`
+  double append_seconds;
+  /// 99th percentile of the time from `Append` until the batch was synced,
+  /// over the last `EditJournal::kLatencySamplesCount` batches
+  double p99_durable_seconds;
+  /// reads of the chunk store on opening and writes of its checkpoints
+  ChunkIoStats chunk_io;
+
+  /// \return durable edits per second of writer time
+  double GetThroughput() const;
+};
+
+/// crash-safe storage of block edits. appended edits are written to a journal
+/// file by a background thread and synced at most `sync_interval` seconds
+/// later. once the journal grows past `checkpoint_bytes` it is folded into
+/// the chunk store, one file of edits per chunk, and emptied.
+///
+/// on opening, the chunk store is read and the journal is replayed on top of
+/// it up to the first incomplete or corrupt record, which is where a crash
+/// would have torn it. the result is available from `GetRecoveredEdits`.
+/// the chunk files are read, and checkpointed, in batches through a
+/// `ChunkIo`, so opening a large save is not one disk round trip per chunk.
+///
+/// layout of `directory`:
+/// - `journal`: records of `u32 size, u32 checksum, size bytes`, each holding
+///   the edits of one `Append` as `i32 x, i32 y, i32 z, u8 block type`
+/// - `chunks/X_Y_Z`: `u32 count`, `count` edits as above, `u32 checksum`.
+///   replaced atomically by renaming
+class EditJournal {
+ public:
+  /// opens or creates a save, recovers its edits and starts the writer
+  ///
+  /// \param directory save directory, created if missing
+  /// \param chunk_radius radius of the world's chunks, see `world.h`
+  /// \param sync_interval longest time in seconds an appended edit waits to be
+  /// synced
+  /// \param checkpoint_bytes journal size that triggers a checkpoint
+  /// \throw std::runtime_error if the save cannot be read or created
+  EditJournal(const std::string& directory, size_t chunk_radius,
+              double sync_interval = kSyncInterval,
+              size_t checkpoint_bytes = kCheckpointBytes);
+
+  /// makes every appended edit durable, checkpoints and stops the writer
+  ~EditJournal();
+
+  EditJournal(const EditJournal&) = delete;
+  EditJournal& operator=(const EditJournal&) = delete;
+
+  /// \return every edit in the save when it was opened
+  const std::vector<BlockEdit>& GetRecoveredEdits() const;
+
+  /// queues edits for the writer thread. only copies them, so it is cheap
+  /// enough to call from the frame or tick that made them
+  ///
+  /// \param changes blocks that changed, see `World::ApplyEdits`
+  /// \throw std::runtime_error if the writer has failed
+  void Append(const std::vector<BlockChange>& changes);
+
+  /// blocks until every edit appended so far is durable
+  ///
+  /// \throw std::runtime_error if the writer has failed
+  void Flush();
+
+  /// blocks until every edit appended so far is in the chunk store and the
+  /// journal is empty
+  ///
+  /// \throw std::runtime_error if the writer has failed
+  void Checkpoint();
+
+  /// \return persistence statistics
+  JournalStats GetStats() const;
+
+  /// default of `sync_interval`
+  static constexpr double kSyncInterval = 0.05;
+  /// default of `checkpoint_bytes`
+  static constexpr size_t kCheckpointBytes = 1 << 20;
+  /// number of batch latencies kept for `JournalStats::p99_durable_seconds`
+  static constexpr size_t kLatencySamplesCount = 4096;
+
+ private:
+  typedef std::chrono::steady_clock::time_point TimePoint;
+
+  /// the edits of one `Append`
+  struct Batch {
+    std::vector<BlockEdit> edits;
+    TimePoint appended;
+  };
+
+  /// method of hashing lattice points
+  struct PositionHasher {
+    size_t operator()(const glm::ivec3& position) const;
+  };
+  typedef std::unordered_map<glm::ivec3, BlockTypes, PositionHasher>
+      ChunkEdits;
+
+  std::string directory_;
+  int chunk_width_;
+  /// reads and writes the chunk store
+  ChunkIo chunk_io_;
+  double sync_interval_;
+  size_t checkpoint_bytes_;
+  /// descriptor of the journal file
+  int journal_;
+  std::vector<BlockEdit> recovered_edits_;
+
+  /// every edit in the save, as of the last write. owned by the writer
+  /// thread once it runs
+  std::map<ChunkCoordinates, ChunkEdits> edits_;
+  /// chunks with edits that are only in the journal
+  std::set<ChunkCoordinates> dirty_chunks_;
+  /// size of the journal file
+  size_t journal_bytes_;
+
+  /// guards everything below
+  mutable std::mutex mutex_;
+  /// wakes the writer
+  std::condition_variable writer_condition_;
+  /// wakes `Flush` and `Checkpoint`
+  std::condition_variable done_condition_;
+  std::deque<Batch> pending_;
+  bool stopping_;
+  /// batches appended, and synced, so far
+  uint64_t appended_batches_;
+  uint64_t durable_batches_;
+  /// last batch that `Flush` waits for
+  uint64_t sync_requested_;
+  /// checkpoints requested by `Checkpoint`, and completed since opening
+  uint64_t requested_checkpoints_;
+  uint64_t completed_checkpoints_;
+  JournalStats stats_;
+  std::deque<double> latencies_;
+  /// what made the writer stop, or empty
+  std::string error_;
+  /// nanoseconds spent in `Append`; updated without taking `mutex_`
+  std::atomic<uint64_t> append_nanoseconds_;
+
+  std::thread writer_;
+
+  /// writer loop: writes queued batches, syncs them when the oldest has
+  /// waited `sync_interval_` or someone waits for it, and checkpoints
+  void Run();
+
+  /// reads the chunk store and replays the journal into `edits_`, marking
+  /// the chunks the journal touched as dirty
+  void Recover();
+
+  /// writes the dirty chunks to the chunk store and empties the journal
+  void WriteCheckpoint();
+
+  /// \param edit an edit to record in `edits_`
+  void Remember(const BlockEdit& edit);
+
+  /// \return path of a chunk's file in the chunk store
+  std::string GetChunkPath(const ChunkCoordinates& chunk) const;
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_EDIT_JOURNAL_H
@@ -0,0 +1,84 @@
+#ifndef MINECRAFT_ENTITY_PHYSICS_H
+#define MINECRAFT_ENTITY_PHYSICS_H
+
+#include <cinder/gl/gl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "entity_scheduler.h"
+#include "entity_store.h"
+#include "region.h"
+#include "spatial_hash.h"
+#include "world.h"
+
+namespace minecraft {
+
+/// the systems that move entities: gravity and collisions with the blocks of
+/// a `World`, then collisions with each other through a `SpatialHash`.
+/// blocks outside the loaded chunks count as solid, so entities wait at the
+/// edge of the world until it is loaded
+class EntityPhysics {
+ public:
+  /// acceleration downwards, in blocks per second squared
+  static const float kGravity;
+  /// gap kept between an entity and the block that stopped it, so that
+  /// resting entities touch nothing
+  static const float kSkin;
+
+  /// \param world blocks the entities collide with
+  /// \param cell_size cell of the broadphase, at least the widest entity
+  /// \throw std::invalid_argument if the size is not positive
+  EntityPhysics(World* world, float cell_size);
+
+  /// applies gravity, then moves each entity by its velocity one axis at a
+  /// time, vertical first. an entity stops at the first solid block in the
+  /// way, however fast it goes, and its velocity along that axis is zeroed
+  ///
+  /// \param store entities to move
+  /// \param seconds length of the step
+  void Move(EntityStore* store, float seconds);
+
+  /// pushes overlapping entities apart horizontally, each by half the
+  /// overlap, along the axis they overlap the least on, without pushing any
+  /// into a block
+  ///
+  /// \param store entities to separate
+  /// \throw std::invalid_argument if an entity is wider than a cell
+  void Separate(EntityStore* store);
+
+  /// adds `Separate` and then `Move` to a scheduler
+  ///
+  /// \param scheduler the scheduler, which must not outlive this
+  void AddSystems(EntityScheduler* scheduler);
+
+  /// \return number of overlapping pairs found by the last `Separate`
+  size_t GetPairsCount() const;
+
+ private:
+  World* world_;
+  SpatialHash broadphase_;
+  std::vector<std::pair<uint32_t, uint32_t>> pairs_;
+  /// blocks of the loaded chunks, during a step
+  BlockBox loaded_bounds_;
+
+  /// moves a box along an axis, up to the first block in the way
+  ///
+  /// \param axis 0, 1 or 2 for x, y or z
+  /// \param distance signed distance to move
+  /// \param position center of the box, updated
+  /// \param half_extents half the size of the box
+  /// \return false if and only if a block stopped the box
+  bool MoveAlong(int axis, float distance, glm::vec3* position,
+                 const glm::vec3& half_extents);
+
+  /// \param position a lattice point
+  /// \return true if and only if an entity cannot be there
+  bool IsBlocked(const glm::ivec3& position);
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_ENTITY_PHYSICS_H
@@ -0,0 +1,83 @@
+#ifndef MINECRAFT_ENTITY_SCHEDULER_H
+#define MINECRAFT_ENTITY_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "entity_store.h"
+
+namespace minecraft {
+
+/// runs the systems of an `EntityStore` in fixed steps, whatever the frame
+/// rate, so entities move the same at 30 and at 144 frames per second. time
+/// left over from a frame is carried into the next one
+class EntityScheduler {
+ public:
+  /// a system: updates some components of every entity over a step of the
+  /// given number of seconds
+  typedef std::function<void(EntityStore*, float)> System;
+
+  /// \param step_seconds length of a step
+  /// \param max_steps most steps run by one `Advance`. after a long stall the
+  /// entities skip ahead rather than make the next frames slower still
+  /// \throw std::invalid_argument if the step is not positive or no steps are
+  /// allowed
+  EntityScheduler(float step_seconds, size_t max_steps);
+
+  /// adds a system, run after those added before it
+  ///
+  /// \param name name of the system, for `GetSystemSeconds`
+  /// \param system the system
+  void AddSystem(const std::string& name, const System& system);
+
+  /// runs the steps that became due
+  ///
+  /// \param store entities to update
+  /// \param elapsed_seconds time since the last call
+  /// \return number of steps run
+  size_t Advance(EntityStore* store, float elapsed_seconds);
+
+  /// runs one step right away
+  ///
+  /// \param store entities to update
+  void Step(EntityStore* store);
+
+  /// \return length of a step
+  float GetStepSeconds() const;
+
+  /// \return number of steps run so far
+  uint64_t GetStepsCount() const;
+
+  /// \return fraction of a step carried into the next `Advance`, to
+  /// interpolate the entities' positions by when drawing them
+  float GetInterpolation() const;
+
+  /// \return names of the systems, in the order they run
+  std::vector<std::string> GetSystemNames() const;
+
+  /// \param name name of a system
+  /// \return seconds spent running it so far
+  /// \throw std::invalid_argument if there is no system with the name
+  double GetSystemSeconds(const std::string& name) const;
+
+ private:
+  struct ScheduledSystem {
+    std::string name;
+    System run;
+    double seconds;
+  };
+
+  float step_seconds_;
+  size_t max_steps_;
+  std::vector<ScheduledSystem> systems_;
+  /// time not yet stepped through
+  float pending_seconds_;
+  uint64_t steps_count_;
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_ENTITY_SCHEDULER_H
@@ -0,0 +1,94 @@
+#ifndef MINECRAFT_ENTITY_STORE_H
+#define MINECRAFT_ENTITY_STORE_H
+
+#include <cinder/gl/gl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace minecraft {
+
+/// a handle to an entity of an `EntityStore`. indices of destroyed entities
+/// are reused with a new generation, so stale handles stay invalid
+struct Entity {
+  uint32_t index;
+  uint32_t generation;
+
+  bool operator==(const Entity& other) const {
+    return index == other.index && generation == other.generation;
+  }
+  bool operator!=(const Entity& other) const {
+    return !(*this == other);
+  }
+};
+
+/// the moving objects of the world (mobs, dropped items, ...), stored as a
+/// structure of arrays: each component is its own array, indexed by slot, and
+/// the live entities occupy slots `[0, GetCount())` without gaps. systems loop
+/// over just the arrays they need, front to back.
+///
+/// destroying an entity moves the last one into its slot, so slots change and
+/// are only valid until the next `Destroy`; `Entity` handles stay valid
+class EntityStore {
+ public:
+  /// \param position center of the entity's box
+  /// \param half_extents half the size of its box along each axis
+  /// \return a handle to the new entity, at rest in slot `GetCount() - 1`
+  Entity Create(const glm::vec3& position, const glm::vec3& half_extents);
+
+  /// \param entity a handle
+  /// \return false if the entity was already destroyed
+  bool Destroy(const Entity& entity);
+
+  /// \param entity a handle
+  /// \return true if and only if the entity has not been destroyed
+  bool IsAlive(const Entity& entity) const;
+
+  /// \return number of live entities
+  size_t GetCount() const;
+
+  /// \param entity a live entity
+  /// \return its slot in the component arrays
+  /// \throw std::invalid_argument if the entity was destroyed
+  size_t GetSlot(const Entity& entity) const;
+
+  /// \param slot below `GetCount()`
+  /// \return the entity in the slot
+  Entity GetEntity(size_t slot) const;
+
+  /// \return centers of the boxes, in blocks
+  glm::vec3* GetPositions();
+  const glm::vec3* GetPositions() const;
+
+  /// \return velocities, in blocks per second
+  glm::vec3* GetVelocities();
+  const glm::vec3* GetVelocities() const;
+
+  /// \return half the size of the boxes
+  glm::vec3* GetHalfExtents();
+  const glm::vec3* GetHalfExtents() const;
+
+  /// \return 1 for the entities that rest on a solid block, 0 for the others
+  uint8_t* GetOnGround();
+  const uint8_t* GetOnGround() const;
+
+ private:
+  /// components, by slot
+  std::vector<glm::vec3> positions_;
+  std::vector<glm::vec3> velocities_;
+  std::vector<glm::vec3> half_extents_;
+  std::vector<uint8_t> on_ground_;
+  /// handle of the entity in each slot
+  std::vector<Entity> entities_;
+
+  /// by index: slot of the entity, and generation of the live or next entity
+  std::vector<uint32_t> slots_;
+  std::vector<uint32_t> generations_;
+  /// indices of destroyed entities, to reuse
+  std::vector<uint32_t> free_indices_;
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_ENTITY_STORE_H
@@ -0,0 +1,53 @@
+#ifndef MINECRAFT_GL_RENDERER_H
+#define MINECRAFT_GL_RENDERER_H
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "renderer.h"
+
+namespace minecraft {
+
+/// draws with cinder's OpenGL helpers. packed meshes are uploaded once per
+/// revision and decoded by a vertex shader
+class GlRenderer : public Renderer {
+ public:
+  GlRenderer();
+
+  void Clear() override;
+  void SetWindowMatrices(const glm::ivec2& size) override;
+  void SetCamera(const ci::vec3& eye, const ci::vec3& forward) override;
+  void DrawMesh(const ci::TriMesh& mesh) override;
+  void DrawPackedMesh(const PackedMesh& mesh) override;
+  void DrawTranslucentPackedMesh(const PackedMesh& mesh) override;
+  void DrawStrokedCube(const ci::vec3& center, const ci::vec3& size) override;
+  void DrawTexture(const ci::gl::Texture2dRef& texture,
+                   const ci::Rectf& bounds) override;
+
+ private:
+  /// a packed mesh on the GPU
+  struct Upload {
+    /// `PackedMesh::GetRevision` when it was uploaded
+    uint64_t revision;
+    ci::gl::VaoRef vao;
+    ci::gl::VboRef vertices;
+    /// the frame it was last drawn in
+    uint64_t frame;
+  };
+
+  /// decodes `PackedVertex`, created on first use
+  ci::gl::GlslProgRef packed_shader_;
+  /// the index pattern of `quads_count_` quads, shared by every packed mesh
+  ci::gl::VboRef quad_indices_;
+  size_t quads_count_;
+  std::unordered_map<const PackedMesh*, Upload> uploads_;
+  /// frames cleared so far
+  uint64_t frame_;
+
+  /// grows `quad_indices_` to at least `quads_count` quads
+  void ReserveQuads(size_t quads_count);
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_GL_RENDERER_H
@@ -0,0 +1,110 @@
+#ifndef MINECRAFT_HEADLESS_RENDERER_H
+#define MINECRAFT_HEADLESS_RENDERER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "renderer.h"
+
+namespace minecraft {
+
+/// what a `HeadlessRenderer` was asked to draw, accumulated over frames
+struct RenderStats {
+  size_t draw_calls;
+  size_t triangles;
+  size_t vertices;
+  /// bytes of vertex and index data the draw calls read
+  size_t geometry_bytes;
+  /// number of times the pipeline (shader and bound texture) had to change
+  size_t state_changes;
+  /// fragments produced by the software raster, hidden or not
+  size_t fragments;
+  /// fragments that passed the depth test when they were drawn
+  size_t visible_fragments;
+  /// visible fragments of translucent geometry, which blend instead of
+  /// writing depth
+  size_t blended_fragments;
+  /// pixels with at least one fragment, summed over frames
+  size_t covered_pixels;
+
+  /// \return average fragments per covered pixel
+  double GetDepthComplexity() const;
+
+  /// \return average fragments written per covered pixel; 1 means every
+  /// pixel was written once, as with perfect front-to-back order
+  double GetOverdraw() const;
+};
+
+/// a renderer without a GPU, for tests and benchmarks. it counts draw calls,
+/// geometry and pipeline changes, and can optionally rasterize the depth of
+/// every mesh triangle into a small software depth buffer to measure depth
+/// complexity and overdraw
+class HeadlessRenderer : public Renderer {
+ public:
+  /// vertical field of view of `SetCamera`, matching `ci::CameraPersp`
+  static const float kFieldOfView;
+  /// near clipping plane of `SetCamera`
+  static const float kNearPlane;
+  /// far clipping plane of `SetCamera`
+  static const float kFarPlane;
+
+  /// \param raster_size size of the software depth buffer, or zero to only
+  /// count draw calls
+  explicit HeadlessRenderer(const glm::ivec2& raster_size = glm::ivec2(0));
+
+  void Clear() override;
+  void SetWindowMatrices(const glm::ivec2& size) override;
+  void SetCamera(const ci::vec3& eye, const ci::vec3& forward) override;
+  void DrawMesh(const ci::TriMesh& mesh) override;
+  void DrawPackedMesh(const PackedMesh& mesh) override;
+  void DrawTranslucentPackedMesh(const PackedMesh& mesh) override;
+  void DrawStrokedCube(const ci::vec3& center, const ci::vec3& size) override;
+  void DrawTexture(const ci::gl::Texture2dRef& texture,
+                   const ci::Rectf& bounds) override;
+
+  /// \return statistics since construction or the last `ResetStats`
+  const RenderStats& GetStats() const;
+
+  /// zeroes the statistics
+  void ResetStats();
+
+ private:
+  /// shader and texture combination of a draw call
+  enum class Pipeline { kNone, kAtlas, kBlendedAtlas, kLines, kOverlay };
+
+  glm::ivec2 raster_size_;
+  /// projection times view of the last `SetCamera`
+  glm::mat4 view_projection_;
+  /// whether the raster is in the perspective view
+  bool perspective_;
+  Pipeline pipeline_;
+  /// normalized device depth of the nearest fragment of each pixel
+  std::vector<float> depth_;
+  /// fragments of each pixel in the current frame
+  std::vector<uint32_t> fragments_;
+  RenderStats stats_;
+
+  /// counts a draw call, and a state change if it needs another pipeline
+  ///
+  /// \param geometry_bytes see `RenderStats::geometry_bytes`
+  void Draw(Pipeline pipeline, size_t triangles, size_t vertices,
+            size_t geometry_bytes);
+
+  /// rasterizes the quads of a packed mesh, see `RasterizeTriangle`
+  ///
+  /// \param mesh packed quads
+  /// \param blended whether the fragments blend rather than write depth
+  void RasterizePackedMesh(const PackedMesh& mesh, bool blended);
+
+  /// rasterizes a triangle into the depth buffer. triangles that cross the
+  /// near plane are skipped rather than clipped
+  ///
+  /// \param corners world positions of the corners
+  /// \param blended whether the fragments are depth-tested only, and
+  /// counted as `RenderStats::blended_fragments`
+  void RasterizeTriangle(const ci::vec3 corners[3], bool blended = false);
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_HEADLESS_RENDERER_H
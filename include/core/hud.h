@@ -0,0 +1,90 @@
+#ifndef MINECRAFT_HUD_H
+#define MINECRAFT_HUD_H
+
+#include <cinder/gl/gl.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "block_types.h"
+#include "renderer.h"
+
+namespace minecraft {
+
+/// retained 2d overlay. every element keeps its own texture, which is only
+/// rasterized again when the element's content changes, so frames where
+/// nothing changes just draw the cached textures
+class Hud {
+ public:
+  /// \param font font of the text elements
+  /// \param color color of the text elements
+  Hud(const ci::Font& font, const ci::Color& color);
+
+  /// adds a text element, showing `label` followed by its value, if it has
+  /// one (see `SetValue`)
+  ///
+  /// \param position top left corner, in window coordinates
+  /// \param label constant part of the text
+  /// \return handle of the element
+  size_t AddText(const ci::vec2& position, const std::string& label);
+
+  /// adds a block icon element
+  ///
+  /// \param bounds where to draw the icon, in window coordinates
+  /// \param block_type block type with an icon
+  /// \return handle of the element
+  size_t AddIcon(const ci::Rectf& bounds, BlockTypes block_type);
+
+  /// sets the number shown after the label of a text element. only a value
+  /// that differs from the current one causes the text to be rasterized again
+  ///
+  /// \param element handle of a text element
+  /// \param value number to show
+  void SetValue(size_t element, int64_t value);
+
+  /// \param element handle of an element
+  /// \param visible whether the element is drawn
+  void SetVisible(size_t element, bool visible);
+
+  /// rasterizes the elements that changed and draws every visible element
+  ///
+  /// \param renderer renderer to draw with
+  void Draw(Renderer* renderer);
+
+  /// \return number of times an element's texture has been rasterized
+  size_t GetRasterizedCount() const;
+
+ private:
+  struct Element {
+    /// top left corner and, for icons, bottom right corner
+    ci::Rectf bounds;
+    bool is_icon;
+    BlockTypes block_type;
+    std::string label;
+    bool has_value;
+    int64_t value;
+    bool visible;
+    /// whether `texture` is out of date
+    bool dirty;
+    ci::gl::Texture2dRef texture;
+  };
+
+  ci::Font font_;
+  ci::Color color_;
+  std::vector<Element> elements_;
+  size_t rasterized_count_;
+
+  /// \param element an element
+  /// \return the text of a text element
+  static std::string GetText(const Element& element);
+
+  /// \param text a line of text
+  /// \return the text drawn with `font_` and `color_` on a transparent
+  /// background
+  ci::gl::Texture2dRef RasterizeText(const std::string& text) const;
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_HUD_H
@@ -0,0 +1,152 @@
+#ifndef MINECRAFT_LOD_H
+#define MINECRAFT_LOD_H
+
+#include <cinder/gl/gl.h>
+
+#include <future>
+#include <map>
+#include <vector>
+
+#include "block_types.h"
+#include "region.h"
+#include "renderer.h"
+#include "terrain_generator.h"
+#include "thread_pool.h"
+#include "world.h"
+
+namespace minecraft {
+
+/// level-of-detail geometry for terrain beyond the loaded chunks.
+///
+/// space is split into cubic tiles of `kTileCells`^3 cells. a tile at level
+/// `l` (1 to `kLevelsCount`) has cells of `2^l` voxels per side, so each
+/// level covers eight times the volume of the one below at the same cost.
+/// tiles are picked like an octree: coarse tiles near the camera, or that
+/// touch the loaded chunks, are replaced by their eight children, down to
+/// level 1. cells inside the loaded chunks are left out, since the world
+/// draws those at full detail.
+///
+/// meshes are built on a thread pool from a snapshot of the terrain and the
+/// player edits, and swapped in by `Update` when they are done. the previous
+/// mesh of a tile is drawn until its replacement is ready.
+///
+/// neighboring tiles, especially of different levels, do not agree on the
+/// height of the terrain. to avoid cracks, surface cells on the boundary of a
+/// tile always get their outward faces ("skirts"), which hang down into the
+/// gap
+class LodManager {
+ public:
+  /// cells along each side of a tile
+  static const int kTileCells;
+  /// number of detail levels; the coarsest has cells of `2^kLevelsCount`
+  static const int kLevelsCount;
+  /// a tile is split into its children while the camera is closer than this
+  /// many tile widths
+  static const float kRefineDistance;
+
+  /// \param world world to mirror, which must outlive this object
+  /// \param thread_pool where meshes are built
+  /// \param view_distance tiles beyond this distance are not drawn
+  LodManager(World* world, ThreadPool* thread_pool, float view_distance);
+
+  /// picks the tiles to draw for a camera position, queues builds for the
+  /// tiles that need new meshes, and swaps in finished meshes
+  ///
+  /// \param eye camera position
+  void Update(const ci::vec3& eye);
+
+  /// draws the picked tiles that have a mesh
+  ///
+  /// \param renderer renderer to draw with
+  void Render(Renderer* renderer) const;
+
+  /// \param view_distance tiles beyond this distance are not drawn, from the
+  /// next `Update` on
+  void SetViewDistance(float view_distance);
+
+  /// limits the builds `Update` queues. tiles over the limit keep their
+  /// previous mesh, if any, and are queued by later updates
+  ///
+  /// \param builds_count most builds queued per `Update`
+  void SetMaxBuildsPerUpdate(size_t builds_count);
+
+  /// rebuilds the tiles that overlap a box, e.g. after edits there
+  ///
+  /// \param box a box
+  void Invalidate(const BlockBox& box);
+
+  /// \return number of picked tiles
+  size_t GetTilesCount() const;
+
+  /// \return number of tiles with a build in progress
+  size_t GetPendingBuildsCount() const;
+
+  /// \return triangles of the picked tiles that have a mesh
+  size_t GetTrianglesCount() const;
+
+  /// builds the mesh of one tile
+  ///
+  /// \param terrain_generator terrain of the tile, called from a worker
+  /// \param edits player edits inside the tile
+  /// \param level detail level, at least 1
+  /// \param min_corner lowest lattice point of the tile
+  /// \param excluded cells entirely inside this box are left empty
+  /// \return the tile's faces, including skirts
+  static ci::TriMesh BuildTileMesh(TerrainGenerator* terrain_generator,
+                                   const std::vector<BlockEdit>& edits,
+                                   int level, const glm::ivec3& min_corner,
+                                   const BlockBox& excluded);
+
+ private:
+  struct TileKey {
+    int level;
+    glm::ivec3 coordinates;
+
+    bool operator<(const TileKey& other) const {
+      if (level != other.level) {
+        return level < other.level;
+      }
+      if (coordinates.x != other.coordinates.x) {
+        return coordinates.x < other.coordinates.x;
+      }
+      if (coordinates.y != other.coordinates.y) {
+        return coordinates.y < other.coordinates.y;
+      }
+      return coordinates.z < other.coordinates.z;
+    }
+  };
+
+  struct Tile {
+    ci::TriMesh mesh;
+    bool has_mesh = false;
+    /// the excluded box the current mesh or build was made with
+    BlockBox excluded = BlockBox{glm::ivec3(0), glm::ivec3(-1)};
+    /// whether the tile must be rebuilt even if `excluded` still matches
+    bool stale = false;
+    std::future<ci::TriMesh> build;
+    /// whether the tile was picked by the last `Update`
+    bool picked = false;
+  };
+
+  World* world_;
+  ThreadPool* thread_pool_;
+  float view_distance_;
+  size_t max_builds_per_update_;
+  /// builds the current `Update` may still queue
+  size_t builds_left_;
+  std::map<TileKey, Tile> tiles_;
+
+  /// \param key a tile
+  /// \return lattice points covered by the tile
+  static BlockBox GetTileBounds(const TileKey& key);
+
+  /// picks a tile or, if it is too close, its children
+  void Pick(const TileKey& key, const ci::vec3& eye, const BlockBox& loaded);
+
+  /// queues a build of a tile
+  void Build(const TileKey& key, Tile* tile, const BlockBox& excluded);
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_LOD_H
@@ -0,0 +1,121 @@
+#ifndef MINECRAFT_MEMORY_POOL_H
+#define MINECRAFT_MEMORY_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace minecraft {
+
+/// what a `MemoryPool` has handed out so far
+struct MemoryStats {
+  /// bytes allocated and not yet freed, rounded up to size classes
+  uint64_t live_bytes;
+  /// highest `live_bytes` so far
+  uint64_t peak_bytes;
+  /// calls of `Allocate`
+  uint64_t allocations;
+  /// calls of `Allocate` that had to go to the heap, because no freed block
+  /// of the size class was left
+  uint64_t heap_allocations;
+};
+
+/// recycles memory by size class. requests are rounded up to a power of two;
+/// freed blocks go on a free list of their class instead of back to the heap,
+/// and later requests of the class take them from there. so once a workload
+/// has reached its peak, repeating it (e.g. streaming chunks in and out)
+/// allocates nothing from the heap, and the heap does not fragment over long
+/// sessions. thread safe
+class MemoryPool {
+ public:
+  /// smallest size class
+  static constexpr size_t kMinBlockSize = 16;
+  /// largest size class; larger requests go to the heap every time
+  static constexpr size_t kMaxBlockSize = size_t(1) << 24;
+
+  MemoryPool();
+  MemoryPool(const MemoryPool&) = delete;
+  MemoryPool& operator=(const MemoryPool&) = delete;
+
+  /// returns the cached blocks to the heap. blocks still allocated must not
+  /// be freed afterwards
+  ~MemoryPool();
+
+  /// \param bytes size of the block
+  /// \return a block of at least `bytes` bytes, aligned for any type
+  /// \throw std::bad_alloc if the heap is exhausted
+  void* Allocate(size_t bytes);
+
+  /// \param block block returned by `Allocate`
+  /// \param bytes size passed to `Allocate`
+  void Deallocate(void* block, size_t bytes);
+
+  /// \return what the pool has handed out so far
+  MemoryStats GetStats() const;
+
+  /// \return bytes on free lists, waiting to be reused
+  size_t GetCachedBytes() const;
+
+  /// \return the pool chunk voxels, meshes and edits are allocated from.
+  /// never destroyed, so it outlives every static object using it
+  static MemoryPool& GetDefault();
+
+ private:
+  /// number of size classes
+  static constexpr size_t kSizeClassesCount = 21;
+
+  /// a freed block, reused as a list node
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  mutable std::mutex mutex_;
+  /// freed blocks of each size class
+  FreeBlock* free_lists_[kSizeClassesCount];
+  MemoryStats stats_;
+  size_t cached_bytes_;
+
+  /// \param bytes size of a request
+  /// \return its size class, or `kSizeClassesCount` if it is too large
+  static size_t GetSizeClass(size_t bytes);
+};
+
+static_assert(MemoryPool::kMinBlockSize << 20 == MemoryPool::kMaxBlockSize,
+              "every power of two between the block sizes is a size class");
+
+/// standard allocator over `MemoryPool::GetDefault`, for containers of chunk
+/// data
+template <typename T>
+class PoolAllocator {
+ public:
+  typedef T value_type;
+
+  PoolAllocator() = default;
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&) {
+  }
+
+  T* allocate(size_t count) {
+    return static_cast<T*>(
+        MemoryPool::GetDefault().Allocate(count * sizeof(T)));
+  }
+
+  void deallocate(T* block, size_t count) {
+    MemoryPool::GetDefault().Deallocate(block, count * sizeof(T));
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) {
+  return false;
+}
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_MEMORY_POOL_H
@@ -0,0 +1,167 @@
+#ifndef MINECRAFT_METRICS_H
+#define MINECRAFT_METRICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace minecraft {
+
+/// number of shards of each metric. threads are spread over the shards, so
+/// threads updating the same metric rarely share a cache line
+const size_t kMetricShardsCount = 16;
+
+/// a value that only goes up, e.g. edits applied. each thread adds to its
+/// own shard with one relaxed atomic add, so counting never waits, not even
+/// on a scrape, which only sums the shards
+class Counter {
+ public:
+  Counter();
+  Counter(const Counter&) = delete;
+  Counter& operator=(const Counter&) = delete;
+
+  /// \param amount how much to count
+  void Add(uint64_t amount = 1);
+
+  /// \return the total so far
+  uint64_t GetValue() const;
+
+ private:
+  /// a cache line of its own
+  struct Shard {
+    std::atomic<uint64_t> value;
+    char padding[64 - sizeof(std::atomic<uint64_t>)];
+  };
+
+  Shard shards_[kMetricShardsCount];
+};
+
+/// a value that is set rather than counted, e.g. loaded chunks
+class Gauge {
+ public:
+  Gauge();
+  Gauge(const Gauge&) = delete;
+  Gauge& operator=(const Gauge&) = delete;
+
+  /// \param value the new value
+  void Set(double value);
+
+  /// \return the last value set, 0 at first
+  double GetValue() const;
+
+ private:
+  /// bits of the double
+  std::atomic<uint64_t> bits_;
+};
+
+/// the state of a `Histogram` at one point
+struct HistogramSnapshot {
+  /// upper bounds of the buckets
+  std::vector<double> bounds;
+  /// observations in each bucket (not cumulative), plus those above the
+  /// last bound
+  std::vector<uint64_t> counts;
+  /// sum of the observations
+  double sum;
+  /// number of observations
+  uint64_t count;
+};
+
+/// counts observations, e.g. latencies, into buckets by upper bound. each
+/// thread observes into its own shard, like `Counter`
+class Histogram {
+ public:
+  /// \param bounds upper bounds of the buckets, increasing
+  /// \throw std::invalid_argument if the bounds are empty or not increasing
+  explicit Histogram(const std::vector<double>& bounds);
+  Histogram(const Histogram&) = delete;
+  Histogram& operator=(const Histogram&) = delete;
+
+  /// \param value an observation
+  void Observe(double value);
+
+  /// \return the buckets, sum and count so far
+  HistogramSnapshot GetSnapshot() const;
+
+ private:
+  std::vector<double> bounds_;
+  /// counts per shard, then the sum's bits; each shard's row is padded to
+  /// whole cache lines
+  size_t stride_;
+  std::unique_ptr<std::atomic<uint64_t>[]> cells_;
+};
+
+/// the metrics of a process, by name, and their exposition in the
+/// Prometheus text format. registering takes a lock; updating a metric
+/// through the pointer returned never does, and formatting only takes the
+/// lock against registration
+class MetricsRegistry {
+ public:
+  /// bounds, in seconds, for latencies from tens of microseconds to a
+  /// second
+  static const std::vector<double> kLatencyBounds;
+
+  MetricsRegistry();
+  MetricsRegistry(const MetricsRegistry&) = delete;
+  MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+  /// registers a counter. metrics sharing a name form a family with one
+  /// help text, told apart by their labels
+  ///
+  /// \param name metric name, conventionally ending in `_total`
+  /// \param help description
+  /// \param labels e.g. `subsystem="chunks"`, or empty
+  /// \return the counter, owned by the registry
+  /// \throw std::invalid_argument if the name is taken by another type of
+  /// metric, or the labels by another metric of the family
+  Counter* AddCounter(const std::string& name, const std::string& help,
+                      const std::string& labels = "");
+
+  /// registers a gauge, see `AddCounter`
+  Gauge* AddGauge(const std::string& name, const std::string& help,
+                  const std::string& labels = "");
+
+  /// registers a histogram, see `AddCounter`
+  ///
+  /// \param bounds upper bounds of its buckets
+  Histogram* AddHistogram(const std::string& name, const std::string& help,
+                          const std::vector<double>& bounds = kLatencyBounds,
+                          const std::string& labels = "");
+
+  /// \return every metric in the Prometheus text exposition format
+  std::string Format() const;
+
+ private:
+  enum class Type { kCounter, kGauge, kHistogram };
+
+  /// one labeled metric of a family; exactly one pointer is set
+  struct Member {
+    std::string labels;
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<Gauge> gauge;
+    std::unique_ptr<Histogram> histogram;
+  };
+
+  struct Family {
+    std::string name;
+    std::string help;
+    Type type;
+    std::vector<std::unique_ptr<Member>> members;
+  };
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Family>> families_;
+
+  /// \return a new member of the named family, created if missing
+  /// \throw std::invalid_argument as `AddCounter`
+  Member* AddMember(const std::string& name, const std::string& help,
+                    Type type, const std::string& labels);
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_METRICS_H
@@ -0,0 +1,79 @@
+#ifndef MINECRAFT_METRICS_EXPORTER_H
+#define MINECRAFT_METRICS_EXPORTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "metrics.h"
+
+namespace minecraft {
+
+/// publishes the metrics of a registry from a thread of its own, so that a
+/// scrape formats the metrics while the frame or tick goes on, and never
+/// waits for it
+class MetricsExporter {
+ public:
+  /// path the metrics are served on
+  static const char* const kMetricsPath;
+
+  /// \param registry metrics to publish, which must outlive the exporter
+  explicit MetricsExporter(const MetricsRegistry* registry);
+
+  /// stops the threads
+  ~MetricsExporter();
+
+  MetricsExporter(const MetricsExporter&) = delete;
+  MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+  /// starts answering `GET /metrics` over HTTP on the loopback interface,
+  /// with the metrics in the Prometheus text format; other paths get a 404
+  ///
+  /// \param port port, or 0 for any free port
+  /// \return the port listened on
+  /// \throw std::runtime_error if the port cannot be listened on
+  /// \throw std::logic_error if it is already serving
+  uint16_t ServeHttp(uint16_t port);
+
+  /// starts rewriting a file with the metrics in the Prometheus text format
+  /// every `interval_seconds`, for collectors that read files (e.g. the node
+  /// exporter's textfile collector). each version is written aside and
+  /// renamed over the file, so readers never see half of one
+  ///
+  /// \param path file to write
+  /// \param interval_seconds seconds between writes
+  /// \throw std::logic_error if it is already writing
+  void DumpToFile(const std::string& path, double interval_seconds);
+
+  /// writes the metrics to a file once, as `DumpToFile` does
+  ///
+  /// \param path file to write
+  /// \throw std::runtime_error if the file cannot be written
+  void WriteFile(const std::string& path) const;
+
+  /// \return number of times the metrics were published
+  uint64_t GetScrapesCount() const;
+
+ private:
+  const MetricsRegistry* registry_;
+  /// tells the threads to stop
+  std::atomic<bool> stopping_;
+  mutable std::atomic<uint64_t> scrapes_count_;
+  /// the listening socket, or -1
+  int listener_;
+  std::thread http_thread_;
+  std::thread file_thread_;
+
+  /// accepts and answers connections until stopped
+  void RunHttp();
+
+  /// answers one request
+  ///
+  /// \param descriptor a connected socket
+  void Answer(int descriptor);
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_METRICS_EXPORTER_H
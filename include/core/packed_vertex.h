@@ -0,0 +1,141 @@
+#ifndef MINECRAFT_PACKED_VERTEX_H
+#define MINECRAFT_PACKED_VERTEX_H
+
+#include <cinder/gl/gl.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "block_types.h"
+#include "memory_pool.h"
+
+namespace minecraft {
+
+/// one corner of a block face in 32 bits, instead of a float position and
+/// texture coordinates (20 bytes). the corner's position and atlas texture
+/// coordinates are decoded from the block, face, corner and layer, on the
+/// CPU by the getters below and on the GPU by `GlRenderer`'s vertex shader.
+///
+/// bits 0-5, 6-11 and 12-17 hold the block's position in its chunk, 18-20 the
+/// face (see `Block::kFaceDirections`), 21-22 the corner of the face (see
+/// `Block::kCubeFaces`) and 23-30 the atlas layer
+class PackedVertex {
+ public:
+  /// blocks along each axis of a chunk, at most, so positions fit in 6 bits
+  static constexpr int kMaxChunkWidth = 64;
+  /// bits of each component of the position
+  static constexpr uint32_t kPositionBits = 6;
+  /// first bit of the face
+  static constexpr uint32_t kFaceShift = 18;
+  /// first bit of the corner
+  static constexpr uint32_t kCornerShift = 21;
+  /// first bit of the atlas layer
+  static constexpr uint32_t kLayerShift = 23;
+
+  /// an unset vertex, all fields zero
+  PackedVertex();
+
+  /// \param block position of the block in its chunk, each component in
+  /// [0, kMaxChunkWidth)
+  /// \param face face index, see `Block::kFaceDirections`
+  /// \param corner corner of the face, see `Block::kCubeFaces`
+  /// \param layer atlas layer of the face
+  PackedVertex(const glm::ivec3& block, size_t face, size_t corner,
+               uint8_t layer);
+
+  /// \return position of the block in its chunk
+  glm::ivec3 GetBlock() const;
+  /// \return face index
+  size_t GetFace() const;
+  /// \return corner of the face
+  size_t GetCorner() const;
+  /// \return atlas layer of the face
+  uint8_t GetLayer() const;
+  /// \return the packed bits
+  uint32_t GetBits() const;
+
+  /// \return position of the corner relative to the chunk, as decoded by the
+  /// vertex shader
+  ci::vec3 GetPosition() const;
+  /// \return atlas texture coordinates of the corner, as decoded by the
+  /// vertex shader
+  ci::vec2 GetTexCoord() const;
+
+ private:
+  uint32_t bits_;
+};
+
+static_assert(sizeof(PackedVertex) == 4, "a packed vertex is 32 bits");
+
+/// vertices of a `PackedMesh`, allocated from `MemoryPool::GetDefault`
+typedef std::vector<PackedVertex, PoolAllocator<PackedVertex>> PackedVertices;
+
+/// the faces of a chunk's blocks as `PackedVertex` quads. the quads share a
+/// fixed index pattern (two triangles, corners 0 1 2 and 0 2 3, like
+/// `Block::AppendFace`), so no indices are stored
+class PackedMesh {
+ public:
+  /// an empty mesh
+  ///
+  /// \param origin lattice point the vertices' block positions are relative
+  /// to, i.e. the chunk's lowest corner
+  explicit PackedMesh(const glm::ivec3& origin = glm::ivec3(0));
+
+  /// empties the mesh, keeping its storage
+  ///
+  /// \param origin new origin
+  void Reset(const glm::ivec3& origin);
+
+  /// appends one face of a block
+  ///
+  /// \param block position of the block relative to the origin
+  /// \param block_type type of the block, for the face's atlas layer
+  /// \param face face index, see `Block::kFaceDirections`
+  void AppendFace(const glm::ivec3& block, BlockTypes block_type,
+                  size_t face);
+
+  /// appends every face of a block
+  ///
+  /// \param block position of the block relative to the origin
+  /// \param block_type type of the block
+  void AppendBlock(const glm::ivec3& block, BlockTypes block_type);
+
+  /// reorders the quads from the farthest to the nearest, by the distance
+  /// from the eye to their centers, so that blended faces drawn in order
+  /// cover the ones behind them
+  ///
+  /// \param eye world position to sort for
+  void SortBackToFront(const ci::vec3& eye);
+
+  /// \return lattice point the vertices are relative to
+  glm::ivec3 GetOrigin() const;
+
+  /// \return four vertices per quad
+  const PackedVertices& GetVertices() const;
+
+  /// \return two per quad
+  size_t GetTrianglesCount() const;
+
+  /// \return bytes of vertex data
+  size_t GetBytes() const;
+
+  /// \return a number that changes whenever the mesh does, and that no other
+  /// mesh has had, so renderers can cache what they uploaded
+  uint64_t GetRevision() const;
+
+  /// \return the same geometry as a mesh of world positions and atlas texture
+  /// coordinates, like `Block::AppendFace` builds
+  ci::TriMesh Unpack() const;
+
+ private:
+  glm::ivec3 origin_;
+  PackedVertices vertices_;
+  uint64_t revision_;
+
+  /// marks the mesh as changed
+  void Touch();
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_PACKED_VERTEX_H
@@ -0,0 +1,190 @@
+#ifndef MINECRAFT_PATHFINDER_H
+#define MINECRAFT_PATHFINDER_H
+
+#include <cinder/gl/gl.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "chunk_coordinates.h"
+#include "chunk_snapshot.h"
+#include "region.h"
+#include "thread_pool.h"
+#include "world.h"
+
+namespace minecraft {
+
+/// a path to find, between two lattice points a mob can stand at
+struct PathRequest {
+  glm::ivec3 start;
+  glm::ivec3 goal;
+};
+
+/// the answer to a `PathRequest`
+struct PathResult {
+  /// false if the goal cannot be reached through the snapshot's chunks
+  bool found;
+  /// the points stood at, from the start to the goal, each one move from the
+  /// previous one. empty if the path was not found
+  std::vector<glm::ivec3> path;
+  /// nodes taken off the open lists of the searches the request ran
+  size_t nodes_expanded;
+};
+
+/// what a `Pathfinder` has done so far
+struct PathfinderStats {
+  /// requests answered
+  uint64_t queries;
+  /// `PathResult::nodes_expanded`, summed over the requests
+  uint64_t nodes_expanded;
+  /// chunk graphs built, see `Pathfinder`
+  uint64_t clusters_built;
+  /// chunk graphs dropped because blocks changed
+  uint64_t clusters_invalidated;
+};
+
+class Pathfinder;
+
+/// requests answered on worker threads, see `Pathfinder::FindPaths`
+class PathBatch {
+ public:
+  /// \return true if and only if every request has been answered
+  bool IsReady() const;
+
+  /// waits for the answers
+  ///
+  /// \return the results, in the order of the requests
+  std::vector<PathResult> Get();
+
+ private:
+  friend class Pathfinder;
+  std::vector<std::future<std::vector<PathResult>>> parts_;
+};
+
+/// finds walking paths through the blocks of a `World` for mobs two blocks
+/// tall. a mob stands in a free block with a free block above and a solid
+/// block below, and moves to one of the four horizontal neighbors, stepping
+/// up one block or dropping up to `kMaxDrop` blocks. every move costs 1.
+///
+/// searches are hierarchical. every chunk is a cluster: transitions between
+/// neighboring chunks are grouped into entrances along the chunk borders,
+/// each entrance has one portal (the transition nearest its middle), and the
+/// cluster graph caches the distances between the portals of a chunk. a path
+/// is found by A* over the portals of the chunks, then refined into moves by
+/// searches inside one chunk at a time. cluster graphs are built the first
+/// time a search needs them, and dropped when blocks in or next to their
+/// chunk change.
+///
+/// searches read a `WorldSnapshot`, so they can run on worker threads while
+/// the world is edited. blocks outside the snapshot's chunks are impassable
+class Pathfinder {
+ public:
+  /// most blocks a mob drops down in one move
+  static const int kMaxDrop;
+  /// requests per task of `FindPaths`
+  static const size_t kBatchSize;
+
+  /// \param world world to find paths in. its changes invalidate cached
+  /// cluster graphs; it must outlive this
+  /// \param thread_pool runs `FindPaths`; it must outlive this
+  Pathfinder(World* world, ThreadPool* thread_pool);
+
+  /// stops listening to the world's changes. batches must have been waited
+  /// for
+  ~Pathfinder();
+
+  Pathfinder(const Pathfinder&) = delete;
+  Pathfinder& operator=(const Pathfinder&) = delete;
+
+  /// answers a request on this thread
+  ///
+  /// \param snapshot blocks to path through
+  /// \param request the request
+  /// \return the path
+  PathResult FindPath(const WorldSnapshot& snapshot,
+                      const PathRequest& request);
+
+  /// answers requests on the thread pool, in tasks of `kBatchSize` requests,
+  /// through a snapshot of the world taken now
+  ///
+  /// \param requests the requests
+  /// \return the answers to come
+  PathBatch FindPaths(const std::vector<PathRequest>& requests);
+
+  /// answers requests on the thread pool, in tasks of `kBatchSize` requests
+  ///
+  /// \param snapshot blocks to path through, kept until the batch is done
+  /// \param requests the requests
+  /// \return the answers to come
+  PathBatch FindPaths(const std::shared_ptr<const WorldSnapshot>& snapshot,
+                      const std::vector<PathRequest>& requests);
+
+  /// drops the cluster graphs that depend on blocks in a box
+  ///
+  /// \param box blocks that changed
+  void Invalidate(const BlockBox& box);
+
+  /// \return what the pathfinder has done so far
+  PathfinderStats GetStats() const;
+
+  /// \return number of cluster graphs cached
+  size_t GetClustersCount() const;
+
+  /// plain A* over single blocks, without the hierarchy. expands far more
+  /// nodes on long paths; kept as the reference the hierarchy is measured
+  /// against
+  ///
+  /// \param snapshot blocks to path through
+  /// \param request the request
+  /// \return a shortest path
+  static PathResult FindBlockPath(const WorldSnapshot& snapshot,
+                                  const PathRequest& request);
+
+  /// \param snapshot blocks to check
+  /// \param position a lattice point
+  /// \return true if and only if a mob can stand there
+  static bool CanStandAt(const WorldSnapshot& snapshot,
+                         const glm::ivec3& position);
+
+ private:
+  struct Cluster;
+
+  World* world_;
+  ThreadPool* thread_pool_;
+  int chunk_radius_;
+  size_t subscription_;
+
+  mutable std::mutex mutex_;
+  std::map<ChunkCoordinates, std::shared_ptr<const Cluster>> clusters_;
+  /// number of `Invalidate` calls, and the last one that dropped each chunk,
+  /// so graphs built from snapshots older than a change are not cached
+  uint64_t invalidations_;
+  std::map<ChunkCoordinates, uint64_t> invalidated_at_;
+
+  std::atomic<uint64_t> queries_;
+  std::atomic<uint64_t> nodes_expanded_;
+  std::atomic<uint64_t> clusters_built_;
+  std::atomic<uint64_t> clusters_invalidated_;
+
+  /// \param snapshot blocks to path through
+  /// \param chunk a chunk of the snapshot
+  /// \param invalidations `invalidations_` when the snapshot was taken
+  /// \return the chunk's graph, cached or built
+  std::shared_ptr<const Cluster> GetCluster(const WorldSnapshot& snapshot,
+                                            const ChunkCoordinates& chunk,
+                                            uint64_t invalidations);
+
+  /// `FindPath`, for a snapshot taken after `invalidations` invalidations
+  PathResult FindPath(const WorldSnapshot& snapshot,
+                      const PathRequest& request, uint64_t invalidations);
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_PATHFINDER_H
@@ -0,0 +1,103 @@
+#ifndef MINECRAFT_QUALITY_CONTROLLER_H
+#define MINECRAFT_QUALITY_CONTROLLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace minecraft {
+
+/// how much of the world is drawn and streamed, and so what a frame costs
+struct QualitySettings {
+  /// radius of the chunks, see `world.h`. fixed once the world is created
+  size_t chunk_radius;
+  /// maximum distance from the player to render blocks in
+  size_t render_radius;
+  /// maximum distance from the player to render level-of-detail terrain in
+  float lod_view_distance;
+  /// most level-of-detail tiles queued for building per update
+  size_t lod_builds_per_update;
+};
+
+/// holds a target frame time by trading quality for speed.
+///
+/// frame and update times are averaged over windows of `kWindowFrames`
+/// frames. a window over the target by more than `kHysteresis` lowers one of
+/// two levels: the streaming level (LOD builds per update) if updates take
+/// most of the frame, otherwise the detail level (render radius and LOD view
+/// distance). only after `kRaiseWindows` windows in a row under the target by
+/// more than `kHysteresis` is a level raised again, so the settings do not
+/// oscillate around the target. at the highest levels the settings are those
+/// the controller was created with; every adjustment is logged
+class QualityController {
+ public:
+  /// names of the presets, cheapest first
+  static const std::vector<std::string> kPresetNames;
+  /// frames averaged before the settings may change
+  static const size_t kWindowFrames;
+  /// levels between the cheapest settings and the initial ones
+  static const size_t kLevelsCount;
+  /// fraction of the target within which the settings are kept
+  static const float kHysteresis;
+  /// windows in a row under the target needed to raise a level
+  static const size_t kRaiseWindows;
+  /// fraction of the frame time above which updates, rather than drawing,
+  /// are slowing frames down
+  static const float kUpdateShare;
+  /// cheapest settings, unless the initial ones are cheaper still
+  static const size_t kMinRenderRadius;
+  static const float kMinLodViewDistance;
+
+  /// \param settings the highest settings, used at first
+  /// \param target_seconds frame time to hold
+  /// \param log where adjustments are logged, or null
+  QualityController(const QualitySettings& settings, float target_seconds,
+                    std::ostream* log);
+
+  /// records the times of a frame
+  ///
+  /// \param frame_seconds time the frame took to update and draw, not
+  /// counting waits for the frame rate or vertical sync, which would hide
+  /// how much headroom there is
+  /// \param update_seconds part of it spent updating
+  /// \return true if and only if the settings changed
+  bool Record(float frame_seconds, float update_seconds);
+
+  /// \return the settings to use now
+  const QualitySettings& GetSettings() const;
+
+  /// \return from 0, cheapest, to `kLevelsCount - 1`, the initial settings
+  size_t GetDetailLevel() const;
+  size_t GetStreamingLevel() const;
+
+  /// \param name one of `kPresetNames`
+  /// \return the preset's settings
+  /// \throw std::invalid_argument if there is no preset with the name
+  static QualitySettings GetPreset(const std::string& name);
+
+ private:
+  QualitySettings highest_;
+  float target_seconds_;
+  std::ostream* log_;
+  size_t detail_level_;
+  size_t streaming_level_;
+  QualitySettings settings_;
+  /// frames and their summed times in the current window
+  size_t frames_;
+  float frame_seconds_;
+  float update_seconds_;
+  /// windows in a row under the target
+  size_t windows_under_;
+
+  /// recomputes `settings_` from the levels and logs what changed
+  ///
+  /// \param frame_seconds average frame time of the window
+  /// \param update_seconds average update time of the window
+  void Apply(float frame_seconds, float update_seconds);
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_QUALITY_CONTROLLER_H
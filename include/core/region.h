@@ -0,0 +1,77 @@
+#ifndef MINECRAFT_REGION_H
+#define MINECRAFT_REGION_H
+
+#include <cinder/gl/gl.h>
+
+#include "block_types.h"
+
+namespace minecraft {
+
+/// a request to set the block at a lattice point
+struct BlockEdit {
+  glm::ivec3 position;
+  BlockTypes block_type;
+};
+
+/// a block that actually changed as the result of an edit
+struct BlockChange {
+  glm::ivec3 position;
+  BlockTypes previous_block_type;
+  BlockTypes block_type;
+};
+
+/// an axis-aligned box of lattice points, both corners inclusive
+struct BlockBox {
+  glm::ivec3 min_corner;
+  glm::ivec3 max_corner;
+
+  /// \param position a lattice point
+  /// \return true if and only if the point is inside the box
+  bool Contains(const glm::ivec3& position) const {
+    return min_corner.x <= position.x && position.x <= max_corner.x &&
+           min_corner.y <= position.y && position.y <= max_corner.y &&
+           min_corner.z <= position.z && position.z <= max_corner.z;
+  }
+
+  /// \return true if and only if the box contains no points
+  bool IsEmpty() const {
+    return min_corner.x > max_corner.x || min_corner.y > max_corner.y ||
+           min_corner.z > max_corner.z;
+  }
+
+  /// \param other a box
+  /// \return the points in both boxes, possibly empty
+  BlockBox Intersect(const BlockBox& other) const {
+    return BlockBox{glm::max(min_corner, other.min_corner),
+                    glm::min(max_corner, other.max_corner)};
+  }
+
+  /// \param other a box
+  /// \return true if and only if the boxes share a point
+  bool Intersects(const BlockBox& other) const {
+    return !Intersect(other).IsEmpty();
+  }
+};
+
+/// the lattice points within `radius` of `center`
+struct BlockSphere {
+  glm::ivec3 center;
+  float radius;
+
+  /// \return the smallest box containing the sphere
+  BlockBox GetBounds() const {
+    int extent = int(radius);
+    return BlockBox{center - glm::ivec3(extent), center + glm::ivec3(extent)};
+  }
+
+  /// \param position a lattice point
+  /// \return true if and only if the point is inside the sphere
+  bool Contains(const glm::ivec3& position) const {
+    glm::ivec3 offset = position - center;
+    return float(glm::dot(offset, offset)) <= radius * radius;
+  }
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_REGION_H
@@ -0,0 +1,66 @@
+#ifndef MINECRAFT_RENDERER_H
+#define MINECRAFT_RENDERER_H
+
+#include <cinder/gl/gl.h>
+
+#include "packed_vertex.h"
+
+namespace minecraft {
+
+/// everything the engine draws goes through a renderer, so that the same
+/// drawing code can run against the GPU or headless (see `GlRenderer` and
+/// `HeadlessRenderer`)
+class Renderer {
+ public:
+  virtual ~Renderer() = default;
+
+  /// clears the color and depth buffers, starting a new frame
+  virtual void Clear() = 0;
+
+  /// switches to window coordinates (top left is 0, 0) for overlays
+  ///
+  /// \param size window size in pixels
+  virtual void SetWindowMatrices(const glm::ivec2& size) = 0;
+
+  /// switches to a depth-tested perspective view
+  ///
+  /// \param eye camera position
+  /// \param forward direction the camera looks in
+  virtual void SetCamera(const ci::vec3& eye, const ci::vec3& forward) = 0;
+
+  /// draws a triangle mesh textured from the block atlas, see
+  /// `Texture::GetAtlas`
+  ///
+  /// \param mesh positions and atlas texture coordinates
+  virtual void DrawMesh(const ci::TriMesh& mesh) = 0;
+
+  /// draws chunk geometry textured from the block atlas
+  ///
+  /// \param mesh packed quads, see `PackedVertex`
+  virtual void DrawPackedMesh(const PackedMesh& mesh) = 0;
+
+  /// draws translucent chunk geometry blended over what was drawn before,
+  /// depth-tested but without writing depth, so faces behind it still show.
+  /// the quads are drawn in order, see `PackedMesh::SortBackToFront`
+  ///
+  /// \param mesh packed quads, see `PackedVertex`
+  virtual void DrawTranslucentPackedMesh(const PackedMesh& mesh) = 0;
+
+  /// draws the twelve edges of a box
+  ///
+  /// \param center center of the box
+  /// \param size side lengths of the box
+  virtual void DrawStrokedCube(const ci::vec3& center,
+                               const ci::vec3& size) = 0;
+
+  /// draws a texture stretched over a rectangle in window coordinates
+  ///
+  /// \param texture a texture
+  /// \param bounds where to draw it
+  virtual void DrawTexture(const ci::gl::Texture2dRef& texture,
+                           const ci::Rectf& bounds) = 0;
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_RENDERER_H
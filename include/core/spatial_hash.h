@@ -0,0 +1,78 @@
+#ifndef MINECRAFT_SPATIAL_HASH_H
+#define MINECRAFT_SPATIAL_HASH_H
+
+#include <cinder/gl/gl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace minecraft {
+
+/// broadphase for boxes against each other: space is divided into cubic cells
+/// and the cells are hashed into buckets, so memory grows with the number of
+/// boxes rather than with the space they are spread over. boxes are at most
+/// a cell wide, so overlapping boxes are in the same or adjacent cells, and
+/// each box is only tested against the boxes of the 27 cells around it.
+///
+/// `Build` sorts the boxes by bucket into one array (a counting sort, linear
+/// in the number of boxes), so the boxes of a bucket are contiguous and
+/// `FindPairs` reads memory mostly in order
+class SpatialHash {
+ public:
+  /// \param cell_size edge of the cells, at least the widest box
+  /// \throw std::invalid_argument if the size is not positive
+  explicit SpatialHash(float cell_size);
+
+  /// replaces the boxes
+  ///
+  /// \param centers centers of the boxes
+  /// \param half_extents half the size of the boxes
+  /// \param count number of boxes, identified by their index in the arrays
+  /// \throw std::invalid_argument if a box is wider than a cell
+  void Build(const glm::vec3* centers, const glm::vec3* half_extents,
+             size_t count);
+
+  /// \param pairs cleared, then set to the pairs of boxes that overlap, each
+  /// once and with the lower index first, in no particular order
+  void FindPairs(std::vector<std::pair<uint32_t, uint32_t>>* pairs) const;
+
+  /// \return edge of the cells
+  float GetCellSize() const;
+
+  /// \return number of buckets of the last `Build`
+  size_t GetBucketsCount() const;
+
+ private:
+  /// a box, as sorted into the buckets
+  struct Entry {
+    glm::vec3 min_corner;
+    glm::vec3 max_corner;
+    glm::ivec3 cell;
+    uint32_t index;
+  };
+
+  /// fewest buckets, so small worlds do not rehash on every box
+  static const size_t kMinBucketsCount;
+
+  float cell_size_;
+  /// buckets minus one; the number of buckets is a power of two
+  size_t bucket_mask_;
+  /// entries, ordered by bucket
+  std::vector<Entry> entries_;
+  /// start of each bucket's entries, plus the end of the last one
+  std::vector<uint32_t> bucket_starts_;
+  /// kept between builds, so building allocates nothing once it has been
+  /// done with as many boxes
+  std::vector<Entry> unsorted_;
+  std::vector<uint32_t> bucket_ends_;
+
+  /// \param cell a cell
+  /// \return its bucket
+  size_t GetBucket(const glm::ivec3& cell) const;
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_SPATIAL_HASH_H
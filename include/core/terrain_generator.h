@@ -8,7 +8,77 @@
 
 namespace minecraft {
 
-/// extendable class which implements a noise function to generate terrain
+/// the built-in terrain: Perlin noise heights, grass on top, dirt above sea
+/// level and stone below. not virtual, so `FillChunk` can inline it
+class PerlinTerrain {
+ public:
+  /// \param min_height minimum height, i.e. sea level
+  /// \param max_height maximum height, i.e. the height of the highest mountain
+  /// \param variance low value (around 1.0f) for more flat terrain, high value
+  /// (around 10.0f) for more varied terrain
+  /// \param seed seed for Perlin noise
+  PerlinTerrain(int min_height, int max_height, float variance, int seed);
+
+  /// \param x lattice coordinate
+  /// \param y lattice coordinate
+  /// \param z lattice coordinate
+  /// \return block type, or `BlockTypes::kNone` for air
+  BlockTypes GetBlockAt(int x, int y, int z) const {
+    return GetBlockInColumn(y, GetHeight(x, z));
+  }
+
+  /// \param x lattice coordinate
+  /// \param z lattice coordinate
+  /// \return height of the grass in the column
+  int GetHeight(int x, int z) const;
+
+  /// \param y lattice coordinate
+  /// \param height height of the column, see `GetHeight`
+  /// \return block type at height `y` in the column. branch free, so loops
+  /// over it vectorize
+  static BlockTypes GetBlockInColumn(int y, int height) {
+    return y == height  ? BlockTypes::kGrass
+           : y > height ? BlockTypes::kNone
+           : y >= 0     ? BlockTypes::kDirt
+                        : BlockTypes::kStone;
+  }
+
+ private:
+  int min_height_;
+  int max_height_;
+  float variance_;
+  FastNoiseLite noise_;
+};
+
+/// fills a chunk's voxels from any generator with a
+/// `BlockTypes GetBlockAt(int x, int y, int z) const` member. instantiated
+/// per generator type, so the call is inlined rather than dispatched
+///
+/// \param generator terrain generator
+/// \param min_corner lowest lattice point in the chunk
+/// \param width number of blocks along each axis
+/// \param voxels output `width^3` voxels, ordered as in `Chunk`
+template <typename Generator>
+void FillChunk(const Generator& generator, const glm::ivec3& min_corner,
+               int width, BlockTypes* voxels) {
+  for (int x = min_corner.x; x < min_corner.x + width; ++x) {
+    for (int y = min_corner.y; y < min_corner.y + width; ++y) {
+      for (int z = min_corner.z; z < min_corner.z + width; ++z) {
+        *voxels++ = generator.GetBlockAt(x, y, z);
+      }
+    }
+  }
+}
+
+/// `FillChunk` for the built-in terrain: computes each column's height once
+/// instead of once per voxel, then fills the chunk row by row
+void FillChunk(const PerlinTerrain& terrain, const glm::ivec3& min_corner,
+               int width, BlockTypes* voxels);
+
+/// runtime-polymorphic terrain generator, for code that picks its terrain at
+/// run time (e.g. tests). by default it generates `PerlinTerrain`; subclasses
+/// can override `GetBlockAt`, and `FillChunk` then falls back to calling it
+/// for every voxel unless they override `FillChunk` too
 class TerrainGenerator {
  public:
   /// constructs a simple terrain generator
@@ -20,30 +90,43 @@ class TerrainGenerator {
   /// \param seed seed for Perlin noise
   TerrainGenerator(int min_height, int max_height, float variance, int seed);
 
+  virtual ~TerrainGenerator() = default;
+
   /// gets the block at (x, y, z)
   ///
   /// \param transform vector
   /// \return block type, or `BlockTypes::kNone` for air
   virtual BlockTypes GetBlockAt(const ci::vec3& transform);
 
+  /// fills a chunk's voxels, see `minecraft::FillChunk`. one virtual call per
+  /// chunk instead of one per voxel
+  ///
+  /// \param min_corner lowest lattice point in the chunk
+  /// \param width number of blocks along each axis
+  /// \param voxels output `width^3` voxels, ordered as in `Chunk`
+  virtual void FillChunk(const glm::ivec3& min_corner, int width,
+                         BlockTypes* voxels);
+
  private:
-  /// minimum height, i.e. sea level
-  int min_height_;
-  /// maximum height, i.e. the height of the highest mountain
-  int max_height_;
-  /// low value (around 1.0f) for more flat terrain, high value (around 10.0f)
-  /// for more varied terrain
-  float variance_;
-  /// Perlin noise terrain generator
-  FastNoiseLite noise_;
+  /// the terrain generated unless a subclass overrides `GetBlockAt`
+  PerlinTerrain terrain_;
+};
 
-  /// Gets the terrain height
-  ///
-  /// \param x coordinate
-  /// \param z coordinate
-  /// \return some value between the constructor's passed `min_height` and
-  /// `max_height`
-  int GetTerrainHeight(int x, int z);
+/// adapts a `TerrainGenerator` to the generator concept of `FillChunk`, at the
+/// cost of a virtual call per voxel
+class PolymorphicTerrain {
+ public:
+  /// \param generator terrain generator
+  explicit PolymorphicTerrain(TerrainGenerator* generator)
+      : generator_(generator) {
+  }
+
+  BlockTypes GetBlockAt(int x, int y, int z) const {
+    return generator_->GetBlockAt(ci::vec3(x, y, z));
+  }
+
+ private:
+  TerrainGenerator* generator_;
 };
 
 }  // namespace minecraft
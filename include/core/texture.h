@@ -3,38 +3,73 @@
 
 #include <cinder/gl/gl.h>
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "asset_pack.h"
 #include "block_types.h"
 
 namespace minecraft {
 
+/// loads block textures and icons once and hands out the cached copies. they
+/// are uploaded from the asset pack, see `asset_pack.h`, if the assets have
+/// one, and decoded from the PNGs otherwise
 class Texture {
-  /// mapping of block types to textures
-  static const std::map<BlockTypes, std::string> kTextureFiles;
-  /// mapping of block types to icons
-  static const std::map<BlockTypes, std::string> kIconFiles;
   /// a texture used for testing, where the faces of the block will be the
   /// numbers 1 to 6 in the face-order TOP, FRONT, RIGHT, BACK, LEFT, BOTTOM
   static const std::string kTestTexture;
 
  public:
-  /// creates a texture
-  ///
-  /// \param block_type the block type for this texture (cannot be
-  /// `BlockTypes::kNone`!)
-  Texture(const BlockTypes& block_type);
+  /// \return a single texture holding every block face, see
+  /// `BlockRegistry::kAtlasFiles` for its layout
+  static ci::gl::Texture2dRef GetAtlas();
 
-  /// \return the texture
-  ci::gl::Texture2dRef GetTexture();
+  /// maps a corner of a face to atlas texture coordinates
+  ///
+  /// \param layer atlas layer of the face
+  /// \param corner corner of the face, each component 0 or 1
+  /// \return texture coordinates in the atlas
+  static ci::vec2 GetAtlasCoordinates(uint8_t layer, const ci::vec2& corner);
 
   /// \param block_type a block type
   /// \return UI icons
   static ci::gl::Texture2dRef GetIcon(BlockTypes block_type);
 
+  /// \return the mapped asset pack, or null if the assets have none or it is
+  /// not valid
+  static const AssetPack* GetPack();
+
+  /// uploads an image and its mipmaps straight from the pack's mapping
+  ///
+  /// \param image an image of the pack
+  /// \return the texture
+  static ci::gl::Texture2dRef CreateTexture(const PackedImage& image);
+
+  /// decodes an image file for `AssetPack::Write`
+  ///
+  /// \param path an image file
+  /// \param name name of the image in the pack
+  /// \return the pixels, bottom row first, as textures are loaded by default
+  static AssetImage DecodeImage(const ci::fs::path& path,
+                                const std::string& name);
+
+  /// decodes the atlas strips and stacks them, like `GetAtlas`
+  ///
+  /// \param strips one image file per `BlockRegistry::kAtlasFiles` entry, in
+  /// the same order
+  /// \return the atlas, named `AssetPack::kAtlasName`
+  static AssetImage DecodeAtlas(const std::vector<ci::fs::path>& strips);
+
  private:
-  /// this block type
-  BlockTypes block_type_;
+  /// uploads the atlas from the pack, or decodes the strips in
+  /// `BlockRegistry::kAtlasFiles` and stacks them
+  static ci::gl::Texture2dRef LoadAtlas();
+
+  /// \return the asset pack, or null if the assets have none or it is not
+  /// valid
+  static std::unique_ptr<AssetPack> LoadPack();
 };
 
 }  // namespace minecraft
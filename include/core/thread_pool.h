@@ -0,0 +1,71 @@
+#ifndef MINECRAFT_THREAD_POOL_H
+#define MINECRAFT_THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace minecraft {
+
+/// a fixed set of worker threads running tasks in submission order
+class ThreadPool {
+ public:
+  /// starts the workers
+  ///
+  /// \param threads_count number of workers, at least 1
+  explicit ThreadPool(size_t threads_count);
+
+  /// drops the tasks that have not started and waits for the running ones
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /// queues a task
+  ///
+  /// \param task callable without arguments
+  /// \return future result of the task. if the pool is destroyed before the
+  /// task starts, the future holds a `std::future_error`
+  template <typename Task>
+  std::future<typename std::result_of<Task()>::type> Submit(Task task) {
+    typedef typename std::result_of<Task()>::type Result;
+    std::shared_ptr<std::packaged_task<Result()>> packaged(
+        new std::packaged_task<Result()>(std::move(task)));
+    std::future<Result> result = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back([packaged]() { (*packaged)(); });
+    }
+    condition_.notify_one();
+    return result;
+  }
+
+  /// \return number of workers
+  size_t GetThreadsCount() const;
+
+  /// \return number of tasks waiting for a worker
+  size_t GetQueuedCount() const;
+
+  /// \return a worker count that leaves a core for the render thread
+  static size_t GetDefaultThreadsCount();
+
+ private:
+  std::vector<std::thread> threads_;
+  std::deque<std::function<void()>> tasks_;
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stopping_;
+
+  /// worker loop
+  void Run();
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_THREAD_POOL_H
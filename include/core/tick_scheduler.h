@@ -0,0 +1,68 @@
+#ifndef MINECRAFT_TICK_SCHEDULER_H
+#define MINECRAFT_TICK_SCHEDULER_H
+
+#include <cinder/gl/gl.h>
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_set>
+#include <vector>
+
+namespace minecraft {
+
+/// time-ordered queue of block updates. a block has at most one pending
+/// update at a time, so repeated requests for the same block collapse
+class TickScheduler {
+ public:
+  TickScheduler();
+
+  /// schedules an update of the block at `position`, `delay` ticks from now
+  ///
+  /// \param position a lattice point
+  /// \param delay number of ticks to wait, at least 1
+  /// \return false if and only if the block already had a pending update
+  bool Schedule(const glm::ivec3& position, uint32_t delay);
+
+  /// advances the clock by one tick and removes the updates that are due
+  ///
+  /// \return lattice points of the due updates, earliest first
+  std::vector<glm::ivec3> Advance();
+
+  /// \return number of ticks advanced so far
+  uint64_t GetTick() const;
+
+  /// \return number of updates waiting in the queue
+  size_t GetPendingCount() const;
+
+ private:
+  struct ScheduledTick {
+    uint64_t tick;
+    /// breaks ties between updates due on the same tick, in scheduling order
+    uint64_t sequence;
+    glm::ivec3 position;
+
+    bool operator>(const ScheduledTick& other) const {
+      return tick != other.tick ? tick > other.tick
+                                : sequence > other.sequence;
+    }
+  };
+
+  struct PositionHasher {
+    size_t operator()(const glm::ivec3& key) const {
+      return size_t((key.x * 5209) ^ (key.y * 1811) ^ (key.z * 7297));
+    }
+  };
+
+  uint64_t tick_;
+  uint64_t sequence_;
+  std::priority_queue<ScheduledTick, std::vector<ScheduledTick>,
+                      std::greater<ScheduledTick>>
+      queue_;
+  /// blocks that are in `queue_`
+  std::unordered_set<glm::ivec3, PositionHasher> pending_;
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_TICK_SCHEDULER_H
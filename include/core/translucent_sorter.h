@@ -0,0 +1,115 @@
+#ifndef MINECRAFT_TRANSLUCENT_SORTER_H
+#define MINECRAFT_TRANSLUCENT_SORTER_H
+
+#include <cinder/gl/gl.h>
+
+#include <cstdint>
+#include <future>
+#include <map>
+
+#include "packed_vertex.h"
+#include "thread_pool.h"
+
+namespace minecraft {
+
+class World;
+
+/// what a `TranslucentSorter` has done so far
+struct SortStats {
+  /// sorts queued on the thread pool
+  uint64_t requested;
+  /// sorts swapped in for drawing
+  uint64_t completed;
+  /// sorts that were due but left for a later update, to spread them over
+  /// frames
+  uint64_t deferred;
+  /// updates that found a chunk's order still good enough, and skipped it
+  uint64_t skipped;
+};
+
+/// keeps a back-to-front sorted copy of every chunk's translucent mesh (see
+/// `Chunk::GetTranslucentMesh`), for `World::Render` to draw instead.
+///
+/// the order of a chunk's faces only changes noticeably when the eye moves
+/// far relative to the chunk's distance, or steps into another block near
+/// it, so a chunk is only re-sorted when the eye crosses into another block
+/// within it, or moves more than `kResortFraction` of its distance from the
+/// chunk (at least `kResortDistance`) since the last sort, or when its mesh
+/// changes. sorts run on a thread pool over copies of the meshes, nearest
+/// chunks first and at most `kMaxSortsPerUpdate` started per update; until a
+/// sort is done, the previous order is drawn
+class TranslucentSorter {
+ public:
+  /// least distance the eye moves, in blocks, before a chunk is re-sorted
+  static const float kResortDistance;
+  /// distance the eye moves before a chunk is re-sorted, as a fraction of
+  /// the distance from the eye to the chunk's center
+  static const float kResortFraction;
+  /// most sorts started per update
+  static constexpr size_t kMaxSortsPerUpdate = 4;
+
+  /// registers with the world, which then draws the sorted meshes
+  ///
+  /// \param world world to sort for, which must outlive this object
+  /// \param thread_pool where meshes are sorted
+  TranslucentSorter(World* world, ThreadPool* thread_pool);
+
+  /// unregisters from the world and waits for the sorts running
+  ~TranslucentSorter();
+
+  TranslucentSorter(const TranslucentSorter&) = delete;
+  TranslucentSorter& operator=(const TranslucentSorter&) = delete;
+
+  /// swaps in the sorts that are done, forgets chunks that no longer have
+  /// translucent faces, and queues the sorts that are due
+  ///
+  /// \param eye camera position
+  void Update(const ci::vec3& eye);
+
+  /// \param mesh a chunk's translucent mesh
+  /// \return its last sorted copy, or the mesh itself if it changed since,
+  /// or has not been sorted yet
+  const PackedMesh& GetSorted(const PackedMesh& mesh) const;
+
+  /// \return number of sorts running or queued
+  size_t GetSortingCount() const;
+
+  /// \return what the sorter has done so far
+  const SortStats& GetStats() const;
+
+ private:
+  /// the sorted copies of a chunk's mesh
+  struct Entry {
+    /// last sort done, drawn instead of the chunk's mesh
+    PackedMesh sorted;
+    /// `PackedMesh::GetRevision` of the chunk's mesh `sorted` was copied
+    /// from, or 0
+    uint64_t sorted_revision;
+    /// being sorted while `sort` is valid; only the worker touches it then
+    PackedMesh pending;
+    /// revision of the chunk's mesh `pending` was copied from, or 0
+    uint64_t pending_revision;
+    /// ready once `pending` is sorted
+    std::future<void> sort;
+    /// eye and the block it was in for the latest sort
+    ci::vec3 eye;
+    glm::ivec3 eye_block;
+  };
+
+  World* world_;
+  ThreadPool* thread_pool_;
+  /// by the chunk's mesh, which stays in its window slot
+  std::map<const PackedMesh*, Entry> entries_;
+  SortStats stats_;
+
+  /// \param mesh a chunk's translucent mesh
+  /// \param entry its entry
+  /// \param eye camera position
+  /// \return whether the mesh should be sorted again
+  bool IsDue(const PackedMesh& mesh, const Entry& entry,
+             const ci::vec3& eye) const;
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_TRANSLUCENT_SORTER_H
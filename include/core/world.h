@@ -4,40 +4,125 @@
 #include <FastNoiseLite.h>
 #include <cinder/gl/gl.h>
 
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <random>
 #include <unordered_map>
 #include <vector>
 
 #include "block.h"
+#include "block_change_bus.h"
 #include "block_types.h"
+#include "chunk.h"
+#include "chunk_coordinates.h"
+#include "chunk_snapshot.h"
+#include "chunk_window.h"
+#include "memory_pool.h"
+#include "metrics.h"
+#include "region.h"
+#include "renderer.h"
 #include "terrain_generator.h"
+#include "tick_scheduler.h"
 
 namespace minecraft {
 
+class ChunkPrefetcher;
+class TranslucentSorter;
+
+/// what the last `World::Tick` did
+struct TickStats {
+  /// number of ticks so far
+  uint64_t tick;
+  /// wall time of the last tick
+  double seconds;
+  /// scheduled updates run in the last tick
+  size_t scheduled_updates;
+  /// random ticks that hit a ticking block in the last tick
+  size_t random_ticks;
+  /// loaded chunks that contain blocks which receive random ticks
+  size_t active_chunks;
+  /// scheduled updates still waiting
+  size_t pending_updates;
+};
+
+/// the metrics a `World` reports, see `World::SetMetrics`
+struct WorldMetrics {
+  /// chunks in the window, loaded and pending
+  Gauge* loaded_chunks;
+  Gauge* pending_chunks;
+  /// render blocks of the loaded chunks
+  Gauge* blocks;
+  /// bytes held by the loaded chunks' voxels, meshes and render blocks, and
+  /// by the player edits
+  Gauge* voxel_bytes;
+  Gauge* mesh_bytes;
+  Gauge* block_bytes;
+  Gauge* edit_bytes;
+  /// time of each `World::MoveToChunk`
+  Histogram* move_to_chunk_seconds;
+  /// time to build a chunk on the calling thread when it is loaded, and on
+  /// a worker when a `ChunkPrefetcher` builds it ahead
+  Histogram* load_generation_seconds;
+  Histogram* prefetch_generation_seconds;
+  /// blocks changed through `World::ApplyEdits`
+  Counter* edits;
+};
+
 /// cinder-compatible world
 class World {
  public:
+  /// which chunks the constructor loads
+  enum class SpawnMode {
+    /// the whole window around the player
+    kFull,
+    /// only the chunks within `kCollisionReach` of the player, which it can
+    /// stand on or bump into; the rest of the window is left pending for
+    /// `StreamChunks`, so the cost of spawning does not grow with the window
+    kProgressive
+  };
+
   /// initializes the terrain noise function and generates chunks adjacent to
   /// the player
   ///
   /// \param terrain_generator terrain generator
   /// \param origin_position player's origin
   /// \param chunk_radius radius of each chunk
+  /// \param spawn_mode which chunks to generate now
   World(TerrainGenerator* terrain_generator, const ci::vec3& origin_position,
-        size_t chunk_radius);
+        size_t chunk_radius, SpawnMode spawn_mode = SpawnMode::kFull);
 
-  /// renders the blocks in the player's chunk and all adjacent chunks if they
-  /// are within rendering distance and in front of the player's field of view.
-  /// if the player has moved between chunks, unloads the distance chunks from
-  /// the blocks array and loads the new adjacent chunks
+  /// renders the player's chunk and all adjacent chunks if they are within
+  /// rendering distance and in front of the player's field of view, one draw
+  /// of packed geometry per chunk. translucent faces are left for
+  /// `RenderTranslucent`.
+  /// if the player has moved between chunks, unloads the distance chunks and
+  /// loads the new adjacent chunks
   ///
+  /// \param renderer renderer to draw with
   /// \param origin the player's location
   /// \param forward the camera's forward vector
   /// \param render_radius radius to render blocks
-  void Render(const ci::vec3& origin, const ci::vec3& forward,
-              float field_of_view_angle, size_t render_radius) const;
+  void Render(Renderer* renderer, const ci::vec3& origin,
+              const ci::vec3& forward, float field_of_view_angle,
+              size_t render_radius) const;
+
+  /// renders the translucent faces of the chunks `Render` draws, blended, from
+  /// the farthest chunk to the nearest, each in the order of the translucent
+  /// sorter if one is set. call it after everything opaque, which the faces
+  /// must show through
+  ///
+  /// \param renderer renderer to draw with
+  /// \param origin the player's location
+  /// \param forward the camera's forward vector
+  /// \param render_radius radius to render blocks
+  void RenderTranslucent(Renderer* renderer, const ci::vec3& origin,
+                         const ci::vec3& forward, float field_of_view_angle,
+                         size_t render_radius) const;
 
   /// clips transform to the lattice block coordinate system and returns the
-  /// block type at the transform from the current blocks array, or `kNone` if
+  /// block type at the transform from the loaded chunks, or `kNone` if
   /// there is no block
   ///
   /// \param transform location
@@ -47,11 +132,12 @@ class World {
   /// draws a stroked cube at the closest block in the direction of `forward`
   /// from `origin`
   ///
+  /// \param renderer renderer to draw with
   /// \param origin a vector
   /// \param forward a vector
   /// \param directional_angle_allowance maximum angle difference for a block to
   /// be considered "in the direction" of the camera's forward vector
-  void OutlineBlockInDirectionOf(const ci::vec3& origin,
+  void OutlineBlockInDirectionOf(Renderer* renderer, const ci::vec3& origin,
                                  const ci::vec3& forward,
                                  float directional_angle_allowance) const;
 
@@ -82,24 +168,212 @@ class World {
   /// \param new_position player's new position
   /// \return true if and only if the player is outside the bounds of
   /// `old_chunk`
-  bool HasMovedChunks(const std::vector<int>& old_chunk,
+  bool HasMovedChunks(const ChunkCoordinates& old_chunk,
                       const ci::vec3& new_position) const;
 
-  /// deletes far away (>1 chunk distance) blocks and pushes blocks to the
-  /// blocks array that are adjacent to `new_chunk`. i.e. if the player has
-  /// passed between chunks in the x direction, loads the adjacent chunks
-  /// further away in the x direction in anticipation of movement there
+  /// recenters the loaded chunks on `new_chunk`: the chunks that are now
+  /// more than one chunk away are replaced by the newly adjacent ones. i.e.
+  /// if the player has passed between chunks in the x direction, loads the
+  /// adjacent chunks further away in the x direction in anticipation of
+  /// movement there. costs one slab of chunks per axis moved, see
+  /// `ChunkWindow`
   ///
   /// \param old_chunk player's old chunk
   /// \param new_chunk player's new chunk
-  void MoveToChunk(const std::vector<int>& old_chunk,
-                   const std::vector<int>& new_chunk);
+  void MoveToChunk(const ChunkCoordinates& old_chunk,
+                   const ChunkCoordinates& new_chunk);
 
   /// returns the chunk that a point is in
   ///
   /// \param point a point
   /// \return a chunk
-  std::vector<int> GetChunk(const ci::vec3& point) const;
+  ChunkCoordinates GetChunk(const ci::vec3& point) const;
+
+  /// finds the highest solid block of a column in the loaded chunks, from the
+  /// chunks' column tops, without reading any voxel
+  ///
+  /// \param x column's x coordinate
+  /// \param z column's z coordinate
+  /// \return y coordinate of the block, or `kNoColumnTop` if the column has
+  /// no solid block or is not loaded
+  int GetColumnTop(int x, int z) const;
+
+  /// sets the block at the lattice point closest to `transform`, recording it
+  /// as a player edit. the chunk does not have to be loaded; the edit is
+  /// applied whenever it is
+  ///
+  /// \param transform location
+  /// \param block_type new block type, or `kNone` to clear the block
+  /// \return the block type that was there before
+  BlockTypes SetBlockAt(const ci::vec3& transform,
+                        const BlockTypes& block_type);
+
+  /// generates every voxel of a chunk, loaded or not, including player edits.
+  /// voxels are ordered by x, then y, then z, each from low to high
+  ///
+  /// \param chunk a chunk
+  /// \return `(2 * chunk_radius)^3` block types
+  std::vector<BlockTypes> GetChunkBlocks(const ChunkCoordinates& chunk);
+
+  /// like `GetChunkBlocks`, but a loaded chunk's voxels are shared instead of
+  /// copied; they are only copied if the chunk is edited while the snapshot
+  /// lives
+  ///
+  /// \param chunk a chunk
+  /// \return a snapshot of the chunk
+  ChunkSnapshot GetChunkSnapshot(const ChunkCoordinates& chunk);
+
+  /// takes a consistent view of the loaded chunks for readers on other
+  /// threads, e.g. saving, streaming or meshing. costs one reference per
+  /// chunk; the first edit of a chunk afterwards copies that chunk only
+  ///
+  /// \return snapshots of every loaded chunk
+  WorldSnapshot GetSnapshot() const;
+
+  /// \return number of chunk copies made because an edit hit a chunk shared
+  /// with a snapshot, see `Chunk`
+  uint64_t GetChunkCopiesCount() const;
+
+  /// \return radius of chunks
+  size_t GetChunkRadius() const;
+
+  /// \return the lattice points covered by the loaded chunks
+  BlockBox GetLoadedBounds() const;
+
+  /// \param box a box
+  /// \return the player edits inside the box, loaded or not
+  std::vector<BlockEdit> GetEditsIn(const BlockBox& box) const;
+
+  /// \return the terrain generator the world was created with
+  TerrainGenerator* GetTerrainGenerator() const;
+
+  /// visits every block in a box, loaded or not, chunk by chunk. unloaded
+  /// chunks are generated on the fly, so the cost is proportional to the
+  /// chunks the box touches, not to the size of the world
+  ///
+  /// \param box a box
+  /// \param visitor called with the lattice point and block type of each block
+  void ForEachBlockIn(
+      const BlockBox& box,
+      const std::function<void(const glm::ivec3&, BlockTypes)>& visitor);
+
+  /// visits every block in a sphere, see `ForEachBlockIn(const BlockBox&, ...)`
+  ///
+  /// \param sphere a sphere
+  /// \param visitor called with the lattice point and block type of each block
+  void ForEachBlockIn(
+      const BlockSphere& sphere,
+      const std::function<void(const glm::ivec3&, BlockTypes)>& visitor);
+
+  /// sets every block in a box
+  ///
+  /// \param box a box
+  /// \param block_type new block type
+  /// \return the blocks that changed
+  std::vector<BlockChange> FillBox(const BlockBox& box,
+                                   const BlockTypes& block_type);
+
+  /// replaces every block of one type in a box with another type
+  ///
+  /// \param box a box
+  /// \param old_block_type block type to replace
+  /// \param new_block_type replacement
+  /// \return the blocks that changed
+  std::vector<BlockChange> ReplaceInBox(const BlockBox& box,
+                                        const BlockTypes& old_block_type,
+                                        const BlockTypes& new_block_type);
+
+  /// applies a list of edits as one transaction: either every edit is
+  /// applied, or (if any edit is invalid) none is and `std::invalid_argument`
+  /// is thrown. edits are grouped by chunk so the edit overlay, the voxels and
+  /// the render blocks of each touched chunk are updated once. later edits to
+  /// the same block win
+  ///
+  /// \param edits edits in application order
+  /// \return the blocks that changed, grouped by chunk
+  std::vector<BlockChange> ApplyEdits(const std::vector<BlockEdit>& edits);
+
+  /// advances the block simulation by one tick: runs the scheduled updates
+  /// that are due, then gives `kRandomTicksPerChunk` random ticks to every
+  /// loaded chunk that contains blocks which receive them. chunks without
+  /// such blocks are skipped after checking their count, so an idle world
+  /// costs almost nothing.
+  /// the resulting edits are applied as one transaction, and then the change
+  /// bus delivers everything that changed since the previous tick
+  ///
+  /// \return the blocks that changed
+  std::vector<BlockChange> Tick();
+
+  /// schedules an update of a loaded block. updates of blocks whose chunk is
+  /// unloaded by the time they are due are dropped
+  ///
+  /// \param position a lattice point
+  /// \param delay number of ticks from now
+  void ScheduleUpdate(const glm::ivec3& position, uint32_t delay);
+
+  /// \return statistics of the last tick
+  const TickStats& GetTickStats() const;
+
+  /// every change made through `ApplyEdits`, and so through every edit
+  /// method and `Tick`, is published here; each `Tick` ends with a flush, so
+  /// subscribers get one batch per tick
+  ///
+  /// \return the block change bus
+  BlockChangeBus& GetChangeBus();
+
+  /// \param chunk a chunk
+  /// \return lowest lattice point in the chunk
+  glm::ivec3 GetChunkMinCorner(const ChunkCoordinates& chunk) const;
+
+  /// \return the chunk the loaded chunks are centered on
+  const ChunkCoordinates& GetWindowCenter() const;
+
+  /// loads chunks of the window that are still pending after a progressive
+  /// spawn, nearest to the center first. chunks the prefetcher is building
+  /// are skipped until they are done, so this never waits for a worker
+  ///
+  /// \param max_chunks most chunks to load
+  /// \return number of chunks loaded
+  size_t StreamChunks(size_t max_chunks);
+
+  /// \return the chunks of the window that are not loaded yet, nearest to the
+  /// center first
+  std::vector<ChunkCoordinates> GetPendingChunks() const;
+
+  /// \param prefetcher source of chunks built ahead of time, consulted
+  /// before building a chunk to load, or nullptr; see `ChunkPrefetcher`
+  void SetPrefetcher(ChunkPrefetcher* prefetcher);
+
+  /// \return the translucent meshes of the loaded chunks that have
+  /// translucent faces, see `Chunk::GetTranslucentMesh`. the meshes stay in
+  /// place while the world lives
+  std::vector<const PackedMesh*> GetTranslucentMeshes() const;
+
+  /// \param sorter source of the order translucent faces are drawn in, or
+  /// nullptr to draw them in mesh order; see `TranslucentSorter`
+  void SetTranslucentSorter(const TranslucentSorter* sorter);
+
+  /// registers the world's metrics, see `WorldMetrics`. the timings and the
+  /// edit count are recorded as they happen; the gauges are refreshed at the
+  /// end of every `Tick`. without a registry nothing is recorded
+  ///
+  /// \param registry registry to report to, which must outlive the world
+  /// \throw std::invalid_argument if the metrics are already registered
+  void SetMetrics(MetricsRegistry* registry);
+
+  /// \return the metrics registered by `SetMetrics`, or nullptr
+  const WorldMetrics* GetMetrics() const;
+
+  /// chunks loaded on each side of the player's chunk
+  static constexpr int kWindowRadius = 1;
+  /// blocks around the player whose chunks a progressive spawn loads at once
+  static constexpr int kCollisionReach = 2;
+  /// `GetColumnTop` of a column without solid blocks
+  static constexpr int kNoColumnTop = std::numeric_limits<int>::min();
+  /// random ticks given to each active chunk per tick
+  static constexpr uint32_t kRandomTicksPerChunk = 3;
+  /// ticks before covered grass turns into dirt
+  static constexpr uint32_t kGrassDecayDelay = 20;
 
  protected:
   /// method of hashing blocks
@@ -112,11 +386,25 @@ class World {
       return ((key.x * 5209) ^ (key.y * 1811)) ^ (key.z * 7297);
     }
   };
-  /// current set of blocks in the current chunk and all adjacent chunks
-  std::vector<Block> blocks_;
-  /// a map of points to blocks used if a player alters the map from the
-  /// expected seed output
-  std::unordered_map<ci::vec3, BlockTypes, BlockHasher> player_map_edits_;
+  /// edits of one chunk, keyed by voxel index (see `Chunk::GetIndex`)
+  typedef std::unordered_map<
+      size_t, BlockTypes, std::hash<size_t>, std::equal_to<size_t>,
+      PoolAllocator<std::pair<const size_t, BlockTypes>>>
+      ChunkEdits;
+  /// edits of every chunk with any
+  typedef std::map<ChunkCoordinates, ChunkEdits, std::less<ChunkCoordinates>,
+                   PoolAllocator<std::pair<const ChunkCoordinates, ChunkEdits>>>
+      MapEdits;
+
+  /// the current chunk and all adjacent chunks
+  ChunkWindow chunks_;
+  /// blocks that a player has altered from the expected seed output, grouped
+  /// by chunk. kept for unloaded chunks too
+  MapEdits player_map_edits_;
+
+  /// \param position a lattice point
+  /// \return the chunk the point is in
+  ChunkCoordinates GetChunkOf(const glm::ivec3& position) const;
 
  private:
   /// terrain generator
@@ -124,55 +412,76 @@ class World {
   /// radius of chunks
   size_t chunk_radius_;
 
-  /// initialization step, generates all chunks near the player at the start of
-  /// game
+  /// scheduled block updates
+  TickScheduler tick_scheduler_;
+  /// picks random ticks; fixed seed, so the simulation is reproducible
+  std::mt19937 random_;
+  TickStats tick_stats_;
+  /// see `GetChangeBus`
+  BlockChangeBus change_bus_;
+  /// see `SetPrefetcher`
+  ChunkPrefetcher* prefetcher_;
+  /// see `SetTranslucentSorter`
+  const TranslucentSorter* translucent_sorter_;
+  /// see `SetMetrics`, all null until then
+  WorldMetrics metrics_;
+  bool has_metrics_;
+
+  /// fills a loaded chunk, see `ChunkWindow::Loader`, taking it from the
+  /// prefetcher if it has it
   ///
-  /// \param origin_chunk the player's initial chunk
-  void InitializeAdjacentChunks(const std::vector<int>& origin_chunk);
+  /// \param chunk chunk coordinates
+  /// \param voxels the chunk's slot
+  void LoadChunk(const ChunkCoordinates& chunk, Chunk* voxels);
 
-  /// deletes all blocks that are more than one chunk away
+  /// fills a chunk from the terrain generator and then applies the chunk's
+  /// player edits
   ///
-  /// \param new_chunk the player's new chunk
-  void DeleteDistanceChunks(const std::vector<int>& new_chunk);
+  /// \param chunk chunk coordinates
+  /// \param voxels output chunk
+  void GenerateVoxels(const ChunkCoordinates& chunk, Chunk* voxels);
 
-  /// pushes blocks to the blocks array that are adjacent to the passed chunk.
-  /// i.e. if the player has passed between chunks in the x direction, loads the
-  /// adjacent chunks further away in the x direction in anticipation of
-  /// movement there
+  /// refreshes the gauges of `metrics_`
+  void UpdateMetrics();
+
+  /// runs the behavior of a block for a scheduled update or a random tick
   ///
-  /// \param old_chunk the player's old chunk
-  /// \param new_chunk the player's new chunk
-  void LoadNextChunks(const std::vector<int>& old_chunk,
-                      const std::vector<int>& new_chunk);
+  /// \param position lattice point of the block
+  /// \param random whether this is a random tick
+  /// \param edits output edits
+  void UpdateBlock(const glm::ivec3& position, bool random,
+                   std::vector<BlockEdit>* edits);
 
-  /// generates a chunk a specified distance away from the player's chunk. for
-  /// use-case simplicity, takes a reference chunk with the delta from that
-  /// chunk.
+  /// lets a block react to a change of itself or of a face neighbor, usually
+  /// by scheduling an update
   ///
-  /// \param reference_chunk a reference chunk to calculate deltas from
-  /// \param delta_x distance in chunk-distance
-  /// \param delta_y distance in chunk-distance
-  /// \param delta_z distance in chunk-distance
-  void GenerateChunk(std::vector<int> old_chunk, int delta_x, int delta_y,
-                     int delta_z);
+  /// \param position lattice point of the block
+  void OnNeighborChanged(const glm::ivec3& position);
+
+  /// \param position a lattice point
+  /// \return whether the block above the point is opaque
+  bool IsCovered(const glm::ivec3& position);
 
-  /// generates the block at the specified transform
+  /// finds the closest solid block in the direction of `forward` from
+  /// `origin`
   ///
-  /// \param transform a location
-  /// \return a block type, or `kNone`
-  BlockTypes GenerateBlockAt(const ci::vec3& transform);
+  /// \param position output lattice point of the block
+  /// \return false if and only if there is no such block
+  bool FindBlockInDirectionOf(const ci::vec3& origin, const ci::vec3& forward,
+                              float directional_angle_allowance,
+                              glm::ivec3* position) const;
 
-  /// gets the index in `blocks_` of the closest block in the direction of
-  /// `forward` from `origin`, or -1 if there is no such block
-  int GetBlockIndexInDirectionOf(const ci::vec3& origin,
-                                 const ci::vec3& forward,
-                                 float directional_angle_allowance) const;
+  /// \param numerator a number
+  /// \param denominator a positive number
+  /// \return `numerator / denominator`, rounded towards negative infinity
+  static int FloorDivide(int numerator, int denominator);
 
   /// aligns `vector` to an axis unit vector
   static ci::vec3 FindAxisAlignedUnitVector(const ci::vec3& vector);
 
-  /// whether or not a block should be rendered in a particular frame
-  static bool IsWithinRenderDistance(const Block& block, const ci::vec3& origin,
+  /// whether or not any of a chunk's blocks may need rendering in a
+  /// particular frame, judged by the sphere around the chunk
+  static bool IsWithinRenderDistance(const Chunk& chunk, const ci::vec3& origin,
                                      const ci::vec3& forward,
                                      float field_of_view_angle,
                                      size_t render_radius);
@@ -11,7 +11,18 @@
 #include <vector>
 
 #include "core/camera.h"
+#include "core/chunk_prefetcher.h"
+#include "core/entity_physics.h"
+#include "core/entity_scheduler.h"
+#include "core/entity_store.h"
+#include "core/gl_renderer.h"
+#include "core/hud.h"
+#include "core/lod.h"
+#include "core/metrics.h"
+#include "core/metrics_exporter.h"
+#include "core/quality_controller.h"
 #include "core/terrain_generator.h"
+#include "core/translucent_sorter.h"
 #include "core/world.h"
 
 namespace minecraft {
@@ -51,10 +62,22 @@ class MinecraftApp : public ci::app::App {
   static const ci::vec2 kUIIconSize;
   /// field of view angle, blocks are not rendered outside this
   static const float kFieldOfViewAngle;
-  /// radius of the chunks, see `world.h` for the usage
-  static const size_t kChunkRadius;
-  /// maximum distance from player to render blocks in
-  static const size_t kRenderRadius;
+  /// quality preset used unless the `MINECRAFT_QUALITY` environment variable
+  /// names another, see `QualityController::kPresetNames`
+  static const char* const kDefaultQualityPreset;
+  /// frame time the quality settings are adjusted to hold
+  static const float kTargetFrameSeconds;
+  /// most pending chunks loaded per update after spawning, see
+  /// `World::StreamChunks`
+  static const size_t kStreamedChunksPerUpdate;
+  /// seconds between writes of `MINECRAFT_METRICS_FILE`
+  static const double kMetricsFileSeconds;
+  /// length of a step of the entity systems
+  static const float kEntityStepSeconds;
+  /// most entity steps run per update, see `EntityScheduler`
+  static const size_t kMaxEntitySteps;
+  /// cell of the entity broadphase, at least as wide as the widest entity
+  static const float kEntityCellSize;
   /// starting position
   static const ci::vec3 kPlayerStartingPosition;
   /// minimum height of terrain, i.e. sea level
@@ -89,27 +112,96 @@ class MinecraftApp : public ci::app::App {
   void keyDown(ci::app::KeyEvent e) override;
 
  private:
+  /// draws to the window
+  GlRenderer renderer_;
   /// world seed
   int seed_;
   /// camera
   Camera camera_;
+  /// render radius, LOD distance and streaming budget, adjusted to the
+  /// measured frame times
+  QualityController quality_;
+  /// world and frame statistics; declared before everything reporting to it
+  MetricsRegistry metrics_;
+  /// timings of `update` and `draw`
+  Histogram* update_seconds_metric_;
+  Histogram* draw_seconds_metric_;
+  /// chunks waiting to be built by the prefetcher and the level-of-detail
+  /// manager, and tasks waiting for a worker
+  Gauge* prefetch_queue_metric_;
+  Gauge* lod_queue_metric_;
+  Gauge* thread_pool_queue_metric_;
+  /// bytes live in and cached by the chunk memory pool
+  Gauge* pool_live_bytes_metric_;
+  Gauge* pool_cached_bytes_metric_;
+  /// number of entities
+  Gauge* entities_metric_;
   /// terrain generator (using Perlin noise)
   TerrainGenerator terrain_generator_;
   /// world, chunk handler
   World world_;
+  /// builds level-of-detail meshes in the background
+  ThreadPool thread_pool_;
+  /// distant terrain
+  LodManager lod_;
+  /// builds the chunks ahead of the player in the background
+  ChunkPrefetcher prefetcher_;
+  /// sorts the chunks' translucent faces in the background
+  TranslucentSorter translucent_sorter_;
+  /// mobs and other moving objects, besides the player
+  EntityStore entities_;
+  /// moves the entities and collides them with blocks and each other
+  EntityPhysics entity_physics_;
+  /// runs the entity systems in fixed steps
+  EntityScheduler entity_scheduler_;
+  /// publishes `metrics_` over HTTP on the port in `MINECRAFT_METRICS_PORT`
+  /// and to the file in `MINECRAFT_METRICS_FILE`, if they are set
+  MetricsExporter metrics_exporter_;
+  /// `getElapsedSeconds` as of the last update
+  double last_update_seconds_;
+  /// time the last update took
+  float update_seconds_;
+  /// whether a frame has been drawn, after which the time to interactive is
+  /// logged
+  bool drawn_;
+  /// whether every chunk of the window has been loaded since spawning, after
+  /// which the time to full view is logged
+  bool full_view_;
   /// current chunk
-  std::vector<int> current_chunk_;
+  ChunkCoordinates current_chunk_;
   /// player's current inventory
   std::map<BlockTypes, size_t> inventory_;
   /// the index of the block in kOrderedBlocks that the player is currently
   /// trying to place
   int current_placing_type_;
+  /// seed, coordinates and inventory overlay
+  Hud hud_;
+  /// `hud_` elements showing the x, y and z coordinates
+  size_t coordinate_texts_[3];
+  /// `hud_` elements showing the chunk memory pool's live and peak KiB and
+  /// its allocations in the last frame
+  size_t memory_texts_[3];
+  /// `MemoryStats::allocations` as of the last frame
+  uint64_t last_allocations_;
+  /// `hud_` elements showing the inventory count of each of `kOrderedBlocks`
+  std::vector<size_t> inventory_texts_;
+  /// `hud_` elements marking the selected block of `kOrderedBlocks`
+  std::vector<size_t> selected_markers_;
 
-  /// draws coordinates at the top of the screen
-  void DrawCoordinatesInterface();
+  /// adds the seed and coordinates at the top of the screen and the icons at
+  /// the bottom to `hud_`
+  void SetUpInterface();
 
-  /// draws icons at the bottom
-  void DrawIconsInterface();
+  /// registers the game's metrics and the world's, and starts the exports
+  /// the environment asks for
+  void SetUpMetrics();
+
+  /// refreshes the gauges that are sampled once per frame
+  void UpdateMetrics();
+
+  /// passes the current coordinates, memory use, inventory and selection to
+  /// `hud_`, which only redraws the elements whose values changed
+  void UpdateInterface();
 
   /// moves in the x or z direction if there is no obstacle blocking the move
   ///
@@ -120,6 +212,11 @@ class MinecraftApp : public ci::app::App {
   /// applies gravity to the camera if the player is not on ground
   void ApplyGravityIfNecessary();
 
+  /// \return whether a solid block is under the player's feet. the column
+  /// top answers this without probing the world, unless the player is below
+  /// it, e.g. under an overhang
+  bool IsOnGround();
+
   /// derived through projectile motion physics
   void JumpIfPossible();
 
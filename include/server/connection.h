@@ -0,0 +1,102 @@
+#ifndef MINECRAFT_CONNECTION_H
+#define MINECRAFT_CONNECTION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "protocol.h"
+
+namespace minecraft {
+
+/// a non-blocking, framed stream socket with send/receive byte counters
+class Connection {
+  /// bytes requested from the socket per `read` call
+  static const size_t kReadSize = 64 * 1024;
+
+ public:
+  /// takes ownership of a connected socket and makes it non-blocking
+  ///
+  /// \param descriptor a connected stream socket
+  explicit Connection(int descriptor);
+  /// closes the socket
+  ~Connection();
+  Connection(const Connection&) = delete;
+  Connection& operator=(const Connection&) = delete;
+
+  /// queues a frame; nothing is written until `Flush`
+  ///
+  /// \param type message type
+  /// \param payload message body
+  void Send(protocol::MessageType type, const std::vector<uint8_t>& payload);
+
+  /// writes as much queued output as the socket accepts
+  ///
+  /// \return false if and only if the peer is gone
+  bool Flush();
+
+  /// reads everything currently available from the socket
+  ///
+  /// \return false if and only if the peer is gone
+  bool Receive();
+
+  /// pops the next complete received frame
+  ///
+  /// \param message output
+  /// \return true if and only if a frame was available
+  bool NextMessage(protocol::Message* message);
+
+  /// \return true if and only if queued output has not been written yet
+  bool HasPendingOutput() const;
+  /// \return the socket
+  int GetDescriptor() const;
+  /// \return bytes written to the socket so far
+  uint64_t GetBytesSent() const;
+  /// \return bytes read from the socket so far
+  uint64_t GetBytesReceived() const;
+  /// \return bytes allocated for the input and output buffers
+  size_t GetBufferCapacity() const;
+
+ private:
+  /// the socket
+  int descriptor_;
+  /// received bytes that have not been consumed yet, starting at
+  /// `input_offset_`
+  std::vector<uint8_t> input_;
+  size_t input_offset_;
+  /// queued bytes that have not been written yet, starting at
+  /// `output_offset_`
+  std::vector<uint8_t> output_;
+  size_t output_offset_;
+  /// counters
+  uint64_t bytes_sent_;
+  uint64_t bytes_received_;
+};
+
+/// creates a listening Unix domain socket, replacing a stale socket file
+///
+/// \param path socket path
+/// \return a non-blocking listening socket
+int ListenUnix(const std::string& path);
+
+/// creates a listening TCP socket on the loopback interface
+///
+/// \param port port, or 0 for any free port
+/// \return a non-blocking listening socket
+int ListenTcp(uint16_t port);
+
+/// \param listener a listening socket
+/// \return the port a TCP listener is bound to
+uint16_t GetListeningPort(int listener);
+
+/// \param path socket path of a server
+/// \return a connected socket
+int ConnectUnix(const std::string& path);
+
+/// \param port port of a server on the loopback interface
+/// \return a connected socket
+int ConnectTcp(uint16_t port);
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_CONNECTION_H
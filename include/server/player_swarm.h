@@ -0,0 +1,166 @@
+#ifndef MINECRAFT_PLAYER_SWARM_H
+#define MINECRAFT_PLAYER_SWARM_H
+
+#include <cinder/gl/gl.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/region.h"
+#include "world_client.h"
+
+namespace minecraft {
+
+/// how the players of a `PlayerSwarm` move
+enum class SwarmMovement {
+  /// wander, turning a little every step
+  kRandomWalk,
+  /// walk a loop of waypoints around the spawn point
+  kScripted
+};
+
+/// what the players of a `PlayerSwarm` saw since it was created or its stats
+/// were last reset
+struct SwarmStats {
+  /// players connected
+  size_t players;
+  /// time covered
+  double seconds;
+  /// `kChunkData` messages received, over all players
+  uint64_t chunks_received;
+  /// chunks held now, over all players
+  uint64_t chunks_held;
+  /// edits sent, over all players
+  uint64_t edits_sent;
+  /// sent edits that came back in a change batch
+  uint64_t edits_confirmed;
+  /// sent edits that did not come back within the timeout, because another
+  /// player changed the block in the same tick or the player walked away
+  uint64_t edits_dropped;
+  /// time from sending an edit until its change was received, over the
+  /// confirmed edits
+  double p50_edit_seconds;
+  double p99_edit_seconds;
+  double max_edit_seconds;
+};
+
+/// simulated players for load testing a `WorldServer`. each player is a
+/// `WorldClient` connected over the server's socket that moves, reports its
+/// position every step, and digs or builds on the blocks it has been sent,
+/// the way the game's player would. the players are stepped on the calling
+/// thread, so the server can be ticked between steps or run elsewhere
+class PlayerSwarm {
+ public:
+  /// behavior of the players
+  struct Settings {
+    /// Unix socket path of the server
+    std::string socket_path;
+    SwarmMovement movement;
+    /// loop walked by `kScripted` players, relative to their spawn point.
+    /// players with no waypoints stand still
+    std::vector<ci::vec3> waypoints;
+    /// view radius asked for, in chunks
+    uint32_t view_radius;
+    /// walking speed, in blocks per second
+    float speed;
+    /// height the players walk at
+    float height;
+    /// players spawn anywhere in a square of this edge around the origin
+    float spawn_spread;
+    /// edits each player makes per second, on average
+    double edits_per_second;
+    /// players edit the top block of a column at most this many blocks away
+    /// horizontally, and at most twice as far below them
+    int reach;
+    /// sent edits not seen after this long are counted as dropped
+    double edit_timeout_seconds;
+    /// seed of the players' random choices
+    unsigned seed;
+  };
+
+  /// \param settings behavior of the players
+  /// \throw std::invalid_argument if the reach or speed are negative
+  explicit PlayerSwarm(const Settings& settings);
+
+  /// connects players and says hello for each of them
+  ///
+  /// \param count number of players to add
+  void AddPlayers(size_t count);
+
+  /// moves every player, sends its position and maybe an edit, then reads
+  /// what the server has sent it
+  ///
+  /// \param seconds time since the last step
+  /// \return false if and only if the server has gone away
+  bool Step(float seconds);
+
+  /// \return what the players saw since the last reset
+  SwarmStats GetStats() const;
+
+  /// starts measuring again
+  void ResetStats();
+
+  /// \return number of players
+  size_t GetPlayersCount() const;
+
+  /// \param player index of a player
+  /// \return the player's client
+  const WorldClient& GetClient(size_t player) const;
+
+  /// \param player index of a player
+  /// \return the player's position
+  ci::vec3 GetPosition(size_t player) const;
+
+ private:
+  /// an edit waiting to come back from the server
+  struct PendingEdit {
+    BlockEdit edit;
+    std::chrono::steady_clock::time_point sent_at;
+  };
+
+  struct Player {
+    WorldClient client;
+    std::mt19937 generator;
+    ci::vec3 spawn;
+    ci::vec3 position;
+    /// direction of a `kRandomWalk` player, in radians around the y axis
+    float heading;
+    /// waypoint a `kScripted` player walks to
+    size_t waypoint;
+    std::vector<PendingEdit> pending_edits;
+  };
+
+  Settings settings_;
+  std::mt19937 generator_;
+  std::vector<std::unique_ptr<Player>> players_;
+
+  std::chrono::steady_clock::time_point stats_start_;
+  uint64_t chunks_received_;
+  uint64_t edits_sent_;
+  uint64_t edits_dropped_;
+  std::vector<double> edit_seconds_;
+
+  /// \param player a player
+  /// \param seconds length of the step
+  void Move(Player* player, float seconds);
+
+  /// digs the top block of a random column in reach, or builds on it. does
+  /// nothing if the column has not been received or has no top in reach
+  ///
+  /// \param player a player
+  void Edit(Player* player);
+
+  /// confirms the pending edits that have come back and drops the old ones
+  ///
+  /// \param player a player that has just polled
+  void CheckEdits(Player* player);
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_PLAYER_SWARM_H
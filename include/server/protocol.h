@@ -0,0 +1,173 @@
+#ifndef MINECRAFT_PROTOCOL_H
+#define MINECRAFT_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "core/block_types.h"
+#include "core/region.h"
+
+namespace minecraft {
+
+/// wire format shared by `WorldServer` and `WorldClient`. every message is a
+/// frame of a little-endian u32 payload length, a u8 message type and the
+/// payload itself
+namespace protocol {
+
+/// bumped whenever the wire format changes
+const uint8_t kProtocolVersion = 1;
+/// bytes before the payload of each frame (length + type)
+const size_t kFrameHeaderSize = 5;
+/// frames larger than this are treated as a corrupt stream
+const uint32_t kMaxPayloadSize = 1 << 24;
+
+/// the different messages in the protocol
+enum MessageType : uint8_t {
+  // client -> server
+  kHello = 1,
+  kPosition = 2,
+  kEditRequest = 3,
+  // server -> client
+  kWelcome = 16,
+  kChunkData = 17,
+  kChunkUnload = 18,
+  kBlockDeltas = 19
+};
+
+/// integer chunk coordinates as sent over the wire
+struct ChunkKey {
+  int32_t x;
+  int32_t y;
+  int32_t z;
+
+  bool operator==(const ChunkKey& other) const;
+  bool operator!=(const ChunkKey& other) const;
+  bool operator<(const ChunkKey& other) const;
+};
+
+/// all of the block changes of one tick that fall inside a single chunk. the
+/// positions are indices into the chunk's voxel array (see `EncodeChunk`)
+struct ChunkDelta {
+  ChunkKey chunk;
+  std::vector<uint32_t> indices;
+  std::vector<BlockTypes> block_types;
+};
+
+/// a complete frame read from a stream
+struct Message {
+  MessageType type;
+  std::vector<uint8_t> payload;
+};
+
+/// appends little-endian primitives to a byte buffer
+class ByteWriter {
+ public:
+  /// \param buffer buffer to append to, must outlive this writer
+  explicit ByteWriter(std::vector<uint8_t>* buffer);
+
+  void WriteU8(uint8_t value);
+  void WriteU32(uint32_t value);
+  void WriteI32(int32_t value);
+  void WriteF32(float value);
+  /// LEB128 variable-length unsigned integer
+  void WriteVarUint(uint32_t value);
+
+ private:
+  std::vector<uint8_t>* buffer_;
+};
+
+/// reads little-endian primitives from a byte range. reading past the end
+/// throws `std::out_of_range` so that truncated messages never produce garbage
+class ByteReader {
+ public:
+  /// \param data start of the range
+  /// \param size size of the range in bytes
+  ByteReader(const uint8_t* data, size_t size);
+  /// \param buffer a buffer that must outlive this reader
+  explicit ByteReader(const std::vector<uint8_t>& buffer);
+
+  uint8_t ReadU8();
+  uint32_t ReadU32();
+  int32_t ReadI32();
+  float ReadF32();
+  uint32_t ReadVarUint();
+  /// \return true if and only if every byte has been consumed
+  bool AtEnd() const;
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t offset_;
+
+  /// throws if fewer than `count` bytes remain
+  void Require(size_t count) const;
+};
+
+/// appends a frame to `out`
+///
+/// \param type message type
+/// \param payload message body
+/// \param out buffer to append to
+void AppendFrame(MessageType type, const std::vector<uint8_t>& payload,
+                 std::vector<uint8_t>* out);
+
+/// reads the complete frame starting at `*offset`, if there is one. callers
+/// drain every available frame and then erase the consumed prefix once, so a
+/// burst of small frames does not shift the buffer once per frame
+///
+/// \param buffer bytes received so far
+/// \param offset position of the next frame, advanced past it on success
+/// \param message output
+/// \return true if and only if a complete frame was extracted
+bool ExtractFrame(const std::vector<uint8_t>& buffer, size_t* offset,
+                  Message* message);
+
+/// run-length encodes a chunk. voxels are ordered x-major, then y, then z,
+/// which is the order `World::GetChunkBlocks` produces. terrain is mostly long
+/// runs of air and dirt, so a chunk is usually a few dozen bytes
+///
+/// \param chunk chunk coordinates
+/// \param blocks the chunk's voxels
+/// \param count number of voxels
+/// \return payload of a `kChunkData` message
+std::vector<uint8_t> EncodeChunk(const ChunkKey& chunk,
+                                 const BlockTypes* blocks, size_t count);
+
+/// `EncodeChunk` of a vector of voxels
+inline std::vector<uint8_t> EncodeChunk(const ChunkKey& chunk,
+                                        const std::vector<BlockTypes>& blocks) {
+  return EncodeChunk(chunk, blocks.data(), blocks.size());
+}
+
+/// inverse of `EncodeChunk`
+///
+/// \param payload a `kChunkData` payload
+/// \param volume number of voxels in a chunk
+/// \param chunk output chunk coordinates
+/// \param blocks output voxels
+void DecodeChunk(const std::vector<uint8_t>& payload, size_t volume,
+                 ChunkKey* chunk, std::vector<BlockTypes>* blocks);
+
+/// encodes one tick's worth of changes, grouped by chunk
+///
+/// \param tick server tick the changes were applied in
+/// \param deltas changes grouped by chunk
+/// \return payload of a `kBlockDeltas` message
+std::vector<uint8_t> EncodeDeltas(uint32_t tick,
+                                  const std::vector<ChunkDelta>& deltas);
+
+/// inverse of `EncodeDeltas`
+///
+/// \param payload a `kBlockDeltas` payload
+/// \param tick output tick
+/// \param deltas output changes
+void DecodeDeltas(const std::vector<uint8_t>& payload, uint32_t* tick,
+                  std::vector<ChunkDelta>* deltas);
+
+}  // namespace protocol
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_PROTOCOL_H
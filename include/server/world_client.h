@@ -0,0 +1,109 @@
+#ifndef MINECRAFT_WORLD_CLIENT_H
+#define MINECRAFT_WORLD_CLIENT_H
+
+#include <cinder/gl/gl.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "connection.h"
+#include "core/block_types.h"
+#include "core/region.h"
+#include "protocol.h"
+
+namespace minecraft {
+
+/// a client of `WorldServer` that mirrors the chunks it is sent. used by the
+/// loopback clients of the server app and by tests
+class WorldClient {
+ public:
+  /// creates a disconnected client
+  WorldClient();
+
+  /// \param path socket path of the server
+  void ConnectUnix(const std::string& path);
+
+  /// \param port loopback port of the server
+  void ConnectTcp(uint16_t port);
+
+  /// asks the server to start streaming
+  ///
+  /// \param view_radius requested view radius in chunks
+  void SendHello(uint32_t view_radius);
+
+  /// \param position the player's new position
+  void SendPosition(const ci::vec3& position);
+
+  /// \param edit a block the player wants to change
+  void SendEdit(const BlockEdit& edit);
+
+  /// flushes queued requests, then reads and applies everything the server
+  /// has sent
+  ///
+  /// \return false if and only if the server has gone away
+  bool Poll();
+
+  /// \param x lattice coordinate
+  /// \param y lattice coordinate
+  /// \param z lattice coordinate
+  /// \return the block, or `kNone` if its chunk has not been received
+  BlockTypes GetBlockAt(int x, int y, int z) const;
+
+  /// \param x lattice coordinate
+  /// \param y lattice coordinate
+  /// \param z lattice coordinate
+  /// \return true if and only if the block's chunk has been received
+  bool HoldsBlockAt(int x, int y, int z) const;
+
+  /// \return true if and only if a `kWelcome` has been received
+  bool IsWelcomed() const;
+  /// \return id assigned by the server
+  uint32_t GetClientId() const;
+  /// \return world seed
+  int GetSeed() const;
+  /// \return the chunks currently held
+  const std::map<protocol::ChunkKey, std::vector<BlockTypes>>& GetChunks()
+      const;
+  /// \return the server tick of the last change batch received
+  uint32_t GetLastDeltaTick() const;
+  /// \return the number of change batches received
+  uint64_t GetDeltaBatchCount() const;
+  /// \return the number of `kChunkData` messages received
+  uint64_t GetChunksReceivedCount() const;
+  /// \return bytes sent to the server
+  uint64_t GetBytesSent() const;
+  /// \return bytes received from the server
+  uint64_t GetBytesReceived() const;
+
+ private:
+  std::unique_ptr<Connection> connection_;
+  bool welcomed_;
+  uint32_t client_id_;
+  int seed_;
+  /// radius of each chunk, as announced by the server
+  int chunk_radius_;
+  std::map<protocol::ChunkKey, std::vector<BlockTypes>> chunks_;
+  uint32_t last_delta_tick_;
+  uint64_t delta_batch_count_;
+  uint64_t chunks_received_count_;
+
+  /// \param message a server message
+  void HandleMessage(const protocol::Message& message);
+
+  /// \param x lattice coordinate
+  /// \param y lattice coordinate
+  /// \param z lattice coordinate
+  /// \return the block in the chunks held, or nullptr if its chunk has not
+  /// been received
+  const BlockTypes* FindBlock(int x, int y, int z) const;
+
+  /// \return volume of a chunk
+  size_t GetChunkVolume() const;
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_WORLD_CLIENT_H
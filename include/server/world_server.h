@@ -0,0 +1,175 @@
+#ifndef MINECRAFT_WORLD_SERVER_H
+#define MINECRAFT_WORLD_SERVER_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "connection.h"
+#include "core/edit_journal.h"
+#include "core/terrain_generator.h"
+#include "core/world.h"
+#include "protocol.h"
+
+namespace minecraft {
+
+/// traffic and cost of one connected client
+struct ClientStats {
+  /// id handed out in the client's `kWelcome`
+  uint32_t client_id;
+  /// bytes written to the client
+  uint64_t bytes_sent;
+  /// bytes read from the client
+  uint64_t bytes_received;
+  /// number of `kChunkData` messages sent
+  uint64_t chunks_sent;
+  /// number of `kEditRequest` messages received
+  uint64_t edits_received;
+  /// number of ticks the client has been connected for
+  uint64_t ticks;
+  /// total time spent reading from, streaming to and flushing this client
+  double service_seconds;
+  /// chunks the client currently holds
+  uint64_t chunks_held;
+  /// estimate of the memory the server keeps for the client: its state, the
+  /// set of chunks it holds and its connection buffers
+  uint64_t memory_bytes;
+};
+
+/// the authoritative world: owns the terrain generator and the world, accepts
+/// loopback clients over a Unix or TCP socket, streams chunks around each
+/// client's position and broadcasts the block changes of each tick as a single
+/// batch
+class WorldServer {
+ public:
+  /// world and streaming parameters
+  struct Settings {
+    /// world seed
+    int seed;
+    /// radius of each chunk, see `world.h`
+    size_t chunk_radius;
+    /// terrain parameters, see `terrain_generator.h`
+    int min_terrain_height;
+    int max_terrain_height;
+    float terrain_variance;
+    /// largest view radius (in chunks) a client may ask for
+    size_t max_view_radius;
+    /// chunks streamed to a single client per tick
+    size_t chunks_per_tick;
+    /// directory the world's edits are saved to and recovered from, see
+    /// `EditJournal`; empty to keep them in memory only
+    std::string save_directory;
+  };
+
+  /// creates the world around the origin and restores the edits of the save
+  /// directory, if any; call `ListenUnix` or `ListenTcp` before ticking
+  ///
+  /// \param settings world and streaming parameters
+  explicit WorldServer(const Settings& settings);
+  /// closes the listener and all clients
+  ~WorldServer();
+  WorldServer(const WorldServer&) = delete;
+  WorldServer& operator=(const WorldServer&) = delete;
+
+  /// \param path Unix domain socket path
+  void ListenUnix(const std::string& path);
+
+  /// \param port loopback TCP port, or 0 for any free port
+  /// \return the bound port
+  uint16_t ListenTcp(uint16_t port);
+
+  /// runs one simulation tick: accepts new clients, reads their requests,
+  /// applies all queued edits at once, then streams chunks and the tick's
+  /// change batch to every client
+  void Tick();
+
+  /// \return the number of ticks run
+  uint32_t GetTick() const;
+  /// \return duration of the last tick
+  double GetLastTickSeconds() const;
+  /// \return traffic and cost of every connected client
+  std::vector<ClientStats> GetClientStats() const;
+  /// \return the authoritative world
+  World& GetWorld();
+  /// \return the journal of the save directory, or nullptr if there is none
+  const EditJournal* GetJournal() const;
+
+ private:
+  /// server-side state of a connected client
+  struct Client {
+    std::unique_ptr<Connection> connection;
+    /// true once a `kHello` has been received
+    bool greeted;
+    /// last reported position
+    ci::vec3 position;
+    /// requested view radius in chunks
+    int view_radius;
+    /// chunks the client currently holds
+    std::set<protocol::ChunkKey> sent_chunks;
+    ClientStats stats;
+  };
+
+  Settings settings_;
+  TerrainGenerator terrain_generator_;
+  World world_;
+  /// persists every change of `world_`, or nullptr
+  std::unique_ptr<EditJournal> journal_;
+  /// listening socket, or -1
+  int listener_;
+  /// path to unlink on shutdown if listening on a Unix socket
+  std::string unix_path_;
+  std::vector<std::unique_ptr<Client>> clients_;
+  uint32_t next_client_id_;
+  uint32_t tick_;
+  double last_tick_seconds_;
+  /// edits received since the last tick, applied in arrival order
+  std::vector<BlockEdit> pending_edits_;
+  /// the changes of the current tick, see `ReplicateChanges`
+  std::vector<protocol::ChunkDelta> tick_deltas_;
+
+  /// accepts every pending connection
+  void AcceptClients();
+
+  /// reads and handles every complete message from a client
+  ///
+  /// \return false if and only if the client disconnected
+  bool ReadClient(Client* client);
+
+  /// \param client the sender
+  /// \param message a client message
+  void HandleMessage(Client* client, const protocol::Message& message);
+
+  /// applies `pending_edits_` to the world as one transaction, then ticks the
+  /// world
+  ///
+  /// \return the resulting changes grouped by chunk; edits that did not change
+  /// anything are dropped and repeated edits to a block collapse into one
+  std::vector<protocol::ChunkDelta> ApplyPendingEdits();
+
+  /// subscriber of the world's change bus: turns a tick's changes into
+  /// `tick_deltas_`
+  void ReplicateChanges(const BlockChangeBatch& batch);
+
+  /// sends missing chunks nearest-first within the client's view, and unloads
+  /// chunks that have fallen out of it
+  void StreamChunks(Client* client);
+
+  /// sends the parts of a tick's change batch that the client holds
+  void SendDeltas(Client* client,
+                  const std::vector<protocol::ChunkDelta>& deltas);
+
+  /// \param point a location
+  /// \return the chunk containing the point
+  protocol::ChunkKey GetChunkKey(const ci::vec3& point) const;
+
+  /// \param key chunk coordinates
+  /// \return lowest lattice point in the chunk
+  glm::ivec3 GetChunkMinCorner(const protocol::ChunkKey& key) const;
+};
+
+}  // namespace minecraft
+
+#endif  // MINECRAFT_WORLD_SERVER_H
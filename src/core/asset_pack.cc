@@ -0,0 +1,266 @@
+#include "core/asset_pack.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using std::invalid_argument;
+using std::map;
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+namespace minecraft {
+
+const uint32_t AssetPack::kVersion = 1;
+const size_t AssetPack::kMaxNameLength = 43;
+const char* const AssetPack::kFileName = "assets.pack";
+const char* const AssetPack::kAtlasName = "atlas";
+
+namespace {
+
+const char kMagic[4] = {'M', 'C', 'A', 'P'};
+const size_t kHeaderSize = 16;
+const size_t kEntrySize = 64;
+/// bytes of an entry's name field, including the terminating NUL
+const size_t kNameSize = 44;
+/// images start at multiples of this, so they can be read with aligned loads
+const size_t kAlignment = 64;
+const size_t kBytesPerPixel = 4;
+
+uint32_t ReadUint32(const uint8_t* bytes) {
+  return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 |
+         uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+}
+
+uint64_t ReadUint64(const uint8_t* bytes) {
+  return uint64_t(ReadUint32(bytes)) | uint64_t(ReadUint32(bytes + 4)) << 32;
+}
+
+void WriteUint32(uint32_t value, uint8_t* bytes) {
+  for (int byte = 0; byte < 4; ++byte) {
+    bytes[byte] = uint8_t(value >> (8 * byte));
+  }
+}
+
+void WriteUint64(uint64_t value, uint8_t* bytes) {
+  WriteUint32(uint32_t(value), bytes);
+  WriteUint32(uint32_t(value >> 32), bytes + 4);
+}
+
+/// \return `value` rounded up to a multiple of `kAlignment`
+size_t Align(size_t value) {
+  return (value + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+/// \return number of mip levels down to 1x1
+uint32_t GetFullLevelsCount(uint32_t width, uint32_t height) {
+  uint32_t levels_count = 1;
+  while ((width >> levels_count) > 0 || (height >> levels_count) > 0) {
+    ++levels_count;
+  }
+  return levels_count;
+}
+
+/// \return a level half the size of `pixels`, each pixel the average of the
+/// (up to) four it covers
+vector<uint8_t> Downsample(const vector<uint8_t>& pixels, uint32_t width,
+                           uint32_t height) {
+  uint32_t half_width = std::max(width / 2, 1u);
+  uint32_t half_height = std::max(height / 2, 1u);
+  vector<uint8_t> half(size_t(half_width) * half_height * kBytesPerPixel);
+  for (uint32_t y = 0; y < half_height; ++y) {
+    for (uint32_t x = 0; x < half_width; ++x) {
+      for (size_t channel = 0; channel < kBytesPerPixel; ++channel) {
+        uint32_t sum = 0;
+        for (uint32_t dy = 0; dy < 2; ++dy) {
+          for (uint32_t dx = 0; dx < 2; ++dx) {
+            uint32_t source_x = std::min(2 * x + dx, width - 1);
+            uint32_t source_y = std::min(2 * y + dy, height - 1);
+            sum += pixels[(size_t(source_y) * width + source_x) *
+                              kBytesPerPixel +
+                          channel];
+          }
+        }
+        half[(size_t(y) * half_width + x) * kBytesPerPixel + channel] =
+            uint8_t((sum + 2) / 4);
+      }
+    }
+  }
+  return half;
+}
+
+/// throws with the current `errno` description
+void ThrowSystemError(const string& what) {
+  throw runtime_error(what + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+uint32_t PackedImage::GetWidth(uint32_t level) const {
+  return std::max(width >> level, 1u);
+}
+
+uint32_t PackedImage::GetHeight(uint32_t level) const {
+  return std::max(height >> level, 1u);
+}
+
+const uint8_t* PackedImage::GetLevel(uint32_t level) const {
+  const uint8_t* level_pixels = pixels;
+  for (uint32_t previous = 0; previous < level; ++previous) {
+    level_pixels +=
+        size_t(GetWidth(previous)) * GetHeight(previous) * kBytesPerPixel;
+  }
+  return level_pixels;
+}
+
+size_t PackedImage::GetBytes() const {
+  return size_t(GetLevel(levels_count) - pixels);
+}
+
+AssetPack::AssetPack(const string& path) : mapping_(nullptr), bytes_(0) {
+  int descriptor = open(path.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    ThrowSystemError("open " + path);
+  }
+  struct stat status;
+  if (fstat(descriptor, &status) < 0) {
+    close(descriptor);
+    ThrowSystemError("stat " + path);
+  }
+  bytes_ = size_t(status.st_size);
+  if (bytes_ < kHeaderSize) {
+    close(descriptor);
+    throw runtime_error(path + " is not an asset pack");
+  }
+  mapping_ = mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  // the mapping keeps the file alive
+  close(descriptor);
+  if (mapping_ == MAP_FAILED) {
+    mapping_ = nullptr;
+    ThrowSystemError("mmap " + path);
+  }
+
+  const uint8_t* file = static_cast<const uint8_t*>(mapping_);
+  try {
+    if (std::memcmp(file, kMagic, sizeof(kMagic)) != 0 ||
+        ReadUint32(file + 4) != kVersion) {
+      throw runtime_error(path + " is not an asset pack of version " +
+                          std::to_string(kVersion));
+    }
+    size_t images_count = ReadUint32(file + 8);
+    if (images_count > (bytes_ - kHeaderSize) / kEntrySize) {
+      throw runtime_error(path + " is truncated");
+    }
+    for (size_t image = 0; image < images_count; ++image) {
+      const uint8_t* entry = file + kHeaderSize + image * kEntrySize;
+      const char* name = reinterpret_cast<const char*>(entry);
+      if (std::memchr(name, '\0', kNameSize) == nullptr) {
+        throw runtime_error(path + " has an unterminated image name");
+      }
+      PackedImage packed;
+      packed.width = ReadUint32(entry + kNameSize);
+      packed.height = ReadUint32(entry + kNameSize + 4);
+      packed.levels_count = ReadUint32(entry + kNameSize + 8);
+      uint64_t offset = ReadUint64(entry + kNameSize + 12);
+      if (packed.width == 0 || packed.height == 0 ||
+          packed.levels_count == 0 ||
+          packed.levels_count >
+              GetFullLevelsCount(packed.width, packed.height) ||
+          offset % kAlignment != 0 || offset > bytes_) {
+        throw runtime_error(path + " has a corrupt entry for " + name);
+      }
+      packed.pixels = file + offset;
+      // checks level 0 first, so the size of the levels cannot overflow
+      if (packed.width > (bytes_ - offset) / kBytesPerPixel / packed.height ||
+          packed.GetBytes() > bytes_ - offset) {
+        throw runtime_error(path + " is truncated");
+      }
+      images_[name] = packed;
+    }
+  } catch (...) {
+    munmap(mapping_, bytes_);
+    throw;
+  }
+}
+
+AssetPack::~AssetPack() {
+  munmap(mapping_, bytes_);
+}
+
+const PackedImage* AssetPack::Find(const string& name) const {
+  map<string, PackedImage>::const_iterator image = images_.find(name);
+  return image == images_.end() ? nullptr : &image->second;
+}
+
+vector<string> AssetPack::GetNames() const {
+  vector<string> names;
+  for (const std::pair<const string, PackedImage>& image : images_) {
+    names.push_back(image.first);
+  }
+  return names;
+}
+
+size_t AssetPack::GetBytes() const {
+  return bytes_;
+}
+
+void AssetPack::Write(const string& path, const vector<AssetImage>& images,
+                      bool mipmaps) {
+  vector<uint8_t> file(Align(kHeaderSize + images.size() * kEntrySize));
+  std::memcpy(file.data(), kMagic, sizeof(kMagic));
+  WriteUint32(kVersion, &file[4]);
+  WriteUint32(uint32_t(images.size()), &file[8]);
+  for (size_t image = 0; image < images.size(); ++image) {
+    const AssetImage& source = images[image];
+    if (source.name.size() > kMaxNameLength) {
+      throw invalid_argument(source.name + " is too long for an image name");
+    }
+    if (source.width == 0 || source.height == 0 ||
+        source.pixels.size() !=
+            size_t(source.width) * source.height * kBytesPerPixel) {
+      throw invalid_argument(source.name + " does not have " +
+                             std::to_string(source.width) + "x" +
+                             std::to_string(source.height) + " RGBA pixels");
+    }
+    uint32_t levels_count =
+        mipmaps ? GetFullLevelsCount(source.width, source.height) : 1;
+    size_t offset = file.size();
+
+    uint8_t* entry = &file[kHeaderSize + image * kEntrySize];
+    std::memcpy(entry, source.name.c_str(), source.name.size() + 1);
+    WriteUint32(source.width, entry + kNameSize);
+    WriteUint32(source.height, entry + kNameSize + 4);
+    WriteUint32(levels_count, entry + kNameSize + 8);
+    WriteUint64(offset, entry + kNameSize + 12);
+
+    vector<uint8_t> level = source.pixels;
+    uint32_t width = source.width;
+    uint32_t height = source.height;
+    for (uint32_t index = 0; index < levels_count; ++index) {
+      if (index > 0) {
+        level = Downsample(level, width, height);
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+      }
+      file.insert(file.end(), level.begin(), level.end());
+    }
+    file.resize(Align(file.size()));
+  }
+
+  std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+  stream.write(reinterpret_cast<const char*>(file.data()),
+               std::streamsize(file.size()));
+  if (!stream) {
+    throw runtime_error("could not write " + path);
+  }
+}
+
+}  // namespace minecraft
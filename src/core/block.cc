@@ -1,5 +1,7 @@
 #include "core/block.h"
 
+#include "core/block_registry.h"
+#include "core/packed_vertex.h"
 #include "core/texture.h"
 
 using ci::Color;
@@ -10,6 +12,7 @@ using ci::vec3;
 using ci::gl::Texture2d;
 using ci::gl::Texture2dRef;
 using ci::gl::VboMesh;
+using glm::ivec3;
 using std::vector;
 
 namespace minecraft {
@@ -30,18 +33,21 @@ const vec3 Block::kCubeFaces[6][4] = {
     {kCubeVertices[1], kCubeVertices[0], kCubeVertices[3], kCubeVertices[2]},
     {kCubeVertices[1], kCubeVertices[5], kCubeVertices[4], kCubeVertices[0]}};
 
+const vec2 Block::kSquareTexCoords[4] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+
+const glm::ivec3 Block::kFaceDirections[6] = {{0, 1, 0},  {-1, 0, 0},
+                                              {0, 0, 1},  {1, 0, 0},
+                                              {0, 0, -1}, {0, -1, 0}};
+
 Block::Block(const BlockTypes& block_type, const vec3& center) {
-  texture_ = Texture(block_type).GetTexture();
   block_type_ = block_type;
   center_ = center;
-  SetUp();
 }
 
-void Block::Render() const {
-  ci::gl::ScopedGlslProg glslScope{
-      ci::gl::getStockShader(ci::gl::ShaderDef().texture())};
-  ci::gl::ScopedTextureBind texScope{texture_};
-  ci::gl::draw(mesh_);
+void Block::Render(Renderer* renderer) const {
+  PackedMesh mesh(ivec3(glm::round(center_)));
+  mesh.AppendBlock(ivec3(0), block_type_);
+  renderer->DrawPackedMesh(mesh);
 }
 
 BlockTypes Block::GetType() const {
@@ -52,23 +58,19 @@ vec3 Block::GetCenter() const {
   return center_;
 }
 
-void Block::SetUp() {
-  // https://mottosso.gitbooks.io/cinder/content/book/guide_to_meshes.htmlss
-  mesh_ = TriMesh(TriMesh::Format().positions().texCoords(2));
-  vec2 texture_vertices[kSquareVerticesCount] = {
-      {0, 0}, {1.0f / kCubeFacesCount, 0}, {1.0f / kCubeFacesCount, 1}, {0, 1}};
-  for (size_t face = 0; face < kCubeFacesCount; ++face) {
-    for (size_t vertex = 0; vertex < kSquareVerticesCount; ++vertex) {
-      mesh_.appendPosition(kCubeFaces[face][vertex] + center_);
-      vec2 face_texture_delta(face * 1.0f / kCubeFacesCount, 0);
-      mesh_.appendTexCoord(texture_vertices[vertex] + face_texture_delta);
-    }
-    size_t vertices_count = mesh_.getNumVertices();
-    mesh_.appendTriangle(vertices_count - 4, vertices_count - 3,
-                         vertices_count - 2);
-    mesh_.appendTriangle(vertices_count - 4, vertices_count - 2,
-                         vertices_count - 1);
+void Block::AppendFace(TriMesh* mesh, BlockTypes block_type, size_t face,
+                       const vec3& center, float size) {
+  uint8_t layer = BlockRegistry::GetFaceLayer(block_type, face);
+  for (size_t vertex = 0; vertex < kSquareVerticesCount; ++vertex) {
+    mesh->appendPosition(kCubeFaces[face][vertex] * size + center);
+    mesh->appendTexCoord(
+        Texture::GetAtlasCoordinates(layer, kSquareTexCoords[vertex]));
   }
+  size_t vertices_count = mesh->getNumVertices();
+  mesh->appendTriangle(vertices_count - 4, vertices_count - 3,
+                       vertices_count - 2);
+  mesh->appendTriangle(vertices_count - 4, vertices_count - 2,
+                       vertices_count - 1);
 }
 
 }  // namespace minecraft
@@ -0,0 +1,176 @@
+#include "core/block_change_bus.h"
+
+#include <algorithm>
+
+using glm::ivec3;
+using std::map;
+using std::vector;
+
+namespace minecraft {
+
+namespace {
+
+int FloorDivide(int numerator, int denominator) {
+  int quotient = numerator / denominator;
+  return quotient * denominator > numerator ? quotient - 1 : quotient;
+}
+
+/// \param chunk changes of a chunk
+/// \param region a box
+/// \param filtered output changes of the chunk inside the box
+/// \return false if and only if no change is inside the box
+bool FilterChanges(const ChunkChanges& chunk, const BlockBox& region,
+                   ChunkChanges* filtered) {
+  if (!chunk.bounds.Intersects(region)) {
+    return false;
+  }
+  if (region.Contains(chunk.bounds.min_corner) &&
+      region.Contains(chunk.bounds.max_corner)) {
+    *filtered = chunk;
+    return true;
+  }
+  filtered->chunk = chunk.chunk;
+  filtered->changes.clear();
+  for (const BlockChange& change : chunk.changes) {
+    if (!region.Contains(change.position)) {
+      continue;
+    }
+    if (filtered->changes.empty()) {
+      filtered->bounds = BlockBox{change.position, change.position};
+    }
+    filtered->bounds.min_corner =
+        glm::min(filtered->bounds.min_corner, change.position);
+    filtered->bounds.max_corner =
+        glm::max(filtered->bounds.max_corner, change.position);
+    filtered->changes.push_back(change);
+  }
+  return !filtered->changes.empty();
+}
+
+}  // namespace
+
+size_t BlockChangeBatch::GetChangesCount() const {
+  size_t count = 0;
+  for (const ChunkChanges& chunk : chunks) {
+    count += chunk.changes.size();
+  }
+  return count;
+}
+
+BlockChangeBus::BlockChangeBus(size_t chunk_radius)
+    : chunk_radius_(int(chunk_radius)),
+      next_subscription_id_(1),
+      stats_{0, 0, 0} {
+}
+
+size_t BlockChangeBus::Subscribe(const Subscriber& subscriber) {
+  subscriptions_.push_back(
+      Subscription{next_subscription_id_, subscriber, false, BlockBox()});
+  return next_subscription_id_++;
+}
+
+size_t BlockChangeBus::Subscribe(const Subscriber& subscriber,
+                                 const BlockBox& region) {
+  subscriptions_.push_back(
+      Subscription{next_subscription_id_, subscriber, true, region});
+  return next_subscription_id_++;
+}
+
+void BlockChangeBus::Unsubscribe(size_t subscription) {
+  subscriptions_.erase(
+      std::remove_if(subscriptions_.begin(), subscriptions_.end(),
+                     [subscription](const Subscription& existing) {
+                       return existing.id == subscription;
+                     }),
+      subscriptions_.end());
+}
+
+void BlockChangeBus::Publish(const vector<BlockChange>& changes) {
+  stats_.published_changes += changes.size();
+  for (const BlockChange& change : changes) {
+    vector<BlockChange>& chunk_changes = pending_[GetChunkOf(change.position)];
+    std::unordered_map<ivec3, size_t, PositionHasher>::iterator existing =
+        pending_indices_.find(change.position);
+    if (existing == pending_indices_.end()) {
+      pending_indices_[change.position] = chunk_changes.size();
+      chunk_changes.push_back(change);
+    } else {
+      // keeps the type from before the tick
+      chunk_changes[existing->second].block_type = change.block_type;
+    }
+  }
+}
+
+void BlockChangeBus::Flush(uint64_t tick) {
+  map<ChunkCoordinates, vector<BlockChange>> pending;
+  pending.swap(pending_);
+  pending_indices_.clear();
+
+  BlockChangeBatch batch;
+  batch.tick = tick;
+  for (const std::pair<const ChunkCoordinates, vector<BlockChange>>& entry :
+       pending) {
+    ChunkChanges chunk;
+    chunk.chunk = entry.first;
+    for (const BlockChange& change : entry.second) {
+      if (change.previous_block_type == change.block_type) {
+        continue;
+      }
+      if (chunk.changes.empty()) {
+        chunk.bounds = BlockBox{change.position, change.position};
+      }
+      chunk.bounds.min_corner = glm::min(chunk.bounds.min_corner,
+                                         change.position);
+      chunk.bounds.max_corner = glm::max(chunk.bounds.max_corner,
+                                         change.position);
+      chunk.changes.push_back(change);
+    }
+    if (!chunk.changes.empty()) {
+      batch.chunks.push_back(std::move(chunk));
+    }
+  }
+  stats_.coalesced_changes += batch.GetChangesCount();
+  if (batch.chunks.empty()) {
+    return;
+  }
+
+  // subscribers may subscribe or unsubscribe while they are notified
+  vector<Subscription> subscriptions = subscriptions_;
+  BlockChangeBatch filtered;
+  filtered.tick = tick;
+  for (const Subscription& subscription : subscriptions) {
+    if (!subscription.filtered) {
+      subscription.subscriber(batch);
+      ++stats_.notifications;
+      continue;
+    }
+    filtered.chunks.clear();
+    ChunkChanges chunk;
+    for (const ChunkChanges& candidate : batch.chunks) {
+      if (FilterChanges(candidate, subscription.region, &chunk)) {
+        filtered.chunks.push_back(chunk);
+      }
+    }
+    if (!filtered.chunks.empty()) {
+      subscription.subscriber(filtered);
+      ++stats_.notifications;
+    }
+  }
+}
+
+size_t BlockChangeBus::GetPendingCount() const {
+  return pending_indices_.size();
+}
+
+const BlockChangeBusStats& BlockChangeBus::GetStats() const {
+  return stats_;
+}
+
+ChunkCoordinates BlockChangeBus::GetChunkOf(const ivec3& position) const {
+  return ChunkCoordinates{
+      FloorDivide(position.x + chunk_radius_, 2 * chunk_radius_),
+      FloorDivide(position.y + chunk_radius_, 2 * chunk_radius_),
+      FloorDivide(position.z + chunk_radius_, 2 * chunk_radius_)};
+}
+
+}  // namespace minecraft
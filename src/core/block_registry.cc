@@ -0,0 +1,17 @@
+#include "core/block_registry.h"
+
+namespace minecraft {
+
+// out-of-line definitions, required for odr-used static constexpr members
+constexpr size_t BlockRegistry::kTilesPerStrip;
+constexpr const char* BlockRegistry::kAtlasFiles[];
+constexpr size_t BlockRegistry::kAtlasStripsCount;
+constexpr BlockProperties BlockRegistry::kProperties[];
+constexpr size_t BlockRegistry::kBlockTypesCount;
+
+static_assert(BlockRegistry::GetFaceLayer(BlockTypes::kGlass, 5) <
+                  BlockRegistry::kAtlasStripsCount *
+                      BlockRegistry::kTilesPerStrip,
+              "face layers must be inside the atlas");
+
+}  // namespace minecraft
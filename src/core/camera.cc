@@ -1,13 +1,7 @@
 #include "core/camera.h"
 
-using ci::CameraPersp;
 using ci::vec2;
 using ci::vec3;
-using ci::gl::clear;
-using ci::gl::drawCube;
-using ci::gl::enableDepthRead;
-using ci::gl::enableDepthWrite;
-using ci::gl::setMatrices;
 
 using minecraft::Camera;
 
@@ -17,13 +11,8 @@ Camera::Camera(const vec3 &initial_position, float terminal_velocity)
     : transform_(initial_position), terminal_velocity_(terminal_velocity) {
 }
 
-void Camera::Render() const {
-  enableDepthRead();
-  enableDepthWrite();
-
-  CameraPersp cam;
-  cam.lookAt(transform_, transform_ + GetForwardVector());
-  setMatrices(cam);
+void Camera::Render(Renderer* renderer) const {
+  renderer->SetCamera(transform_, GetForwardVector());
 }
 
 vec3 Camera::GetForwardVector() const {
@@ -0,0 +1,196 @@
+#include "core/chunk.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+#include "core/block_registry.h"
+
+using ci::vec3;
+using glm::ivec3;
+using std::invalid_argument;
+using std::vector;
+
+namespace minecraft {
+
+constexpr int Chunk::kNoSolidBlock;
+
+namespace {
+
+/// \param volume number of voxels
+/// \return air, with the array and its reference count from the pool
+std::shared_ptr<VoxelArray> MakeVoxels(size_t volume) {
+  return std::allocate_shared<VoxelArray>(PoolAllocator<VoxelArray>(), volume,
+                                          BlockTypes::kNone);
+}
+
+}  // namespace
+
+Chunk::Chunk(const ivec3& min_corner, int width)
+    : min_corner_(min_corner),
+      width_(width),
+      voxels_(MakeVoxels(size_t(width * width * width))),
+      mesh_(min_corner),
+      translucent_mesh_(min_corner),
+      column_tops_(size_t(width * width), int8_t(kNoSolidBlock)),
+      column_tops_stale_(false),
+      random_ticking_count_(0),
+      copies_count_(0) {
+  if (width > PackedVertex::kMaxChunkWidth) {
+    throw invalid_argument("chunks can be at most " +
+                           std::to_string(PackedVertex::kMaxChunkWidth) +
+                           " blocks wide");
+  }
+}
+
+void Chunk::MoveTo(const ivec3& min_corner) {
+  min_corner_ = min_corner;
+  column_tops_stale_ = true;
+  // the old voxels are about to be overwritten; no point in copying them
+  if (voxels_.use_count() > 1) {
+    voxels_ = MakeVoxels(voxels_->size());
+  }
+}
+
+bool Chunk::Contains(const ivec3& position) const {
+  ivec3 local = position - min_corner_;
+  return 0 <= local.x && local.x < width_ && 0 <= local.y &&
+         local.y < width_ && 0 <= local.z && local.z < width_;
+}
+
+size_t Chunk::GetIndex(const ivec3& position) const {
+  ivec3 local = position - min_corner_;
+  return size_t((local.x * width_ + local.y) * width_ + local.z);
+}
+
+ivec3 Chunk::GetPosition(size_t index) const {
+  int local_index = int(index);
+  return min_corner_ + ivec3(local_index / (width_ * width_),
+                             local_index / width_ % width_,
+                             local_index % width_);
+}
+
+BlockTypes Chunk::GetBlockAt(const ivec3& position) const {
+  return (*voxels_)[GetIndex(position)];
+}
+
+void Chunk::SetBlock(size_t index, BlockTypes block_type) {
+  Detach();
+  (*voxels_)[index] = block_type;
+  if (!column_tops_stale_) {
+    UpdateColumnTop(index);
+  }
+}
+
+VoxelArray& Chunk::GetVoxels() {
+  Detach();
+  column_tops_stale_ = true;
+  return *voxels_;
+}
+
+const VoxelArray& Chunk::GetVoxels() const {
+  return *voxels_;
+}
+
+ChunkSnapshot Chunk::GetSnapshot() const {
+  return ChunkSnapshot(min_corner_, width_, voxels_);
+}
+
+uint64_t Chunk::GetCopiesCount() const {
+  return copies_count_;
+}
+
+void Chunk::Detach() {
+  if (voxels_.use_count() > 1) {
+    voxels_ = std::allocate_shared<VoxelArray>(PoolAllocator<VoxelArray>(),
+                                               *voxels_);
+    ++copies_count_;
+  } else {
+    // pairs with the release of the last snapshot on another thread, so its
+    // reads happen before our writes
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+}
+
+void Chunk::UpdateColumnTop(size_t index) {
+  const VoxelArray& voxels = *voxels_;
+  int x = int(index) / (width_ * width_);
+  int y = int(index) / width_ % width_;
+  int z = int(index) % width_;
+  int8_t& top = column_tops_[size_t(x * width_ + z)];
+  if (BlockRegistry::IsSolid(voxels[index])) {
+    top = int8_t(std::max(int(top), y));
+  } else if (y == top) {
+    // the top was removed; the new one is the next solid voxel below, so
+    // the search stops there
+    do {
+      --top;
+    } while (top >= 0 && !BlockRegistry::IsSolid(
+                             voxels[size_t((x * width_ + top) * width_ + z)]));
+  }
+}
+
+void Chunk::RebuildBlocks() {
+  blocks_.clear();
+  mesh_.Reset(min_corner_);
+  translucent_mesh_.Reset(min_corner_);
+  random_ticking_count_ = 0;
+  const VoxelArray& voxels = *voxels_;
+  for (size_t index = 0; index < voxels.size(); ++index) {
+    if (BlockRegistry::IsVisible(voxels[index])) {
+      ivec3 position = GetPosition(index);
+      blocks_.emplace_back(voxels[index], vec3(position));
+      PackedMesh& mesh = BlockRegistry::IsTranslucent(voxels[index])
+                             ? translucent_mesh_
+                             : mesh_;
+      mesh.AppendBlock(position - min_corner_, voxels[index]);
+    }
+    random_ticking_count_ += BlockRegistry::HasRandomTicks(voxels[index]);
+  }
+
+  if (column_tops_stale_) {
+    // from the top of each column down to its first solid voxel
+    for (int x = 0; x < width_; ++x) {
+      for (int z = 0; z < width_; ++z) {
+        int y = width_ - 1;
+        while (y >= 0 && !BlockRegistry::IsSolid(
+                             voxels[size_t((x * width_ + y) * width_ + z)])) {
+          --y;
+        }
+        column_tops_[size_t(x * width_ + z)] = int8_t(y);
+      }
+    }
+    column_tops_stale_ = false;
+  }
+}
+
+int Chunk::GetColumnTop(int x, int z) const {
+  return column_tops_[size_t(x * width_ + z)];
+}
+
+size_t Chunk::GetRandomTickingCount() const {
+  return random_ticking_count_;
+}
+
+const vector<Block>& Chunk::GetBlocks() const {
+  return blocks_;
+}
+
+const PackedMesh& Chunk::GetMesh() const {
+  return mesh_;
+}
+
+const PackedMesh& Chunk::GetTranslucentMesh() const {
+  return translucent_mesh_;
+}
+
+ivec3 Chunk::GetMinCorner() const {
+  return min_corner_;
+}
+
+int Chunk::GetWidth() const {
+  return width_;
+}
+
+}  // namespace minecraft
@@ -0,0 +1,561 @@
+#include "core/chunk_io.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(IORING_FEAT_RW_CUR_POS)
+#define MINECRAFT_HAS_IO_URING 1
+#endif
+#endif
+
+using std::deque;
+using std::exception_ptr;
+using std::function;
+using std::future;
+using std::lock_guard;
+using std::mutex;
+using std::pair;
+using std::runtime_error;
+using std::string;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+namespace minecraft {
+
+constexpr size_t ChunkIo::kQueueDepth;
+constexpr size_t ChunkIo::kMaxThreads;
+constexpr size_t ChunkIo::kLatencySamplesCount;
+
+namespace {
+
+/// \return an exception carrying the current `errno` description
+exception_ptr MakeSystemError(const string& what, int error) {
+  return std::make_exception_ptr(
+      runtime_error(what + ": " + std::strerror(error)));
+}
+
+}  // namespace
+
+/// one file of a batch: opened, transferred in as many parts as the kernel
+/// needs, synced if written, then closed
+struct ChunkIo::Operation {
+  string path;
+  bool write;
+  /// the bytes read
+  vector<uint8_t> bytes;
+  /// the bytes to write
+  const vector<uint8_t>* contents = nullptr;
+  int descriptor = -1;
+  /// bytes transferred so far
+  size_t done = 0;
+  /// true once a write is being synced
+  bool syncing = false;
+  steady_clock::time_point submitted;
+  /// operations in flight once this one was submitted
+  size_t in_flight = 0;
+
+  /// opens the file and, for a read, sizes the buffer to the file
+  void Open() {
+    descriptor = write ? open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)
+                       : open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+      std::rethrow_exception(MakeSystemError("open " + path, errno));
+    }
+    if (!write) {
+      struct stat status;
+      if (fstat(descriptor, &status) < 0) {
+        int error = errno;
+        Close();
+        std::rethrow_exception(MakeSystemError("stat " + path, error));
+      }
+      bytes.resize(size_t(status.st_size));
+    }
+    syncing = write && contents->empty();
+  }
+
+  void Close() {
+    if (descriptor >= 0) {
+      close(descriptor);
+      descriptor = -1;
+    }
+  }
+
+  /// \return bytes to transfer in all
+  size_t GetSize() const {
+    return write ? contents->size() : bytes.size();
+  }
+
+  /// \return true if and only if nothing is left to do after opening
+  bool IsEmpty() const {
+    return !write && bytes.empty();
+  }
+
+  /// transfers the rest of the file and syncs it with blocking calls, then
+  /// closes it
+  void RunBlocking() {
+    Open();
+    while (done < GetSize()) {
+      ssize_t result =
+          write ? pwrite(descriptor, contents->data() + done,
+                         GetSize() - done, off_t(done))
+                : pread(descriptor, bytes.data() + done, GetSize() - done,
+                        off_t(done));
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      if (result <= 0) {
+        int error = result < 0 ? errno : EIO;
+        Close();
+        std::rethrow_exception(
+            MakeSystemError((write ? "write " : "read ") + path, error));
+      }
+      done += size_t(result);
+    }
+    if (write && fsync(descriptor) < 0) {
+      int error = errno;
+      Close();
+      std::rethrow_exception(MakeSystemError("fsync " + path, error));
+    }
+    Close();
+  }
+};
+
+#if defined(MINECRAFT_HAS_IO_URING)
+
+/// an io_uring set up with raw system calls: a submission queue of entries
+/// handed to the kernel and a completion queue of results, both shared
+/// memory rings
+struct ChunkIo::Ring {
+  int descriptor;
+  void* submission_map;
+  size_t submission_map_size;
+  void* completion_map;
+  size_t completion_map_size;
+  io_uring_sqe* entries;
+  size_t entries_size;
+  unsigned* submission_tail;
+  unsigned* submission_array;
+  unsigned submission_mask;
+  unsigned* completion_head;
+  unsigned* completion_tail;
+  unsigned completion_mask;
+  io_uring_cqe* completions;
+  /// entries filled in but not handed to the kernel yet
+  unsigned unsubmitted;
+
+  /// \param entries_count size of the submission queue
+  /// \return the ring, or nullptr if the kernel does not provide io_uring or
+  /// its reads and writes
+  static std::unique_ptr<Ring> Create(unsigned entries_count) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    long descriptor = syscall(__NR_io_uring_setup, entries_count, &params);
+    if (descriptor < 0) {
+      return nullptr;
+    }
+    std::unique_ptr<Ring> ring(new Ring());
+    ring->descriptor = int(descriptor);
+    ring->submission_map = MAP_FAILED;
+    ring->completion_map = MAP_FAILED;
+    ring->entries = nullptr;
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+      return nullptr;
+    }
+
+    ring->submission_map_size =
+        params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->completion_map_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_map) {
+      ring->submission_map_size = ring->completion_map_size =
+          std::max(ring->submission_map_size, ring->completion_map_size);
+    }
+    ring->submission_map =
+        mmap(nullptr, ring->submission_map_size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring->descriptor, IORING_OFF_SQ_RING);
+    ring->completion_map =
+        single_map ? ring->submission_map
+                   : mmap(nullptr, ring->completion_map_size,
+                          PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ring->descriptor, IORING_OFF_CQ_RING);
+    ring->entries_size = params.sq_entries * sizeof(io_uring_sqe);
+    void* entries =
+        mmap(nullptr, ring->entries_size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring->descriptor, IORING_OFF_SQES);
+    if (entries != MAP_FAILED) {
+      ring->entries = static_cast<io_uring_sqe*>(entries);
+    }
+    if (ring->submission_map == MAP_FAILED ||
+        ring->completion_map == MAP_FAILED || entries == MAP_FAILED) {
+      // the destructor unmaps whatever was mapped
+      return nullptr;
+    }
+
+    char* submission = static_cast<char*>(ring->submission_map);
+    ring->submission_tail =
+        reinterpret_cast<unsigned*>(submission + params.sq_off.tail);
+    ring->submission_array =
+        reinterpret_cast<unsigned*>(submission + params.sq_off.array);
+    ring->submission_mask =
+        *reinterpret_cast<unsigned*>(submission + params.sq_off.ring_mask);
+    char* completion = static_cast<char*>(ring->completion_map);
+    ring->completion_head =
+        reinterpret_cast<unsigned*>(completion + params.cq_off.head);
+    ring->completion_tail =
+        reinterpret_cast<unsigned*>(completion + params.cq_off.tail);
+    ring->completion_mask =
+        *reinterpret_cast<unsigned*>(completion + params.cq_off.ring_mask);
+    ring->completions =
+        reinterpret_cast<io_uring_cqe*>(completion + params.cq_off.cqes);
+    ring->unsubmitted = 0;
+    return ring;
+  }
+
+  ~Ring() {
+    if (entries != nullptr) {
+      munmap(entries, entries_size);
+    }
+    if (completion_map != MAP_FAILED && completion_map != submission_map) {
+      munmap(completion_map, completion_map_size);
+    }
+    if (submission_map != MAP_FAILED) {
+      munmap(submission_map, submission_map_size);
+    }
+    close(descriptor);
+  }
+
+  /// queues an operation's next step: the rest of its transfer, or its sync
+  ///
+  /// \param operation the operation
+  /// \param tag returned with the completion
+  void Prepare(const Operation& operation, uint64_t tag) {
+    // the kernel only reads the tail, and this thread is its only writer
+    unsigned tail = *submission_tail;
+    unsigned index = tail & submission_mask;
+    io_uring_sqe* entry = &entries[index];
+    std::memset(entry, 0, sizeof(*entry));
+    entry->fd = operation.descriptor;
+    entry->user_data = tag;
+    if (operation.syncing) {
+      entry->opcode = IORING_OP_FSYNC;
+    } else {
+      const uint8_t* data = (operation.write ? operation.contents->data()
+                                             : operation.bytes.data()) +
+                            operation.done;
+      entry->opcode = operation.write ? IORING_OP_WRITE : IORING_OP_READ;
+      entry->addr = uint64_t(reinterpret_cast<uintptr_t>(data));
+      entry->len = unsigned(operation.GetSize() - operation.done);
+      entry->off = uint64_t(operation.done);
+    }
+    submission_array[index] = index;
+    __atomic_store_n(submission_tail, tail + 1, __ATOMIC_RELEASE);
+    ++unsubmitted;
+  }
+
+  /// hands the queued entries to the kernel and waits for a completion
+  ///
+  /// \throw std::runtime_error if the kernel refuses them
+  void SubmitAndWait() {
+    while (true) {
+      long result = syscall(__NR_io_uring_enter, descriptor, unsubmitted, 1,
+                            IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (result >= 0) {
+        unsubmitted -= unsigned(result);
+        return;
+      }
+      if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        std::rethrow_exception(MakeSystemError("io_uring_enter", errno));
+      }
+    }
+  }
+
+  /// \param completion output
+  /// \return false if and only if no completion is waiting
+  bool Pop(io_uring_cqe* completion) {
+    unsigned head = *completion_head;
+    if (head == __atomic_load_n(completion_tail, __ATOMIC_ACQUIRE)) {
+      return false;
+    }
+    *completion = completions[head & completion_mask];
+    __atomic_store_n(completion_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+};
+
+#else
+
+/// the io_uring is not available here
+struct ChunkIo::Ring {
+  static std::unique_ptr<Ring> Create(unsigned) {
+    return nullptr;
+  }
+};
+
+#endif
+
+ChunkIo::ChunkIo(Backend backend, size_t queue_depth)
+    : backend_(backend), queue_depth_(queue_depth), stats_() {
+  if (queue_depth == 0) {
+    throw std::invalid_argument("queue depth must be positive");
+  }
+  if (backend == Backend::kIoUring) {
+    ring_ = Ring::Create(unsigned(queue_depth));
+    if (ring_ == nullptr) {
+      backend_ = Backend::kThreadPool;
+    }
+  }
+  if (backend_ == Backend::kThreadPool) {
+    thread_pool_.reset(new ThreadPool(std::min(queue_depth, kMaxThreads)));
+  }
+}
+
+ChunkIo::~ChunkIo() = default;
+
+void ChunkIo::ReadFiles(const vector<string>& paths,
+                        const ReadHandler& on_read) {
+  vector<Operation> operations(paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    operations[i].path = paths[i];
+    operations[i].write = false;
+    operations[i].contents = nullptr;
+  }
+  function<void(Operation*)> on_done = [&operations,
+                                        &on_read](Operation* operation) {
+    on_read(size_t(operation - operations.data()), &operation->bytes);
+  };
+  if (ring_ != nullptr) {
+    RunOnRing(&operations, on_done);
+  } else {
+    RunOnThreadPool(&operations, on_done);
+  }
+}
+
+void ChunkIo::WriteFiles(const vector<string>& paths,
+                         const vector<vector<uint8_t>>& contents) {
+  if (contents.size() != paths.size()) {
+    throw std::invalid_argument("every file needs contents");
+  }
+  vector<Operation> operations(paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    operations[i].path = paths[i];
+    operations[i].write = true;
+    operations[i].contents = &contents[i];
+  }
+  function<void(Operation*)> on_done = [](Operation*) {};
+  if (ring_ != nullptr) {
+    RunOnRing(&operations, on_done);
+  } else {
+    RunOnThreadPool(&operations, on_done);
+  }
+}
+
+ChunkIo::Backend ChunkIo::GetBackend() const {
+  return backend_;
+}
+
+size_t ChunkIo::GetQueueDepth() const {
+  return queue_depth_;
+}
+
+ChunkIoStats ChunkIo::GetStats() const {
+  ChunkIoStats stats;
+  vector<double> latencies;
+  {
+    lock_guard<mutex> lock(mutex_);
+    stats = stats_;
+    latencies.assign(latencies_.begin(), latencies_.end());
+  }
+  stats.p50_read_seconds = 0;
+  stats.p99_read_seconds = 0;
+  if (!latencies.empty()) {
+    size_t rank = latencies.size() / 2;
+    std::nth_element(latencies.begin(), latencies.begin() + rank,
+                     latencies.end());
+    stats.p50_read_seconds = latencies[rank];
+    rank = std::min(latencies.size() - 1, latencies.size() * 99 / 100);
+    std::nth_element(latencies.begin(), latencies.begin() + rank,
+                     latencies.end());
+    stats.p99_read_seconds = latencies[rank];
+  }
+  return stats;
+}
+
+void ChunkIo::RunOnRing(vector<Operation>* operations,
+                        const function<void(Operation*)>& on_done) {
+#if defined(MINECRAFT_HAS_IO_URING)
+  size_t next = 0;
+  size_t in_flight = 0;
+  // the first failure; once set nothing new is started, and the operations
+  // in flight are waited for since the kernel still writes to their buffers
+  exception_ptr failure;
+
+  // closes a finished operation and hands it over
+  auto finish = [&](Operation* operation) {
+    operation->Close();
+    Record(*operation, operation->in_flight);
+    if (failure == nullptr) {
+      try {
+        on_done(operation);
+      } catch (...) {
+        failure = std::current_exception();
+      }
+    }
+  };
+
+  while (true) {
+    while (failure == nullptr && next < operations->size() &&
+           in_flight < queue_depth_) {
+      Operation* operation = &(*operations)[next];
+      operation->descriptor = -1;
+      operation->done = 0;
+      operation->submitted = steady_clock::now();
+      operation->in_flight = in_flight + 1;
+      try {
+        operation->Open();
+      } catch (...) {
+        failure = std::current_exception();
+        break;
+      }
+      if (operation->IsEmpty()) {
+        finish(operation);
+      } else {
+        ring_->Prepare(*operation, next);
+        ++in_flight;
+      }
+      ++next;
+    }
+    if (in_flight == 0) {
+      break;
+    }
+
+    try {
+      ring_->SubmitAndWait();
+    } catch (...) {
+      for (Operation& operation : *operations) {
+        operation.Close();
+      }
+      throw;
+    }
+    io_uring_cqe completion;
+    while (ring_->Pop(&completion)) {
+      Operation* operation = &(*operations)[size_t(completion.user_data)];
+      int result = completion.res;
+      if (result == -EINTR || result == -EAGAIN) {
+        ring_->Prepare(*operation, completion.user_data);
+        continue;
+      }
+      if (result < 0 || (result == 0 && !operation->syncing)) {
+        if (failure == nullptr) {
+          string what = operation->syncing ? "fsync "
+                        : operation->write ? "write "
+                                           : "read ";
+          failure = MakeSystemError(what + operation->path,
+                                    result < 0 ? -result : EIO);
+        }
+        operation->Close();
+        --in_flight;
+        continue;
+      }
+      if (!operation->syncing) {
+        operation->done += size_t(result);
+        if (operation->done < operation->GetSize() || operation->write) {
+          // a short transfer continues where it stopped; a complete write
+          // is synced
+          operation->syncing = operation->done == operation->GetSize();
+          ring_->Prepare(*operation, completion.user_data);
+          continue;
+        }
+      }
+      --in_flight;
+      finish(operation);
+    }
+  }
+  if (failure != nullptr) {
+    std::rethrow_exception(failure);
+  }
+#else
+  RunOnThreadPool(operations, on_done);
+#endif
+}
+
+void ChunkIo::RunOnThreadPool(vector<Operation>* operations,
+                              const function<void(Operation*)>& on_done) {
+  deque<pair<Operation*, future<void>>> in_flight;
+  exception_ptr failure;
+
+  // waits for the oldest operation and hands it over
+  auto finish_oldest = [&]() {
+    Operation* operation = in_flight.front().first;
+    try {
+      in_flight.front().second.get();
+      Record(*operation, operation->in_flight);
+      if (failure == nullptr) {
+        on_done(operation);
+      }
+    } catch (...) {
+      if (failure == nullptr) {
+        failure = std::current_exception();
+      }
+    }
+    in_flight.pop_front();
+  };
+
+  for (Operation& operation : *operations) {
+    if (failure != nullptr) {
+      break;
+    }
+    if (in_flight.size() >= queue_depth_) {
+      finish_oldest();
+    }
+    operation.descriptor = -1;
+    operation.done = 0;
+    operation.submitted = steady_clock::now();
+    operation.in_flight = in_flight.size() + 1;
+    Operation* submitted = &operation;
+    in_flight.push_back(pair<Operation*, future<void>>(
+        submitted,
+        thread_pool_->Submit([submitted]() { submitted->RunBlocking(); })));
+  }
+  while (!in_flight.empty()) {
+    finish_oldest();
+  }
+  if (failure != nullptr) {
+    std::rethrow_exception(failure);
+  }
+}
+
+void ChunkIo::Record(const Operation& operation, size_t in_flight) {
+  double seconds =
+      duration<double>(steady_clock::now() - operation.submitted).count();
+  lock_guard<mutex> lock(mutex_);
+  stats_.max_queue_depth = std::max(stats_.max_queue_depth, in_flight);
+  if (operation.write) {
+    ++stats_.writes;
+    stats_.bytes_written += operation.GetSize();
+    return;
+  }
+  ++stats_.reads;
+  stats_.bytes_read += operation.GetSize();
+  latencies_.push_back(seconds);
+  if (latencies_.size() > kLatencySamplesCount) {
+    latencies_.pop_front();
+  }
+}
+
+}  // namespace minecraft
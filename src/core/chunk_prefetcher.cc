@@ -0,0 +1,261 @@
+#include "core/chunk_prefetcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include "core/world.h"
+
+using ci::vec3;
+using glm::ivec3;
+using std::map;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+namespace minecraft {
+
+constexpr size_t ChunkPrefetcher::kTrajectoryLength;
+constexpr size_t ChunkPrefetcher::kMaxPredictions;
+constexpr size_t ChunkPrefetcher::kMaxPrefetched;
+const float ChunkPrefetcher::kMinLookahead = 0.25f;
+const float ChunkPrefetcher::kMaxLookahead = 4.0f;
+const float ChunkPrefetcher::kMinSpeed = 0.5f;
+
+namespace {
+
+/// \return number of chunks between two chunks along the farthest axis
+int GetChunkDistance(const ChunkCoordinates& first,
+                     const ChunkCoordinates& second) {
+  return std::max({std::abs(first.x - second.x), std::abs(first.y - second.y),
+                   std::abs(first.z - second.z)});
+}
+
+}  // namespace
+
+ChunkPrefetcher::ChunkPrefetcher(World* world, ThreadPool* thread_pool)
+    : world_(world),
+      thread_pool_(thread_pool),
+      trajectory_count_(0),
+      trajectory_next_(0),
+      velocity_(0),
+      lookahead_(1.0f),
+      stats_{0, 0, 0, 0, 0} {
+  world_->SetPrefetcher(this);
+}
+
+ChunkPrefetcher::~ChunkPrefetcher() {
+  world_->SetPrefetcher(nullptr);
+  for (std::pair<const ChunkCoordinates, Entry>& entry : entries_) {
+    entry.second.build.wait();
+  }
+  for (Entry& entry : retiring_) {
+    entry.build.wait();
+  }
+}
+
+void ChunkPrefetcher::Update(const vec3& position, const vec3& forward,
+                             float seconds) {
+  // velocity over the recorded trajectory, from its oldest position
+  trajectory_[trajectory_next_] = position;
+  trajectory_seconds_[trajectory_next_] = seconds;
+  trajectory_next_ = (trajectory_next_ + 1) % kTrajectoryLength;
+  trajectory_count_ = std::min(trajectory_count_ + 1, kTrajectoryLength);
+  size_t oldest = trajectory_count_ < kTrajectoryLength ? 0 : trajectory_next_;
+  float elapsed = 0;
+  for (size_t i = 1; i < trajectory_count_; ++i) {
+    elapsed += trajectory_seconds_[(oldest + i) % kTrajectoryLength];
+  }
+  velocity_ = elapsed > 0 ? (position - trajectory_[oldest]) / elapsed
+                          : vec3(0);
+
+  // reuse the chunks of dropped entries that have been built since
+  for (size_t i = 0; i < retiring_.size();) {
+    if (retiring_[i].build.wait_for(std::chrono::seconds(0)) ==
+        std::future_status::ready) {
+      spares_.push_back(std::move(retiring_[i].chunk));
+      retiring_[i] = std::move(retiring_.back());
+      retiring_.pop_back();
+    } else {
+      ++i;
+    }
+  }
+
+  // where the player will be, soonest first, and where it would be going the
+  // same way it looks
+  const ChunkCoordinates& center = world_->GetWindowCenter();
+  vector<ChunkCoordinates> predicted;
+  if (IsMoving()) {
+    // a chunk apart at most, so the predicted windows leave no gaps
+    float reach = glm::length(velocity_) * lookahead_;
+    float width = 2.0f * float(world_->GetChunkRadius());
+    size_t count = std::max(size_t(1), size_t(std::ceil(reach / width)));
+    count = std::min(count, kMaxPredictions);
+    for (size_t i = 1; i <= count; ++i) {
+      predicted.push_back(world_->GetChunk(
+          position + velocity_ * (lookahead_ * float(i) / float(count))));
+    }
+    vec3 heading = glm::length(forward) > 0 ? glm::normalize(forward) : forward;
+    predicted.push_back(world_->GetChunk(position + heading * reach));
+  }
+  predicted.erase(std::remove(predicted.begin(), predicted.end(), center),
+                  predicted.end());
+  vector<ChunkCoordinates> pending = world_->GetPendingChunks();
+
+  // drop chunks that are stale, or neither pending nor ahead of the player.
+  // chunks one beyond the predicted windows are kept, so small changes of the
+  // prediction do not drop and queue the same chunks over and over
+  int r = World::kWindowRadius;
+  for (map<ChunkCoordinates, Entry>::iterator entry = entries_.begin();
+       entry != entries_.end();) {
+    bool ahead = std::find(pending.begin(), pending.end(), entry->first) !=
+                 pending.end();
+    for (const ChunkCoordinates& chunk : predicted) {
+      ahead = ahead || GetChunkDistance(entry->first, chunk) <= r + 1;
+    }
+    if (entry->second.stale || !ahead) {
+      Retire(&entry->second);
+      entry = entries_.erase(entry);
+      ++stats_.wasted;
+      ScaleLookahead(0.9f);
+    } else {
+      ++entry;
+    }
+  }
+
+  for (const ChunkCoordinates& chunk : pending) {
+    Request(chunk);
+  }
+  for (const ChunkCoordinates& chunk : predicted) {
+    for (int x = chunk.x - r; x <= chunk.x + r; ++x) {
+      for (int y = chunk.y - r; y <= chunk.y + r; ++y) {
+        for (int z = chunk.z - r; z <= chunk.z + r; ++z) {
+          ChunkCoordinates candidate{x, y, z};
+          if (GetChunkDistance(candidate, center) > r) {
+            Request(candidate);
+          }
+        }
+      }
+    }
+  }
+}
+
+bool ChunkPrefetcher::Take(const ChunkCoordinates& chunk, Chunk* voxels) {
+  map<ChunkCoordinates, Entry>::iterator entry = entries_.find(chunk);
+  if (entry == entries_.end() || entry->second.stale) {
+    if (IsMoving()) {
+      ++stats_.misses;
+      ScaleLookahead(1.5f);
+    }
+    return false;
+  }
+  if (entry->second.build.wait_for(std::chrono::seconds(0)) !=
+      std::future_status::ready) {
+    ++stats_.late;
+    ScaleLookahead(1.25f);
+  }
+  // rethrows anything the build threw
+  entry->second.build.get();
+  std::swap(*voxels, *entry->second.chunk);
+  spares_.push_back(std::move(entry->second.chunk));
+  entries_.erase(entry);
+  ++stats_.useful;
+  return true;
+}
+
+bool ChunkPrefetcher::IsBuilding(const ChunkCoordinates& chunk) const {
+  map<ChunkCoordinates, Entry>::const_iterator entry = entries_.find(chunk);
+  return entry != entries_.end() && !entry->second.stale &&
+         entry->second.build.wait_for(std::chrono::seconds(0)) !=
+             std::future_status::ready;
+}
+
+void ChunkPrefetcher::Invalidate(const ChunkCoordinates& chunk) {
+  map<ChunkCoordinates, Entry>::iterator entry = entries_.find(chunk);
+  if (entry != entries_.end()) {
+    entry->second.stale = true;
+  }
+}
+
+vec3 ChunkPrefetcher::GetVelocity() const {
+  return velocity_;
+}
+
+float ChunkPrefetcher::GetLookahead() const {
+  return lookahead_;
+}
+
+size_t ChunkPrefetcher::GetPrefetchedCount() const {
+  return entries_.size();
+}
+
+const PrefetchStats& ChunkPrefetcher::GetStats() const {
+  return stats_;
+}
+
+bool ChunkPrefetcher::IsMoving() const {
+  return glm::length(velocity_) >= kMinSpeed;
+}
+
+void ChunkPrefetcher::Request(const ChunkCoordinates& chunk) {
+  if (entries_.size() >= kMaxPrefetched || entries_.count(chunk) > 0) {
+    return;
+  }
+  int width = 2 * int(world_->GetChunkRadius());
+  unique_ptr<Chunk> target;
+  if (spares_.empty()) {
+    target.reset(new Chunk(ivec3(0), width));
+  } else {
+    target = std::move(spares_.back());
+    spares_.pop_back();
+  }
+  // the build only sees copies, so later edits do not race with it; edits
+  // made before it is taken mark it stale instead
+  ivec3 min_corner = world_->GetChunkMinCorner(chunk);
+  vector<BlockEdit> edits = world_->GetEditsIn(
+      BlockBox{min_corner, min_corner + ivec3(width - 1)});
+  TerrainGenerator* terrain_generator = world_->GetTerrainGenerator();
+  Histogram* generation_seconds =
+      world_->GetMetrics() != nullptr
+          ? world_->GetMetrics()->prefetch_generation_seconds
+          : nullptr;
+  Chunk* built = target.get();
+  Entry& entry = entries_[chunk];
+  entry.chunk = std::move(target);
+  entry.stale = false;
+  entry.build = thread_pool_->Submit(
+      [built, terrain_generator, generation_seconds, min_corner, width,
+       edits]() {
+        steady_clock::time_point start = steady_clock::now();
+        built->MoveTo(min_corner);
+        terrain_generator->FillChunk(min_corner, width,
+                                     built->GetVoxels().data());
+        for (const BlockEdit& edit : edits) {
+          built->SetBlock(built->GetIndex(edit.position), edit.block_type);
+        }
+        built->RebuildBlocks();
+        if (generation_seconds != nullptr) {
+          generation_seconds->Observe(
+              duration<double>(steady_clock::now() - start).count());
+        }
+      });
+  ++stats_.requested;
+}
+
+void ChunkPrefetcher::Retire(Entry* entry) {
+  if (entry->build.wait_for(std::chrono::seconds(0)) ==
+      std::future_status::ready) {
+    spares_.push_back(std::move(entry->chunk));
+  } else {
+    retiring_.push_back(std::move(*entry));
+  }
+}
+
+void ChunkPrefetcher::ScaleLookahead(float factor) {
+  lookahead_ = std::min(kMaxLookahead,
+                        std::max(kMinLookahead, lookahead_ * factor));
+}
+
+}  // namespace minecraft
@@ -0,0 +1,80 @@
+#include "core/chunk_snapshot.h"
+
+using glm::ivec3;
+using std::map;
+using std::shared_ptr;
+using std::vector;
+
+namespace minecraft {
+
+namespace {
+
+int FloorDivide(int numerator, int denominator) {
+  int quotient = numerator / denominator;
+  return quotient * denominator > numerator ? quotient - 1 : quotient;
+}
+
+}  // namespace
+
+ChunkSnapshot::ChunkSnapshot(const ivec3& min_corner, int width,
+                             const shared_ptr<const VoxelArray>& voxels)
+    : min_corner_(min_corner), width_(width), voxels_(voxels) {
+}
+
+bool ChunkSnapshot::Contains(const ivec3& position) const {
+  ivec3 local = position - min_corner_;
+  return 0 <= local.x && local.x < width_ && 0 <= local.y &&
+         local.y < width_ && 0 <= local.z && local.z < width_;
+}
+
+BlockTypes ChunkSnapshot::GetBlockAt(const ivec3& position) const {
+  ivec3 local = position - min_corner_;
+  return (*voxels_)[size_t((local.x * width_ + local.y) * width_ + local.z)];
+}
+
+const VoxelArray& ChunkSnapshot::GetVoxels() const {
+  return *voxels_;
+}
+
+ivec3 ChunkSnapshot::GetMinCorner() const {
+  return min_corner_;
+}
+
+int ChunkSnapshot::GetWidth() const {
+  return width_;
+}
+
+WorldSnapshot::WorldSnapshot(size_t chunk_radius)
+    : chunk_radius_(int(chunk_radius)) {
+}
+
+void WorldSnapshot::Add(const ChunkCoordinates& chunk,
+                        const ChunkSnapshot& snapshot) {
+  chunks_.erase(chunk);
+  chunks_.insert(std::make_pair(chunk, snapshot));
+}
+
+const ChunkSnapshot* WorldSnapshot::Find(const ChunkCoordinates& chunk) const {
+  map<ChunkCoordinates, ChunkSnapshot>::const_iterator found =
+      chunks_.find(chunk);
+  return found == chunks_.end() ? nullptr : &found->second;
+}
+
+bool WorldSnapshot::GetBlockAt(const ivec3& position,
+                               BlockTypes* block_type) const {
+  const ChunkSnapshot* chunk = Find(ChunkCoordinates{
+      FloorDivide(position.x + chunk_radius_, 2 * chunk_radius_),
+      FloorDivide(position.y + chunk_radius_, 2 * chunk_radius_),
+      FloorDivide(position.z + chunk_radius_, 2 * chunk_radius_)});
+  if (chunk == nullptr) {
+    return false;
+  }
+  *block_type = chunk->GetBlockAt(position);
+  return true;
+}
+
+const map<ChunkCoordinates, ChunkSnapshot>& WorldSnapshot::GetChunks() const {
+  return chunks_;
+}
+
+}  // namespace minecraft
@@ -0,0 +1,166 @@
+#include "core/chunk_window.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using glm::ivec3;
+using std::vector;
+
+namespace minecraft {
+
+ChunkWindow::ChunkWindow(int radius, int chunk_radius)
+    : radius_(radius),
+      size_(2 * radius + 1),
+      chunk_radius_(chunk_radius),
+      center_{0, 0, 0},
+      centered_(false) {
+  slots_.reserve(size_t(size_ * size_ * size_));
+  for (int i = 0; i < size_ * size_ * size_; ++i) {
+    slots_.push_back(Slot{ChunkCoordinates{0, 0, 0}, false,
+                          Chunk(ivec3(0), 2 * chunk_radius)});
+  }
+}
+
+void ChunkWindow::Recenter(const ChunkCoordinates& center,
+                           const Loader& load, const Deferral& defer) {
+  ChunkCoordinates old_center = center_;
+  center_ = center;
+  int r = radius_;
+  ChunkCoordinates low{center.x - r, center.y - r, center.z - r};
+  ChunkCoordinates high{center.x + r, center.y + r, center.z + r};
+  if (!centered_ || std::abs(center.x - old_center.x) >= size_ ||
+      std::abs(center.y - old_center.y) >= size_ ||
+      std::abs(center.z - old_center.z) >= size_) {
+    centered_ = true;
+    LoadRange(low, high, load, defer);
+    return;
+  }
+
+  // the chunks in the new window but not the old one form up to three slabs,
+  // one per axis. each slab is limited to the overlap on the earlier axes so
+  // that no chunk is loaded twice
+  ChunkCoordinates old_low{old_center.x - r, old_center.y - r,
+                           old_center.z - r};
+  ChunkCoordinates old_high{old_center.x + r, old_center.y + r,
+                            old_center.z + r};
+  ChunkCoordinates overlap_low{std::max(low.x, old_low.x),
+                               std::max(low.y, old_low.y),
+                               std::max(low.z, old_low.z)};
+  ChunkCoordinates overlap_high{std::min(high.x, old_high.x),
+                                std::min(high.y, old_high.y),
+                                std::min(high.z, old_high.z)};
+  if (center.x > old_center.x) {
+    LoadRange({old_high.x + 1, low.y, low.z}, high, load, defer);
+  } else if (center.x < old_center.x) {
+    LoadRange(low, {old_low.x - 1, high.y, high.z}, load, defer);
+  }
+  if (center.y > old_center.y) {
+    LoadRange({overlap_low.x, old_high.y + 1, low.z},
+              {overlap_high.x, high.y, high.z}, load, defer);
+  } else if (center.y < old_center.y) {
+    LoadRange({overlap_low.x, low.y, low.z},
+              {overlap_high.x, old_low.y - 1, high.z}, load, defer);
+  }
+  if (center.z > old_center.z) {
+    LoadRange({overlap_low.x, overlap_low.y, old_high.z + 1},
+              {overlap_high.x, overlap_high.y, high.z}, load, defer);
+  } else if (center.z < old_center.z) {
+    LoadRange({overlap_low.x, overlap_low.y, low.z},
+              {overlap_high.x, overlap_high.y, old_low.z - 1}, load, defer);
+  }
+}
+
+Chunk* ChunkWindow::Find(const ChunkCoordinates& coordinates) {
+  return const_cast<Chunk*>(
+      static_cast<const ChunkWindow*>(this)->Find(coordinates));
+}
+
+const Chunk* ChunkWindow::Find(const ChunkCoordinates& coordinates) const {
+  if (!IsInWindow(coordinates)) {
+    return nullptr;
+  }
+  const Slot& slot = slots_[GetSlotIndex(coordinates)];
+  return slot.loaded && slot.coordinates == coordinates ? &slot.chunk
+                                                        : nullptr;
+}
+
+bool ChunkWindow::LoadPending(const ChunkCoordinates& coordinates,
+                              const Loader& load) {
+  if (!IsInWindow(coordinates)) {
+    return false;
+  }
+  const Slot& slot = slots_[GetSlotIndex(coordinates)];
+  if (slot.loaded || slot.coordinates != coordinates) {
+    return false;
+  }
+  Load(coordinates, load, nullptr);
+  return true;
+}
+
+vector<ChunkCoordinates> ChunkWindow::GetPending() const {
+  vector<ChunkCoordinates> pending;
+  if (!centered_) {
+    return pending;
+  }
+  for (const Slot& slot : slots_) {
+    if (!slot.loaded) {
+      pending.push_back(slot.coordinates);
+    }
+  }
+  return pending;
+}
+
+const vector<ChunkWindow::Slot>& ChunkWindow::GetSlots() const {
+  return slots_;
+}
+
+const ChunkCoordinates& ChunkWindow::GetCenter() const {
+  return center_;
+}
+
+int ChunkWindow::GetRadius() const {
+  return radius_;
+}
+
+bool ChunkWindow::IsInWindow(const ChunkCoordinates& coordinates) const {
+  return centered_ && std::abs(coordinates.x - center_.x) <= radius_ &&
+         std::abs(coordinates.y - center_.y) <= radius_ &&
+         std::abs(coordinates.z - center_.z) <= radius_;
+}
+
+size_t ChunkWindow::GetSlotIndex(const ChunkCoordinates& coordinates) const {
+  int x = (coordinates.x % size_ + size_) % size_;
+  int y = (coordinates.y % size_ + size_) % size_;
+  int z = (coordinates.z % size_ + size_) % size_;
+  return size_t((x * size_ + y) * size_ + z);
+}
+
+void ChunkWindow::Load(const ChunkCoordinates& coordinates,
+                       const Loader& load, const Deferral& defer) {
+  Slot& slot = slots_[GetSlotIndex(coordinates)];
+  slot.coordinates = coordinates;
+  if (defer && defer(coordinates)) {
+    // keeps the old voxels until the chunk is loaded; nothing reads them
+    slot.loaded = false;
+    return;
+  }
+  slot.chunk.MoveTo(ivec3(coordinates.x, coordinates.y, coordinates.z) *
+                        (2 * chunk_radius_) -
+                    ivec3(chunk_radius_));
+  load(coordinates, &slot.chunk);
+  slot.loaded = true;
+}
+
+void ChunkWindow::LoadRange(const ChunkCoordinates& low,
+                            const ChunkCoordinates& high, const Loader& load,
+                            const Deferral& defer) {
+  for (int x = low.x; x <= high.x; ++x) {
+    for (int y = low.y; y <= high.y; ++y) {
+      for (int z = low.z; z <= high.z; ++z) {
+        Load(ChunkCoordinates{x, y, z}, load, defer);
+      }
+    }
+  }
+}
+
+}  // namespace minecraft
@@ -0,0 +1,511 @@
+#include "core/edit_journal.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+using glm::ivec3;
+using std::lock_guard;
+using std::mutex;
+using std::pair;
+using std::runtime_error;
+using std::string;
+using std::unique_lock;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+namespace minecraft {
+
+constexpr double EditJournal::kSyncInterval;
+constexpr size_t EditJournal::kCheckpointBytes;
+constexpr size_t EditJournal::kLatencySamplesCount;
+
+namespace {
+
+/// bytes of one encoded edit
+const size_t kEditSize = 13;
+/// bytes of a journal record header
+const size_t kRecordHeaderSize = 8;
+
+/// throws with the current `errno` description
+void ThrowSystemError(const string& what) {
+  throw runtime_error(what + ": " + std::strerror(errno));
+}
+
+/// \return lookup table of `GetChecksum`
+vector<uint32_t> MakeChecksumTable() {
+  vector<uint32_t> table(256);
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t value = i;
+    for (int bit = 0; bit < 8; ++bit) {
+      value = (value & 1) != 0 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+    }
+    table[i] = value;
+  }
+  return table;
+}
+
+/// CRC-32 (IEEE) of a byte range
+uint32_t GetChecksum(const uint8_t* data, size_t size) {
+  static const vector<uint32_t> table = MakeChecksumTable();
+  uint32_t checksum = 0xFFFFFFFFu;
+  for (size_t i = 0; i < size; ++i) {
+    checksum = table[(checksum ^ data[i]) & 0xFF] ^ (checksum >> 8);
+  }
+  return checksum ^ 0xFFFFFFFFu;
+}
+
+void AppendUint32(uint32_t value, vector<uint8_t>* bytes) {
+  for (int shift = 0; shift < 32; shift += 8) {
+    bytes->push_back(uint8_t(value >> shift));
+  }
+}
+
+uint32_t ReadUint32(const uint8_t* bytes) {
+  return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 |
+         uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+}
+
+void AppendEdit(const BlockEdit& edit, vector<uint8_t>* bytes) {
+  AppendUint32(uint32_t(edit.position.x), bytes);
+  AppendUint32(uint32_t(edit.position.y), bytes);
+  AppendUint32(uint32_t(edit.position.z), bytes);
+  bytes->push_back(uint8_t(edit.block_type));
+}
+
+BlockEdit ReadEdit(const uint8_t* bytes) {
+  return BlockEdit{ivec3(int32_t(ReadUint32(bytes)),
+                         int32_t(ReadUint32(bytes + 4)),
+                         int32_t(ReadUint32(bytes + 8))),
+                   BlockTypes(bytes[12])};
+}
+
+void WriteAll(int descriptor, const vector<uint8_t>& bytes) {
+  size_t written = 0;
+  while (written < bytes.size()) {
+    ssize_t result =
+        write(descriptor, bytes.data() + written, bytes.size() - written);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ThrowSystemError("write");
+    }
+    written += size_t(result);
+  }
+}
+
+/// \param path a file
+/// \param bytes output contents
+/// \return false if and only if the file does not exist
+bool ReadAll(const string& path, vector<uint8_t>* bytes) {
+  int descriptor = open(path.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    if (errno == ENOENT) {
+      return false;
+    }
+    ThrowSystemError("open " + path);
+  }
+  bytes->clear();
+  uint8_t buffer[1 << 16];
+  while (true) {
+    ssize_t result = read(descriptor, buffer, sizeof(buffer));
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      close(descriptor);
+      ThrowSystemError("read " + path);
+    }
+    if (result == 0) {
+      break;
+    }
+    bytes->insert(bytes->end(), buffer, buffer + result);
+  }
+  close(descriptor);
+  return true;
+}
+
+void MakeDirectory(const string& path) {
+  if (mkdir(path.c_str(), 0755) < 0 && errno != EEXIST) {
+    ThrowSystemError("mkdir " + path);
+  }
+}
+
+/// makes the entries of a directory, e.g. renamed files, durable
+void SyncDirectory(const string& path) {
+  int descriptor = open(path.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    ThrowSystemError("open " + path);
+  }
+  fsync(descriptor);
+  close(descriptor);
+}
+
+int FloorDivide(int numerator, int denominator) {
+  int quotient = numerator / denominator;
+  return quotient * denominator > numerator ? quotient - 1 : quotient;
+}
+
+}  // namespace
+
+double JournalStats::GetThroughput() const {
+  return writer_seconds > 0 ? double(edits_durable) / writer_seconds : 0;
+}
+
+EditJournal::EditJournal(const string& directory, size_t chunk_radius,
+                         double sync_interval, size_t checkpoint_bytes)
+    : directory_(directory),
+      chunk_width_(2 * int(chunk_radius)),
+      sync_interval_(sync_interval),
+      checkpoint_bytes_(checkpoint_bytes),
+      journal_(-1),
+      journal_bytes_(0),
+      stopping_(false),
+      appended_batches_(0),
+      durable_batches_(0),
+      sync_requested_(0),
+      requested_checkpoints_(0),
+      completed_checkpoints_(0),
+      stats_(),
+      append_nanoseconds_(0) {
+  if (chunk_radius == 0) {
+    throw std::invalid_argument("chunk radius must be positive");
+  }
+  MakeDirectory(directory_);
+  MakeDirectory(directory_ + "/chunks");
+  Recover();
+  for (const pair<const ChunkCoordinates, ChunkEdits>& chunk_edits : edits_) {
+    for (const pair<const ivec3, BlockTypes>& edit : chunk_edits.second) {
+      recovered_edits_.push_back(BlockEdit{edit.first, edit.second});
+    }
+  }
+
+  journal_ = open((directory_ + "/journal").c_str(),
+                  O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (journal_ < 0) {
+    ThrowSystemError("open " + directory_ + "/journal");
+  }
+  // folds the replayed tail into the store, which also cuts off a torn record
+  if (journal_bytes_ > 0) {
+    try {
+      WriteCheckpoint();
+    } catch (...) {
+      close(journal_);
+      throw;
+    }
+    ++stats_.checkpoints;
+  }
+  writer_ = std::thread(&EditJournal::Run, this);
+}
+
+EditJournal::~EditJournal() {
+  {
+    lock_guard<mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  writer_condition_.notify_all();
+  writer_.join();
+  close(journal_);
+}
+
+const vector<BlockEdit>& EditJournal::GetRecoveredEdits() const {
+  return recovered_edits_;
+}
+
+void EditJournal::Append(const vector<BlockChange>& changes) {
+  if (changes.empty()) {
+    return;
+  }
+  steady_clock::time_point start = steady_clock::now();
+  Batch batch;
+  batch.edits.reserve(changes.size());
+  for (const BlockChange& change : changes) {
+    batch.edits.push_back(BlockEdit{change.position, change.block_type});
+  }
+  batch.appended = start;
+  {
+    lock_guard<mutex> lock(mutex_);
+    if (!error_.empty()) {
+      throw runtime_error(error_);
+    }
+    pending_.push_back(std::move(batch));
+    ++appended_batches_;
+    stats_.edits_appended += changes.size();
+  }
+  writer_condition_.notify_one();
+  append_nanoseconds_ += uint64_t(
+      duration_cast<nanoseconds>(steady_clock::now() - start).count());
+}
+
+void EditJournal::Flush() {
+  unique_lock<mutex> lock(mutex_);
+  uint64_t target = appended_batches_;
+  sync_requested_ = std::max(sync_requested_, target);
+  writer_condition_.notify_one();
+  done_condition_.wait(lock, [this, target]() {
+    return durable_batches_ >= target || !error_.empty();
+  });
+  if (!error_.empty()) {
+    throw runtime_error(error_);
+  }
+}
+
+void EditJournal::Checkpoint() {
+  unique_lock<mutex> lock(mutex_);
+  uint64_t target = ++requested_checkpoints_;
+  writer_condition_.notify_one();
+  done_condition_.wait(lock, [this, target]() {
+    return completed_checkpoints_ >= target || !error_.empty();
+  });
+  if (!error_.empty()) {
+    throw runtime_error(error_);
+  }
+}
+
+JournalStats EditJournal::GetStats() const {
+  JournalStats stats;
+  vector<double> latencies;
+  {
+    lock_guard<mutex> lock(mutex_);
+    stats = stats_;
+    latencies.assign(latencies_.begin(), latencies_.end());
+  }
+  stats.append_seconds = double(append_nanoseconds_.load()) * 1e-9;
+  stats.chunk_io = chunk_io_.GetStats();
+  stats.p99_durable_seconds = 0;
+  if (!latencies.empty()) {
+    size_t rank = std::min(latencies.size() - 1, latencies.size() * 99 / 100);
+    std::nth_element(latencies.begin(), latencies.begin() + rank,
+                     latencies.end());
+    stats.p99_durable_seconds = latencies[rank];
+  }
+  return stats;
+}
+
+size_t EditJournal::PositionHasher::operator()(const ivec3& position) const {
+  return size_t(position.x * 5209) ^ size_t(position.y * 1811) ^
+         size_t(position.z * 7297);
+}
+
+void EditJournal::Run() {
+  // batches written to the journal but not synced yet
+  std::deque<Batch> unsynced;
+  unique_lock<mutex> lock(mutex_);
+  while (true) {
+    bool idle = pending_.empty() && !stopping_ &&
+                requested_checkpoints_ == completed_checkpoints_ &&
+                sync_requested_ <= durable_batches_;
+    if (idle && unsynced.empty()) {
+      writer_condition_.wait(lock);
+      continue;
+    }
+    if (idle &&
+        writer_condition_.wait_until(
+            lock, unsynced.front().appended +
+                      duration_cast<steady_clock::duration>(
+                          duration<double>(sync_interval_))) ==
+            std::cv_status::no_timeout) {
+      continue;
+    }
+
+    std::deque<Batch> batches;
+    batches.swap(pending_);
+    bool stopping = stopping_;
+    bool sync_requested = sync_requested_ > durable_batches_;
+    uint64_t checkpoint_target = requested_checkpoints_;
+    bool checkpoint = stopping || checkpoint_target > completed_checkpoints_;
+    lock.unlock();
+
+    steady_clock::time_point start = steady_clock::now();
+    uint64_t bytes_written = 0;
+    size_t synced_batches = 0;
+    size_t synced_edits = 0;
+    vector<double> latencies;
+    bool checkpointed = false;
+    string error;
+    try {
+      for (Batch& batch : batches) {
+        vector<uint8_t> payload;
+        payload.reserve(batch.edits.size() * kEditSize);
+        for (const BlockEdit& edit : batch.edits) {
+          AppendEdit(edit, &payload);
+          Remember(edit);
+        }
+        vector<uint8_t> record;
+        record.reserve(kRecordHeaderSize + payload.size());
+        AppendUint32(uint32_t(payload.size()), &record);
+        AppendUint32(GetChecksum(payload.data(), payload.size()), &record);
+        record.insert(record.end(), payload.begin(), payload.end());
+        WriteAll(journal_, record);
+        journal_bytes_ += record.size();
+        bytes_written += record.size();
+        unsynced.push_back(std::move(batch));
+      }
+
+      steady_clock::time_point now = steady_clock::now();
+      bool full = journal_bytes_ >= checkpoint_bytes_;
+      if (!unsynced.empty() &&
+          (checkpoint || sync_requested || full ||
+           duration<double>(now - unsynced.front().appended).count() >=
+               sync_interval_)) {
+        if (fsync(journal_) < 0) {
+          ThrowSystemError("fsync journal");
+        }
+        steady_clock::time_point synced = steady_clock::now();
+        for (const Batch& batch : unsynced) {
+          latencies.push_back(
+              duration<double>(synced - batch.appended).count());
+          synced_edits += batch.edits.size();
+        }
+        synced_batches = unsynced.size();
+        unsynced.clear();
+      }
+      if ((checkpoint || full) && unsynced.empty() && journal_bytes_ > 0) {
+        WriteCheckpoint();
+        checkpointed = true;
+      }
+    } catch (const std::exception& exception) {
+      error = exception.what();
+    }
+    double seconds = duration<double>(steady_clock::now() - start).count();
+
+    lock.lock();
+    durable_batches_ += synced_batches;
+    stats_.edits_durable += synced_edits;
+    stats_.bytes_written += bytes_written;
+    stats_.syncs += synced_batches > 0 ? 1 : 0;
+    stats_.checkpoints += checkpointed ? 1 : 0;
+    stats_.writer_seconds += seconds;
+    for (double latency : latencies) {
+      latencies_.push_back(latency);
+      if (latencies_.size() > kLatencySamplesCount) {
+        latencies_.pop_front();
+      }
+    }
+    if (error.empty() && checkpoint) {
+      completed_checkpoints_ =
+          std::max(completed_checkpoints_, checkpoint_target);
+    }
+    error_ = error;
+    done_condition_.notify_all();
+    if (!error_.empty() || (stopping && pending_.empty())) {
+      return;
+    }
+  }
+}
+
+void EditJournal::Recover() {
+  string chunks_path = directory_ + "/chunks";
+  DIR* chunks = opendir(chunks_path.c_str());
+  if (chunks == nullptr) {
+    ThrowSystemError("opendir " + chunks_path);
+  }
+  vector<string> paths;
+  for (dirent* entry = readdir(chunks); entry != nullptr;
+       entry = readdir(chunks)) {
+    ChunkCoordinates chunk;
+    int length = 0;
+    // skips ".", ".." and the temporary files of an interrupted checkpoint
+    if (std::sscanf(entry->d_name, "%d_%d_%d%n", &chunk.x, &chunk.y, &chunk.z,
+                    &length) != 3 ||
+        entry->d_name[length] != '\0') {
+      continue;
+    }
+    paths.push_back(GetChunkPath(chunk));
+  }
+  closedir(chunks);
+  chunk_io_.ReadFiles(paths, [this, &paths](size_t index,
+                                            vector<uint8_t>* bytes) {
+    if (bytes->size() < 8 ||
+        bytes->size() != 8 + ReadUint32(bytes->data()) * kEditSize ||
+        ReadUint32(bytes->data() + bytes->size() - 4) !=
+            GetChecksum(bytes->data(), bytes->size() - 4)) {
+      throw runtime_error(paths[index] + " is corrupt");
+    }
+    for (size_t offset = 4; offset + 4 < bytes->size(); offset += kEditSize) {
+      Remember(ReadEdit(bytes->data() + offset));
+    }
+  });
+  dirty_chunks_.clear();
+
+  vector<uint8_t> bytes;
+  if (!ReadAll(directory_ + "/journal", &bytes)) {
+    return;
+  }
+  journal_bytes_ = bytes.size();
+  size_t offset = 0;
+  while (offset + kRecordHeaderSize <= bytes.size()) {
+    size_t size = ReadUint32(bytes.data() + offset);
+    const uint8_t* payload = bytes.data() + offset + kRecordHeaderSize;
+    if (size > bytes.size() - offset - kRecordHeaderSize ||
+        size % kEditSize != 0 ||
+        ReadUint32(bytes.data() + offset + 4) != GetChecksum(payload, size)) {
+      break;
+    }
+    for (size_t edit = 0; edit < size; edit += kEditSize) {
+      Remember(ReadEdit(payload + edit));
+    }
+    offset += kRecordHeaderSize + size;
+  }
+}
+
+void EditJournal::WriteCheckpoint() {
+  vector<string> temporary_paths;
+  vector<vector<uint8_t>> contents;
+  for (const ChunkCoordinates& chunk : dirty_chunks_) {
+    const ChunkEdits& chunk_edits = edits_[chunk];
+    vector<uint8_t> bytes;
+    bytes.reserve(8 + chunk_edits.size() * kEditSize);
+    AppendUint32(uint32_t(chunk_edits.size()), &bytes);
+    for (const pair<const ivec3, BlockTypes>& edit : chunk_edits) {
+      AppendEdit(BlockEdit{edit.first, edit.second}, &bytes);
+    }
+    AppendUint32(GetChecksum(bytes.data(), bytes.size()), &bytes);
+    temporary_paths.push_back(GetChunkPath(chunk) + ".tmp");
+    contents.push_back(std::move(bytes));
+  }
+  // every new chunk file is durable before any replaces its old version
+  chunk_io_.WriteFiles(temporary_paths, contents);
+  for (const string& temporary_path : temporary_paths) {
+    string path = temporary_path.substr(0, temporary_path.size() - 4);
+    if (rename(temporary_path.c_str(), path.c_str()) < 0) {
+      ThrowSystemError("rename " + temporary_path);
+    }
+  }
+  SyncDirectory(directory_ + "/chunks");
+  dirty_chunks_.clear();
+
+  // only now is the journal redundant; a crash before this point replays it
+  // over the new chunk files, which is harmless
+  if (ftruncate(journal_, 0) < 0 || fsync(journal_) < 0) {
+    ThrowSystemError("truncate journal");
+  }
+  journal_bytes_ = 0;
+}
+
+void EditJournal::Remember(const BlockEdit& edit) {
+  ChunkCoordinates chunk{
+      FloorDivide(edit.position.x + chunk_width_ / 2, chunk_width_),
+      FloorDivide(edit.position.y + chunk_width_ / 2, chunk_width_),
+      FloorDivide(edit.position.z + chunk_width_ / 2, chunk_width_)};
+  edits_[chunk][edit.position] = edit.block_type;
+  dirty_chunks_.insert(chunk);
+}
+
+string EditJournal::GetChunkPath(const ChunkCoordinates& chunk) const {
+  return directory_ + "/chunks/" + std::to_string(chunk.x) + "_" +
+         std::to_string(chunk.y) + "_" + std::to_string(chunk.z);
+}
+
+}  // namespace minecraft
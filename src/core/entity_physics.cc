@@ -0,0 +1,144 @@
+#include "core/entity_physics.h"
+
+#include <cmath>
+
+#include "core/block_registry.h"
+
+using glm::ivec3;
+using glm::vec3;
+using std::pair;
+
+namespace minecraft {
+
+const float EntityPhysics::kGravity = 32.0f;
+const float EntityPhysics::kSkin = 0.001f;
+
+namespace {
+
+/// blocks are centered on lattice points. these return the lowest and the
+/// highest lattice coordinate of the blocks a box's side overlaps
+
+int GetLowestOverlapped(float min_corner) {
+  return int(std::floor(min_corner - 0.5f)) + 1;
+}
+
+int GetHighestOverlapped(float max_corner) {
+  return int(std::ceil(max_corner + 0.5f)) - 1;
+}
+
+}  // namespace
+
+EntityPhysics::EntityPhysics(World* world, float cell_size)
+    : world_(world),
+      broadphase_(cell_size),
+      loaded_bounds_(world->GetLoadedBounds()) {
+}
+
+void EntityPhysics::Move(EntityStore* store, float seconds) {
+  loaded_bounds_ = world_->GetLoadedBounds();
+  vec3* positions = store->GetPositions();
+  vec3* velocities = store->GetVelocities();
+  const vec3* half_extents = store->GetHalfExtents();
+  uint8_t* on_ground = store->GetOnGround();
+  const int axes[3] = {1, 0, 2};
+  for (size_t slot = 0; slot < store->GetCount(); ++slot) {
+    vec3& velocity = velocities[slot];
+    velocity.y -= kGravity * seconds;
+    on_ground[slot] = 0;
+    for (int axis : axes) {
+      float distance = velocity[axis] * seconds;
+      if (distance != 0 && !MoveAlong(axis, distance, &positions[slot],
+                                      half_extents[slot])) {
+        on_ground[slot] = axis == 1 && distance < 0 ? 1 : on_ground[slot];
+        velocity[axis] = 0;
+      }
+    }
+  }
+}
+
+void EntityPhysics::Separate(EntityStore* store) {
+  loaded_bounds_ = world_->GetLoadedBounds();
+  vec3* positions = store->GetPositions();
+  const vec3* half_extents = store->GetHalfExtents();
+  broadphase_.Build(positions, half_extents, store->GetCount());
+  broadphase_.FindPairs(&pairs_);
+  for (const pair<uint32_t, uint32_t>& entities : pairs_) {
+    vec3 offset = positions[entities.second] - positions[entities.first];
+    vec3 overlap = half_extents[entities.first] +
+                   half_extents[entities.second] - glm::abs(offset);
+    if (overlap.x <= 0 || overlap.z <= 0) {
+      // an earlier pair already pushed one of them away
+      continue;
+    }
+    int axis = overlap.x < overlap.z ? 0 : 2;
+    float push = (offset[axis] < 0 ? -overlap[axis] : overlap[axis]) / 2;
+    MoveAlong(axis, -push, &positions[entities.first],
+              half_extents[entities.first]);
+    MoveAlong(axis, push, &positions[entities.second],
+              half_extents[entities.second]);
+  }
+}
+
+void EntityPhysics::AddSystems(EntityScheduler* scheduler) {
+  scheduler->AddSystem("separate",
+                       [this](EntityStore* store, float) { Separate(store); });
+  scheduler->AddSystem("move", [this](EntityStore* store, float seconds) {
+    Move(store, seconds);
+  });
+}
+
+size_t EntityPhysics::GetPairsCount() const {
+  return pairs_.size();
+}
+
+bool EntityPhysics::MoveAlong(int axis, float distance, vec3* position,
+                              const vec3& half_extents) {
+  vec3 min_corner = *position - half_extents;
+  vec3 max_corner = *position + half_extents;
+  // layers of blocks the box sweeps through, nearest first, not counting
+  // those it overlaps already. the sweep reaches `kSkin` further, so a box
+  // resting on a block keeps finding it
+  int first_layer;
+  int last_layer;
+  int step;
+  if (distance > 0) {
+    first_layer = GetHighestOverlapped(max_corner[axis]) + 1;
+    last_layer = GetHighestOverlapped(max_corner[axis] + distance + kSkin);
+    step = 1;
+  } else {
+    first_layer = GetLowestOverlapped(min_corner[axis]) - 1;
+    last_layer = GetLowestOverlapped(min_corner[axis] + distance - kSkin);
+    step = -1;
+  }
+  int first_side = (axis + 1) % 3;
+  int second_side = (axis + 2) % 3;
+
+  for (int layer = first_layer; (last_layer - layer) * step >= 0;
+       layer += step) {
+    ivec3 block;
+    block[axis] = layer;
+    for (block[first_side] = GetLowestOverlapped(min_corner[first_side]);
+         block[first_side] <= GetHighestOverlapped(max_corner[first_side]);
+         ++block[first_side]) {
+      for (block[second_side] = GetLowestOverlapped(min_corner[second_side]);
+           block[second_side] <=
+           GetHighestOverlapped(max_corner[second_side]);
+           ++block[second_side]) {
+        if (IsBlocked(block)) {
+          (*position)[axis] =
+              float(layer) - float(step) * (0.5f + half_extents[axis] + kSkin);
+          return false;
+        }
+      }
+    }
+  }
+  (*position)[axis] += distance;
+  return true;
+}
+
+bool EntityPhysics::IsBlocked(const ivec3& position) {
+  return !loaded_bounds_.Contains(position) ||
+         BlockRegistry::IsSolid(world_->GetBlockAt(vec3(position)));
+}
+
+}  // namespace minecraft
@@ -0,0 +1,79 @@
+#include "core/entity_scheduler.h"
+
+#include <chrono>
+#include <stdexcept>
+
+using std::string;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+namespace minecraft {
+
+EntityScheduler::EntityScheduler(float step_seconds, size_t max_steps)
+    : step_seconds_(step_seconds),
+      max_steps_(max_steps),
+      pending_seconds_(0),
+      steps_count_(0) {
+  if (!(step_seconds > 0) || max_steps == 0) {
+    throw std::invalid_argument("entities must be stepped forward in time");
+  }
+}
+
+void EntityScheduler::AddSystem(const string& name, const System& system) {
+  systems_.push_back(ScheduledSystem{name, system, 0});
+}
+
+size_t EntityScheduler::Advance(EntityStore* store, float elapsed_seconds) {
+  pending_seconds_ += elapsed_seconds;
+  size_t steps = 0;
+  while (pending_seconds_ >= step_seconds_ && steps < max_steps_) {
+    Step(store);
+    pending_seconds_ -= step_seconds_;
+    ++steps;
+  }
+  if (pending_seconds_ >= step_seconds_) {
+    pending_seconds_ = 0;
+  }
+  return steps;
+}
+
+void EntityScheduler::Step(EntityStore* store) {
+  for (ScheduledSystem& system : systems_) {
+    steady_clock::time_point start = steady_clock::now();
+    system.run(store, step_seconds_);
+    system.seconds += duration<double>(steady_clock::now() - start).count();
+  }
+  ++steps_count_;
+}
+
+float EntityScheduler::GetStepSeconds() const {
+  return step_seconds_;
+}
+
+uint64_t EntityScheduler::GetStepsCount() const {
+  return steps_count_;
+}
+
+float EntityScheduler::GetInterpolation() const {
+  return pending_seconds_ / step_seconds_;
+}
+
+vector<string> EntityScheduler::GetSystemNames() const {
+  vector<string> names;
+  for (const ScheduledSystem& system : systems_) {
+    names.push_back(system.name);
+  }
+  return names;
+}
+
+double EntityScheduler::GetSystemSeconds(const string& name) const {
+  for (const ScheduledSystem& system : systems_) {
+    if (system.name == name) {
+      return system.seconds;
+    }
+  }
+  throw std::invalid_argument("there is no entity system named " + name);
+}
+
+}  // namespace minecraft
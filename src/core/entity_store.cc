@@ -0,0 +1,107 @@
+#include "core/entity_store.h"
+
+#include <stdexcept>
+#include <string>
+
+using glm::vec3;
+
+namespace minecraft {
+
+Entity EntityStore::Create(const vec3& position, const vec3& half_extents) {
+  uint32_t index;
+  if (free_indices_.empty()) {
+    index = uint32_t(slots_.size());
+    slots_.push_back(0);
+    generations_.push_back(0);
+  } else {
+    index = free_indices_.back();
+    free_indices_.pop_back();
+  }
+  Entity entity{index, generations_[index]};
+  slots_[index] = uint32_t(entities_.size());
+  positions_.push_back(position);
+  velocities_.push_back(vec3(0));
+  half_extents_.push_back(half_extents);
+  on_ground_.push_back(0);
+  entities_.push_back(entity);
+  return entity;
+}
+
+bool EntityStore::Destroy(const Entity& entity) {
+  if (!IsAlive(entity)) {
+    return false;
+  }
+  size_t slot = slots_[entity.index];
+  size_t last = entities_.size() - 1;
+  if (slot != last) {
+    positions_[slot] = positions_[last];
+    velocities_[slot] = velocities_[last];
+    half_extents_[slot] = half_extents_[last];
+    on_ground_[slot] = on_ground_[last];
+    entities_[slot] = entities_[last];
+    slots_[entities_[slot].index] = uint32_t(slot);
+  }
+  positions_.pop_back();
+  velocities_.pop_back();
+  half_extents_.pop_back();
+  on_ground_.pop_back();
+  entities_.pop_back();
+  ++generations_[entity.index];
+  free_indices_.push_back(entity.index);
+  return true;
+}
+
+bool EntityStore::IsAlive(const Entity& entity) const {
+  return entity.index < generations_.size() &&
+         generations_[entity.index] == entity.generation;
+}
+
+size_t EntityStore::GetCount() const {
+  return entities_.size();
+}
+
+size_t EntityStore::GetSlot(const Entity& entity) const {
+  if (!IsAlive(entity)) {
+    throw std::invalid_argument("entity " + std::to_string(entity.index) +
+                                " was destroyed");
+  }
+  return slots_[entity.index];
+}
+
+Entity EntityStore::GetEntity(size_t slot) const {
+  return entities_[slot];
+}
+
+vec3* EntityStore::GetPositions() {
+  return positions_.data();
+}
+
+const vec3* EntityStore::GetPositions() const {
+  return positions_.data();
+}
+
+vec3* EntityStore::GetVelocities() {
+  return velocities_.data();
+}
+
+const vec3* EntityStore::GetVelocities() const {
+  return velocities_.data();
+}
+
+vec3* EntityStore::GetHalfExtents() {
+  return half_extents_.data();
+}
+
+const vec3* EntityStore::GetHalfExtents() const {
+  return half_extents_.data();
+}
+
+uint8_t* EntityStore::GetOnGround() {
+  return on_ground_.data();
+}
+
+const uint8_t* EntityStore::GetOnGround() const {
+  return on_ground_.data();
+}
+
+}  // namespace minecraft
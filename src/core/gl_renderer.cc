@@ -0,0 +1,213 @@
+#include "core/gl_renderer.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "core/block.h"
+#include "core/block_registry.h"
+#include "core/texture.h"
+
+using ci::CameraPersp;
+using ci::Rectf;
+using ci::TriMesh;
+using ci::vec3;
+using ci::gl::GlslProg;
+using ci::gl::Texture2dRef;
+using ci::gl::Vao;
+using ci::gl::Vbo;
+using std::string;
+using std::to_string;
+using std::vector;
+
+namespace minecraft {
+
+namespace {
+
+/// attribute location of the packed vertex
+const GLuint kPackedAttribute = 0;
+
+/// \return a vertex shader that decodes `PackedVertex` exactly like
+/// `PackedVertex::GetPosition` and `PackedVertex::GetTexCoord` do
+string MakePackedVertexShader() {
+  string corners;
+  for (size_t face = 0; face < Block::kCubeFacesCount; ++face) {
+    for (size_t corner = 0; corner < Block::kSquareVerticesCount; ++corner) {
+      const vec3& position = Block::kCubeFaces[face][corner];
+      corners += (corners.empty() ? "" : ", ") + string("vec3(") +
+                 to_string(position.x) + ", " + to_string(position.y) + ", " +
+                 to_string(position.z) + ")";
+    }
+  }
+  string tex_coords;
+  for (size_t corner = 0; corner < Block::kSquareVerticesCount; ++corner) {
+    const ci::vec2& tex_coord = Block::kSquareTexCoords[corner];
+    tex_coords += (tex_coords.empty() ? "" : ", ") + string("vec2(") +
+                  to_string(tex_coord.x) + ", " + to_string(tex_coord.y) + ")";
+  }
+  string position_mask = to_string((1u << PackedVertex::kPositionBits) - 1);
+  string tiles = to_string(float(BlockRegistry::kTilesPerStrip));
+  string strips = to_string(float(BlockRegistry::kAtlasStripsCount));
+  return "#version 150\n"
+         "uniform mat4 ciModelViewProjection;\n"
+         "uniform vec3 uOrigin;\n"
+         "in uint aPacked;\n"
+         "out highp vec2 TexCoord;\n"
+         "const vec3 kCorners[" +
+         to_string(Block::kCubeFacesCount * Block::kSquareVerticesCount) +
+         "] = vec3[](" + corners +
+         ");\n"
+         "const vec2 kTexCoords[" +
+         to_string(Block::kSquareVerticesCount) + "] = vec2[](" + tex_coords +
+         ");\n"
+         "void main() {\n"
+         "  uint mask = " + position_mask + "u;\n"
+         "  vec3 block = vec3(float(aPacked & mask),\n"
+         "      float((aPacked >> " + to_string(PackedVertex::kPositionBits) +
+         "u) & mask),\n"
+         "      float((aPacked >> " +
+         to_string(2 * PackedVertex::kPositionBits) +
+         "u) & mask));\n"
+         "  uint face = (aPacked >> " + to_string(PackedVertex::kFaceShift) +
+         "u) & 7u;\n"
+         "  uint corner = (aPacked >> " +
+         to_string(PackedVertex::kCornerShift) +
+         "u) & 3u;\n"
+         "  uint layer = aPacked >> " + to_string(PackedVertex::kLayerShift) +
+         "u;\n"
+         "  vec3 position = uOrigin + block + kCorners[face * 4u + corner];\n"
+         "  gl_Position = ciModelViewProjection * vec4(position, 1.0);\n"
+         "  float column = float(layer % " +
+         to_string(BlockRegistry::kTilesPerStrip) +
+         "u);\n"
+         "  float row = float(layer / " +
+         to_string(BlockRegistry::kTilesPerStrip) +
+         "u);\n"
+         "  vec2 uv = kTexCoords[corner];\n"
+         "  TexCoord = vec2((column + uv.x) / " + tiles +
+         ",\n"
+         "                  1.0 - (row + 1.0 - uv.y) / " + strips +
+         ");\n"
+         "}\n";
+}
+
+const char* const kPackedFragmentShader =
+    "#version 150\n"
+    "uniform sampler2D uTex0;\n"
+    "in highp vec2 TexCoord;\n"
+    "out vec4 oColor;\n"
+    "void main() {\n"
+    "  oColor = texture(uTex0, TexCoord);\n"
+    "}\n";
+
+}  // namespace
+
+GlRenderer::GlRenderer() : quads_count_(0), frame_(0) {
+}
+
+void GlRenderer::Clear() {
+  ci::gl::clear();
+  // meshes not drawn last frame were unloaded or destroyed
+  for (auto upload = uploads_.begin(); upload != uploads_.end();) {
+    if (upload->second.frame < frame_) {
+      upload = uploads_.erase(upload);
+    } else {
+      ++upload;
+    }
+  }
+  ++frame_;
+}
+
+void GlRenderer::SetWindowMatrices(const glm::ivec2& size) {
+  ci::gl::setMatricesWindow(size);
+}
+
+void GlRenderer::SetCamera(const vec3& eye, const vec3& forward) {
+  ci::gl::enableDepthRead();
+  ci::gl::enableDepthWrite();
+
+  CameraPersp cam;
+  cam.lookAt(eye, eye + forward);
+  ci::gl::setMatrices(cam);
+}
+
+void GlRenderer::DrawMesh(const TriMesh& mesh) {
+  ci::gl::ScopedGlslProg glslScope{
+      ci::gl::getStockShader(ci::gl::ShaderDef().texture())};
+  ci::gl::ScopedTextureBind texScope{Texture::GetAtlas()};
+  ci::gl::draw(mesh);
+}
+
+void GlRenderer::DrawPackedMesh(const PackedMesh& mesh) {
+  if (mesh.GetVertices().empty()) {
+    return;
+  }
+  if (packed_shader_ == nullptr) {
+    packed_shader_ = GlslProg::create(
+        GlslProg::Format()
+            .vertex(MakePackedVertexShader())
+            .fragment(kPackedFragmentShader)
+            .attribLocation("aPacked", GLint(kPackedAttribute)));
+    packed_shader_->uniform("uTex0", 0);
+  }
+  size_t quads_count = mesh.GetVertices().size() / 4;
+  ReserveQuads(quads_count);
+
+  Upload& upload = uploads_[&mesh];
+  if (upload.vao == nullptr || upload.revision != mesh.GetRevision()) {
+    upload.vertices = Vbo::create(GL_ARRAY_BUFFER, mesh.GetBytes(),
+                                  mesh.GetVertices().data(), GL_STATIC_DRAW);
+    upload.vao = Vao::create();
+    ci::gl::ScopedVao vao_scope(upload.vao);
+    ci::gl::ScopedBuffer buffer_scope(upload.vertices);
+    ci::gl::enableVertexAttribArray(kPackedAttribute);
+    ci::gl::vertexAttribIPointer(kPackedAttribute, 1, GL_UNSIGNED_INT, 0,
+                                 nullptr);
+    upload.revision = mesh.GetRevision();
+  }
+  upload.frame = frame_;
+
+  ci::gl::ScopedGlslProg glsl_scope(packed_shader_);
+  ci::gl::ScopedTextureBind texture_scope(Texture::GetAtlas());
+  ci::gl::ScopedVao vao_scope(upload.vao);
+  // the index buffer may have grown since the mesh was uploaded
+  ci::gl::ScopedBuffer index_scope(quad_indices_);
+  packed_shader_->uniform("uOrigin", vec3(mesh.GetOrigin()));
+  ci::gl::setDefaultShaderVars();
+  ci::gl::drawElements(GL_TRIANGLES, GLsizei(quads_count * 6),
+                       GL_UNSIGNED_INT, nullptr);
+}
+
+void GlRenderer::DrawTranslucentPackedMesh(const PackedMesh& mesh) {
+  ci::gl::ScopedBlendAlpha blend_scope;
+  ci::gl::ScopedDepthWrite depth_write_scope(false);
+  DrawPackedMesh(mesh);
+}
+
+void GlRenderer::DrawStrokedCube(const vec3& center, const vec3& size) {
+  ci::gl::drawStrokedCube(center, size);
+}
+
+void GlRenderer::DrawTexture(const Texture2dRef& texture, const Rectf& bounds) {
+  ci::gl::draw(texture, bounds);
+}
+
+void GlRenderer::ReserveQuads(size_t quads_count) {
+  if (quads_count <= quads_count_) {
+    return;
+  }
+  quads_count_ = std::max(quads_count, 2 * quads_count_);
+  vector<uint32_t> indices;
+  indices.reserve(quads_count_ * 6);
+  for (uint32_t first = 0; first < quads_count_ * 4; first += 4) {
+    // the triangles of `Block::AppendFace`
+    uint32_t quad[6] = {first, first + 1, first + 2,
+                        first, first + 2, first + 3};
+    indices.insert(indices.end(), quad, quad + 6);
+  }
+  quad_indices_ =
+      Vbo::create(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t),
+                  indices.data(), GL_STATIC_DRAW);
+}
+
+}  // namespace minecraft
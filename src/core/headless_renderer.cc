@@ -0,0 +1,208 @@
+#include "core/headless_renderer.h"
+
+#include <algorithm>
+#include <limits>
+
+using ci::Rectf;
+using ci::TriMesh;
+using ci::vec2;
+using ci::vec3;
+using ci::vec4;
+using ci::gl::Texture2dRef;
+using glm::ivec2;
+
+namespace minecraft {
+
+const float HeadlessRenderer::kFieldOfView = glm::radians(35.0f);
+const float HeadlessRenderer::kNearPlane = 0.1f;
+const float HeadlessRenderer::kFarPlane = 1000.0f;
+
+double RenderStats::GetDepthComplexity() const {
+  return covered_pixels == 0 ? 0 : double(fragments) / double(covered_pixels);
+}
+
+double RenderStats::GetOverdraw() const {
+  return covered_pixels == 0 ? 0
+                             : double(visible_fragments) /
+                                   double(covered_pixels);
+}
+
+HeadlessRenderer::HeadlessRenderer(const ivec2& raster_size)
+    : raster_size_(raster_size),
+      view_projection_(1.0f),
+      perspective_(false),
+      pipeline_(Pipeline::kNone),
+      depth_(size_t(raster_size.x * raster_size.y),
+             std::numeric_limits<float>::max()),
+      fragments_(size_t(raster_size.x * raster_size.y), 0) {
+  ResetStats();
+}
+
+void HeadlessRenderer::Clear() {
+  std::fill(depth_.begin(), depth_.end(), std::numeric_limits<float>::max());
+  std::fill(fragments_.begin(), fragments_.end(), 0);
+}
+
+void HeadlessRenderer::SetWindowMatrices(const ivec2&) {
+  perspective_ = false;
+}
+
+void HeadlessRenderer::SetCamera(const vec3& eye, const vec3& forward) {
+  float aspect_ratio = raster_size_.y == 0
+                           ? 1.0f
+                           : float(raster_size_.x) / float(raster_size_.y);
+  view_projection_ =
+      glm::perspective(kFieldOfView, aspect_ratio, kNearPlane, kFarPlane) *
+      glm::lookAt(eye, eye + forward, vec3(0, 1, 0));
+  perspective_ = true;
+}
+
+void HeadlessRenderer::DrawMesh(const TriMesh& mesh) {
+  Draw(Pipeline::kAtlas, mesh.getNumTriangles(), mesh.getNumVertices(),
+       mesh.getNumVertices() * (sizeof(vec3) + sizeof(vec2)) +
+           mesh.getIndices().size() * sizeof(uint32_t));
+  if (!perspective_ || depth_.empty()) {
+    return;
+  }
+  const vec3* positions = mesh.getPositions<3>();
+  const std::vector<uint32_t>& indices = mesh.getIndices();
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    vec3 corners[3] = {positions[indices[i]], positions[indices[i + 1]],
+                       positions[indices[i + 2]]};
+    RasterizeTriangle(corners);
+  }
+}
+
+void HeadlessRenderer::DrawPackedMesh(const PackedMesh& mesh) {
+  // the quads' indices are shared, so only the vertices count
+  Draw(Pipeline::kAtlas, mesh.GetTrianglesCount(), mesh.GetVertices().size(),
+       mesh.GetBytes());
+  RasterizePackedMesh(mesh, false);
+}
+
+void HeadlessRenderer::DrawTranslucentPackedMesh(const PackedMesh& mesh) {
+  Draw(Pipeline::kBlendedAtlas, mesh.GetTrianglesCount(),
+       mesh.GetVertices().size(), mesh.GetBytes());
+  RasterizePackedMesh(mesh, true);
+}
+
+void HeadlessRenderer::DrawStrokedCube(const vec3&, const vec3&) {
+  // twelve edges of two vertices
+  Draw(Pipeline::kLines, 0, 24, 24 * sizeof(vec3));
+}
+
+void HeadlessRenderer::DrawTexture(const Texture2dRef&, const Rectf&) {
+  Draw(Pipeline::kOverlay, 2, 4, 4 * (sizeof(vec2) + sizeof(vec2)));
+}
+
+const RenderStats& HeadlessRenderer::GetStats() const {
+  return stats_;
+}
+
+void HeadlessRenderer::ResetStats() {
+  stats_ = RenderStats{0, 0, 0, 0, 0, 0, 0, 0, 0};
+}
+
+void HeadlessRenderer::Draw(Pipeline pipeline, size_t triangles,
+                            size_t vertices, size_t geometry_bytes) {
+  if (pipeline != pipeline_) {
+    pipeline_ = pipeline;
+    ++stats_.state_changes;
+  }
+  ++stats_.draw_calls;
+  stats_.triangles += triangles;
+  stats_.vertices += vertices;
+  stats_.geometry_bytes += geometry_bytes;
+}
+
+void HeadlessRenderer::RasterizePackedMesh(const PackedMesh& mesh,
+                                           bool blended) {
+  if (!perspective_ || depth_.empty()) {
+    return;
+  }
+  const PackedVertices& vertices = mesh.GetVertices();
+  vec3 origin(mesh.GetOrigin());
+  for (size_t first = 0; first + 3 < vertices.size(); first += 4) {
+    vec3 quad[4];
+    for (size_t corner = 0; corner < 4; ++corner) {
+      quad[corner] = origin + vertices[first + corner].GetPosition();
+    }
+    vec3 first_triangle[3] = {quad[0], quad[1], quad[2]};
+    vec3 second_triangle[3] = {quad[0], quad[2], quad[3]};
+    RasterizeTriangle(first_triangle, blended);
+    RasterizeTriangle(second_triangle, blended);
+  }
+}
+
+void HeadlessRenderer::RasterizeTriangle(const vec3 corners[3],
+                                         bool blended) {
+  // to pixel coordinates, with normalized device depth
+  vec3 screen[3];
+  for (int corner = 0; corner < 3; ++corner) {
+    vec4 clip = view_projection_ * vec4(corners[corner], 1.0f);
+    if (clip.w < kNearPlane) {
+      return;
+    }
+    screen[corner] =
+        vec3((clip.x / clip.w * 0.5f + 0.5f) * float(raster_size_.x),
+             (clip.y / clip.w * 0.5f + 0.5f) * float(raster_size_.y),
+             clip.z / clip.w);
+  }
+
+  float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) -
+               (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+  if (area == 0) {
+    return;
+  }
+  int min_x = std::max(
+      0, int(std::floor(std::min({screen[0].x, screen[1].x, screen[2].x}))));
+  int max_x = std::min(
+      raster_size_.x - 1,
+      int(std::ceil(std::max({screen[0].x, screen[1].x, screen[2].x}))));
+  int min_y = std::max(
+      0, int(std::floor(std::min({screen[0].y, screen[1].y, screen[2].y}))));
+  int max_y = std::min(
+      raster_size_.y - 1,
+      int(std::ceil(std::max({screen[0].y, screen[1].y, screen[2].y}))));
+
+  for (int y = min_y; y <= max_y; ++y) {
+    for (int x = min_x; x <= max_x; ++x) {
+      vec2 center(float(x) + 0.5f, float(y) + 0.5f);
+      // barycentric weights from the edge functions, sign-corrected so
+      // either winding works
+      float weights[3];
+      bool inside = true;
+      for (int edge = 0; edge < 3; ++edge) {
+        const vec3& from = screen[(edge + 1) % 3];
+        const vec3& to = screen[(edge + 2) % 3];
+        weights[edge] = ((to.x - from.x) * (center.y - from.y) -
+                         (center.x - from.x) * (to.y - from.y)) /
+                        area;
+        inside = inside && weights[edge] >= 0;
+      }
+      if (!inside) {
+        continue;
+      }
+      float depth = weights[0] * screen[0].z + weights[1] * screen[1].z +
+                    weights[2] * screen[2].z;
+      if (depth < -1 || depth > 1) {
+        continue;
+      }
+      size_t pixel = size_t(y * raster_size_.x + x);
+      ++stats_.fragments;
+      if (fragments_[pixel]++ == 0) {
+        ++stats_.covered_pixels;
+      }
+      if (depth < depth_[pixel]) {
+        ++stats_.visible_fragments;
+        if (blended) {
+          ++stats_.blended_fragments;
+        } else {
+          depth_[pixel] = depth;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace minecraft
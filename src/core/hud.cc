@@ -0,0 +1,97 @@
+#include "core/hud.h"
+
+#include "cinder/Text.h"
+#include "core/texture.h"
+
+using ci::Color;
+using ci::ColorA;
+using ci::Font;
+using ci::Rectf;
+using ci::TextLayout;
+using ci::vec2;
+using ci::gl::Texture2d;
+using ci::gl::Texture2dRef;
+using std::string;
+using std::to_string;
+
+namespace minecraft {
+
+Hud::Hud(const Font& font, const Color& color)
+    : font_(font), color_(color), rasterized_count_(0) {
+}
+
+size_t Hud::AddText(const vec2& position, const string& label) {
+  elements_.push_back(Element{Rectf(position, position), false,
+                              BlockTypes::kNone, label, false, 0, true, true,
+                              nullptr});
+  return elements_.size() - 1;
+}
+
+size_t Hud::AddIcon(const Rectf& bounds, BlockTypes block_type) {
+  elements_.push_back(
+      Element{bounds, true, block_type, "", false, 0, true, true, nullptr});
+  return elements_.size() - 1;
+}
+
+void Hud::SetValue(size_t element, int64_t value) {
+  Element& text = elements_.at(element);
+  if (!text.has_value || text.value != value) {
+    text.has_value = true;
+    text.value = value;
+    text.dirty = true;
+  }
+}
+
+void Hud::SetVisible(size_t element, bool visible) {
+  elements_.at(element).visible = visible;
+}
+
+void Hud::Draw(Renderer* renderer) {
+  for (Element& element : elements_) {
+    if (!element.visible) {
+      continue;
+    }
+    if (element.dirty) {
+      element.texture = element.is_icon ? Texture::GetIcon(element.block_type)
+                                        : RasterizeText(GetText(element));
+      element.dirty = false;
+      ++rasterized_count_;
+    }
+    if (element.texture == nullptr) {
+      continue;
+    }
+    if (element.is_icon) {
+      renderer->DrawTexture(element.texture, element.bounds);
+    } else {
+      vec2 position = element.bounds.getUpperLeft();
+      vec2 size(element.texture->getWidth(), element.texture->getHeight());
+      renderer->DrawTexture(element.texture, Rectf(position, position + size));
+    }
+  }
+}
+
+size_t Hud::GetRasterizedCount() const {
+  return rasterized_count_;
+}
+
+string Hud::GetText(const Element& element) {
+  return element.has_value ? element.label + to_string(element.value)
+                           : element.label;
+}
+
+#ifdef DONT_USE_TEXTURES
+Texture2dRef Hud::RasterizeText(const string& text) const {
+  return nullptr;
+}
+#else
+Texture2dRef Hud::RasterizeText(const string& text) const {
+  TextLayout layout;
+  layout.clear(ColorA(0, 0, 0, 0));
+  layout.setFont(font_);
+  layout.setColor(color_);
+  layout.addLine(text);
+  return Texture2d::create(layout.render(true));
+}
+#endif
+
+}  // namespace minecraft
@@ -0,0 +1,275 @@
+#include "core/lod.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <unordered_map>
+
+#include "core/block.h"
+#include "core/block_registry.h"
+
+using ci::TriMesh;
+using ci::vec3;
+using glm::ivec3;
+using std::map;
+using std::unordered_map;
+using std::vector;
+
+namespace minecraft {
+
+const int LodManager::kTileCells = 8;
+const int LodManager::kLevelsCount = 3;
+const float LodManager::kRefineDistance = 1.0f;
+
+/// the empty box, so that every empty intersection compares equal
+static const BlockBox kEmptyBox{ivec3(0), ivec3(-1)};
+
+/// \return true if and only if the boxes have the same corners
+static bool IsSameBox(const BlockBox& first, const BlockBox& second) {
+  return first.min_corner == second.min_corner &&
+         first.max_corner == second.max_corner;
+}
+
+LodManager::LodManager(World* world, ThreadPool* thread_pool,
+                       float view_distance)
+    : world_(world),
+      thread_pool_(thread_pool),
+      view_distance_(view_distance),
+      max_builds_per_update_(std::numeric_limits<size_t>::max()),
+      builds_left_(0) {
+}
+
+void LodManager::Update(const vec3& eye) {
+  for (std::pair<const TileKey, Tile>& entry : tiles_) {
+    Tile& tile = entry.second;
+    if (tile.build.valid() &&
+        tile.build.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready) {
+      tile.mesh = tile.build.get();
+      tile.has_mesh = true;
+    }
+    tile.picked = false;
+  }
+  builds_left_ = max_builds_per_update_;
+
+  BlockBox loaded = world_->GetLoadedBounds();
+  float width = float(kTileCells << kLevelsCount);
+  ivec3 low(glm::floor((eye - vec3(view_distance_)) / width));
+  ivec3 high(glm::floor((eye + vec3(view_distance_)) / width));
+  for (int x = low.x; x <= high.x; ++x) {
+    for (int y = low.y; y <= high.y; ++y) {
+      for (int z = low.z; z <= high.z; ++z) {
+        Pick(TileKey{kLevelsCount, ivec3(x, y, z)}, eye, loaded);
+      }
+    }
+  }
+
+  // an unpicked tile's build, if any, still finishes but is discarded
+  for (map<TileKey, Tile>::iterator tile = tiles_.begin();
+       tile != tiles_.end();) {
+    if (tile->second.picked) {
+      ++tile;
+    } else {
+      tile = tiles_.erase(tile);
+    }
+  }
+}
+
+void LodManager::Pick(const TileKey& key, const vec3& eye,
+                      const BlockBox& loaded) {
+  BlockBox bounds = GetTileBounds(key);
+  vec3 closest = glm::clamp(eye, vec3(bounds.min_corner) - 0.5f,
+                            vec3(bounds.max_corner) + 0.5f);
+  float distance = glm::length(eye - closest);
+  if (distance > view_distance_) {
+    return;
+  }
+
+  float width = float(kTileCells << key.level);
+  if (key.level > 1 && (distance < kRefineDistance * width ||
+                        bounds.Intersects(loaded))) {
+    for (int child = 0; child < 8; ++child) {
+      ivec3 offset((child >> 2) & 1, (child >> 1) & 1, child & 1);
+      Pick(TileKey{key.level - 1, key.coordinates * 2 + offset}, eye, loaded);
+    }
+    return;
+  }
+
+  Tile& tile = tiles_[key];
+  tile.picked = true;
+  BlockBox excluded = bounds.Intersect(loaded);
+  if (excluded.IsEmpty()) {
+    excluded = kEmptyBox;
+  }
+  bool up_to_date =
+      tile.has_mesh && !tile.stale && IsSameBox(tile.excluded, excluded);
+  if (!tile.build.valid() && !up_to_date && builds_left_ > 0) {
+    Build(key, &tile, excluded);
+    --builds_left_;
+  }
+}
+
+void LodManager::Build(const TileKey& key, Tile* tile,
+                       const BlockBox& excluded) {
+  BlockBox bounds = GetTileBounds(key);
+  // the snapshot is copied into the task, so later edits do not race with it
+  vector<BlockEdit> edits = world_->GetEditsIn(bounds);
+  TerrainGenerator* terrain_generator = world_->GetTerrainGenerator();
+  int level = key.level;
+  ivec3 min_corner = bounds.min_corner;
+  tile->build = thread_pool_->Submit(
+      [terrain_generator, edits, level, min_corner, excluded]() {
+        return BuildTileMesh(terrain_generator, edits, level, min_corner,
+                             excluded);
+      });
+  tile->excluded = excluded;
+  tile->stale = false;
+}
+
+void LodManager::SetViewDistance(float view_distance) {
+  view_distance_ = view_distance;
+}
+
+void LodManager::SetMaxBuildsPerUpdate(size_t builds_count) {
+  max_builds_per_update_ = builds_count;
+}
+
+void LodManager::Render(Renderer* renderer) const {
+  for (const std::pair<const TileKey, Tile>& entry : tiles_) {
+    const Tile& tile = entry.second;
+    if (tile.has_mesh && tile.mesh.getNumTriangles() > 0) {
+      renderer->DrawMesh(tile.mesh);
+    }
+  }
+}
+
+void LodManager::Invalidate(const BlockBox& box) {
+  for (std::pair<const TileKey, Tile>& entry : tiles_) {
+    if (GetTileBounds(entry.first).Intersects(box)) {
+      entry.second.stale = true;
+    }
+  }
+}
+
+size_t LodManager::GetTilesCount() const {
+  return tiles_.size();
+}
+
+size_t LodManager::GetPendingBuildsCount() const {
+  size_t pending = 0;
+  for (const std::pair<const TileKey, Tile>& entry : tiles_) {
+    pending += entry.second.build.valid() ? 1 : 0;
+  }
+  return pending;
+}
+
+size_t LodManager::GetTrianglesCount() const {
+  size_t triangles = 0;
+  for (const std::pair<const TileKey, Tile>& entry : tiles_) {
+    if (entry.second.has_mesh) {
+      triangles += entry.second.mesh.getNumTriangles();
+    }
+  }
+  return triangles;
+}
+
+BlockBox LodManager::GetTileBounds(const TileKey& key) {
+  int width = kTileCells << key.level;
+  ivec3 min_corner = key.coordinates * width;
+  return BlockBox{min_corner, min_corner + ivec3(width - 1)};
+}
+
+TriMesh LodManager::BuildTileMesh(TerrainGenerator* terrain_generator,
+                                  const vector<BlockEdit>& edits, int level,
+                                  const ivec3& min_corner,
+                                  const BlockBox& excluded) {
+  int scale = 1 << level;
+  int width = kTileCells * scale;
+  unordered_map<size_t, BlockTypes> edited;
+  for (const BlockEdit& edit : edits) {
+    ivec3 local = edit.position - min_corner;
+    edited[size_t((local.x * width + local.y) * width + local.z)] =
+        edit.block_type;
+  }
+
+  // each cell takes the most common visible type of 2 x 2 x 2 samples spread
+  // over it, or stays empty if most samples are air. at level 1 the samples
+  // are exactly the cell's voxels
+  int sample_offsets[2] = {scale / 4, scale - 1 - scale / 4};
+  vector<BlockTypes> cells(size_t(kTileCells * kTileCells * kTileCells),
+                           BlockTypes::kNone);
+  for (size_t index = 0; index < cells.size(); ++index) {
+    int cell = int(index);
+    ivec3 cell_min =
+        min_corner + scale * ivec3(cell / (kTileCells * kTileCells),
+                                   cell / kTileCells % kTileCells,
+                                   cell % kTileCells);
+    BlockBox cell_box{cell_min, cell_min + ivec3(scale - 1)};
+    if (IsSameBox(excluded.Intersect(cell_box), cell_box)) {
+      continue;
+    }
+    size_t counts[BlockRegistry::kBlockTypesCount] = {0};
+    size_t visible = 0;
+    for (int sample = 0; sample < 8; ++sample) {
+      ivec3 position = cell_min + ivec3(sample_offsets[(sample >> 2) & 1],
+                                        sample_offsets[(sample >> 1) & 1],
+                                        sample_offsets[sample & 1]);
+      ivec3 local = position - min_corner;
+      unordered_map<size_t, BlockTypes>::const_iterator edit = edited.find(
+          size_t((local.x * width + local.y) * width + local.z));
+      BlockTypes block_type = edit != edited.end()
+                                  ? edit->second
+                                  : terrain_generator->GetBlockAt(
+                                        vec3(position));
+      // level-of-detail meshes are opaque, so translucent blocks are left
+      // out rather than drawn solid
+      if (BlockRegistry::IsVisible(block_type) &&
+          !BlockRegistry::IsTranslucent(block_type)) {
+        ++counts[block_type];
+        ++visible;
+      }
+    }
+    if (visible >= 4) {
+      cells[index] = BlockTypes(
+          std::max_element(counts, counts + BlockRegistry::kBlockTypesCount) -
+          counts);
+    }
+  }
+
+  TriMesh mesh(TriMesh::Format().positions().texCoords(2));
+  BlockBox tile_cells{ivec3(0), ivec3(kTileCells - 1)};
+  for (size_t index = 0; index < cells.size(); ++index) {
+    if (!BlockRegistry::IsVisible(cells[index])) {
+      continue;
+    }
+    int cell = int(index);
+    ivec3 coordinates(cell / (kTileCells * kTileCells),
+                      cell / kTileCells % kTileCells, cell % kTileCells);
+    // which faces are open inside the tile, and whether any of them is
+    bool open[6];
+    bool is_surface = false;
+    bool is_inside[6];
+    for (size_t face = 0; face < 6; ++face) {
+      ivec3 neighbor = coordinates + Block::kFaceDirections[face];
+      is_inside[face] = tile_cells.Contains(neighbor);
+      open[face] =
+          is_inside[face] &&
+          !BlockRegistry::IsOpaque(
+              cells[size_t((neighbor.x * kTileCells + neighbor.y) *
+                               kTileCells +
+                           neighbor.z)]);
+      is_surface = is_surface || open[face];
+    }
+    vec3 center = vec3(min_corner + scale * coordinates) +
+                  vec3(float(scale - 1) / 2.0f);
+    for (size_t face = 0; face < 6; ++face) {
+      // boundary faces of surface cells are the skirts
+      if (open[face] || (!is_inside[face] && is_surface)) {
+        Block::AppendFace(&mesh, cells[index], face, center, float(scale));
+      }
+    }
+  }
+  return mesh;
+}
+
+}  // namespace minecraft
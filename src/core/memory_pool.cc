@@ -0,0 +1,95 @@
+#include "core/memory_pool.h"
+
+#include <algorithm>
+#include <new>
+
+namespace minecraft {
+
+constexpr size_t MemoryPool::kMinBlockSize;
+constexpr size_t MemoryPool::kMaxBlockSize;
+constexpr size_t MemoryPool::kSizeClassesCount;
+
+MemoryPool::MemoryPool() : stats_{0, 0, 0, 0}, cached_bytes_(0) {
+  std::fill(free_lists_, free_lists_ + kSizeClassesCount, nullptr);
+}
+
+MemoryPool::~MemoryPool() {
+  for (FreeBlock* block : free_lists_) {
+    while (block != nullptr) {
+      FreeBlock* next = block->next;
+      ::operator delete(block);
+      block = next;
+    }
+  }
+}
+
+void* MemoryPool::Allocate(size_t bytes) {
+  size_t size_class = GetSizeClass(bytes);
+  size_t block_size =
+      size_class == kSizeClassesCount ? bytes : kMinBlockSize << size_class;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.allocations;
+    stats_.live_bytes += block_size;
+    stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.live_bytes);
+    if (size_class < kSizeClassesCount &&
+        free_lists_[size_class] != nullptr) {
+      FreeBlock* block = free_lists_[size_class];
+      free_lists_[size_class] = block->next;
+      cached_bytes_ -= block_size;
+      return block;
+    }
+    ++stats_.heap_allocations;
+  }
+  // outside the lock: the heap has its own
+  return ::operator new(block_size);
+}
+
+void MemoryPool::Deallocate(void* block, size_t bytes) {
+  if (block == nullptr) {
+    return;
+  }
+  size_t size_class = GetSizeClass(bytes);
+  size_t block_size =
+      size_class == kSizeClassesCount ? bytes : kMinBlockSize << size_class;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.live_bytes -= block_size;
+    if (size_class < kSizeClassesCount) {
+      FreeBlock* freed = static_cast<FreeBlock*>(block);
+      freed->next = free_lists_[size_class];
+      free_lists_[size_class] = freed;
+      cached_bytes_ += block_size;
+      return;
+    }
+  }
+  ::operator delete(block);
+}
+
+MemoryStats MemoryPool::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+size_t MemoryPool::GetCachedBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cached_bytes_;
+}
+
+MemoryPool& MemoryPool::GetDefault() {
+  static MemoryPool* pool = new MemoryPool();
+  return *pool;
+}
+
+size_t MemoryPool::GetSizeClass(size_t bytes) {
+  if (bytes > kMaxBlockSize) {
+    return kSizeClassesCount;
+  }
+  size_t size_class = 0;
+  while ((kMinBlockSize << size_class) < bytes) {
+    ++size_class;
+  }
+  return size_class;
+}
+
+}  // namespace minecraft
@@ -0,0 +1,263 @@
+#include "core/metrics.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+using std::atomic;
+using std::lock_guard;
+using std::mutex;
+using std::ostringstream;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace minecraft {
+
+const vector<double> MetricsRegistry::kLatencyBounds = {
+    0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005,
+    0.01,    0.025,  0.05,    0.1,    0.25,  0.5,    1};
+
+namespace {
+
+/// atomics per cache line
+const size_t kCellsPerLine = 64 / sizeof(atomic<uint64_t>);
+
+/// hands out shard indices to threads in turn
+atomic<size_t> next_shard(0);
+
+/// \return the shard of the calling thread
+size_t GetShard() {
+  thread_local size_t shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % kMetricShardsCount;
+  return shard;
+}
+
+uint64_t ToBits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+double FromBits(uint64_t bits) {
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/// \param value a number
+/// \return the shortest text that reads back as the number, as the text
+/// format expects it
+string FormatValue(double value) {
+  if (std::isnan(value)) {
+    return "NaN";
+  }
+  if (std::isinf(value)) {
+    return value > 0 ? "+Inf" : "-Inf";
+  }
+  char text[32];
+  for (int precision = 6; precision <= 17; ++precision) {
+    std::snprintf(text, sizeof(text), "%.*g", precision, value);
+    if (std::strtod(text, nullptr) == value) {
+      break;
+    }
+  }
+  return text;
+}
+
+/// \param labels labels of a metric, or empty
+/// \param extra another label, or empty
+/// \return the braced label set, or empty if there are no labels
+string FormatLabels(const string& labels, const string& extra) {
+  if (labels.empty() && extra.empty()) {
+    return "";
+  }
+  string separator = labels.empty() || extra.empty() ? "" : ",";
+  return "{" + labels + separator + extra + "}";
+}
+
+}  // namespace
+
+Counter::Counter() {
+  for (Shard& shard : shards_) {
+    shard.value.store(0, std::memory_order_relaxed);
+  }
+}
+
+void Counter::Add(uint64_t amount) {
+  shards_[GetShard()].value.fetch_add(amount, std::memory_order_relaxed);
+}
+
+uint64_t Counter::GetValue() const {
+  uint64_t value = 0;
+  for (const Shard& shard : shards_) {
+    value += shard.value.load(std::memory_order_relaxed);
+  }
+  return value;
+}
+
+Gauge::Gauge() : bits_(ToBits(0)) {}
+
+void Gauge::Set(double value) {
+  bits_.store(ToBits(value), std::memory_order_relaxed);
+}
+
+double Gauge::GetValue() const {
+  return FromBits(bits_.load(std::memory_order_relaxed));
+}
+
+Histogram::Histogram(const vector<double>& bounds) : bounds_(bounds) {
+  if (bounds.empty()) {
+    throw std::invalid_argument("a histogram needs a bucket");
+  }
+  for (size_t i = 1; i < bounds.size(); ++i) {
+    if (!(bounds[i - 1] < bounds[i])) {
+      throw std::invalid_argument("the bounds must be increasing");
+    }
+  }
+  // a count per bucket, one for the overflow bucket, and the sum
+  size_t cells = bounds.size() + 2;
+  stride_ = (cells + kCellsPerLine - 1) / kCellsPerLine * kCellsPerLine;
+  cells_.reset(new atomic<uint64_t>[stride_ * kMetricShardsCount]);
+  for (size_t shard = 0; shard < kMetricShardsCount; ++shard) {
+    atomic<uint64_t>* row = &cells_[shard * stride_];
+    for (size_t i = 0; i <= bounds.size(); ++i) {
+      row[i].store(0, std::memory_order_relaxed);
+    }
+    row[bounds.size() + 1].store(ToBits(0), std::memory_order_relaxed);
+  }
+}
+
+void Histogram::Observe(double value) {
+  atomic<uint64_t>* row = &cells_[GetShard() * stride_];
+  size_t bucket = 0;
+  while (bucket < bounds_.size() && value > bounds_[bucket]) {
+    ++bucket;
+  }
+  row[bucket].fetch_add(1, std::memory_order_relaxed);
+  // only threads sharing the shard contend here, so this rarely retries
+  atomic<uint64_t>& sum = row[bounds_.size() + 1];
+  uint64_t bits = sum.load(std::memory_order_relaxed);
+  while (!sum.compare_exchange_weak(bits, ToBits(FromBits(bits) + value),
+                                    std::memory_order_relaxed)) {
+  }
+}
+
+HistogramSnapshot Histogram::GetSnapshot() const {
+  HistogramSnapshot snapshot;
+  snapshot.bounds = bounds_;
+  snapshot.counts.assign(bounds_.size() + 1, 0);
+  snapshot.sum = 0;
+  snapshot.count = 0;
+  for (size_t shard = 0; shard < kMetricShardsCount; ++shard) {
+    const atomic<uint64_t>* row = &cells_[shard * stride_];
+    for (size_t i = 0; i <= bounds_.size(); ++i) {
+      uint64_t count = row[i].load(std::memory_order_relaxed);
+      snapshot.counts[i] += count;
+      snapshot.count += count;
+    }
+    snapshot.sum +=
+        FromBits(row[bounds_.size() + 1].load(std::memory_order_relaxed));
+  }
+  return snapshot;
+}
+
+MetricsRegistry::MetricsRegistry() {}
+
+Counter* MetricsRegistry::AddCounter(const string& name, const string& help,
+                                     const string& labels) {
+  Member* member = AddMember(name, help, Type::kCounter, labels);
+  member->counter.reset(new Counter());
+  return member->counter.get();
+}
+
+Gauge* MetricsRegistry::AddGauge(const string& name, const string& help,
+                                 const string& labels) {
+  Member* member = AddMember(name, help, Type::kGauge, labels);
+  member->gauge.reset(new Gauge());
+  return member->gauge.get();
+}
+
+Histogram* MetricsRegistry::AddHistogram(const string& name,
+                                         const string& help,
+                                         const vector<double>& bounds,
+                                         const string& labels) {
+  // built first, so invalid bounds leave the registry as it was
+  unique_ptr<Histogram> histogram(new Histogram(bounds));
+  Member* member = AddMember(name, help, Type::kHistogram, labels);
+  member->histogram = std::move(histogram);
+  return member->histogram.get();
+}
+
+string MetricsRegistry::Format() const {
+  lock_guard<mutex> lock(mutex_);
+  ostringstream text;
+  for (const unique_ptr<Family>& family : families_) {
+    text << "# HELP " << family->name << " " << family->help << "\n";
+    text << "# TYPE " << family->name << " "
+         << (family->type == Type::kCounter
+                 ? "counter"
+                 : family->type == Type::kGauge ? "gauge" : "histogram")
+         << "\n";
+    for (const unique_ptr<Member>& member : family->members) {
+      const string& labels = member->labels;
+      if (member->counter != nullptr) {
+        text << family->name << FormatLabels(labels, "") << " "
+             << member->counter->GetValue() << "\n";
+      } else if (member->gauge != nullptr) {
+        text << family->name << FormatLabels(labels, "") << " "
+             << FormatValue(member->gauge->GetValue()) << "\n";
+      } else {
+        HistogramSnapshot snapshot = member->histogram->GetSnapshot();
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i <= snapshot.bounds.size(); ++i) {
+          cumulative += snapshot.counts[i];
+          double bound = i < snapshot.bounds.size()
+                             ? snapshot.bounds[i]
+                             : std::numeric_limits<double>::infinity();
+          text << family->name << "_bucket"
+               << FormatLabels(labels, "le=\"" + FormatValue(bound) + "\"")
+               << " " << cumulative << "\n";
+        }
+        text << family->name << "_sum" << FormatLabels(labels, "") << " "
+             << FormatValue(snapshot.sum) << "\n";
+        text << family->name << "_count" << FormatLabels(labels, "") << " "
+             << cumulative << "\n";
+      }
+    }
+  }
+  return text.str();
+}
+
+MetricsRegistry::Member* MetricsRegistry::AddMember(const string& name,
+                                                    const string& help,
+                                                    Type type,
+                                                    const string& labels) {
+  lock_guard<mutex> lock(mutex_);
+  Family* family = nullptr;
+  for (const unique_ptr<Family>& existing : families_) {
+    if (existing->name == name) {
+      family = existing.get();
+    }
+  }
+  if (family == nullptr) {
+    families_.emplace_back(new Family{name, help, type, {}});
+    family = families_.back().get();
+  } else if (family->type != type) {
+    throw std::invalid_argument(name + " is another type of metric");
+  }
+  for (const unique_ptr<Member>& member : family->members) {
+    if (member->labels == labels) {
+      throw std::invalid_argument(name + "{" + labels +
+                                  "} is already registered");
+    }
+  }
+  family->members.emplace_back(new Member());
+  family->members.back()->labels = labels;
+  return family->members.back().get();
+}
+
+}  // namespace minecraft
@@ -0,0 +1,205 @@
+#include "core/metrics_exporter.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using std::runtime_error;
+using std::string;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+#ifndef MSG_NOSIGNAL
+// macOS, where `SO_NOSIGPIPE` is set on the socket instead
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace minecraft {
+
+const char* const MetricsExporter::kMetricsPath = "/metrics";
+
+namespace {
+
+/// how often the threads check whether they should stop, in milliseconds
+const int kStopCheckMilliseconds = 100;
+/// longest request read, in bytes
+const size_t kMaxRequestBytes = 8192;
+/// most a client may take to send its request, in milliseconds
+const int kRequestTimeoutMilliseconds = 1000;
+
+void ThrowSystemError(const string& what) {
+  throw runtime_error(what + ": " + std::strerror(errno));
+}
+
+/// \param descriptor a connected socket
+/// \param text bytes to send, all of them
+void SendAll(int descriptor, const string& text) {
+  size_t sent = 0;
+  while (sent < text.size()) {
+    ssize_t result =
+        send(descriptor, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      return;
+    }
+    sent += size_t(result);
+  }
+}
+
+}  // namespace
+
+MetricsExporter::MetricsExporter(const MetricsRegistry* registry)
+    : registry_(registry), stopping_(false), scrapes_count_(0),
+      listener_(-1) {}
+
+MetricsExporter::~MetricsExporter() {
+  stopping_ = true;
+  if (http_thread_.joinable()) {
+    http_thread_.join();
+  }
+  if (file_thread_.joinable()) {
+    file_thread_.join();
+  }
+  if (listener_ >= 0) {
+    close(listener_);
+  }
+}
+
+uint16_t MetricsExporter::ServeHttp(uint16_t port) {
+  if (listener_ >= 0) {
+    throw std::logic_error("the metrics are already served");
+  }
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (listener < 0) {
+    ThrowSystemError("socket");
+  }
+  int enable = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  socklen_t length = sizeof(address);
+  if (bind(listener, reinterpret_cast<sockaddr*>(&address), length) < 0 ||
+      listen(listener, SOMAXCONN) < 0 ||
+      getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) <
+          0) {
+    close(listener);
+    ThrowSystemError("could not serve metrics on port " +
+                     std::to_string(port));
+  }
+  listener_ = listener;
+  http_thread_ = std::thread(&MetricsExporter::RunHttp, this);
+  return ntohs(address.sin_port);
+}
+
+void MetricsExporter::DumpToFile(const string& path,
+                                 double interval_seconds) {
+  if (file_thread_.joinable()) {
+    throw std::logic_error("the metrics are already dumped");
+  }
+  file_thread_ = std::thread([this, path, interval_seconds]() {
+    steady_clock::time_point next = steady_clock::now();
+    while (!stopping_) {
+      if (steady_clock::now() >= next) {
+        try {
+          WriteFile(path);
+        } catch (const runtime_error&) {
+          // tried again next interval, e.g. once the directory exists
+        }
+        next += std::chrono::duration_cast<steady_clock::duration>(
+            duration<double>(interval_seconds));
+      }
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(kStopCheckMilliseconds));
+    }
+  });
+}
+
+void MetricsExporter::WriteFile(const string& path) const {
+  string temporary_path = path + ".tmp";
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    file << registry_->Format();
+    if (!file) {
+      throw runtime_error("could not write " + temporary_path);
+    }
+  }
+  if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+    ThrowSystemError("rename " + temporary_path);
+  }
+  ++scrapes_count_;
+}
+
+uint64_t MetricsExporter::GetScrapesCount() const {
+  return scrapes_count_;
+}
+
+void MetricsExporter::RunHttp() {
+  while (!stopping_) {
+    pollfd listening = {listener_, POLLIN, 0};
+    if (poll(&listening, 1, kStopCheckMilliseconds) <= 0) {
+      continue;
+    }
+    int descriptor = accept(listener_, nullptr, nullptr);
+    if (descriptor >= 0) {
+      Answer(descriptor);
+      close(descriptor);
+    }
+  }
+}
+
+void MetricsExporter::Answer(int descriptor) {
+#ifdef SO_NOSIGPIPE
+  int enable = 1;
+  setsockopt(descriptor, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+  // reads up to the end of the request line; the headers do not matter
+  string request;
+  char buffer[1024];
+  while (request.find("\r\n") == string::npos &&
+         request.size() < kMaxRequestBytes) {
+    pollfd readable = {descriptor, POLLIN, 0};
+    if (poll(&readable, 1, kRequestTimeoutMilliseconds) <= 0) {
+      return;
+    }
+    ssize_t result = recv(descriptor, buffer, sizeof(buffer), 0);
+    if (result <= 0) {
+      return;
+    }
+    request.append(buffer, size_t(result));
+  }
+
+  string request_line = request.substr(0, request.find("\r\n"));
+  string status = "404 Not Found";
+  string body = "not found\n";
+  string target = string("GET ") + kMetricsPath;
+  if (request_line.compare(0, target.size(), target) == 0 &&
+      (request_line.size() == target.size() ||
+       request_line[target.size()] == ' ' ||
+       request_line[target.size()] == '?')) {
+    status = "200 OK";
+    body = registry_->Format();
+    ++scrapes_count_;
+  }
+  SendAll(descriptor,
+          "HTTP/1.1 " + status +
+              "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8"
+              "\r\nContent-Length: " +
+              std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" +
+              body);
+}
+
+}  // namespace minecraft
@@ -0,0 +1,166 @@
+#include "core/packed_vertex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include "core/block.h"
+#include "core/block_registry.h"
+#include "core/texture.h"
+
+using ci::TriMesh;
+using ci::vec2;
+using ci::vec3;
+using glm::ivec3;
+using std::pair;
+using std::vector;
+
+namespace minecraft {
+
+constexpr int PackedVertex::kMaxChunkWidth;
+constexpr uint32_t PackedVertex::kPositionBits;
+constexpr uint32_t PackedVertex::kFaceShift;
+constexpr uint32_t PackedVertex::kCornerShift;
+constexpr uint32_t PackedVertex::kLayerShift;
+
+namespace {
+
+const uint32_t kPositionMask = (1u << PackedVertex::kPositionBits) - 1;
+
+}  // namespace
+
+PackedVertex::PackedVertex() : bits_(0) {
+}
+
+PackedVertex::PackedVertex(const ivec3& block, size_t face, size_t corner,
+                           uint8_t layer)
+    : bits_(uint32_t(block.x) | uint32_t(block.y) << kPositionBits |
+            uint32_t(block.z) << 2 * kPositionBits |
+            uint32_t(face) << kFaceShift | uint32_t(corner) << kCornerShift |
+            uint32_t(layer) << kLayerShift) {
+}
+
+ivec3 PackedVertex::GetBlock() const {
+  return ivec3(int(bits_ & kPositionMask),
+               int(bits_ >> kPositionBits & kPositionMask),
+               int(bits_ >> 2 * kPositionBits & kPositionMask));
+}
+
+size_t PackedVertex::GetFace() const {
+  return bits_ >> kFaceShift & 7;
+}
+
+size_t PackedVertex::GetCorner() const {
+  return bits_ >> kCornerShift & 3;
+}
+
+uint8_t PackedVertex::GetLayer() const {
+  return uint8_t(bits_ >> kLayerShift);
+}
+
+uint32_t PackedVertex::GetBits() const {
+  return bits_;
+}
+
+vec3 PackedVertex::GetPosition() const {
+  return vec3(GetBlock()) + Block::kCubeFaces[GetFace()][GetCorner()];
+}
+
+vec2 PackedVertex::GetTexCoord() const {
+  return Texture::GetAtlasCoordinates(GetLayer(),
+                                      Block::kSquareTexCoords[GetCorner()]);
+}
+
+PackedMesh::PackedMesh(const ivec3& origin) : origin_(origin) {
+  Touch();
+}
+
+void PackedMesh::Reset(const ivec3& origin) {
+  origin_ = origin;
+  vertices_.clear();
+  Touch();
+}
+
+void PackedMesh::AppendFace(const ivec3& block, BlockTypes block_type,
+                            size_t face) {
+  uint8_t layer = BlockRegistry::GetFaceLayer(block_type, face);
+  for (size_t corner = 0; corner < Block::kSquareVerticesCount; ++corner) {
+    vertices_.emplace_back(block, face, corner, layer);
+  }
+  Touch();
+}
+
+void PackedMesh::AppendBlock(const ivec3& block, BlockTypes block_type) {
+  for (size_t face = 0; face < Block::kCubeFacesCount; ++face) {
+    AppendFace(block, block_type, face);
+  }
+}
+
+void PackedMesh::SortBackToFront(const vec3& eye) {
+  size_t quads_count = vertices_.size() / Block::kSquareVerticesCount;
+  // squared distances from the eye to the quads' centers, relative to the
+  // origin like the positions
+  vec3 relative_eye = eye - vec3(origin_);
+  vector<pair<float, size_t>> order(quads_count);
+  for (size_t quad = 0; quad < quads_count; ++quad) {
+    const PackedVertex& first = vertices_[quad * Block::kSquareVerticesCount];
+    const PackedVertex& third =
+        vertices_[quad * Block::kSquareVerticesCount + 2];
+    vec3 offset =
+        (first.GetPosition() + third.GetPosition()) * 0.5f - relative_eye;
+    order[quad] = pair<float, size_t>(-glm::dot(offset, offset), quad);
+  }
+  std::sort(order.begin(), order.end());
+
+  PackedVertices sorted(vertices_.get_allocator());
+  sorted.reserve(vertices_.size());
+  for (const pair<float, size_t>& quad : order) {
+    const PackedVertex* first =
+        &vertices_[quad.second * Block::kSquareVerticesCount];
+    sorted.insert(sorted.end(), first, first + Block::kSquareVerticesCount);
+  }
+  vertices_.swap(sorted);
+  Touch();
+}
+
+ivec3 PackedMesh::GetOrigin() const {
+  return origin_;
+}
+
+const PackedVertices& PackedMesh::GetVertices() const {
+  return vertices_;
+}
+
+size_t PackedMesh::GetTrianglesCount() const {
+  return vertices_.size() / Block::kSquareVerticesCount * 2;
+}
+
+size_t PackedMesh::GetBytes() const {
+  return vertices_.size() * sizeof(PackedVertex);
+}
+
+uint64_t PackedMesh::GetRevision() const {
+  return revision_;
+}
+
+TriMesh PackedMesh::Unpack() const {
+  TriMesh mesh(TriMesh::Format().positions().texCoords(2));
+  vec3 origin(origin_);
+  for (size_t vertex = 0; vertex < vertices_.size(); ++vertex) {
+    mesh.appendPosition(origin + vertices_[vertex].GetPosition());
+    mesh.appendTexCoord(vertices_[vertex].GetTexCoord());
+    if (vertex % 4 == 3) {
+      uint32_t first = uint32_t(vertex - 3);
+      mesh.appendTriangle(first, first + 1, first + 2);
+      mesh.appendTriangle(first, first + 2, first + 3);
+    }
+  }
+  return mesh;
+}
+
+void PackedMesh::Touch() {
+  static std::atomic<uint64_t> next_revision(1);
+  revision_ = next_revision.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace minecraft
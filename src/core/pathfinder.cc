@@ -0,0 +1,880 @@
+#include "core/pathfinder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+#include "core/block_registry.h"
+
+using glm::ivec3;
+using std::shared_ptr;
+using std::unordered_map;
+using std::vector;
+
+namespace minecraft {
+
+const int Pathfinder::kMaxDrop = 3;
+const size_t Pathfinder::kBatchSize = 16;
+
+namespace {
+
+const ivec3 kUp(0, 1, 0);
+
+/// the horizontal moves, in the order successors are visited
+const ivec3 kDirections[4] = {ivec3(1, 0, 0), ivec3(-1, 0, 0),
+                              ivec3(0, 0, 1), ivec3(0, 0, -1)};
+
+/// chunks a move can lead to from a chunk: moves are horizontal, possibly
+/// stepping up or dropping across a vertical border too
+const ChunkCoordinates kNeighborChunks[14] = {
+    {1, -1, 0},  {1, 0, 0},  {1, 1, 0},  {-1, -1, 0}, {-1, 0, 0},
+    {-1, 1, 0},  {0, -1, 1}, {0, 0, 1},  {0, 1, 1},   {0, -1, -1},
+    {0, 0, -1},  {0, 1, -1}, {0, -1, 0}, {0, 1, 0}};
+
+const uint32_t kUnreached = std::numeric_limits<uint32_t>::max();
+
+/// method of hashing lattice points
+struct PositionHasher {
+  size_t operator()(const ivec3& key) const {
+    return size_t((key.x * 5209) ^ (key.y * 1811) ^ (key.z * 7297));
+  }
+};
+
+int FloorDivide(int numerator, int denominator) {
+  int quotient = numerator / denominator;
+  return quotient * denominator > numerator ? quotient - 1 : quotient;
+}
+
+/// \return lower bound of the moves from `from` to `to`, each of which
+/// changes x or z by one
+uint32_t GetDistanceBound(const ivec3& from, const ivec3& to) {
+  return uint32_t(std::abs(from.x - to.x) + std::abs(from.z - to.z));
+}
+
+/// reads the blocks of a snapshot, remembering the chunk of the last one
+class BlockReader {
+ public:
+  explicit BlockReader(const WorldSnapshot& snapshot)
+      : snapshot_(snapshot), chunk_(nullptr), width_(0) {
+    if (!snapshot.GetChunks().empty()) {
+      width_ = snapshot.GetChunks().begin()->second.GetWidth();
+    }
+  }
+
+  /// \return width of the snapshot's chunks, 0 if it has none
+  int GetWidth() const {
+    return width_;
+  }
+
+  /// \return the chunk of a lattice point
+  ChunkCoordinates GetChunk(const ivec3& position) const {
+    int radius = width_ / 2;
+    return ChunkCoordinates{FloorDivide(position.x + radius, width_),
+                            FloorDivide(position.y + radius, width_),
+                            FloorDivide(position.z + radius, width_)};
+  }
+
+  /// \return the blocks of a chunk
+  BlockBox GetBounds(const ChunkCoordinates& chunk) const {
+    ivec3 min_corner = ivec3(chunk.x, chunk.y, chunk.z) * width_ -
+                       ivec3(width_ / 2);
+    return BlockBox{min_corner, min_corner + ivec3(width_ - 1)};
+  }
+
+  /// \return true if and only if the point is in the snapshot and its block
+  /// is not solid
+  bool IsFree(const ivec3& position) {
+    return Find(position) && !BlockRegistry::IsSolid(
+                                 chunk_->GetBlockAt(position));
+  }
+
+  /// \return true if and only if the point is in the snapshot and its block
+  /// is solid
+  bool IsSolid(const ivec3& position) {
+    return Find(position) &&
+           BlockRegistry::IsSolid(chunk_->GetBlockAt(position));
+  }
+
+  /// \return true if and only if a mob can stand at the point
+  bool CanStandAt(const ivec3& position) {
+    return IsFree(position) && IsFree(position + kUp) &&
+           IsSolid(position - kUp);
+  }
+
+  /// \param from a point a mob stands at
+  /// \param direction one of `kDirections`
+  /// \param to set to where the move leads
+  /// \return false if the mob cannot move in the direction
+  bool GetMove(const ivec3& from, const ivec3& direction, ivec3* to) {
+    ivec3 ahead = from + direction;
+    if (CanStandAt(ahead)) {
+      *to = ahead;
+      return true;
+    }
+    if (IsSolid(ahead)) {
+      // steps up, if there is room above the mob's head to do so
+      *to = ahead + kUp;
+      return CanStandAt(*to) && IsFree(from + 2 * kUp);
+    }
+    if (!IsFree(ahead) || !IsFree(ahead + kUp)) {
+      return false;
+    }
+    for (int drop = 1; drop <= Pathfinder::kMaxDrop; ++drop) {
+      *to = ahead - drop * kUp;
+      if (CanStandAt(*to)) {
+        return true;
+      }
+      if (!IsFree(*to)) {
+        return false;
+      }
+    }
+    return false;
+  }
+
+  /// \param from a point a mob stands at
+  /// \param successors set to where the moves from it lead
+  /// \return number of successors, at most 4
+  size_t GetSuccessors(const ivec3& from, ivec3* successors) {
+    size_t successors_count = 0;
+    for (const ivec3& direction : kDirections) {
+      if (GetMove(from, direction, &successors[successors_count])) {
+        ++successors_count;
+      }
+    }
+    return successors_count;
+  }
+
+  /// \param to a point a mob stands at
+  /// \param predecessors set to the points whose moves lead there, at most
+  /// `4 * (kMaxDrop + 2)`
+  /// \return number of predecessors
+  size_t GetPredecessors(const ivec3& to, ivec3* predecessors) {
+    size_t predecessors_count = 0;
+    for (const ivec3& direction : kDirections) {
+      for (int rise = -1; rise <= Pathfinder::kMaxDrop; ++rise) {
+        ivec3 from = to - direction + rise * kUp;
+        ivec3 reached;
+        if (CanStandAt(from) && GetMove(from, direction, &reached) &&
+            reached == to) {
+          predecessors[predecessors_count++] = from;
+        }
+      }
+    }
+    return predecessors_count;
+  }
+
+ private:
+  const WorldSnapshot& snapshot_;
+  const ChunkSnapshot* chunk_;
+  int width_;
+
+  /// points `chunk_` at the chunk of a point
+  ///
+  /// \return false if the snapshot does not have it
+  bool Find(const ivec3& position) {
+    if (chunk_ != nullptr && chunk_->Contains(position)) {
+      return true;
+    }
+    if (width_ == 0) {
+      return false;
+    }
+    const ChunkSnapshot* chunk = snapshot_.Find(GetChunk(position));
+    if (chunk == nullptr) {
+      return false;
+    }
+    chunk_ = chunk;
+    return true;
+  }
+};
+
+/// a node of an A* search: the point, its distance from the start and that
+/// plus the bound of its distance to the goal
+struct OpenNode {
+  ivec3 position;
+  uint32_t distance;
+  uint32_t estimate;
+
+  bool operator>(const OpenNode& other) const {
+    // among equal estimates, nodes nearer the goal first
+    return estimate != other.estimate ? estimate > other.estimate
+                                      : distance < other.distance;
+  }
+};
+
+typedef std::priority_queue<OpenNode, vector<OpenNode>,
+                            std::greater<OpenNode>>
+    OpenList;
+
+/// searches confined to the blocks of one chunk
+class ChunkSearch {
+ public:
+  /// \param reader blocks to search
+  explicit ChunkSearch(BlockReader* reader)
+      : reader_(reader),
+        width_(reader->GetWidth()),
+        stamps_(size_t(width_) * width_ * width_, 0),
+        distances_(stamps_.size()),
+        parents_(stamps_.size()),
+        stamp_(0) {
+  }
+
+  /// searches breadth first, which finds shortest paths since all moves cost
+  /// the same, until the whole chunk is reached
+  ///
+  /// \param bounds the chunk to search
+  /// \param source a point to search from, inside the chunk
+  /// \param forward whether to follow moves, or to follow them backwards to
+  /// find the distances to `source`
+  /// \return number of nodes expanded
+  size_t Run(const BlockBox& bounds, const ivec3& source, bool forward) {
+    Start(bounds);
+    queue_.clear();
+    Visit(source, 0, GetIndex(source));
+    queue_.push_back(source);
+    ivec3 neighbors[4 * (Pathfinder::kMaxDrop + 2)];
+    for (size_t next = 0; next < queue_.size(); ++next) {
+      ivec3 node = queue_[next];
+      uint32_t index = GetIndex(node);
+      size_t neighbors_count = forward
+                                   ? reader_->GetSuccessors(node, neighbors)
+                                   : reader_->GetPredecessors(node, neighbors);
+      for (size_t neighbor = 0; neighbor < neighbors_count; ++neighbor) {
+        const ivec3& reached = neighbors[neighbor];
+        if (bounds_.Contains(reached) && !IsReached(reached)) {
+          Visit(reached, distances_[index] + 1, index);
+          queue_.push_back(reached);
+        }
+      }
+    }
+    return queue_.size();
+  }
+
+  /// searches with A* from a point to another of the same chunk
+  ///
+  /// \param bounds the chunk to search
+  /// \param source a point to search from, inside the chunk
+  /// \param target a point to search for, inside the chunk
+  /// \return number of nodes expanded
+  size_t RunTo(const BlockBox& bounds, const ivec3& source,
+               const ivec3& target) {
+    Start(bounds);
+    OpenList open;
+    Visit(source, 0, GetIndex(source));
+    open.push(OpenNode{source, 0, GetDistanceBound(source, target)});
+    size_t expanded = 0;
+    ivec3 successors[4];
+    while (!open.empty()) {
+      OpenNode node = open.top();
+      open.pop();
+      uint32_t index = GetIndex(node.position);
+      if (node.distance > distances_[index]) {
+        continue;
+      }
+      ++expanded;
+      if (node.position == target) {
+        break;
+      }
+      size_t successors_count =
+          reader_->GetSuccessors(node.position, successors);
+      for (size_t successor = 0; successor < successors_count; ++successor) {
+        const ivec3& reached = successors[successor];
+        if (bounds_.Contains(reached) &&
+            (!IsReached(reached) ||
+             node.distance + 1 < distances_[GetIndex(reached)])) {
+          Visit(reached, node.distance + 1, index);
+          open.push(OpenNode{reached, node.distance + 1,
+                             node.distance + 1 +
+                                 GetDistanceBound(reached, target)});
+        }
+      }
+    }
+    return expanded;
+  }
+
+  /// \param position a point in the searched chunk
+  /// \return its distance from (or to) the source, or `kUnreached`
+  uint32_t GetDistance(const ivec3& position) const {
+    if (!bounds_.Contains(position) || !IsReached(position)) {
+      return kUnreached;
+    }
+    return distances_[GetIndex(position)];
+  }
+
+  /// \param target a point reached by a forward search or by `RunTo`
+  /// \param path gets the points after the source up to the target appended
+  void AppendPath(const ivec3& target, vector<ivec3>* path) const {
+    size_t start = path->size();
+    for (uint32_t index = GetIndex(target); distances_[index] > 0;
+         index = parents_[index]) {
+      path->push_back(GetPosition(index));
+    }
+    std::reverse(path->begin() + start, path->end());
+  }
+
+ private:
+  BlockReader* reader_;
+  int width_;
+  BlockBox bounds_;
+  /// by index in the chunk: the search that reached the point last, and the
+  /// distance and the parent it reached it with
+  vector<uint32_t> stamps_;
+  vector<uint32_t> distances_;
+  vector<uint32_t> parents_;
+  uint32_t stamp_;
+  vector<ivec3> queue_;
+
+  uint32_t GetIndex(const ivec3& position) const {
+    ivec3 local = position - bounds_.min_corner;
+    return uint32_t((local.x * width_ + local.y) * width_ + local.z);
+  }
+
+  ivec3 GetPosition(uint32_t index) const {
+    return bounds_.min_corner +
+           ivec3(int(index) / (width_ * width_), int(index) / width_ % width_,
+                 int(index) % width_);
+  }
+
+  bool IsReached(const ivec3& position) const {
+    return stamps_[GetIndex(position)] == stamp_;
+  }
+
+  /// forgets the points reached by the previous search
+  void Start(const BlockBox& bounds) {
+    bounds_ = bounds;
+    if (++stamp_ == 0) {
+      std::fill(stamps_.begin(), stamps_.end(), 0);
+      stamp_ = 1;
+    }
+  }
+
+  void Visit(const ivec3& position, uint32_t distance, uint32_t parent) {
+    uint32_t index = GetIndex(position);
+    stamps_[index] = stamp_;
+    distances_[index] = distance;
+    parents_[index] = parent;
+  }
+};
+
+/// a move between two chunks
+struct Transition {
+  ivec3 from;
+  ivec3 to;
+};
+
+/// \param parents union-find parents, flattened along the way
+/// \return the root of `element`
+size_t FindRoot(vector<size_t>* parents, size_t element) {
+  while ((*parents)[element] != element) {
+    (*parents)[element] = (*parents)[(*parents)[element]];
+    element = (*parents)[element];
+  }
+  return element;
+}
+
+/// groups the moves from one chunk into another into entrances: moves in
+/// the same direction from points side by side along the border. computed
+/// the same way from either chunk, so both agree on the portals
+///
+/// \param reader blocks to read
+/// \param from blocks of the chunk the moves leave
+/// \param to blocks of the chunk the moves enter
+/// \return for each entrance, the move nearest its middle
+vector<Transition> FindEntrances(BlockReader* reader, const BlockBox& from,
+                                 const BlockBox& to) {
+  // points whose moves can enter `to`
+  BlockBox sources =
+      from.Intersect(BlockBox{to.min_corner - ivec3(1, 1, 1),
+                              to.max_corner + ivec3(1, Pathfinder::kMaxDrop,
+                                                    1)});
+  vector<Transition> transitions;
+  vector<size_t> directions;
+  unordered_map<ivec3, size_t, PositionHasher> by_source[4];
+  for (int x = sources.min_corner.x; x <= sources.max_corner.x; ++x) {
+    for (int y = sources.min_corner.y; y <= sources.max_corner.y; ++y) {
+      for (int z = sources.min_corner.z; z <= sources.max_corner.z; ++z) {
+        ivec3 source(x, y, z);
+        if (!reader->CanStandAt(source)) {
+          continue;
+        }
+        for (size_t direction = 0; direction < 4; ++direction) {
+          ivec3 reached;
+          if (reader->GetMove(source, kDirections[direction], &reached) &&
+              to.Contains(reached)) {
+            by_source[direction][source] = transitions.size();
+            transitions.push_back(Transition{source, reached});
+            directions.push_back(direction);
+          }
+        }
+      }
+    }
+  }
+
+  vector<size_t> parents(transitions.size());
+  for (size_t transition = 0; transition < transitions.size(); ++transition) {
+    parents[transition] = transition;
+  }
+  for (size_t transition = 0; transition < transitions.size(); ++transition) {
+    size_t direction = directions[transition];
+    // along the border, i.e. across the direction of the move
+    ivec3 side(kDirections[direction].z, 0, kDirections[direction].x);
+    for (int rise = -1; rise <= 1; ++rise) {
+      unordered_map<ivec3, size_t, PositionHasher>::const_iterator beside =
+          by_source[direction].find(transitions[transition].from + side +
+                                    rise * kUp);
+      if (beside != by_source[direction].end()) {
+        parents[FindRoot(&parents, beside->second)] =
+            FindRoot(&parents, transition);
+      }
+    }
+  }
+
+  // the move nearest the mean of each entrance
+  unordered_map<size_t, glm::vec3> sums;
+  unordered_map<size_t, size_t> counts;
+  for (size_t transition = 0; transition < transitions.size(); ++transition) {
+    size_t root = FindRoot(&parents, transition);
+    sums[root] += glm::vec3(transitions[transition].from);
+    ++counts[root];
+  }
+  unordered_map<size_t, size_t> nearest;
+  vector<size_t> roots;
+  for (size_t transition = 0; transition < transitions.size(); ++transition) {
+    size_t root = FindRoot(&parents, transition);
+    glm::vec3 middle = sums[root] / float(counts[root]);
+    unordered_map<size_t, size_t>::iterator best = nearest.find(root);
+    if (best == nearest.end()) {
+      nearest[root] = transition;
+      roots.push_back(root);
+    } else {
+      glm::vec3 offset = glm::vec3(transitions[transition].from) - middle;
+      glm::vec3 best_offset =
+          glm::vec3(transitions[best->second].from) - middle;
+      if (glm::dot(offset, offset) < glm::dot(best_offset, best_offset)) {
+        best->second = transition;
+      }
+    }
+  }
+  vector<Transition> entrances;
+  for (size_t root : roots) {
+    entrances.push_back(transitions[nearest[root]]);
+  }
+  return entrances;
+}
+
+
+}  // namespace
+
+/// the portals of a chunk and the edges from each: to the portals of the
+/// same chunk it reaches, and to the neighboring chunk if it is the start
+/// of a portal move
+struct Pathfinder::Cluster {
+  struct Edge {
+    ivec3 to;
+    uint32_t cost;
+  };
+
+  vector<ivec3> portals;
+  unordered_map<ivec3, size_t, PositionHasher> indices;
+  vector<vector<Edge>> edges;
+  /// bit `i` set if and only if the snapshot the graph was built from had
+  /// the chunk at `kNeighborChunks[i]`
+  uint32_t neighbors;
+
+  /// \param position a point
+  /// \return its index in `portals`, adding it if it is not there yet
+  size_t AddPortal(const ivec3& position) {
+    unordered_map<ivec3, size_t, PositionHasher>::iterator found =
+        indices.find(position);
+    if (found != indices.end()) {
+      return found->second;
+    }
+    indices[position] = portals.size();
+    portals.push_back(position);
+    edges.push_back(vector<Edge>());
+    return portals.size() - 1;
+  }
+};
+
+namespace {
+
+/// \return the bits of `Cluster::neighbors` for a chunk of a snapshot
+uint32_t GetNeighbors(const WorldSnapshot& snapshot,
+                      const ChunkCoordinates& chunk) {
+  uint32_t neighbors = 0;
+  for (size_t neighbor = 0; neighbor < 14; ++neighbor) {
+    const ChunkCoordinates& offset = kNeighborChunks[neighbor];
+    if (snapshot.Find(ChunkCoordinates{chunk.x + offset.x, chunk.y + offset.y,
+                                       chunk.z + offset.z}) != nullptr) {
+      neighbors |= uint32_t(1) << neighbor;
+    }
+  }
+  return neighbors;
+}
+
+}  // namespace
+
+Pathfinder::Pathfinder(World* world, ThreadPool* thread_pool)
+    : world_(world),
+      thread_pool_(thread_pool),
+      chunk_radius_(int(world->GetChunkRadius())),
+      invalidations_(0),
+      queries_(0),
+      nodes_expanded_(0),
+      clusters_built_(0),
+      clusters_invalidated_(0) {
+  subscription_ =
+      world->GetChangeBus().Subscribe([this](const BlockChangeBatch& batch) {
+        for (const ChunkChanges& chunk : batch.chunks) {
+          Invalidate(chunk.bounds);
+        }
+      });
+}
+
+Pathfinder::~Pathfinder() {
+  world_->GetChangeBus().Unsubscribe(subscription_);
+}
+
+PathResult Pathfinder::FindPath(const WorldSnapshot& snapshot,
+                                const PathRequest& request) {
+  uint64_t invalidations;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    invalidations = invalidations_;
+  }
+  return FindPath(snapshot, request, invalidations);
+}
+
+PathBatch Pathfinder::FindPaths(const vector<PathRequest>& requests) {
+  return FindPaths(shared_ptr<const WorldSnapshot>(
+                       new WorldSnapshot(world_->GetSnapshot())),
+                   requests);
+}
+
+PathBatch Pathfinder::FindPaths(
+    const shared_ptr<const WorldSnapshot>& snapshot,
+    const vector<PathRequest>& requests) {
+  uint64_t invalidations;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    invalidations = invalidations_;
+  }
+  PathBatch batch;
+  for (size_t first = 0; first < requests.size(); first += kBatchSize) {
+    vector<PathRequest> part(
+        requests.begin() + first,
+        requests.begin() + std::min(requests.size(), first + kBatchSize));
+    batch.parts_.push_back(
+        thread_pool_->Submit([this, snapshot, part, invalidations]() {
+          vector<PathResult> results;
+          for (const PathRequest& request : part) {
+            results.push_back(FindPath(*snapshot, request, invalidations));
+          }
+          return results;
+        }));
+  }
+  return batch;
+}
+
+void Pathfinder::Invalidate(const BlockBox& box) {
+  // a graph reads the blocks around its chunk's standing points and the
+  // moves out of it, so changes just outside the chunk matter too
+  int width = 2 * chunk_radius_;
+  ivec3 margin(2, kMaxDrop + 2, 2);
+  ivec3 min_corner = box.min_corner - margin + ivec3(chunk_radius_);
+  ivec3 max_corner = box.max_corner + margin + ivec3(chunk_radius_);
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++invalidations_;
+  for (int x = FloorDivide(min_corner.x, width);
+       x <= FloorDivide(max_corner.x, width); ++x) {
+    for (int y = FloorDivide(min_corner.y, width);
+         y <= FloorDivide(max_corner.y, width); ++y) {
+      for (int z = FloorDivide(min_corner.z, width);
+           z <= FloorDivide(max_corner.z, width); ++z) {
+        ChunkCoordinates chunk{x, y, z};
+        clusters_invalidated_ += clusters_.erase(chunk);
+        invalidated_at_[chunk] = invalidations_;
+      }
+    }
+  }
+}
+
+PathfinderStats Pathfinder::GetStats() const {
+  return PathfinderStats{queries_, nodes_expanded_, clusters_built_,
+                         clusters_invalidated_};
+}
+
+size_t Pathfinder::GetClustersCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return clusters_.size();
+}
+
+PathResult Pathfinder::FindBlockPath(const WorldSnapshot& snapshot,
+                                     const PathRequest& request) {
+  BlockReader reader(snapshot);
+  PathResult result{false, {}, 0};
+  if (!reader.CanStandAt(request.start) || !reader.CanStandAt(request.goal)) {
+    return result;
+  }
+  unordered_map<ivec3, uint32_t, PositionHasher> distances;
+  unordered_map<ivec3, ivec3, PositionHasher> parents;
+  OpenList open;
+  distances[request.start] = 0;
+  open.push(OpenNode{request.start, 0,
+                     GetDistanceBound(request.start, request.goal)});
+  ivec3 successors[4];
+  while (!open.empty()) {
+    OpenNode node = open.top();
+    open.pop();
+    if (node.distance > distances[node.position]) {
+      continue;
+    }
+    ++result.nodes_expanded;
+    if (node.position == request.goal) {
+      result.found = true;
+      for (ivec3 position = request.goal; position != request.start;
+           position = parents[position]) {
+        result.path.push_back(position);
+      }
+      result.path.push_back(request.start);
+      std::reverse(result.path.begin(), result.path.end());
+      return result;
+    }
+    size_t successors_count = reader.GetSuccessors(node.position, successors);
+    for (size_t successor = 0; successor < successors_count; ++successor) {
+      const ivec3& reached = successors[successor];
+      unordered_map<ivec3, uint32_t, PositionHasher>::iterator known =
+          distances.find(reached);
+      if (known == distances.end() || node.distance + 1 < known->second) {
+        distances[reached] = node.distance + 1;
+        parents[reached] = node.position;
+        open.push(OpenNode{reached, node.distance + 1,
+                           node.distance + 1 +
+                               GetDistanceBound(reached, request.goal)});
+      }
+    }
+  }
+  return result;
+}
+
+bool Pathfinder::CanStandAt(const WorldSnapshot& snapshot,
+                            const ivec3& position) {
+  BlockReader reader(snapshot);
+  return reader.CanStandAt(position);
+}
+
+shared_ptr<const Pathfinder::Cluster> Pathfinder::GetCluster(
+    const WorldSnapshot& snapshot, const ChunkCoordinates& chunk,
+    uint64_t invalidations) {
+  uint32_t neighbors = GetNeighbors(snapshot, chunk);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<ChunkCoordinates, shared_ptr<const Cluster>>::const_iterator
+        cached = clusters_.find(chunk);
+    if (cached != clusters_.end() && cached->second->neighbors == neighbors) {
+      return cached->second;
+    }
+  }
+
+  BlockReader reader(snapshot);
+  shared_ptr<Cluster> cluster(new Cluster());
+  cluster->neighbors = neighbors;
+  BlockBox bounds = reader.GetBounds(chunk);
+  for (size_t neighbor = 0; neighbor < 14; ++neighbor) {
+    if ((neighbors & (uint32_t(1) << neighbor)) == 0) {
+      continue;
+    }
+    const ChunkCoordinates& offset = kNeighborChunks[neighbor];
+    BlockBox neighbor_bounds = reader.GetBounds(ChunkCoordinates{
+        chunk.x + offset.x, chunk.y + offset.y, chunk.z + offset.z});
+    for (const Transition& exit :
+         FindEntrances(&reader, bounds, neighbor_bounds)) {
+      size_t portal = cluster->AddPortal(exit.from);
+      cluster->edges[portal].push_back(Cluster::Edge{exit.to, 1});
+    }
+    for (const Transition& entrance :
+         FindEntrances(&reader, neighbor_bounds, bounds)) {
+      cluster->AddPortal(entrance.to);
+    }
+  }
+
+  ChunkSearch search(&reader);
+  for (size_t portal = 0; portal < cluster->portals.size(); ++portal) {
+    search.Run(bounds, cluster->portals[portal], true);
+    for (size_t other = 0; other < cluster->portals.size(); ++other) {
+      uint32_t distance = search.GetDistance(cluster->portals[other]);
+      if (other != portal && distance != kUnreached) {
+        cluster->edges[portal].push_back(
+            Cluster::Edge{cluster->portals[other], distance});
+      }
+    }
+  }
+  ++clusters_built_;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<ChunkCoordinates, uint64_t>::const_iterator invalidated =
+      invalidated_at_.find(chunk);
+  if (invalidated == invalidated_at_.end() ||
+      invalidated->second <= invalidations) {
+    clusters_[chunk] = cluster;
+  }
+  return cluster;
+}
+
+PathResult Pathfinder::FindPath(const WorldSnapshot& snapshot,
+                                const PathRequest& request,
+                                uint64_t invalidations) {
+  BlockReader reader(snapshot);
+  PathResult result{false, {}, 0};
+  const ivec3& start = request.start;
+  const ivec3& goal = request.goal;
+  ++queries_;
+  if (!reader.CanStandAt(start) || !reader.CanStandAt(goal)) {
+    return result;
+  }
+
+  ChunkCoordinates start_chunk = reader.GetChunk(start);
+  ChunkCoordinates goal_chunk = reader.GetChunk(goal);
+  ChunkSearch search(&reader);
+  // graphs of the chunks visited, so the cache is locked once per chunk
+  std::map<ChunkCoordinates, shared_ptr<const Cluster>> clusters;
+  std::function<const Cluster&(const ChunkCoordinates&)> get_cluster =
+      [&](const ChunkCoordinates& chunk) -> const Cluster& {
+    shared_ptr<const Cluster>& cluster = clusters[chunk];
+    if (!cluster) {
+      cluster = GetCluster(snapshot, chunk, invalidations);
+    }
+    return *cluster;
+  };
+
+  // edges from the start to the portals of its chunk, and to the goal if
+  // it is in the same chunk
+  vector<Cluster::Edge> start_edges;
+  const Cluster& start_cluster = get_cluster(start_chunk);
+  result.nodes_expanded +=
+      search.Run(reader.GetBounds(start_chunk), start, true);
+  for (const ivec3& portal : start_cluster.portals) {
+    uint32_t distance = search.GetDistance(portal);
+    if (distance != kUnreached && portal != start) {
+      start_edges.push_back(Cluster::Edge{portal, distance});
+    }
+  }
+  if (start_chunk == goal_chunk && search.GetDistance(goal) != kUnreached) {
+    start_edges.push_back(Cluster::Edge{goal, search.GetDistance(goal)});
+  }
+  // and from the portals of the goal's chunk to the goal
+  unordered_map<ivec3, uint32_t, PositionHasher> goal_distances;
+  const Cluster& goal_cluster = get_cluster(goal_chunk);
+  result.nodes_expanded +=
+      search.Run(reader.GetBounds(goal_chunk), goal, false);
+  for (const ivec3& portal : goal_cluster.portals) {
+    uint32_t distance = search.GetDistance(portal);
+    if (distance != kUnreached) {
+      goal_distances[portal] = distance;
+    }
+  }
+
+  // A* over the portals
+  unordered_map<ivec3, uint32_t, PositionHasher> distances;
+  unordered_map<ivec3, ivec3, PositionHasher> parents;
+  OpenList open;
+  distances[start] = 0;
+  open.push(OpenNode{start, 0, GetDistanceBound(start, goal)});
+  vector<Cluster::Edge> edges;
+  bool found = false;
+  while (!open.empty()) {
+    OpenNode node = open.top();
+    open.pop();
+    if (node.distance > distances[node.position]) {
+      continue;
+    }
+    ++result.nodes_expanded;
+    if (node.position == goal) {
+      found = true;
+      break;
+    }
+
+    edges.clear();
+    if (node.position == start) {
+      edges = start_edges;
+    }
+    ChunkCoordinates chunk = reader.GetChunk(node.position);
+    const Cluster& cluster = get_cluster(chunk);
+    unordered_map<ivec3, size_t, PositionHasher>::const_iterator portal =
+        cluster.indices.find(node.position);
+    if (portal != cluster.indices.end()) {
+      edges.insert(edges.end(), cluster.edges[portal->second].begin(),
+                   cluster.edges[portal->second].end());
+    }
+    if (chunk == goal_chunk) {
+      unordered_map<ivec3, uint32_t, PositionHasher>::const_iterator to_goal =
+          goal_distances.find(node.position);
+      if (to_goal != goal_distances.end()) {
+        edges.push_back(Cluster::Edge{goal, to_goal->second});
+      }
+    }
+
+    for (const Cluster::Edge& edge : edges) {
+      uint32_t distance = node.distance + edge.cost;
+      unordered_map<ivec3, uint32_t, PositionHasher>::iterator known =
+          distances.find(edge.to);
+      if (known == distances.end() || distance < known->second) {
+        distances[edge.to] = distance;
+        parents[edge.to] = node.position;
+        open.push(OpenNode{edge.to, distance,
+                           distance + GetDistanceBound(edge.to, goal)});
+      }
+    }
+  }
+
+  if (found) {
+    vector<ivec3> portals;
+    for (ivec3 position = goal; position != start;
+         position = parents[position]) {
+      portals.push_back(position);
+    }
+    std::reverse(portals.begin(), portals.end());
+
+    // refines the edges between portals of the same chunk into moves; the
+    // others are single moves between chunks
+    result.found = true;
+    result.path.push_back(start);
+    for (const ivec3& portal : portals) {
+      ChunkCoordinates chunk = reader.GetChunk(result.path.back());
+      if (chunk != reader.GetChunk(portal)) {
+        result.path.push_back(portal);
+        continue;
+      }
+      result.nodes_expanded +=
+          search.RunTo(reader.GetBounds(chunk), result.path.back(), portal);
+      search.AppendPath(portal, &result.path);
+    }
+  }
+  nodes_expanded_ += result.nodes_expanded;
+  return result;
+}
+
+bool PathBatch::IsReady() const {
+  for (const std::future<vector<PathResult>>& part : parts_) {
+    if (part.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      return false;
+    }
+  }
+  return true;
+}
+
+vector<PathResult> PathBatch::Get() {
+  vector<PathResult> results;
+  for (std::future<vector<PathResult>>& part : parts_) {
+    vector<PathResult> part_results = part.get();
+    results.insert(results.end(), part_results.begin(), part_results.end());
+  }
+  parts_.clear();
+  return results;
+}
+
+}  // namespace minecraft
@@ -0,0 +1,158 @@
+#include "core/quality_controller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <stdexcept>
+
+using std::string;
+using std::vector;
+
+namespace minecraft {
+
+const vector<string> QualityController::kPresetNames = {"low", "medium",
+                                                        "high", "ultra"};
+const size_t QualityController::kWindowFrames = 30;
+const size_t QualityController::kLevelsCount = 5;
+const float QualityController::kHysteresis = 0.15f;
+const size_t QualityController::kRaiseWindows = 4;
+const float QualityController::kUpdateShare = 0.5f;
+const size_t QualityController::kMinRenderRadius = 4;
+const float QualityController::kMinLodViewDistance = 48.0f;
+
+namespace {
+
+/// settings of `QualityController::kPresetNames`, in the same order
+const QualitySettings kPresets[] = {
+    QualitySettings{2, 6, 96.0f, 2},
+    QualitySettings{2, 8, 160.0f, 4},
+    QualitySettings{3, 12, 240.0f, 8},
+    QualitySettings{4, 16, 320.0f, 16},
+};
+
+/// \return `low` if `level` is 0, `high` if it is `levels_count - 1`, and in
+/// between otherwise
+float Interpolate(float low, float high, size_t level, size_t levels_count) {
+  return low + (high - low) * float(level) / float(levels_count - 1);
+}
+
+}  // namespace
+
+QualityController::QualityController(const QualitySettings& settings,
+                                     float target_seconds, std::ostream* log)
+    : highest_(settings),
+      target_seconds_(target_seconds),
+      log_(log),
+      detail_level_(kLevelsCount - 1),
+      streaming_level_(kLevelsCount - 1),
+      settings_(settings),
+      frames_(0),
+      frame_seconds_(0),
+      update_seconds_(0),
+      windows_under_(0) {
+}
+
+bool QualityController::Record(float frame_seconds, float update_seconds) {
+  frame_seconds_ += frame_seconds;
+  update_seconds_ += update_seconds;
+  if (++frames_ < kWindowFrames) {
+    return false;
+  }
+  float frame = frame_seconds_ / float(frames_);
+  float update = update_seconds_ / float(frames_);
+  frames_ = 0;
+  frame_seconds_ = 0;
+  update_seconds_ = 0;
+
+  if (frame > target_seconds_ * (1 + kHysteresis)) {
+    windows_under_ = 0;
+    bool updates_slow = update > kUpdateShare * frame;
+    if (streaming_level_ > 0 && (updates_slow || detail_level_ == 0)) {
+      --streaming_level_;
+    } else if (detail_level_ > 0) {
+      --detail_level_;
+    } else {
+      return false;
+    }
+  } else if (frame < target_seconds_ * (1 - kHysteresis)) {
+    if (++windows_under_ < kRaiseWindows) {
+      return false;
+    }
+    windows_under_ = 0;
+    // the lower level was cut the most, so it is restored first
+    if (streaming_level_ < detail_level_) {
+      ++streaming_level_;
+    } else if (detail_level_ < kLevelsCount - 1) {
+      ++detail_level_;
+    } else if (streaming_level_ < kLevelsCount - 1) {
+      ++streaming_level_;
+    } else {
+      return false;
+    }
+  } else {
+    windows_under_ = 0;
+    return false;
+  }
+  Apply(frame, update);
+  return true;
+}
+
+const QualitySettings& QualityController::GetSettings() const {
+  return settings_;
+}
+
+size_t QualityController::GetDetailLevel() const {
+  return detail_level_;
+}
+
+size_t QualityController::GetStreamingLevel() const {
+  return streaming_level_;
+}
+
+QualitySettings QualityController::GetPreset(const string& name) {
+  for (size_t preset = 0; preset < kPresetNames.size(); ++preset) {
+    if (kPresetNames[preset] == name) {
+      return kPresets[preset];
+    }
+  }
+  throw std::invalid_argument("no quality preset named " + name);
+}
+
+void QualityController::Apply(float frame_seconds, float update_seconds) {
+  QualitySettings previous = settings_;
+  float min_radius = float(std::min(kMinRenderRadius, highest_.render_radius));
+  settings_.render_radius = size_t(std::round(
+      Interpolate(min_radius, float(highest_.render_radius), detail_level_,
+                  kLevelsCount)));
+  settings_.lod_view_distance = std::round(Interpolate(
+      std::min(kMinLodViewDistance, highest_.lod_view_distance),
+      highest_.lod_view_distance, detail_level_, kLevelsCount));
+  settings_.lod_builds_per_update = size_t(std::round(Interpolate(
+      float(std::min<size_t>(1, highest_.lod_builds_per_update)),
+      float(highest_.lod_builds_per_update), streaming_level_,
+      kLevelsCount)));
+
+  if (log_ == nullptr) {
+    return;
+  }
+  *log_ << std::fixed << std::setprecision(1) << "quality: frame "
+        << frame_seconds * 1000 << " ms, update " << update_seconds * 1000
+        << " ms, target " << target_seconds_ * 1000 << " ms: detail level "
+        << detail_level_ << ", streaming level " << streaming_level_;
+  if (settings_.render_radius != previous.render_radius) {
+    *log_ << ", render radius " << previous.render_radius << " -> "
+          << settings_.render_radius;
+  }
+  if (settings_.lod_view_distance != previous.lod_view_distance) {
+    *log_ << std::setprecision(0) << ", lod view distance "
+          << previous.lod_view_distance << " -> "
+          << settings_.lod_view_distance;
+  }
+  if (settings_.lod_builds_per_update != previous.lod_builds_per_update) {
+    *log_ << ", lod builds per update " << previous.lod_builds_per_update
+          << " -> " << settings_.lod_builds_per_update;
+  }
+  *log_ << std::endl;
+}
+
+}  // namespace minecraft
@@ -0,0 +1,103 @@
+#include "core/spatial_hash.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+using glm::ivec3;
+using glm::vec3;
+using std::pair;
+using std::vector;
+
+namespace minecraft {
+
+const size_t SpatialHash::kMinBucketsCount = 64;
+
+SpatialHash::SpatialHash(float cell_size)
+    : cell_size_(cell_size), bucket_mask_(kMinBucketsCount - 1) {
+  if (!(cell_size > 0)) {
+    throw std::invalid_argument("cells of a spatial hash must have a size");
+  }
+  bucket_starts_.assign(kMinBucketsCount + 1, 0);
+}
+
+void SpatialHash::Build(const vec3* centers, const vec3* half_extents,
+                        size_t count) {
+  size_t buckets_count = kMinBucketsCount;
+  while (buckets_count < 2 * count) {
+    buckets_count *= 2;
+  }
+  bucket_mask_ = buckets_count - 1;
+
+  unsorted_.resize(count);
+  bucket_starts_.assign(buckets_count + 1, 0);
+  for (size_t index = 0; index < count; ++index) {
+    const vec3& half_extent = half_extents[index];
+    if (2 * std::max(half_extent.x, std::max(half_extent.y, half_extent.z)) >
+        cell_size_) {
+      throw std::invalid_argument("box " + std::to_string(index) +
+                                  " is wider than a cell");
+    }
+    Entry& entry = unsorted_[index];
+    entry.min_corner = centers[index] - half_extent;
+    entry.max_corner = centers[index] + half_extent;
+    entry.cell = ivec3(glm::floor(centers[index] / cell_size_));
+    entry.index = uint32_t(index);
+    ++bucket_starts_[GetBucket(entry.cell) + 1];
+  }
+  for (size_t bucket = 0; bucket < buckets_count; ++bucket) {
+    bucket_starts_[bucket + 1] += bucket_starts_[bucket];
+  }
+
+  entries_.resize(count);
+  bucket_ends_.assign(bucket_starts_.begin(), bucket_starts_.end() - 1);
+  for (const Entry& entry : unsorted_) {
+    entries_[bucket_ends_[GetBucket(entry.cell)]++] = entry;
+  }
+}
+
+void SpatialHash::FindPairs(vector<pair<uint32_t, uint32_t>>* pairs) const {
+  pairs->clear();
+  for (const Entry& entry : entries_) {
+    for (int dx = -1; dx <= 1; ++dx) {
+      for (int dy = -1; dy <= 1; ++dy) {
+        for (int dz = -1; dz <= 1; ++dz) {
+          ivec3 cell = entry.cell + ivec3(dx, dy, dz);
+          size_t bucket = GetBucket(cell);
+          for (uint32_t other = bucket_starts_[bucket];
+               other < bucket_starts_[bucket + 1]; ++other) {
+            const Entry& candidate = entries_[other];
+            // cells sharing the bucket are skipped, so that a box reached
+            // through several cells is only tested once
+            if (candidate.index > entry.index && candidate.cell == cell &&
+                candidate.min_corner.x < entry.max_corner.x &&
+                entry.min_corner.x < candidate.max_corner.x &&
+                candidate.min_corner.y < entry.max_corner.y &&
+                entry.min_corner.y < candidate.max_corner.y &&
+                candidate.min_corner.z < entry.max_corner.z &&
+                entry.min_corner.z < candidate.max_corner.z) {
+              pairs->push_back(std::make_pair(entry.index, candidate.index));
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+float SpatialHash::GetCellSize() const {
+  return cell_size_;
+}
+
+size_t SpatialHash::GetBucketsCount() const {
+  return bucket_mask_ + 1;
+}
+
+size_t SpatialHash::GetBucket(const ivec3& cell) const {
+  return (size_t(uint32_t(cell.x) * 73856093u) ^
+          size_t(uint32_t(cell.y) * 19349663u) ^
+          size_t(uint32_t(cell.z) * 83492791u)) &
+         bucket_mask_;
+}
+
+}  // namespace minecraft
@@ -1,36 +1,72 @@
 #include "core/terrain_generator.h"
 
-#include <iostream>
+#include <typeinfo>
+#include <vector>
+
+#include "core/memory_pool.h"
 
 using ci::vec3;
+using glm::ivec3;
+using std::vector;
 
 namespace minecraft {
 
-TerrainGenerator::TerrainGenerator(int min_height, int max_height,
-                                   float variance, int seed)
+PerlinTerrain::PerlinTerrain(int min_height, int max_height, float variance,
+                             int seed)
     : min_height_(min_height), max_height_(max_height), variance_(variance) {
   noise_ = FastNoiseLite(seed);
   noise_.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
 }
 
-BlockTypes TerrainGenerator::GetBlockAt(const vec3& transform) {
-  int height = GetTerrainHeight(transform.x, transform.z);
-  int lattice_y = int(round(transform.y));
-  if (lattice_y == height) {
-    return BlockTypes::kGrass;
-  } else if (0 <= lattice_y && lattice_y < height) {
-    return BlockTypes::kDirt;
-  } else if (lattice_y < height) {
-    return BlockTypes::kStone;
-  }
-  return BlockTypes::kNone;
-}
-
-int TerrainGenerator::GetTerrainHeight(int x, int z) {
+int PerlinTerrain::GetHeight(int x, int z) const {
   int height_delta = max_height_ - min_height_;
   float noise_function =
-      noise_.GetNoise(round(x) * variance_, round(z) * variance_);
+      noise_.GetNoise(float(x) * variance_, float(z) * variance_);
   return int(noise_function * float(height_delta) - float(min_height_));
 }
 
-}  // namespace minecraft
\ No newline at end of file
+void FillChunk(const PerlinTerrain& terrain, const ivec3& min_corner,
+               int width, BlockTypes* voxels) {
+  // heights indexed by x then z, so each row of voxels below reads them
+  // contiguously. pooled, since every chunk load needs them
+  vector<int, PoolAllocator<int>> heights(size_t(width * width));
+  for (int x = 0; x < width; ++x) {
+    for (int z = 0; z < width; ++z) {
+      heights[size_t(x * width + z)] =
+          terrain.GetHeight(min_corner.x + x, min_corner.z + z);
+    }
+  }
+  for (int x = 0; x < width; ++x) {
+    const int* row_heights = heights.data() + x * width;
+    for (int y = min_corner.y; y < min_corner.y + width; ++y) {
+      for (int z = 0; z < width; ++z) {
+        voxels[z] = PerlinTerrain::GetBlockInColumn(y, row_heights[z]);
+      }
+      voxels += width;
+    }
+  }
+}
+
+TerrainGenerator::TerrainGenerator(int min_height, int max_height,
+                                   float variance, int seed)
+    : terrain_(min_height, max_height, variance, seed) {
+}
+
+BlockTypes TerrainGenerator::GetBlockAt(const vec3& transform) {
+  ivec3 lattice_point = ivec3(glm::round(transform));
+  return terrain_.GetBlockAt(lattice_point.x, lattice_point.y,
+                             lattice_point.z);
+}
+
+void TerrainGenerator::FillChunk(const ivec3& min_corner, int width,
+                                 BlockTypes* voxels) {
+  // a subclass may have overridden `GetBlockAt`, which only the slow path
+  // honors
+  if (typeid(*this) == typeid(TerrainGenerator)) {
+    minecraft::FillChunk(terrain_, min_corner, width, voxels);
+  } else {
+    minecraft::FillChunk(PolymorphicTerrain(this), min_corner, width, voxels);
+  }
+}
+
+}  // namespace minecraft
@@ -1,55 +1,161 @@
 #include "core/texture.h"
 
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
 #include "cinder/app/app.h"
+#include "core/block_registry.h"
 
+using ci::ivec2;
 using ci::loadImage;
+using ci::Surface8u;
+using ci::vec2;
 using ci::app::getAssetPath;
 using ci::gl::Texture2d;
 using ci::gl::Texture2dRef;
 using std::invalid_argument;
-using std::map;
 using std::string;
+using std::unique_ptr;
+using std::vector;
 
 namespace minecraft {
 
-const map<BlockTypes, string> Texture::kTextureFiles = {
-    {kGrass, "grass.png"}, {kDirt, "dirt.png"}, {kStone, "stone.png"}};
-const map<BlockTypes, string> Texture::kIconFiles = {
-    {kGrass, "grass_icon.png"},
-    {kDirt, "dirt_icon.png"},
-    {kStone, "stone_icon.png"}};
 const string Texture::kTestTexture = "test.png";
 
-Texture::Texture(const BlockTypes &block_type) : block_type_(block_type) {
-}
-
 #ifdef DONT_USE_TEXTURES
-Texture2dRef Texture::GetTexture() {
-  std::move(block_type_);  // avoid unused variable error
+Texture2dRef Texture::GetAtlas() {
   return nullptr;
 }
-#elif defined USE_TEST_TEXTURES
-Texture2dRef Texture::GetTexture() {
-  std::move(block_type_);  // avoid unused variable error
-  return Texture2d::create(loadImage(getAssetPath(kTestTexture)));
+#else
+Texture2dRef Texture::GetAtlas() {
+  static Texture2dRef atlas = LoadAtlas();
+  return atlas;
 }
+#endif
+
+Texture2dRef Texture::LoadAtlas() {
+#ifndef USE_TEST_TEXTURES
+  const AssetPack* pack = GetPack();
+  if (pack != nullptr && pack->Find(AssetPack::kAtlasName) != nullptr) {
+    return CreateTexture(*pack->Find(AssetPack::kAtlasName));
+  }
+#endif
+  Surface8u atlas;
+  for (size_t strip = 0; strip < BlockRegistry::kAtlasStripsCount; ++strip) {
+#ifdef USE_TEST_TEXTURES
+    Surface8u surface(loadImage(getAssetPath(kTestTexture)));
 #else
-Texture2dRef Texture::GetTexture() {
-  if (kTextureFiles.find(block_type_) != kTextureFiles.end()) {
-    return Texture2d::create(
-        loadImage(getAssetPath(kTextureFiles.at(block_type_))));
+    Surface8u surface(
+        loadImage(getAssetPath(BlockRegistry::kAtlasFiles[strip])));
+#endif
+    if (strip == 0) {
+      int strips_count = int(BlockRegistry::kAtlasStripsCount);
+      atlas = Surface8u(surface.getWidth(), surface.getHeight() * strips_count,
+                        true);
+    }
+    atlas.copyFrom(surface, surface.getBounds(),
+                   ivec2(0, int(strip) * surface.getHeight()));
   }
-  throw invalid_argument(std::to_string(block_type_) +
-                         " does not have a texture");
+  return Texture2d::create(atlas);
+}
+
+AssetImage Texture::DecodeImage(const ci::fs::path& path,
+                                const string& name) {
+  Surface8u surface(loadImage(path));
+  AssetImage image{name, uint32_t(surface.getWidth()),
+                   uint32_t(surface.getHeight()), {}};
+  image.pixels.reserve(size_t(image.width) * image.height * 4);
+  for (int y = surface.getHeight() - 1; y >= 0; --y) {
+    for (int x = 0; x < surface.getWidth(); ++x) {
+      ci::ColorA8u pixel = surface.getPixel(ivec2(x, y));
+      image.pixels.insert(image.pixels.end(), {pixel.r, pixel.g, pixel.b,
+                                               pixel.a});
+    }
+  }
+  return image;
+}
+
+AssetImage Texture::DecodeAtlas(const vector<ci::fs::path>& strips) {
+  AssetImage atlas{AssetPack::kAtlasName, 0, 0, {}};
+  // strips go from the top down, so they are appended bottom row first from
+  // the last strip on
+  for (size_t strip = strips.size(); strip-- > 0;) {
+    AssetImage image = DecodeImage(strips[strip], "");
+    if (atlas.width != 0 && image.width != atlas.width) {
+      throw invalid_argument(strips[strip].string() + " is " +
+                             std::to_string(image.width) +
+                             " pixels wide, not " +
+                             std::to_string(atlas.width));
+    }
+    atlas.width = image.width;
+    atlas.height += image.height;
+    atlas.pixels.insert(atlas.pixels.end(), image.pixels.begin(),
+                        image.pixels.end());
+  }
+  return atlas;
+}
+
+unique_ptr<AssetPack> Texture::LoadPack() {
+  ci::fs::path path = getAssetPath(AssetPack::kFileName);
+  if (path.empty()) {
+    return nullptr;
+  }
+  try {
+    return unique_ptr<AssetPack>(new AssetPack(path.string()));
+  } catch (const std::runtime_error& error) {
+    std::cerr << error.what() << ", decoding the PNGs instead\n";
+    return nullptr;
+  }
+}
+
+vec2 Texture::GetAtlasCoordinates(uint8_t layer, const vec2& corner) {
+  float column = float(layer % BlockRegistry::kTilesPerStrip);
+  float row = float(layer / BlockRegistry::kTilesPerStrip);
+  // textures are loaded bottom-up, so the first strip is at the top (v = 1)
+  return vec2((column + corner.x) / float(BlockRegistry::kTilesPerStrip),
+              1.0f - (row + 1.0f - corner.y) /
+                         float(BlockRegistry::kAtlasStripsCount));
 }
-#endif
 
 Texture2dRef Texture::GetIcon(BlockTypes block_type) {
-  if (kIconFiles.find(block_type) != kIconFiles.end()) {
-    return Texture2d::create(
-        loadImage(getAssetPath(kIconFiles.at(block_type))));
+  static Texture2dRef icons[BlockRegistry::kBlockTypesCount];
+  if (icons[block_type] == nullptr) {
+    const char* icon_file = BlockRegistry::Get(block_type).icon_file;
+    if (icon_file == nullptr) {
+      throw invalid_argument(std::to_string(block_type) +
+                             " does not have an icon");
+    }
+    const AssetPack* pack = GetPack();
+    if (pack != nullptr && pack->Find(icon_file) != nullptr) {
+      icons[block_type] = CreateTexture(*pack->Find(icon_file));
+    } else {
+      icons[block_type] =
+          Texture2d::create(loadImage(getAssetPath(icon_file)));
+    }
+  }
+  return icons[block_type];
+}
+
+const AssetPack* Texture::GetPack() {
+  static unique_ptr<AssetPack> pack = LoadPack();
+  return pack.get();
+}
+
+Texture2dRef Texture::CreateTexture(const PackedImage& image) {
+  Texture2d::Format format;
+  if (image.levels_count > 1) {
+    // allocates the levels, which are then replaced by the packed ones
+    format.mipmap(true).minFilter(GL_LINEAR_MIPMAP_LINEAR);
+  }
+  Texture2dRef texture = Texture2d::create(
+      image.pixels, GL_RGBA, int(image.width), int(image.height), format);
+  for (uint32_t level = 1; level < image.levels_count; ++level) {
+    texture->update(image.GetLevel(level), GL_RGBA, GL_UNSIGNED_BYTE,
+                    int(level), int(image.GetWidth(level)),
+                    int(image.GetHeight(level)));
   }
-  throw invalid_argument(std::to_string(block_type) + " does not have an icon");
+  return texture;
 }
 
-}  // namespace minecraft
\ No newline at end of file
+}  // namespace minecraft
@@ -0,0 +1,61 @@
+#include "core/thread_pool.h"
+
+#include <algorithm>
+
+using std::function;
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+namespace minecraft {
+
+ThreadPool::ThreadPool(size_t threads_count) : stopping_(false) {
+  threads_count = std::max<size_t>(threads_count, 1);
+  for (size_t i = 0; i < threads_count; ++i) {
+    threads_.emplace_back(&ThreadPool::Run, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    lock_guard<mutex> lock(mutex_);
+    stopping_ = true;
+    tasks_.clear();
+  }
+  condition_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+size_t ThreadPool::GetThreadsCount() const {
+  return threads_.size();
+}
+
+size_t ThreadPool::GetQueuedCount() const {
+  lock_guard<mutex> lock(mutex_);
+  return tasks_.size();
+}
+
+size_t ThreadPool::GetDefaultThreadsCount() {
+  size_t cores = std::thread::hardware_concurrency();
+  return cores > 1 ? cores - 1 : 1;
+}
+
+void ThreadPool::Run() {
+  while (true) {
+    function<void()> task;
+    {
+      unique_lock<mutex> lock(mutex_);
+      condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+      if (stopping_) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+}  // namespace minecraft
@@ -0,0 +1,41 @@
+#include "core/tick_scheduler.h"
+
+#include <algorithm>
+
+using glm::ivec3;
+using std::vector;
+
+namespace minecraft {
+
+TickScheduler::TickScheduler() : tick_(0), sequence_(0) {
+}
+
+bool TickScheduler::Schedule(const ivec3& position, uint32_t delay) {
+  if (!pending_.insert(position).second) {
+    return false;
+  }
+  queue_.push(ScheduledTick{tick_ + std::max<uint32_t>(delay, 1), sequence_++,
+                            position});
+  return true;
+}
+
+vector<ivec3> TickScheduler::Advance() {
+  ++tick_;
+  vector<ivec3> due;
+  while (!queue_.empty() && queue_.top().tick <= tick_) {
+    due.push_back(queue_.top().position);
+    pending_.erase(queue_.top().position);
+    queue_.pop();
+  }
+  return due;
+}
+
+uint64_t TickScheduler::GetTick() const {
+  return tick_;
+}
+
+size_t TickScheduler::GetPendingCount() const {
+  return queue_.size();
+}
+
+}  // namespace minecraft
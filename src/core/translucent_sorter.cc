@@ -0,0 +1,147 @@
+#include "core/translucent_sorter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <vector>
+
+#include "core/world.h"
+
+using ci::vec3;
+using glm::ivec3;
+using std::map;
+using std::pair;
+using std::vector;
+
+namespace minecraft {
+
+const float TranslucentSorter::kResortDistance = 1.0f;
+const float TranslucentSorter::kResortFraction = 0.125f;
+constexpr size_t TranslucentSorter::kMaxSortsPerUpdate;
+
+namespace {
+
+/// \return whether a point is inside a box, bounds included
+bool IsInside(const ivec3& point, const ivec3& low, const ivec3& high) {
+  return point.x >= low.x && point.y >= low.y && point.z >= low.z &&
+         point.x <= high.x && point.y <= high.y && point.z <= high.z;
+}
+
+}  // namespace
+
+TranslucentSorter::TranslucentSorter(World* world, ThreadPool* thread_pool)
+    : world_(world), thread_pool_(thread_pool), stats_{0, 0, 0, 0} {
+  world_->SetTranslucentSorter(this);
+}
+
+TranslucentSorter::~TranslucentSorter() {
+  world_->SetTranslucentSorter(nullptr);
+  for (pair<const PackedMesh* const, Entry>& entry : entries_) {
+    if (entry.second.sort.valid()) {
+      entry.second.sort.wait();
+    }
+  }
+}
+
+void TranslucentSorter::Update(const vec3& eye) {
+  for (pair<const PackedMesh* const, Entry>& element : entries_) {
+    Entry& entry = element.second;
+    if (entry.sort.valid() && entry.sort.wait_for(std::chrono::seconds(0)) ==
+                                  std::future_status::ready) {
+      // rethrows anything the sort threw
+      entry.sort.get();
+      std::swap(entry.sorted, entry.pending);
+      entry.sorted_revision = entry.pending_revision;
+      ++stats_.completed;
+    }
+  }
+
+  // the entries of chunks without translucent faces are dropped once their
+  // sorts are done, since the worker may still write to them
+  vector<const PackedMesh*> meshes = world_->GetTranslucentMeshes();
+  std::sort(meshes.begin(), meshes.end());
+  for (map<const PackedMesh*, Entry>::iterator entry = entries_.begin();
+       entry != entries_.end();) {
+    if (!entry->second.sort.valid() &&
+        !std::binary_search(meshes.begin(), meshes.end(), entry->first)) {
+      entry = entries_.erase(entry);
+    } else {
+      ++entry;
+    }
+  }
+
+  // nearest first, since their order shows the most
+  float half_width = float(world_->GetChunkRadius());
+  vector<pair<float, const PackedMesh*>> due;
+  for (const PackedMesh* mesh : meshes) {
+    const Entry& entry = entries_[mesh];
+    if (entry.sort.valid()) {
+      continue;
+    }
+    if (IsDue(*mesh, entry, eye)) {
+      vec3 center = vec3(mesh->GetOrigin()) + half_width - 0.5f;
+      due.emplace_back(glm::distance(eye, center), mesh);
+    } else {
+      ++stats_.skipped;
+    }
+  }
+  std::sort(due.begin(), due.end());
+  if (due.size() > kMaxSortsPerUpdate) {
+    stats_.deferred += due.size() - kMaxSortsPerUpdate;
+    due.resize(kMaxSortsPerUpdate);
+  }
+
+  for (const pair<float, const PackedMesh*>& mesh : due) {
+    Entry& entry = entries_[mesh.second];
+    // copied here, so the worker never reads a mesh the world rebuilds
+    entry.pending = *mesh.second;
+    entry.pending_revision = mesh.second->GetRevision();
+    entry.eye = eye;
+    entry.eye_block = ivec3(glm::round(eye));
+    PackedMesh* pending = &entry.pending;
+    entry.sort = thread_pool_->Submit(
+        [pending, eye]() { pending->SortBackToFront(eye); });
+    ++stats_.requested;
+  }
+}
+
+const PackedMesh& TranslucentSorter::GetSorted(const PackedMesh& mesh) const {
+  map<const PackedMesh*, Entry>::const_iterator entry = entries_.find(&mesh);
+  if (entry == entries_.end() ||
+      entry->second.sorted_revision != mesh.GetRevision()) {
+    return mesh;
+  }
+  return entry->second.sorted;
+}
+
+size_t TranslucentSorter::GetSortingCount() const {
+  size_t sorting = 0;
+  for (const pair<const PackedMesh* const, Entry>& entry : entries_) {
+    sorting += entry.second.sort.valid();
+  }
+  return sorting;
+}
+
+const SortStats& TranslucentSorter::GetStats() const {
+  return stats_;
+}
+
+bool TranslucentSorter::IsDue(const PackedMesh& mesh, const Entry& entry,
+                              const vec3& eye) const {
+  if (entry.pending_revision != mesh.GetRevision()) {
+    return true;
+  }
+  // another block, within the chunk or next to it
+  int width = 2 * int(world_->GetChunkRadius());
+  ivec3 eye_block = ivec3(glm::round(eye));
+  if (eye_block != entry.eye_block &&
+      IsInside(eye_block, mesh.GetOrigin() - 1, mesh.GetOrigin() + width)) {
+    return true;
+  }
+  vec3 center = vec3(mesh.GetOrigin()) + float(width) / 2.0f - 0.5f;
+  float threshold =
+      std::max(kResortDistance, kResortFraction * glm::distance(eye, center));
+  return glm::distance(eye, entry.eye) > threshold;
+}
+
+}  // namespace minecraft
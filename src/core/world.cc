@@ -1,15 +1,27 @@
 #include "core/world.h"
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
 #include <random>
+#include <stdexcept>
+
+#include "core/block_registry.h"
+#include "core/chunk_prefetcher.h"
+#include "core/translucent_sorter.h"
 
 using ci::vec2;
 using ci::vec3;
-using ci::gl::drawCube;
-using ci::gl::drawStrokedCube;
 using glm::distance;
 using glm::dot;
+using glm::ivec3;
 using glm::length;
 using std::abs;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+using std::function;
+using std::map;
 using std::mt19937;
 using std::pair;
 using std::random_device;
@@ -18,170 +30,737 @@ using std::vector;
 
 namespace minecraft {
 
+constexpr int World::kWindowRadius;
+constexpr int World::kCollisionReach;
+constexpr int World::kNoColumnTop;
+constexpr uint32_t World::kRandomTicksPerChunk;
+constexpr uint32_t World::kGrassDecayDelay;
+
+/// the block itself and its face neighbors
+static const ivec3 kNeighborhood[] = {ivec3(0, 0, 0),  ivec3(1, 0, 0),
+                                      ivec3(-1, 0, 0), ivec3(0, 1, 0),
+                                      ivec3(0, -1, 0), ivec3(0, 0, 1),
+                                      ivec3(0, 0, -1)};
+
+/// \return squared distance between two chunks, in chunks
+static int GetSquaredChunkDistance(const ChunkCoordinates& first,
+                                   const ChunkCoordinates& second) {
+  int x = first.x - second.x;
+  int y = first.y - second.y;
+  int z = first.z - second.z;
+  return x * x + y * y + z * z;
+}
+
 World::World(TerrainGenerator* terrain_generator,
-             const ci::vec3& origin_position, size_t chunk_radius)
-    : terrain_generator_(terrain_generator), chunk_radius_(chunk_radius) {
-  InitializeAdjacentChunks(GetChunk(origin_position));
+             const ci::vec3& origin_position, size_t chunk_radius,
+             SpawnMode spawn_mode)
+    : chunks_(kWindowRadius, int(chunk_radius)),
+      terrain_generator_(terrain_generator),
+      chunk_radius_(chunk_radius),
+      random_(0),
+      tick_stats_{0, 0, 0, 0, 0, 0},
+      change_bus_(chunk_radius),
+      prefetcher_(nullptr),
+      translucent_sorter_(nullptr),
+      metrics_(),
+      has_metrics_(false) {
+  ChunkWindow::Deferral defer;
+  if (spawn_mode == SpawnMode::kProgressive) {
+    // the chunks overlapping the blocks within reach of the player
+    ivec3 origin = ivec3(glm::round(origin_position));
+    ChunkCoordinates low = GetChunkOf(origin - ivec3(kCollisionReach));
+    ChunkCoordinates high = GetChunkOf(origin + ivec3(kCollisionReach));
+    defer = [low, high](const ChunkCoordinates& chunk) {
+      return chunk.x < low.x || chunk.x > high.x || chunk.y < low.y ||
+             chunk.y > high.y || chunk.z < low.z || chunk.z > high.z;
+    };
+  }
+  chunks_.Recenter(GetChunk(origin_position),
+                   [this](const ChunkCoordinates& chunk, Chunk* voxels) {
+                     LoadChunk(chunk, voxels);
+                   },
+                   defer);
+}
+
+void World::Render(Renderer* renderer, const vec3& origin,
+                   const vec3& forward, float field_of_view_angle,
+                   size_t render_radius) const {
+  for (const ChunkWindow::Slot& slot : chunks_.GetSlots()) {
+    const PackedMesh& mesh = slot.chunk.GetMesh();
+    if (slot.loaded && mesh.GetTrianglesCount() > 0 &&
+        IsWithinRenderDistance(slot.chunk, origin, forward,
+                               field_of_view_angle, render_radius)) {
+      renderer->DrawPackedMesh(mesh);
+    }
+  }
 }
 
-void World::Render(const vec3& origin, const vec3& forward,
-                   float field_of_view_angle, size_t render_radius) const {
-  for (const Block& block : blocks_) {
-    if (IsWithinRenderDistance(block, origin, forward, field_of_view_angle,
-                               render_radius)) {
-      block.Render();
+void World::RenderTranslucent(Renderer* renderer, const vec3& origin,
+                              const vec3& forward, float field_of_view_angle,
+                              size_t render_radius) const {
+  // by squared distance from the origin to the chunk's center
+  vector<pair<float, const PackedMesh*>> meshes;
+  for (const ChunkWindow::Slot& slot : chunks_.GetSlots()) {
+    const PackedMesh& mesh = slot.chunk.GetTranslucentMesh();
+    if (slot.loaded && mesh.GetTrianglesCount() > 0 &&
+        IsWithinRenderDistance(slot.chunk, origin, forward,
+                               field_of_view_angle, render_radius)) {
+      vec3 offset = vec3(slot.chunk.GetMinCorner()) +
+                    (float(slot.chunk.GetWidth()) - 1.0f) / 2.0f - origin;
+      meshes.emplace_back(dot(offset, offset), &mesh);
     }
   }
+  std::sort(meshes.begin(), meshes.end(),
+            [](const pair<float, const PackedMesh*>& first,
+               const pair<float, const PackedMesh*>& second) {
+              return first.first > second.first;
+            });
+  for (const pair<float, const PackedMesh*>& mesh : meshes) {
+    renderer->DrawTranslucentPackedMesh(
+        translucent_sorter_ != nullptr
+            ? translucent_sorter_->GetSorted(*mesh.second)
+            : *mesh.second);
+  }
 }
 
-bool World::IsWithinRenderDistance(const Block& block, const vec3& origin,
+bool World::IsWithinRenderDistance(const Chunk& chunk, const vec3& origin,
                                    const vec3& forward,
                                    float field_of_view_angle,
                                    size_t render_radius) {
-  return distance(origin, block.GetCenter()) <= render_radius &&
-         GetAngle(block.GetCenter() - origin, forward) <= field_of_view_angle;
+  // the sphere around the chunk's blocks
+  float width = float(chunk.GetWidth());
+  vec3 center = vec3(chunk.GetMinCorner()) + (width - 1.0f) / 2.0f;
+  float radius = width * std::sqrt(3.0f) / 2.0f;
+  float center_distance = distance(origin, center);
+  if (center_distance > float(render_radius) + radius) {
+    return false;
+  }
+  return center_distance <= radius ||
+         GetAngle(center - origin, forward) <=
+             field_of_view_angle + std::asin(radius / center_distance);
 }
 
-bool World::HasMovedChunks(const vector<int>& old_chunk,
+bool World::HasMovedChunks(const ChunkCoordinates& old_chunk,
                            const vec3& new_position) const {
   return old_chunk != GetChunk(new_position);
 }
 
-void World::MoveToChunk(const vector<int>& old_chunk,
-                        const vector<int>& new_chunk) {
-  DeleteDistanceChunks(new_chunk);
-  LoadNextChunks(old_chunk, new_chunk);
+void World::MoveToChunk(const ChunkCoordinates& old_chunk,
+                        const ChunkCoordinates& new_chunk) {
+  steady_clock::time_point start = steady_clock::now();
+  chunks_.Recenter(new_chunk,
+                   [this](const ChunkCoordinates& chunk, Chunk* voxels) {
+                     LoadChunk(chunk, voxels);
+                   });
+  if (has_metrics_) {
+    metrics_.move_to_chunk_seconds->Observe(
+        duration<double>(steady_clock::now() - start).count());
+  }
 }
 
-void World::DeleteDistanceChunks(const vector<int>& new_chunk) {
-  size_t block_index = 0;
-  while (block_index < blocks_.size()) {
-    vector<int> block_chunk = GetChunk(blocks_[block_index].GetCenter());
-    if (abs(block_chunk[0] - new_chunk[0]) > 1 ||
-        abs(block_chunk[1] - new_chunk[1]) > 1 ||
-        abs(block_chunk[2] - new_chunk[2]) > 1) {
-      blocks_.erase(blocks_.begin() + block_index);
-    } else {
-      ++block_index;
+ChunkCoordinates World::GetChunk(const vec3& point) const {
+  return ChunkCoordinates{int(floor(point.x / (2.0f * chunk_radius_) + 0.5f)),
+                          int(floor(point.y / (2.0f * chunk_radius_) + 0.5f)),
+                          int(floor(point.z / (2.0f * chunk_radius_) + 0.5f))};
+}
+
+ChunkCoordinates World::GetChunkOf(const ivec3& position) const {
+  int half_width = int(chunk_radius_);
+  return ChunkCoordinates{FloorDivide(position.x + half_width, 2 * half_width),
+                          FloorDivide(position.y + half_width, 2 * half_width),
+                          FloorDivide(position.z + half_width, 2 * half_width)};
+}
+
+ivec3 World::GetChunkMinCorner(const ChunkCoordinates& chunk) const {
+  int half_width = int(chunk_radius_);
+  return ivec3(chunk.x, chunk.y, chunk.z) * (2 * half_width) -
+         ivec3(half_width);
+}
+
+const ChunkCoordinates& World::GetWindowCenter() const {
+  return chunks_.GetCenter();
+}
+
+size_t World::StreamChunks(size_t max_chunks) {
+  size_t loaded = 0;
+  for (const ChunkCoordinates& chunk : GetPendingChunks()) {
+    if (loaded == max_chunks) {
+      break;
     }
+    if (prefetcher_ != nullptr && prefetcher_->IsBuilding(chunk)) {
+      continue;
+    }
+    chunks_.LoadPending(chunk,
+                        [this](const ChunkCoordinates& pending, Chunk* voxels) {
+                          LoadChunk(pending, voxels);
+                        });
+    ++loaded;
   }
+  return loaded;
 }
 
-void World::LoadNextChunks(const vector<int>& old_chunk,
-                           const vector<int>& new_chunk) {
-  if (old_chunk[0] != new_chunk[0]) {
-    int direction = new_chunk[0] - old_chunk[0];
-    for (int y = -1; y <= 1; ++y) {
-      for (int z = -1; z <= 1; ++z) {
-        GenerateChunk(new_chunk, direction, y, z);
-      }
+vector<ChunkCoordinates> World::GetPendingChunks() const {
+  vector<ChunkCoordinates> pending = chunks_.GetPending();
+  const ChunkCoordinates& center = chunks_.GetCenter();
+  std::sort(pending.begin(), pending.end(),
+            [&center](const ChunkCoordinates& first,
+                      const ChunkCoordinates& second) {
+              int first_distance = GetSquaredChunkDistance(first, center);
+              int second_distance = GetSquaredChunkDistance(second, center);
+              return first_distance != second_distance
+                         ? first_distance < second_distance
+                         : first < second;
+            });
+  return pending;
+}
+
+void World::SetPrefetcher(ChunkPrefetcher* prefetcher) {
+  prefetcher_ = prefetcher;
+}
+
+vector<const PackedMesh*> World::GetTranslucentMeshes() const {
+  vector<const PackedMesh*> meshes;
+  for (const ChunkWindow::Slot& slot : chunks_.GetSlots()) {
+    const PackedMesh& mesh = slot.chunk.GetTranslucentMesh();
+    if (slot.loaded && mesh.GetTrianglesCount() > 0) {
+      meshes.push_back(&mesh);
+    }
+  }
+  return meshes;
+}
+
+void World::SetTranslucentSorter(const TranslucentSorter* sorter) {
+  translucent_sorter_ = sorter;
+}
+
+void World::SetMetrics(MetricsRegistry* registry) {
+  if (has_metrics_) {
+    throw std::invalid_argument("the world metrics are already registered");
+  }
+  const char* memory_help = "Bytes held, by subsystem";
+  metrics_.loaded_chunks = registry->AddGauge(
+      "minecraft_loaded_chunks", "Chunks of the window loaded");
+  metrics_.pending_chunks = registry->AddGauge(
+      "minecraft_pending_chunks", "Chunks of the window not loaded yet");
+  metrics_.blocks = registry->AddGauge(
+      "minecraft_blocks", "Render blocks of the loaded chunks");
+  metrics_.voxel_bytes = registry->AddGauge(
+      "minecraft_memory_bytes", memory_help, "subsystem=\"voxels\"");
+  metrics_.mesh_bytes = registry->AddGauge(
+      "minecraft_memory_bytes", memory_help, "subsystem=\"meshes\"");
+  metrics_.block_bytes = registry->AddGauge(
+      "minecraft_memory_bytes", memory_help, "subsystem=\"blocks\"");
+  metrics_.edit_bytes = registry->AddGauge(
+      "minecraft_memory_bytes", memory_help, "subsystem=\"edits\"");
+  metrics_.move_to_chunk_seconds = registry->AddHistogram(
+      "minecraft_move_to_chunk_seconds", "Time to recenter the loaded chunks");
+  const char* generation_help = "Time to build a chunk from the terrain";
+  metrics_.load_generation_seconds = registry->AddHistogram(
+      "minecraft_chunk_generation_seconds", generation_help,
+      MetricsRegistry::kLatencyBounds, "path=\"load\"");
+  metrics_.prefetch_generation_seconds = registry->AddHistogram(
+      "minecraft_chunk_generation_seconds", generation_help,
+      MetricsRegistry::kLatencyBounds, "path=\"prefetch\"");
+  metrics_.edits = registry->AddCounter("minecraft_edits_total",
+                                        "Blocks changed by edits");
+  has_metrics_ = true;
+  UpdateMetrics();
+}
+
+const WorldMetrics* World::GetMetrics() const {
+  return has_metrics_ ? &metrics_ : nullptr;
+}
+
+int World::FloorDivide(int numerator, int denominator) {
+  int quotient = numerator / denominator;
+  return quotient * denominator > numerator ? quotient - 1 : quotient;
+}
+
+void World::LoadChunk(const ChunkCoordinates& chunk, Chunk* voxels) {
+  if (prefetcher_ != nullptr && prefetcher_->Take(chunk, voxels)) {
+    return;
+  }
+  steady_clock::time_point start = steady_clock::now();
+  GenerateVoxels(chunk, voxels);
+  voxels->RebuildBlocks();
+  if (has_metrics_) {
+    metrics_.load_generation_seconds->Observe(
+        duration<double>(steady_clock::now() - start).count());
+  }
+}
+
+void World::GenerateVoxels(const ChunkCoordinates& chunk, Chunk* voxels) {
+  VoxelArray& blocks = voxels->GetVoxels();
+  terrain_generator_->FillChunk(voxels->GetMinCorner(), voxels->GetWidth(),
+                                blocks.data());
+  MapEdits::const_iterator edits =
+      player_map_edits_.find(chunk);
+  if (edits != player_map_edits_.end()) {
+    for (const pair<const size_t, BlockTypes>& edit : edits->second) {
+      blocks[edit.first] = edit.second;
+    }
+  }
+}
+
+void World::UpdateMetrics() {
+  size_t loaded_chunks = 0;
+  size_t blocks = 0;
+  size_t voxel_bytes = 0;
+  size_t mesh_bytes = 0;
+  for (const ChunkWindow::Slot& slot : chunks_.GetSlots()) {
+    if (!slot.loaded) {
+      continue;
+    }
+    ++loaded_chunks;
+    blocks += slot.chunk.GetBlocks().size();
+    voxel_bytes += slot.chunk.GetVoxels().size() * sizeof(BlockTypes);
+    mesh_bytes += slot.chunk.GetMesh().GetBytes() +
+                  slot.chunk.GetTranslucentMesh().GetBytes();
+  }
+  // a hash node per edit: the entry, the next pointer and a bucket
+  size_t edit_bytes = 0;
+  for (const pair<const ChunkCoordinates, ChunkEdits>& chunk_edits :
+       player_map_edits_) {
+    edit_bytes += chunk_edits.second.size() *
+                  (sizeof(pair<const size_t, BlockTypes>) + 2 * sizeof(void*));
+  }
+  metrics_.loaded_chunks->Set(double(loaded_chunks));
+  metrics_.pending_chunks->Set(
+      double(chunks_.GetSlots().size() - loaded_chunks));
+  metrics_.blocks->Set(double(blocks));
+  metrics_.voxel_bytes->Set(double(voxel_bytes));
+  metrics_.mesh_bytes->Set(double(mesh_bytes));
+  metrics_.block_bytes->Set(double(blocks * sizeof(Block)));
+  metrics_.edit_bytes->Set(double(edit_bytes));
+}
+
+BlockTypes World::GetBlockAt(const vec3& transform) {
+  ivec3 lattice_point = ivec3(glm::round(transform));
+  const Chunk* chunk = chunks_.Find(GetChunkOf(lattice_point));
+  if (chunk == nullptr) {
+    return BlockTypes::kNone;
+  }
+  return chunk->GetBlockAt(lattice_point);
+}
+
+int World::GetColumnTop(int x, int z) const {
+  ChunkCoordinates column = GetChunkOf(ivec3(x, 0, z));
+  const ChunkCoordinates& center = chunks_.GetCenter();
+  for (int y = center.y + chunks_.GetRadius();
+       y >= center.y - chunks_.GetRadius(); --y) {
+    const Chunk* chunk = chunks_.Find(ChunkCoordinates{column.x, y, column.z});
+    if (chunk == nullptr) {
+      continue;
+    }
+    ivec3 min_corner = chunk->GetMinCorner();
+    int top = chunk->GetColumnTop(x - min_corner.x, z - min_corner.z);
+    if (top != Chunk::kNoSolidBlock) {
+      return min_corner.y + top;
+    }
+  }
+  return kNoColumnTop;
+}
+
+BlockTypes World::SetBlockAt(const vec3& transform,
+                             const BlockTypes& block_type) {
+  ivec3 lattice_point = ivec3(glm::round(transform));
+  vector<BlockChange> changes =
+      ApplyEdits({BlockEdit{lattice_point, block_type}});
+  return changes.empty() ? block_type : changes.front().previous_block_type;
+}
+
+vector<BlockTypes> World::GetChunkBlocks(const ChunkCoordinates& chunk) {
+  const Chunk* loaded = chunks_.Find(chunk);
+  if (loaded != nullptr) {
+    const VoxelArray& voxels = loaded->GetVoxels();
+    return vector<BlockTypes>(voxels.begin(), voxels.end());
+  }
+  Chunk generated(GetChunkMinCorner(chunk), 2 * int(chunk_radius_));
+  GenerateVoxels(chunk, &generated);
+  const VoxelArray& voxels = generated.GetVoxels();
+  return vector<BlockTypes>(voxels.begin(), voxels.end());
+}
+
+ChunkSnapshot World::GetChunkSnapshot(const ChunkCoordinates& chunk) {
+  const Chunk* loaded = chunks_.Find(chunk);
+  if (loaded != nullptr) {
+    return loaded->GetSnapshot();
+  }
+  Chunk generated(GetChunkMinCorner(chunk), 2 * int(chunk_radius_));
+  GenerateVoxels(chunk, &generated);
+  return generated.GetSnapshot();
+}
+
+WorldSnapshot World::GetSnapshot() const {
+  WorldSnapshot snapshot(chunk_radius_);
+  for (const ChunkWindow::Slot& slot : chunks_.GetSlots()) {
+    if (slot.loaded) {
+      snapshot.Add(slot.coordinates, slot.chunk.GetSnapshot());
+    }
+  }
+  return snapshot;
+}
+
+uint64_t World::GetChunkCopiesCount() const {
+  uint64_t copies_count = 0;
+  for (const ChunkWindow::Slot& slot : chunks_.GetSlots()) {
+    copies_count += slot.chunk.GetCopiesCount();
+  }
+  return copies_count;
+}
+
+size_t World::GetChunkRadius() const {
+  return chunk_radius_;
+}
+
+BlockBox World::GetLoadedBounds() const {
+  const ChunkCoordinates& center = chunks_.GetCenter();
+  int radius = chunks_.GetRadius();
+  ivec3 min_corner = GetChunkMinCorner(ChunkCoordinates{
+      center.x - radius, center.y - radius, center.z - radius});
+  return BlockBox{min_corner, min_corner + ivec3((2 * radius + 1) * 2 *
+                                                     int(chunk_radius_) -
+                                                 1)};
+}
+
+vector<BlockEdit> World::GetEditsIn(const BlockBox& box) const {
+  vector<BlockEdit> edits;
+  int width = 2 * int(chunk_radius_);
+  Chunk layout(ivec3(0), width);
+  for (const pair<const ChunkCoordinates, ChunkEdits>& chunk_edits :
+       player_map_edits_) {
+    ivec3 min_corner = GetChunkMinCorner(chunk_edits.first);
+    if (!box.Intersects(BlockBox{min_corner, min_corner + ivec3(width - 1)})) {
+      continue;
     }
-  } else if (old_chunk[1] != new_chunk[1]) {
-    int direction = new_chunk[1] - old_chunk[1];
-    for (int x = -1; x <= 1; ++x) {
-      for (int z = -1; z <= 1; ++z) {
-        GenerateChunk(new_chunk, x, direction, z);
+    for (const pair<const size_t, BlockTypes>& edit : chunk_edits.second) {
+      ivec3 position = min_corner + layout.GetPosition(edit.first);
+      if (box.Contains(position)) {
+        edits.push_back(BlockEdit{position, edit.second});
       }
     }
-  } else if (old_chunk[2] != new_chunk[2]) {
-    int direction = new_chunk[2] - old_chunk[2];
-    for (int x = -1; x <= 1; ++x) {
-      for (int y = -1; y <= 1; ++y) {
-        GenerateChunk(new_chunk, x, y, direction);
+  }
+  return edits;
+}
+
+TerrainGenerator* World::GetTerrainGenerator() const {
+  return terrain_generator_;
+}
+
+void World::ForEachBlockIn(
+    const BlockBox& box,
+    const function<void(const ivec3&, BlockTypes)>& visitor) {
+  ChunkCoordinates min_chunk = GetChunkOf(box.min_corner);
+  ChunkCoordinates max_chunk = GetChunkOf(box.max_corner);
+  int width = 2 * int(chunk_radius_);
+  Chunk generated(ivec3(0), width);
+  for (int chunk_x = min_chunk.x; chunk_x <= max_chunk.x; ++chunk_x) {
+    for (int chunk_y = min_chunk.y; chunk_y <= max_chunk.y; ++chunk_y) {
+      for (int chunk_z = min_chunk.z; chunk_z <= max_chunk.z; ++chunk_z) {
+        ChunkCoordinates chunk = {chunk_x, chunk_y, chunk_z};
+        const Chunk* voxels = chunks_.Find(chunk);
+        if (voxels == nullptr) {
+          generated = Chunk(GetChunkMinCorner(chunk), width);
+          GenerateVoxels(chunk, &generated);
+          voxels = &generated;
+        }
+        // the part of the box inside this chunk
+        ivec3 low = glm::max(box.min_corner, voxels->GetMinCorner());
+        ivec3 high = glm::min(box.max_corner,
+                              voxels->GetMinCorner() + ivec3(width - 1));
+        for (int x = low.x; x <= high.x; ++x) {
+          for (int y = low.y; y <= high.y; ++y) {
+            for (int z = low.z; z <= high.z; ++z) {
+              ivec3 position(x, y, z);
+              visitor(position, voxels->GetBlockAt(position));
+            }
+          }
+        }
       }
     }
   }
 }
 
-vector<int> World::GetChunk(const vec3& point) const {
-  return vector<int>{int(floor(point.x / (2.0f * chunk_radius_) + 0.5f)),
-                     int(floor(point.y / (2.0f * chunk_radius_) + 0.5f)),
-                     int(floor(point.z / (2.0f * chunk_radius_) + 0.5f))};
+void World::ForEachBlockIn(
+    const BlockSphere& sphere,
+    const function<void(const ivec3&, BlockTypes)>& visitor) {
+  ForEachBlockIn(sphere.GetBounds(),
+                 [&sphere, &visitor](const ivec3& position,
+                                     BlockTypes block_type) {
+                   if (sphere.Contains(position)) {
+                     visitor(position, block_type);
+                   }
+                 });
+}
+
+vector<BlockChange> World::FillBox(const BlockBox& box,
+                                   const BlockTypes& block_type) {
+  vector<BlockEdit> edits;
+  ForEachBlockIn(box, [&edits, block_type](const ivec3& position,
+                                           BlockTypes current_block_type) {
+    if (current_block_type != block_type) {
+      edits.push_back(BlockEdit{position, block_type});
+    }
+  });
+  return ApplyEdits(edits);
 }
 
-void World::InitializeAdjacentChunks(const vector<int>& origin_chunk) {
-  for (int x = -1; x < 2; ++x) {
-    for (int y = -1; y < 2; ++y) {
-      for (int z = -1; z < 2; ++z) {
-        GenerateChunk(origin_chunk, x, y, z);
+vector<BlockChange> World::ReplaceInBox(const BlockBox& box,
+                                        const BlockTypes& old_block_type,
+                                        const BlockTypes& new_block_type) {
+  vector<BlockEdit> edits;
+  ForEachBlockIn(box, [&edits, old_block_type, new_block_type](
+                          const ivec3& position, BlockTypes block_type) {
+    if (block_type == old_block_type) {
+      edits.push_back(BlockEdit{position, new_block_type});
+    }
+  });
+  return ApplyEdits(edits);
+}
+
+vector<BlockChange> World::ApplyEdits(const vector<BlockEdit>& edits) {
+  for (const BlockEdit& edit : edits) {
+    if (edit.block_type >= BlockRegistry::kBlockTypesCount) {
+      throw std::invalid_argument(std::to_string(edit.block_type) +
+                                  " is not a block type");
+    }
+  }
+
+  // group by chunk, keeping the application order within each chunk
+  vector<pair<ChunkCoordinates, size_t>> order;
+  order.reserve(edits.size());
+  for (size_t i = 0; i < edits.size(); ++i) {
+    order.push_back(
+        pair<ChunkCoordinates, size_t>(GetChunkOf(edits[i].position), i));
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [](const pair<ChunkCoordinates, size_t>& first,
+                      const pair<ChunkCoordinates, size_t>& second) {
+                     return first.first < second.first;
+                   });
+
+  vector<BlockChange> changes;
+  int width = 2 * int(chunk_radius_);
+  size_t group_start = 0;
+  while (group_start < order.size()) {
+    const ChunkCoordinates& chunk = order[group_start].first;
+    size_t group_end = group_start;
+    while (group_end < order.size() && order[group_end].first == chunk) {
+      ++group_end;
+    }
+
+    // the current contents of the chunk: the loaded voxels if there are any,
+    // otherwise the generated terrain with the chunk's edits
+    Chunk* loaded = chunks_.Find(chunk);
+    Chunk generated(GetChunkMinCorner(chunk), width);
+    Chunk* voxels;
+    if (loaded != nullptr) {
+      voxels = loaded;
+    } else {
+      GenerateVoxels(chunk, &generated);
+      voxels = &generated;
+    }
+
+    if (prefetcher_ != nullptr) {
+      prefetcher_->Invalidate(chunk);
+    }
+    ChunkEdits& chunk_edits = player_map_edits_[chunk];
+    // index of each block's change in `changes`, so repeated edits collapse
+    std::unordered_map<size_t, size_t> changed;
+    for (size_t i = group_start; i < group_end; ++i) {
+      const BlockEdit& edit = edits[order[i].second];
+      size_t index = voxels->GetIndex(edit.position);
+      BlockTypes previous_block_type = voxels->GetBlockAt(edit.position);
+      if (previous_block_type == edit.block_type) {
+        continue;
+      }
+      voxels->SetBlock(index, edit.block_type);
+      chunk_edits[index] = edit.block_type;
+      std::unordered_map<size_t, size_t>::iterator existing =
+          changed.find(index);
+      if (existing == changed.end()) {
+        changed[index] = changes.size();
+        changes.push_back(
+            BlockChange{edit.position, previous_block_type, edit.block_type});
+      } else {
+        changes[existing->second].block_type = edit.block_type;
       }
     }
+    if (chunk_edits.empty()) {
+      player_map_edits_.erase(chunk);
+    }
+    if (loaded != nullptr && !changed.empty()) {
+      loaded->RebuildBlocks();
+    }
+    group_start = group_end;
+  }
+
+  // an edit may have been undone later in the same transaction
+  changes.erase(std::remove_if(changes.begin(), changes.end(),
+                               [](const BlockChange& change) {
+                                 return change.previous_block_type ==
+                                        change.block_type;
+                               }),
+                changes.end());
+
+  for (const BlockChange& change : changes) {
+    for (const ivec3& offset : kNeighborhood) {
+      OnNeighborChanged(change.position + offset);
+    }
+  }
+  if (has_metrics_) {
+    metrics_.edits->Add(changes.size());
   }
+  change_bus_.Publish(changes);
+  return changes;
 }
 
-void World::GenerateChunk(vector<int> reference_chunk, int delta_x, int delta_y,
-                          int delta_z) {
-  int origin[] = {2 * (reference_chunk[0] + delta_x) * int(chunk_radius_),
-                  2 * (reference_chunk[1] + delta_y) * int(chunk_radius_),
-                  2 * (reference_chunk[2] + delta_z) * int(chunk_radius_)};
-  int half_width = int(chunk_radius_);
-  for (int x = origin[0] - half_width; x < origin[0] + half_width; x++) {
-    for (int y = origin[1] - half_width; y < origin[1] + half_width; ++y) {
-      for (int z = origin[2] - half_width; z < origin[2] + half_width; ++z) {
-        BlockTypes block_type = GenerateBlockAt(vec3(x, y, z));
-        if (block_type != BlockTypes::kNone) {
-          blocks_.emplace_back(block_type, vec3(x, y, z));
-        }
+vector<BlockChange> World::Tick() {
+  steady_clock::time_point start = steady_clock::now();
+  vector<BlockEdit> edits;
+
+  size_t scheduled_updates = 0;
+  for (const ivec3& position : tick_scheduler_.Advance()) {
+    if (chunks_.Find(GetChunkOf(position)) != nullptr) {
+      UpdateBlock(position, false, &edits);
+      ++scheduled_updates;
+    }
+  }
+
+  size_t random_ticks = 0;
+  size_t active_chunks = 0;
+  for (const ChunkWindow::Slot& slot : chunks_.GetSlots()) {
+    const Chunk& voxels = slot.chunk;
+    if (!slot.loaded || voxels.GetRandomTickingCount() == 0) {
+      continue;
+    }
+    ++active_chunks;
+    uniform_int_distribution<size_t> index_distribution(
+        0, voxels.GetVoxels().size() - 1);
+    for (uint32_t i = 0; i < kRandomTicksPerChunk; ++i) {
+      size_t index = index_distribution(random_);
+      if (BlockRegistry::HasRandomTicks(voxels.GetVoxels()[index])) {
+        UpdateBlock(voxels.GetPosition(index), true, &edits);
+        ++random_ticks;
       }
     }
   }
+
+  vector<BlockChange> changes = ApplyEdits(edits);
+  tick_stats_.tick = tick_scheduler_.GetTick();
+  tick_stats_.scheduled_updates = scheduled_updates;
+  tick_stats_.random_ticks = random_ticks;
+  tick_stats_.active_chunks = active_chunks;
+  tick_stats_.pending_updates = tick_scheduler_.GetPendingCount();
+  tick_stats_.seconds = duration<double>(steady_clock::now() - start).count();
+  change_bus_.Flush(tick_stats_.tick);
+  if (has_metrics_) {
+    UpdateMetrics();
+  }
+  return changes;
 }
 
-BlockTypes World::GetBlockAt(const vec3& transform) {
-  for (const Block& block : blocks_) {
-    if (abs(block.GetCenter().x - transform.x) <= 0.5 &&
-        abs(block.GetCenter().y - transform.y) <= 0.5 &&
-        abs(block.GetCenter().z - transform.z) <= 0.5) {
-      return block.GetType();
+void World::ScheduleUpdate(const ivec3& position, uint32_t delay) {
+  tick_scheduler_.Schedule(position, delay);
+}
+
+const TickStats& World::GetTickStats() const {
+  return tick_stats_;
+}
+
+BlockChangeBus& World::GetChangeBus() {
+  return change_bus_;
+}
+
+void World::UpdateBlock(const ivec3& position, bool random,
+                        vector<BlockEdit>* edits) {
+  switch (GetBlockAt(vec3(position))) {
+    case BlockTypes::kGrass: {
+      // grass under an opaque block dies
+      if (IsCovered(position)) {
+        edits->push_back(BlockEdit{position, BlockTypes::kDirt});
+        return;
+      }
+      if (!random) {
+        return;
+      }
+      // and otherwise spreads to nearby uncovered dirt
+      uniform_int_distribution<int> offset_distribution(-1, 1);
+      ivec3 neighbor = position;
+      neighbor.x += offset_distribution(random_);
+      neighbor.y += offset_distribution(random_);
+      neighbor.z += offset_distribution(random_);
+      if (GetBlockAt(vec3(neighbor)) == BlockTypes::kDirt &&
+          !IsCovered(neighbor)) {
+        edits->push_back(BlockEdit{neighbor, BlockTypes::kGrass});
+      }
+      return;
     }
+    default:
+      return;
   }
-  return BlockTypes::kNone;
 }
 
-BlockTypes World::GenerateBlockAt(const vec3& transform) {
-  if (player_map_edits_.find(transform) != player_map_edits_.end()) {
-    return player_map_edits_.at(transform);
+bool World::IsCovered(const ivec3& position) {
+  return BlockRegistry::IsOpaque(GetBlockAt(vec3(position + ivec3(0, 1, 0))));
+}
+
+void World::OnNeighborChanged(const ivec3& position) {
+  switch (GetBlockAt(vec3(position))) {
+    case BlockTypes::kGrass:
+      if (IsCovered(position)) {
+        ScheduleUpdate(position, kGrassDecayDelay);
+      }
+      return;
+    default:
+      return;
   }
-  return terrain_generator_->GetBlockAt(transform);
 }
 
-int World::GetBlockIndexInDirectionOf(const vec3& origin, const vec3& forward,
-                                      float directional_angle_allowance) const {
+bool World::FindBlockInDirectionOf(const vec3& origin, const vec3& forward,
+                                   float directional_angle_allowance,
+                                   ivec3* position) const {
   float min_distance = FLT_MAX;
-  int closest_block = -1;
-  size_t index = 0;
-  for (const Block& block : blocks_) {
-    vec3 displacement = block.GetCenter() - origin;
-    if (GetAngle(forward, displacement) <= directional_angle_allowance &&
-        length(displacement) < min_distance) {
-      min_distance = length(displacement);
-      closest_block = index;
+  bool found = false;
+  for (const ChunkWindow::Slot& slot : chunks_.GetSlots()) {
+    if (!slot.loaded) {
+      continue;
+    }
+    const VoxelArray& voxels = slot.chunk.GetVoxels();
+    for (size_t index = 0; index < voxels.size(); ++index) {
+      if (!BlockRegistry::IsSolid(voxels[index])) {
+        continue;
+      }
+      ivec3 block_position = slot.chunk.GetPosition(index);
+      vec3 displacement = vec3(block_position) - origin;
+      if (GetAngle(forward, displacement) <= directional_angle_allowance &&
+          length(displacement) < min_distance) {
+        min_distance = length(displacement);
+        *position = block_position;
+        found = true;
+      }
     }
-    ++index;
   }
-  return closest_block;
+  return found;
 }
 
-void World::OutlineBlockInDirectionOf(const vec3& origin, const vec3& forward,
+void World::OutlineBlockInDirectionOf(Renderer* renderer, const vec3& origin,
+                                      const vec3& forward,
                                       float directional_angle_allowance) const {
-  int closest_block =
-      GetBlockIndexInDirectionOf(origin, forward, directional_angle_allowance);
-  if (closest_block != -1) {
-    drawStrokedCube(blocks_.at(closest_block).GetCenter(), vec3(1, 1, 1));
+  ivec3 closest_block;
+  if (FindBlockInDirectionOf(origin, forward, directional_angle_allowance,
+                             &closest_block)) {
+    renderer->DrawStrokedCube(vec3(closest_block), vec3(1, 1, 1));
   }
 }
 
 BlockTypes World::DeleteBlockInDirectionOf(const vec3& origin,
                                            const vec3& forward,
                                            float directional_angle_allowance) {
-  size_t closest_block =
-      GetBlockIndexInDirectionOf(origin, forward, directional_angle_allowance);
-  if (closest_block != -1) {
-    player_map_edits_.insert(pair<vec3, BlockTypes>(
-        blocks_.at(closest_block).GetCenter(), BlockTypes::kNone));
-    BlockTypes deleted_block_type = blocks_.at(closest_block).GetType();
-    blocks_.erase(blocks_.begin() + closest_block);
-    return deleted_block_type;
+  ivec3 closest_block;
+  if (FindBlockInDirectionOf(origin, forward, directional_angle_allowance,
+                             &closest_block)) {
+    return SetBlockAt(vec3(closest_block), BlockTypes::kNone);
   }
   return BlockTypes::kNone;
 }
@@ -189,19 +768,17 @@ BlockTypes World::DeleteBlockInDirectionOf(const vec3& origin,
 bool World::CreateBlockInDirectionOf(const vec3& origin, const vec3& forward,
                                      const BlockTypes& block_type,
                                      float directional_angle_allowance) {
-  size_t closest_block_index =
-      GetBlockIndexInDirectionOf(origin, forward, directional_angle_allowance);
-  if (closest_block_index == -1) {
+  ivec3 closest_block_position;
+  if (!FindBlockInDirectionOf(origin, forward, directional_angle_allowance,
+                              &closest_block_position)) {
     return false;
   }
-  vec3 closest_block = blocks_.at(closest_block_index).GetCenter();
+  vec3 closest_block(closest_block_position);
   vec3 displacement = origin - closest_block;
   vec3 desired_hit_box =
       FindAxisAlignedUnitVector(displacement) + closest_block;
-  if (GetBlockAt(desired_hit_box) == kNone) {
-    player_map_edits_.insert(
-        pair<vec3, BlockTypes>(desired_hit_box, block_type));
-    blocks_.emplace_back(block_type, desired_hit_box);
+  if (!BlockRegistry::IsSolid(GetBlockAt(desired_hit_box))) {
+    SetBlockAt(desired_hit_box, block_type);
     return true;
   }
   return false;
@@ -221,4 +798,4 @@ vec3 World::FindAxisAlignedUnitVector(const vec3& vector) {
   }
 }
 
-}  // namespace minecraft
\ No newline at end of file
+}  // namespace minecraft
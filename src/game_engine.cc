@@ -1,7 +1,13 @@
 #include "game_engine.h"
 
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
 #include "cinder/Utilities.h"
 #include "cinder/app/Window.h"
+#include "core/block_registry.h"
+#include "core/memory_pool.h"
 #include "core/texture.h"
 
 using ci::CameraPersp;
@@ -16,7 +22,6 @@ using ci::app::setWindowSize;
 using ci::app::Window;
 using ci::gl::clear;
 using ci::gl::drawCube;
-using ci::gl::drawString;
 using ci::gl::drawStrokedCube;
 using ci::gl::enableDepthRead;
 using ci::gl::enableDepthWrite;
@@ -25,14 +30,25 @@ using ci::gl::FboRef;
 using ci::gl::setMatrices;
 using ci::gl::setMatricesWindow;
 using minecraft::Camera;
-using minecraft::Texture;
 using std::pair;
 using std::string;
 using std::to_string;
 using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
 
 namespace minecraft {
 
+/// when static objects were initialized, shortly after the process started
+static const steady_clock::time_point kProcessStart = steady_clock::now();
+
+/// \return the settings of the quality preset the player picked
+static QualitySettings GetQualityPreset(const char* default_preset) {
+  const char* preset = std::getenv("MINECRAFT_QUALITY");
+  return QualityController::GetPreset(preset == nullptr ? default_preset
+                                                        : preset);
+}
+
 const float MinecraftApp::kWindowSize = 575.0f;
 const float MinecraftApp::kCentralPartition = 0.5f;
 const float MinecraftApp::kMoveDistance = 0.8f;
@@ -49,11 +65,13 @@ const float MinecraftApp::kUITextSpacing = 20.0f;
 const float MinecraftApp::kUIIconSpacing = 25.0f;
 const vec2 MinecraftApp::kUIIconSize = vec2(20, 20);
 const float MinecraftApp::kFieldOfViewAngle = 1.0472f;
-const size_t MinecraftApp::kChunkRadius = 2;   // increasing this significantly
-                                               // impacts lag
-const size_t MinecraftApp::kRenderRadius = 8;  // increasing this significantly
-                                               // impacts lag, especially
-                                               // underground
+const char* const MinecraftApp::kDefaultQualityPreset = "medium";
+const float MinecraftApp::kTargetFrameSeconds = 1.0f / 60.0f;
+const size_t MinecraftApp::kStreamedChunksPerUpdate = 4;
+const double MinecraftApp::kMetricsFileSeconds = 5;
+const float MinecraftApp::kEntityStepSeconds = 1.0f / 20.0f;
+const size_t MinecraftApp::kMaxEntitySteps = 4;
+const float MinecraftApp::kEntityCellSize = 2.0f;
 const vec3 MinecraftApp::kPlayerStartingPosition = vec3(0, 10, 0);
 const int MinecraftApp::kMinTerrainHeight = -3;
 const int MinecraftApp::kMaxTerrainHeight = 2;
@@ -66,44 +84,125 @@ const vector<BlockTypes> MinecraftApp::kOrderedBlocks = {
 MinecraftApp::MinecraftApp()
     : seed_(rand() % kMaxSeedLength),
       camera_(kPlayerStartingPosition),
+      quality_(GetQualityPreset(kDefaultQualityPreset), kTargetFrameSeconds,
+               &std::clog),
+      update_seconds_metric_(nullptr),
+      draw_seconds_metric_(nullptr),
+      prefetch_queue_metric_(nullptr),
+      lod_queue_metric_(nullptr),
+      thread_pool_queue_metric_(nullptr),
+      pool_live_bytes_metric_(nullptr),
+      pool_cached_bytes_metric_(nullptr),
+      entities_metric_(nullptr),
       terrain_generator_(kMinTerrainHeight, kMaxTerrainHeight, kTerrainVariance,
                          seed_),
-      world_(&terrain_generator_, kPlayerStartingPosition, kChunkRadius) {
+      world_(&terrain_generator_, kPlayerStartingPosition,
+             quality_.GetSettings().chunk_radius,
+             World::SpawnMode::kProgressive),
+      thread_pool_(ThreadPool::GetDefaultThreadsCount()),
+      lod_(&world_, &thread_pool_, quality_.GetSettings().lod_view_distance),
+      prefetcher_(&world_, &thread_pool_),
+      translucent_sorter_(&world_, &thread_pool_),
+      entity_physics_(&world_, kEntityCellSize),
+      entity_scheduler_(kEntityStepSeconds, kMaxEntitySteps),
+      metrics_exporter_(&metrics_),
+      last_update_seconds_(0),
+      update_seconds_(0),
+      drawn_(false),
+      full_view_(false),
+      current_placing_type_(0),
+      hud_(kUITextFont, kUITextColor),
+      last_allocations_(0) {
   setWindowSize((int)kWindowSize, (int)kWindowSize);
+  lod_.SetMaxBuildsPerUpdate(quality_.GetSettings().lod_builds_per_update);
+  entity_physics_.AddSystems(&entity_scheduler_);
   current_chunk_ = world_.GetChunk(kPlayerStartingPosition);
   for (const BlockTypes& block_type : kOrderedBlocks) {
     inventory_.insert(pair<BlockTypes, size_t>(block_type, 0));
   }
+  SetUpInterface();
+  SetUpMetrics();
+  // distant terrain has to catch up with edits once the player walks away
+  world_.GetChangeBus().Subscribe([this](const BlockChangeBatch& batch) {
+    for (const ChunkChanges& chunk : batch.chunks) {
+      lod_.Invalidate(chunk.bounds);
+    }
+  });
 }
 
 void MinecraftApp::draw() {
-  clear();
-  setMatricesWindow(getWindowSize());
-  DrawCoordinatesInterface();
-  DrawIconsInterface();
-  camera_.Render();
-  world_.Render(camera_.GetTransform(), camera_.GetForwardVector(),
-                kFieldOfViewAngle, kRenderRadius);
-  world_.OutlineBlockInDirectionOf(camera_.GetTransform(),
+  double seconds = getElapsedSeconds();
+  renderer_.Clear();
+  renderer_.SetWindowMatrices(getWindowSize());
+  UpdateInterface();
+  hud_.Draw(&renderer_);
+  camera_.Render(&renderer_);
+  world_.Render(&renderer_, camera_.GetTransform(), camera_.GetForwardVector(),
+                kFieldOfViewAngle, quality_.GetSettings().render_radius);
+  lod_.Render(&renderer_);
+  world_.RenderTranslucent(&renderer_, camera_.GetTransform(),
+                           camera_.GetForwardVector(), kFieldOfViewAngle,
+                           quality_.GetSettings().render_radius);
+  world_.OutlineBlockInDirectionOf(&renderer_, camera_.GetTransform(),
                                    camera_.GetForwardVector(),
                                    kDirectionalAngleAllowance);
+  if (!drawn_) {
+    drawn_ = true;
+    std::clog << "startup: interactive (first frame) after "
+              << duration<double, std::milli>(steady_clock::now() -
+                                              kProcessStart)
+                     .count()
+              << " ms, textures "
+              << (Texture::GetPack() != nullptr ? "mapped from the asset pack"
+                                                : "decoded from PNGs")
+              << std::endl;
+  }
+  float draw_seconds = float(getElapsedSeconds() - seconds);
+  draw_seconds_metric_->Observe(draw_seconds);
+  if (quality_.Record(update_seconds_ + draw_seconds, update_seconds_)) {
+    lod_.SetViewDistance(quality_.GetSettings().lod_view_distance);
+    lod_.SetMaxBuildsPerUpdate(quality_.GetSettings().lod_builds_per_update);
+  }
 }
 
 void MinecraftApp::update() {
+  double seconds = getElapsedSeconds();
   vec2 mouse_point = getWindow()->getMousePos();
   ApplyGravityIfNecessary();
   if (IsBoundedBy(mouse_point, 0, kWindowSize, 0, kWindowSize)) {
     PanScreen(mouse_point);
   }
+  float elapsed_seconds = float(seconds - last_update_seconds_);
+  last_update_seconds_ = seconds;
+  prefetcher_.Update(camera_.GetTransform(), camera_.GetForwardVector(),
+                     elapsed_seconds);
   if (world_.HasMovedChunks(current_chunk_, camera_.GetTransform())) {
-    vector<int> new_chunk = world_.GetChunk(camera_.GetTransform());
+    ChunkCoordinates new_chunk = world_.GetChunk(camera_.GetTransform());
     world_.MoveToChunk(current_chunk_, new_chunk);
     current_chunk_ = new_chunk;
   }
+  if (!full_view_) {
+    world_.StreamChunks(kStreamedChunksPerUpdate);
+    if (world_.GetPendingChunks().empty()) {
+      full_view_ = true;
+      std::clog << "startup: full view after "
+                << duration<double, std::milli>(steady_clock::now() -
+                                                kProcessStart)
+                       .count()
+                << " ms" << std::endl;
+    }
+  }
+  world_.Tick();
+  entity_scheduler_.Advance(&entities_, elapsed_seconds);
+  lod_.Update(camera_.GetTransform());
+  translucent_sorter_.Update(camera_.GetTransform());
+  UpdateMetrics();
+  update_seconds_ = float(getElapsedSeconds() - seconds);
+  update_seconds_metric_->Observe(update_seconds_);
 }
 
 void MinecraftApp::ApplyGravityIfNecessary() {
-  if (BlockExistsAt(0, -kPlayerHeight, 0)) {
+  if (IsOnGround()) {
     camera_.ApplyNormalForce();
   } else {
     camera_.ApplyYForce(-kGravityForce);
@@ -143,9 +242,24 @@ void MinecraftApp::MoveIfPossible(float delta_x, float delta_z) {
   camera_.TransformZ(delta_z);
 }
 
+bool MinecraftApp::IsOnGround() {
+  glm::ivec3 feet(glm::round(camera_.GetTransform() -
+                             vec3(0, kPlayerHeight, 0)));
+  int top = world_.GetColumnTop(feet.x, feet.z);
+  if (top == World::kNoColumnTop || feet.y > top) {
+    return false;
+  }
+  return feet.y == top || BlockExistsAt(0, -kPlayerHeight, 0);
+}
+
 void MinecraftApp::JumpIfPossible() {
-  if (BlockExistsAt(0, -kPlayerHeight, 0)) {
+  if (IsOnGround()) {
+    glm::ivec3 head(glm::round(camera_.GetTransform()));
+    // nothing to bump into above the column top
     int max_height = ceil(kJumpForce * kJumpForce / (2 * kGravityForce));
+    if (world_.GetColumnTop(head.x, head.z) <= head.y) {
+      max_height = 0;
+    }
     for (size_t i = 1; i <= max_height; ++i) {
       if (BlockExistsAt(0, i, 0)) {
         return;
@@ -185,39 +299,99 @@ void MinecraftApp::SwitchCurrentPlacingType(int direction) {
 
 bool MinecraftApp::BlockExistsAt(float delta_x, float delta_y, float delta_z) {
   vec3 location = camera_.GetTransform() + vec3(delta_x, delta_y, delta_z);
-  return world_.GetBlockAt(location) != BlockTypes::kNone;
+  return BlockRegistry::IsSolid(world_.GetBlockAt(location));
 }
 
-void MinecraftApp::DrawCoordinatesInterface() {
-  drawString("seed: " + to_string(seed_), kLeftUITextPosition, kUITextColor,
-             kUITextFont);
-  drawString("x: " + to_string(int(camera_.GetTransform().x)),
-             kLeftUITextPosition + vec2(0, kUITextSpacing), kUITextColor,
-             kUITextFont);
-  drawString("y: " + to_string(int(camera_.GetTransform().y)),
-             kLeftUITextPosition + vec2(0, 2 * kUITextSpacing), kUITextColor,
-             kUITextFont);
-  drawString("z: " + to_string(int(camera_.GetTransform().z)),
-             kLeftUITextPosition + vec2(0, 3 * kUITextSpacing), kUITextColor,
-             kUITextFont);
-}
+void MinecraftApp::SetUpInterface() {
+  size_t seed_text = hud_.AddText(kLeftUITextPosition, "seed: ");
+  hud_.SetValue(seed_text, seed_);
+  const char* coordinate_labels[] = {"x: ", "y: ", "z: "};
+  for (int axis = 0; axis < 3; ++axis) {
+    coordinate_texts_[axis] = hud_.AddText(
+        kLeftUITextPosition + vec2(0, float(axis + 1) * kUITextSpacing),
+        coordinate_labels[axis]);
+  }
+  const char* memory_labels[] = {"live KiB: ", "peak KiB: ", "allocs/frame: "};
+  for (int line = 0; line < 3; ++line) {
+    memory_texts_[line] = hud_.AddText(
+        kLeftUITextPosition + vec2(0, float(line + 4) * kUITextSpacing),
+        memory_labels[line]);
+  }
 
-void MinecraftApp::DrawIconsInterface() {
   for (int i = 0; i < kOrderedBlocks.size(); ++i) {
     vec2 space = vec2(0, float(i) * kUIIconSpacing);
-    Rectf icon(kRightUITextPosition + space,
-               kRightUITextPosition + kUIIconSize + space);
-    ci::gl::draw(Texture::GetIcon(kOrderedBlocks.at(i)), icon);
-    char starred = current_placing_type_ == i ? kUIIconSelectedMarker : ' ';
-    if (current_placing_type_ == i) {
-      vec2 star_offset(-kUITextFont.getSize() / 2, kUIIconSize.y / 4);
-      drawString(string(1, starred), kRightUITextPosition + space + star_offset,
-                 kUITextColor, kUITextFont);
-    }
+    hud_.AddIcon(Rectf(kRightUITextPosition + space,
+                       kRightUITextPosition + kUIIconSize + space),
+                 kOrderedBlocks.at(i));
+    vec2 star_offset(-kUITextFont.getSize() / 2, kUIIconSize.y / 4);
+    selected_markers_.push_back(
+        hud_.AddText(kRightUITextPosition + space + star_offset,
+                     string(1, kUIIconSelectedMarker)));
     vec2 text_offset(kUIIconSize.x, kUIIconSize.y / 4);
-    drawString(": " + to_string(inventory_.at(kOrderedBlocks.at(i))),
-               kRightUITextPosition + space + text_offset, kUITextColor,
-               kUITextFont);
+    inventory_texts_.push_back(
+        hud_.AddText(kRightUITextPosition + space + text_offset, ": "));
+  }
+}
+
+void MinecraftApp::SetUpMetrics() {
+  world_.SetMetrics(&metrics_);
+  update_seconds_metric_ = metrics_.AddHistogram(
+      "minecraft_update_seconds", "Time of each update of the game");
+  draw_seconds_metric_ = metrics_.AddHistogram(
+      "minecraft_draw_seconds", "Time of each draw of the game");
+  const char* queue_help = "Work waiting to be done in the background";
+  prefetch_queue_metric_ = metrics_.AddGauge(
+      "minecraft_generation_queue_depth", queue_help, "queue=\"prefetch\"");
+  lod_queue_metric_ = metrics_.AddGauge("minecraft_generation_queue_depth",
+                                        queue_help, "queue=\"lod\"");
+  thread_pool_queue_metric_ = metrics_.AddGauge(
+      "minecraft_generation_queue_depth", queue_help,
+      "queue=\"thread_pool\"");
+  pool_live_bytes_metric_ =
+      metrics_.AddGauge("minecraft_memory_pool_bytes",
+                        "Bytes of the chunk memory pool", "state=\"live\"");
+  pool_cached_bytes_metric_ =
+      metrics_.AddGauge("minecraft_memory_pool_bytes",
+                        "Bytes of the chunk memory pool", "state=\"cached\"");
+  entities_metric_ = metrics_.AddGauge("minecraft_entities", "Entities");
+
+  const char* port = std::getenv("MINECRAFT_METRICS_PORT");
+  if (port != nullptr) {
+    std::clog << "metrics: serving http://127.0.0.1:"
+              << metrics_exporter_.ServeHttp(uint16_t(std::atoi(port)))
+              << MetricsExporter::kMetricsPath << std::endl;
+  }
+  const char* path = std::getenv("MINECRAFT_METRICS_FILE");
+  if (path != nullptr) {
+    metrics_exporter_.DumpToFile(path, kMetricsFileSeconds);
+  }
+}
+
+void MinecraftApp::UpdateMetrics() {
+  prefetch_queue_metric_->Set(double(prefetcher_.GetPrefetchedCount()));
+  lod_queue_metric_->Set(double(lod_.GetPendingBuildsCount()));
+  thread_pool_queue_metric_->Set(double(thread_pool_.GetQueuedCount()));
+  MemoryPool& pool = MemoryPool::GetDefault();
+  pool_live_bytes_metric_->Set(double(pool.GetStats().live_bytes));
+  pool_cached_bytes_metric_->Set(double(pool.GetCachedBytes()));
+  entities_metric_->Set(double(entities_.GetCount()));
+}
+
+void MinecraftApp::UpdateInterface() {
+  vec3 transform = camera_.GetTransform();
+  hud_.SetValue(coordinate_texts_[0], int(transform.x));
+  hud_.SetValue(coordinate_texts_[1], int(transform.y));
+  hud_.SetValue(coordinate_texts_[2], int(transform.z));
+  MemoryStats memory = MemoryPool::GetDefault().GetStats();
+  hud_.SetValue(memory_texts_[0], int64_t(memory.live_bytes / 1024));
+  hud_.SetValue(memory_texts_[1], int64_t(memory.peak_bytes / 1024));
+  hud_.SetValue(memory_texts_[2],
+                int64_t(memory.allocations - last_allocations_));
+  last_allocations_ = memory.allocations;
+  for (int i = 0; i < kOrderedBlocks.size(); ++i) {
+    hud_.SetVisible(selected_markers_[i], current_placing_type_ == i);
+    hud_.SetValue(inventory_texts_[i],
+                  int64_t(inventory_.at(kOrderedBlocks.at(i))));
   }
 }
 
@@ -0,0 +1,236 @@
+#include "server/connection.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+using minecraft::protocol::AppendFrame;
+using minecraft::protocol::ExtractFrame;
+using minecraft::protocol::Message;
+using minecraft::protocol::MessageType;
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+namespace minecraft {
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+const int kSendFlags = MSG_NOSIGNAL;
+#else
+const int kSendFlags = 0;
+#endif
+
+/// throws with the current `errno` description
+void ThrowSystemError(const string& what) {
+  throw runtime_error(what + ": " + std::strerror(errno));
+}
+
+void SetNonBlocking(int descriptor) {
+  int flags = fcntl(descriptor, F_GETFL, 0);
+  if (flags < 0 || fcntl(descriptor, F_SETFL, flags | O_NONBLOCK) < 0) {
+    ThrowSystemError("fcntl");
+  }
+#ifdef SO_NOSIGPIPE
+  int enable = 1;
+  setsockopt(descriptor, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+}
+
+sockaddr_un MakeUnixAddress(const string& path) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    throw std::invalid_argument(path + " is too long for a socket path");
+  }
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  return address;
+}
+
+sockaddr_in MakeLoopbackAddress(uint16_t port) {
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return address;
+}
+
+}  // namespace
+
+Connection::Connection(int descriptor)
+    : descriptor_(descriptor),
+      input_offset_(0),
+      output_offset_(0),
+      bytes_sent_(0),
+      bytes_received_(0) {
+  SetNonBlocking(descriptor_);
+}
+
+Connection::~Connection() {
+  close(descriptor_);
+}
+
+void Connection::Send(MessageType type, const vector<uint8_t>& payload) {
+  AppendFrame(type, payload, &output_);
+}
+
+bool Connection::Flush() {
+  while (output_offset_ < output_.size()) {
+    ssize_t written = send(descriptor_, output_.data() + output_offset_,
+                           output_.size() - output_offset_, kSendFlags);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      return false;
+    }
+    output_offset_ += size_t(written);
+    bytes_sent_ += uint64_t(written);
+  }
+  if (output_offset_ == output_.size()) {
+    output_.clear();
+    output_offset_ = 0;
+  }
+  return true;
+}
+
+bool Connection::Receive() {
+  if (input_offset_ > 0) {
+    input_.erase(input_.begin(), input_.begin() + input_offset_);
+    input_offset_ = 0;
+  }
+  while (true) {
+    size_t old_size = input_.size();
+    input_.resize(old_size + kReadSize);
+    ssize_t received =
+        recv(descriptor_, input_.data() + old_size, kReadSize, 0);
+    if (received <= 0) {
+      input_.resize(old_size);
+      if (received == 0) {
+        return false;
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    input_.resize(old_size + size_t(received));
+    bytes_received_ += uint64_t(received);
+  }
+}
+
+bool Connection::NextMessage(Message* message) {
+  return ExtractFrame(input_, &input_offset_, message);
+}
+
+bool Connection::HasPendingOutput() const {
+  return output_offset_ < output_.size();
+}
+
+int Connection::GetDescriptor() const {
+  return descriptor_;
+}
+
+uint64_t Connection::GetBytesSent() const {
+  return bytes_sent_;
+}
+
+uint64_t Connection::GetBytesReceived() const {
+  return bytes_received_;
+}
+
+size_t Connection::GetBufferCapacity() const {
+  return input_.capacity() + output_.capacity();
+}
+
+int ListenUnix(const string& path) {
+  sockaddr_un address = MakeUnixAddress(path);
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    ThrowSystemError("socket");
+  }
+  unlink(path.c_str());
+  if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) <
+          0 ||
+      listen(listener, SOMAXCONN) < 0) {
+    close(listener);
+    ThrowSystemError("could not listen on " + path);
+  }
+  SetNonBlocking(listener);
+  return listener;
+}
+
+int ListenTcp(uint16_t port) {
+  sockaddr_in address = MakeLoopbackAddress(port);
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (listener < 0) {
+    ThrowSystemError("socket");
+  }
+  int enable = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) <
+          0 ||
+      listen(listener, SOMAXCONN) < 0) {
+    close(listener);
+    ThrowSystemError("could not listen on port " + std::to_string(port));
+  }
+  SetNonBlocking(listener);
+  return listener;
+}
+
+uint16_t GetListeningPort(int listener) {
+  sockaddr_in address;
+  socklen_t length = sizeof(address);
+  if (getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) <
+      0) {
+    ThrowSystemError("getsockname");
+  }
+  return ntohs(address.sin_port);
+}
+
+int ConnectUnix(const string& path) {
+  sockaddr_un address = MakeUnixAddress(path);
+  int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (descriptor < 0) {
+    ThrowSystemError("socket");
+  }
+  if (connect(descriptor, reinterpret_cast<sockaddr*>(&address),
+              sizeof(address)) < 0) {
+    close(descriptor);
+    ThrowSystemError("could not connect to " + path);
+  }
+  return descriptor;
+}
+
+int ConnectTcp(uint16_t port) {
+  sockaddr_in address = MakeLoopbackAddress(port);
+  int descriptor = socket(AF_INET, SOCK_STREAM, 0);
+  if (descriptor < 0) {
+    ThrowSystemError("socket");
+  }
+  if (connect(descriptor, reinterpret_cast<sockaddr*>(&address),
+              sizeof(address)) < 0) {
+    close(descriptor);
+    ThrowSystemError("could not connect to port " + std::to_string(port));
+  }
+  // edits are tiny and latency-sensitive
+  int enable = 1;
+  setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  return descriptor;
+}
+
+}  // namespace minecraft
@@ -0,0 +1,202 @@
+#include "server/player_swarm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "core/block_registry.h"
+
+using ci::vec3;
+using glm::ivec3;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+namespace minecraft {
+
+namespace {
+
+/// most a random walker turns per second, in radians
+const float kMaxTurnRate = 1.5f;
+
+/// \param samples latencies, reordered
+/// \param percent a percentile
+/// \return the percentile of the samples, or 0 if there are none
+double GetPercentile(vector<double>* samples, size_t percent) {
+  if (samples->empty()) {
+    return 0;
+  }
+  size_t rank = std::min(samples->size() - 1, samples->size() * percent / 100);
+  std::nth_element(samples->begin(), samples->begin() + rank, samples->end());
+  return (*samples)[rank];
+}
+
+}  // namespace
+
+PlayerSwarm::PlayerSwarm(const Settings& settings)
+    : settings_(settings), generator_(settings.seed) {
+  if (settings.reach < 0 || settings.speed < 0) {
+    throw std::invalid_argument("the reach and speed cannot be negative");
+  }
+  ResetStats();
+}
+
+void PlayerSwarm::AddPlayers(size_t count) {
+  std::uniform_real_distribution<float> spread(-settings_.spawn_spread / 2,
+                                               settings_.spawn_spread / 2);
+  std::uniform_real_distribution<float> angle(0, 2 * float(M_PI));
+  for (size_t i = 0; i < count; ++i) {
+    unique_ptr<Player> player(new Player());
+    player->client.ConnectUnix(settings_.socket_path);
+    player->client.SendHello(settings_.view_radius);
+    player->generator.seed(generator_());
+    player->spawn = vec3(spread(generator_), settings_.height,
+                         spread(generator_));
+    player->position = player->spawn;
+    player->heading = angle(generator_);
+    player->waypoint = 0;
+    players_.push_back(std::move(player));
+  }
+}
+
+bool PlayerSwarm::Step(float seconds) {
+  std::uniform_real_distribution<double> chance(0, 1);
+  for (unique_ptr<Player>& player : players_) {
+    Move(player.get(), seconds);
+    player->client.SendPosition(player->position);
+    if (chance(player->generator) < settings_.edits_per_second * seconds) {
+      Edit(player.get());
+    }
+    uint64_t chunks_before = player->client.GetChunksReceivedCount();
+    if (!player->client.Poll()) {
+      return false;
+    }
+    chunks_received_ += player->client.GetChunksReceivedCount() - chunks_before;
+    CheckEdits(player.get());
+  }
+  return true;
+}
+
+SwarmStats PlayerSwarm::GetStats() const {
+  SwarmStats stats = SwarmStats();
+  stats.players = players_.size();
+  stats.seconds = duration<double>(steady_clock::now() - stats_start_).count();
+  stats.chunks_received = chunks_received_;
+  for (const unique_ptr<Player>& player : players_) {
+    stats.chunks_held += player->client.GetChunks().size();
+  }
+  stats.edits_sent = edits_sent_;
+  stats.edits_confirmed = edit_seconds_.size();
+  stats.edits_dropped = edits_dropped_;
+  vector<double> samples = edit_seconds_;
+  stats.p50_edit_seconds = GetPercentile(&samples, 50);
+  stats.p99_edit_seconds = GetPercentile(&samples, 99);
+  stats.max_edit_seconds =
+      samples.empty() ? 0 : *std::max_element(samples.begin(), samples.end());
+  return stats;
+}
+
+void PlayerSwarm::ResetStats() {
+  stats_start_ = steady_clock::now();
+  chunks_received_ = 0;
+  edits_sent_ = 0;
+  edits_dropped_ = 0;
+  edit_seconds_.clear();
+}
+
+size_t PlayerSwarm::GetPlayersCount() const {
+  return players_.size();
+}
+
+const WorldClient& PlayerSwarm::GetClient(size_t player) const {
+  return players_.at(player)->client;
+}
+
+vec3 PlayerSwarm::GetPosition(size_t player) const {
+  return players_.at(player)->position;
+}
+
+void PlayerSwarm::Move(Player* player, float seconds) {
+  float distance = settings_.speed * seconds;
+  if (settings_.movement == SwarmMovement::kRandomWalk) {
+    std::uniform_real_distribution<float> turn(-kMaxTurnRate * seconds,
+                                               kMaxTurnRate * seconds);
+    player->heading += turn(player->generator);
+    player->position += distance * vec3(std::cos(player->heading), 0,
+                                        std::sin(player->heading));
+    return;
+  }
+
+  // walks through as many waypoints as the step reaches
+  const vector<vec3>& waypoints = settings_.waypoints;
+  while (!waypoints.empty() && distance > 0) {
+    vec3 target = player->spawn + waypoints[player->waypoint];
+    vec3 offset = target - player->position;
+    float remaining = glm::length(offset);
+    if (remaining > distance) {
+      player->position += offset * (distance / remaining);
+      return;
+    }
+    player->position = target;
+    distance -= remaining;
+    player->waypoint = (player->waypoint + 1) % waypoints.size();
+    if (waypoints.size() == 1) {
+      return;
+    }
+  }
+}
+
+void PlayerSwarm::Edit(Player* player) {
+  std::uniform_int_distribution<int> offset(-settings_.reach, settings_.reach);
+  ivec3 block(int(std::round(player->position.x)) + offset(player->generator),
+              int(std::round(player->position.y)),
+              int(std::round(player->position.z)) + offset(player->generator));
+  const WorldClient& client = player->client;
+  int lowest = block.y - 2 * settings_.reach;
+  while (block.y >= lowest && client.HoldsBlockAt(block.x, block.y, block.z)) {
+    if (BlockRegistry::IsSolid(client.GetBlockAt(block.x, block.y, block.z))) {
+      break;
+    }
+    --block.y;
+  }
+  if (block.y < lowest || !client.HoldsBlockAt(block.x, block.y, block.z)) {
+    return;
+  }
+
+  BlockEdit edit = {block, BlockTypes::kNone};
+  if (player->generator() % 2 == 0) {
+    // builds on top instead of digging, if the block above is air
+    ivec3 above = block + ivec3(0, 1, 0);
+    if (!client.HoldsBlockAt(above.x, above.y, above.z) ||
+        client.GetBlockAt(above.x, above.y, above.z) != BlockTypes::kNone) {
+      return;
+    }
+    edit = BlockEdit{above, BlockTypes::kStone};
+  }
+  player->client.SendEdit(edit);
+  player->pending_edits.push_back(PendingEdit{edit, steady_clock::now()});
+  ++edits_sent_;
+}
+
+void PlayerSwarm::CheckEdits(Player* player) {
+  steady_clock::time_point now = steady_clock::now();
+  vector<PendingEdit>& pending_edits = player->pending_edits;
+  size_t kept = 0;
+  for (const PendingEdit& pending : pending_edits) {
+    const ivec3& position = pending.edit.position;
+    double seconds = duration<double>(now - pending.sent_at).count();
+    if (player->client.HoldsBlockAt(position.x, position.y, position.z) &&
+        player->client.GetBlockAt(position.x, position.y, position.z) ==
+            pending.edit.block_type) {
+      edit_seconds_.push_back(seconds);
+    } else if (seconds > settings_.edit_timeout_seconds) {
+      ++edits_dropped_;
+    } else {
+      pending_edits[kept++] = pending;
+    }
+  }
+  pending_edits.resize(kept);
+}
+
+}  // namespace minecraft
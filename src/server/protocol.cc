@@ -0,0 +1,227 @@
+#include "server/protocol.h"
+
+#include <cstring>
+#include <stdexcept>
+
+using std::out_of_range;
+using std::runtime_error;
+using std::vector;
+
+namespace minecraft {
+
+namespace protocol {
+
+bool ChunkKey::operator==(const ChunkKey& other) const {
+  return x == other.x && y == other.y && z == other.z;
+}
+
+bool ChunkKey::operator!=(const ChunkKey& other) const {
+  return !(*this == other);
+}
+
+bool ChunkKey::operator<(const ChunkKey& other) const {
+  if (x != other.x) {
+    return x < other.x;
+  } else if (y != other.y) {
+    return y < other.y;
+  }
+  return z < other.z;
+}
+
+ByteWriter::ByteWriter(vector<uint8_t>* buffer) : buffer_(buffer) {
+}
+
+void ByteWriter::WriteU8(uint8_t value) {
+  buffer_->push_back(value);
+}
+
+void ByteWriter::WriteU32(uint32_t value) {
+  for (size_t byte = 0; byte < 4; ++byte) {
+    buffer_->push_back(uint8_t(value >> (8 * byte)));
+  }
+}
+
+void ByteWriter::WriteI32(int32_t value) {
+  WriteU32(uint32_t(value));
+}
+
+void ByteWriter::WriteF32(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  WriteU32(bits);
+}
+
+void ByteWriter::WriteVarUint(uint32_t value) {
+  while (value >= 0x80) {
+    buffer_->push_back(uint8_t(value | 0x80));
+    value >>= 7;
+  }
+  buffer_->push_back(uint8_t(value));
+}
+
+ByteReader::ByteReader(const uint8_t* data, size_t size)
+    : data_(data), size_(size), offset_(0) {
+}
+
+ByteReader::ByteReader(const vector<uint8_t>& buffer)
+    : ByteReader(buffer.data(), buffer.size()) {
+}
+
+uint8_t ByteReader::ReadU8() {
+  Require(1);
+  return data_[offset_++];
+}
+
+uint32_t ByteReader::ReadU32() {
+  Require(4);
+  uint32_t value = 0;
+  for (size_t byte = 0; byte < 4; ++byte) {
+    value |= uint32_t(data_[offset_++]) << (8 * byte);
+  }
+  return value;
+}
+
+int32_t ByteReader::ReadI32() {
+  return int32_t(ReadU32());
+}
+
+float ByteReader::ReadF32() {
+  uint32_t bits = ReadU32();
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+uint32_t ByteReader::ReadVarUint() {
+  uint32_t value = 0;
+  for (size_t shift = 0; shift < 35; shift += 7) {
+    uint8_t byte = ReadU8();
+    value |= uint32_t(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  throw runtime_error("varint is too long");
+}
+
+bool ByteReader::AtEnd() const {
+  return offset_ == size_;
+}
+
+void ByteReader::Require(size_t count) const {
+  if (size_ - offset_ < count) {
+    throw out_of_range("message is truncated");
+  }
+}
+
+void AppendFrame(MessageType type, const vector<uint8_t>& payload,
+                 vector<uint8_t>* out) {
+  ByteWriter writer(out);
+  writer.WriteU32(uint32_t(payload.size()));
+  writer.WriteU8(type);
+  out->insert(out->end(), payload.begin(), payload.end());
+}
+
+bool ExtractFrame(const vector<uint8_t>& buffer, size_t* offset,
+                  Message* message) {
+  if (buffer.size() - *offset < kFrameHeaderSize) {
+    return false;
+  }
+  ByteReader header(buffer.data() + *offset, kFrameHeaderSize);
+  uint32_t payload_size = header.ReadU32();
+  if (payload_size > kMaxPayloadSize) {
+    throw runtime_error("frame of " + std::to_string(payload_size) +
+                        " bytes exceeds the protocol limit");
+  }
+  if (buffer.size() - *offset < kFrameHeaderSize + payload_size) {
+    return false;
+  }
+  message->type = MessageType(header.ReadU8());
+  auto payload_start = buffer.begin() + *offset + kFrameHeaderSize;
+  message->payload.assign(payload_start, payload_start + payload_size);
+  *offset += kFrameHeaderSize + payload_size;
+  return true;
+}
+
+vector<uint8_t> EncodeChunk(const ChunkKey& chunk, const BlockTypes* blocks,
+                            size_t count) {
+  vector<uint8_t> payload;
+  ByteWriter writer(&payload);
+  writer.WriteI32(chunk.x);
+  writer.WriteI32(chunk.y);
+  writer.WriteI32(chunk.z);
+  size_t index = 0;
+  while (index < count) {
+    size_t run_end = index + 1;
+    while (run_end < count && blocks[run_end] == blocks[index]) {
+      ++run_end;
+    }
+    writer.WriteVarUint(uint32_t(run_end - index));
+    writer.WriteU8(uint8_t(blocks[index]));
+    index = run_end;
+  }
+  return payload;
+}
+
+void DecodeChunk(const vector<uint8_t>& payload, size_t volume,
+                 ChunkKey* chunk, vector<BlockTypes>* blocks) {
+  ByteReader reader(payload);
+  chunk->x = reader.ReadI32();
+  chunk->y = reader.ReadI32();
+  chunk->z = reader.ReadI32();
+  blocks->clear();
+  blocks->reserve(volume);
+  while (!reader.AtEnd()) {
+    uint32_t run_length = reader.ReadVarUint();
+    BlockTypes block_type = BlockTypes(reader.ReadU8());
+    if (blocks->size() + run_length > volume) {
+      throw runtime_error("chunk data overflows the chunk volume");
+    }
+    blocks->insert(blocks->end(), run_length, block_type);
+  }
+  if (blocks->size() != volume) {
+    throw runtime_error("chunk data does not fill the chunk volume");
+  }
+}
+
+vector<uint8_t> EncodeDeltas(uint32_t tick, const vector<ChunkDelta>& deltas) {
+  vector<uint8_t> payload;
+  ByteWriter writer(&payload);
+  writer.WriteU32(tick);
+  writer.WriteVarUint(uint32_t(deltas.size()));
+  for (const ChunkDelta& delta : deltas) {
+    writer.WriteI32(delta.chunk.x);
+    writer.WriteI32(delta.chunk.y);
+    writer.WriteI32(delta.chunk.z);
+    writer.WriteVarUint(uint32_t(delta.indices.size()));
+    for (size_t i = 0; i < delta.indices.size(); ++i) {
+      writer.WriteVarUint(delta.indices[i]);
+      writer.WriteU8(uint8_t(delta.block_types[i]));
+    }
+  }
+  return payload;
+}
+
+void DecodeDeltas(const vector<uint8_t>& payload, uint32_t* tick,
+                  vector<ChunkDelta>* deltas) {
+  ByteReader reader(payload);
+  *tick = reader.ReadU32();
+  uint32_t chunk_count = reader.ReadVarUint();
+  deltas->clear();
+  for (uint32_t chunk = 0; chunk < chunk_count; ++chunk) {
+    ChunkDelta delta;
+    delta.chunk.x = reader.ReadI32();
+    delta.chunk.y = reader.ReadI32();
+    delta.chunk.z = reader.ReadI32();
+    uint32_t change_count = reader.ReadVarUint();
+    for (uint32_t change = 0; change < change_count; ++change) {
+      delta.indices.push_back(reader.ReadVarUint());
+      delta.block_types.push_back(BlockTypes(reader.ReadU8()));
+    }
+    deltas->push_back(delta);
+  }
+}
+
+}  // namespace protocol
+
+}  // namespace minecraft
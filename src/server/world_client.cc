@@ -0,0 +1,187 @@
+#include "server/world_client.h"
+
+#include <stdexcept>
+
+using ci::vec3;
+using minecraft::protocol::ByteReader;
+using minecraft::protocol::ByteWriter;
+using minecraft::protocol::ChunkDelta;
+using minecraft::protocol::ChunkKey;
+using minecraft::protocol::Message;
+using std::map;
+using std::string;
+using std::vector;
+
+namespace minecraft {
+
+WorldClient::WorldClient()
+    : welcomed_(false),
+      client_id_(0),
+      seed_(0),
+      chunk_radius_(0),
+      last_delta_tick_(0),
+      delta_batch_count_(0),
+      chunks_received_count_(0) {
+}
+
+void WorldClient::ConnectUnix(const string& path) {
+  connection_.reset(new Connection(minecraft::ConnectUnix(path)));
+}
+
+void WorldClient::ConnectTcp(uint16_t port) {
+  connection_.reset(new Connection(minecraft::ConnectTcp(port)));
+}
+
+void WorldClient::SendHello(uint32_t view_radius) {
+  vector<uint8_t> hello;
+  ByteWriter writer(&hello);
+  writer.WriteU8(protocol::kProtocolVersion);
+  writer.WriteU32(view_radius);
+  connection_->Send(protocol::kHello, hello);
+}
+
+void WorldClient::SendPosition(const vec3& position) {
+  vector<uint8_t> payload;
+  ByteWriter writer(&payload);
+  writer.WriteF32(position.x);
+  writer.WriteF32(position.y);
+  writer.WriteF32(position.z);
+  connection_->Send(protocol::kPosition, payload);
+}
+
+void WorldClient::SendEdit(const BlockEdit& edit) {
+  vector<uint8_t> payload;
+  ByteWriter writer(&payload);
+  writer.WriteI32(edit.position.x);
+  writer.WriteI32(edit.position.y);
+  writer.WriteI32(edit.position.z);
+  writer.WriteU8(uint8_t(edit.block_type));
+  connection_->Send(protocol::kEditRequest, payload);
+}
+
+bool WorldClient::Poll() {
+  if (!connection_->Flush() || !connection_->Receive()) {
+    return false;
+  }
+  Message message;
+  while (connection_->NextMessage(&message)) {
+    HandleMessage(message);
+  }
+  return true;
+}
+
+BlockTypes WorldClient::GetBlockAt(int x, int y, int z) const {
+  const BlockTypes* block = FindBlock(x, y, z);
+  return block == nullptr ? BlockTypes::kNone : *block;
+}
+
+bool WorldClient::HoldsBlockAt(int x, int y, int z) const {
+  return FindBlock(x, y, z) != nullptr;
+}
+
+bool WorldClient::IsWelcomed() const {
+  return welcomed_;
+}
+
+uint32_t WorldClient::GetClientId() const {
+  return client_id_;
+}
+
+int WorldClient::GetSeed() const {
+  return seed_;
+}
+
+const map<ChunkKey, vector<BlockTypes>>& WorldClient::GetChunks() const {
+  return chunks_;
+}
+
+uint32_t WorldClient::GetLastDeltaTick() const {
+  return last_delta_tick_;
+}
+
+uint64_t WorldClient::GetDeltaBatchCount() const {
+  return delta_batch_count_;
+}
+
+uint64_t WorldClient::GetChunksReceivedCount() const {
+  return chunks_received_count_;
+}
+
+uint64_t WorldClient::GetBytesSent() const {
+  return connection_->GetBytesSent();
+}
+
+uint64_t WorldClient::GetBytesReceived() const {
+  return connection_->GetBytesReceived();
+}
+
+void WorldClient::HandleMessage(const Message& message) {
+  if (message.type == protocol::kWelcome) {
+    ByteReader reader(message.payload);
+    client_id_ = reader.ReadU32();
+    seed_ = reader.ReadI32();
+    chunk_radius_ = int(reader.ReadU32());
+    welcomed_ = true;
+  } else if (message.type == protocol::kChunkData) {
+    ChunkKey key;
+    vector<BlockTypes> blocks;
+    protocol::DecodeChunk(message.payload, GetChunkVolume(), &key, &blocks);
+    chunks_[key].swap(blocks);
+    ++chunks_received_count_;
+  } else if (message.type == protocol::kChunkUnload) {
+    ByteReader reader(message.payload);
+    ChunkKey key;
+    key.x = reader.ReadI32();
+    key.y = reader.ReadI32();
+    key.z = reader.ReadI32();
+    chunks_.erase(key);
+  } else if (message.type == protocol::kBlockDeltas) {
+    vector<ChunkDelta> deltas;
+    protocol::DecodeDeltas(message.payload, &last_delta_tick_, &deltas);
+    for (const ChunkDelta& delta : deltas) {
+      map<ChunkKey, vector<BlockTypes>>::iterator chunk =
+          chunks_.find(delta.chunk);
+      if (chunk == chunks_.end()) {
+        continue;
+      }
+      for (size_t i = 0; i < delta.indices.size(); ++i) {
+        if (delta.indices[i] >= chunk->second.size()) {
+          throw std::runtime_error("block change outside of its chunk");
+        }
+        chunk->second[delta.indices[i]] = delta.block_types[i];
+      }
+    }
+    ++delta_batch_count_;
+  }
+}
+
+const BlockTypes* WorldClient::FindBlock(int x, int y, int z) const {
+  if (!welcomed_) {
+    return nullptr;
+  }
+  int width = 2 * chunk_radius_;
+  // inverse of `World::GetChunk` for lattice points
+  int lattice[] = {x, y, z};
+  int chunk[3];
+  int local[3];
+  for (size_t axis = 0; axis < 3; ++axis) {
+    int shifted = lattice[axis] + chunk_radius_;
+    chunk[axis] =
+        shifted >= 0 ? shifted / width : -((width - 1 - shifted) / width);
+    local[axis] = shifted - chunk[axis] * width;
+  }
+  ChunkKey key = {chunk[0], chunk[1], chunk[2]};
+  map<ChunkKey, vector<BlockTypes>>::const_iterator found = chunks_.find(key);
+  if (found == chunks_.end()) {
+    return nullptr;
+  }
+  size_t index = size_t((local[0] * width + local[1]) * width + local[2]);
+  return &found->second[index];
+}
+
+size_t WorldClient::GetChunkVolume() const {
+  size_t width = size_t(2 * chunk_radius_);
+  return width * width * width;
+}
+
+}  // namespace minecraft
@@ -0,0 +1,327 @@
+#include "server/world_server.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+
+#include "core/block_registry.h"
+
+using ci::vec3;
+using minecraft::protocol::ByteReader;
+using minecraft::protocol::ByteWriter;
+using minecraft::protocol::ChunkDelta;
+using minecraft::protocol::ChunkKey;
+using minecraft::protocol::Message;
+using std::map;
+using std::pair;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+namespace minecraft {
+
+namespace {
+
+/// a node of `Client::sent_chunks`: the key plus the three pointers and the
+/// color of a red-black tree node
+const size_t kSentChunkBytes = sizeof(ChunkKey) + 4 * sizeof(void*);
+
+}  // namespace
+
+WorldServer::WorldServer(const Settings& settings)
+    : settings_(settings),
+      terrain_generator_(settings.min_terrain_height,
+                         settings.max_terrain_height, settings.terrain_variance,
+                         settings.seed),
+      world_(&terrain_generator_, vec3(0, 0, 0), settings.chunk_radius),
+      listener_(-1),
+      next_client_id_(1),
+      tick_(0),
+      last_tick_seconds_(0) {
+  if (!settings.save_directory.empty()) {
+    journal_.reset(
+        new EditJournal(settings.save_directory, settings.chunk_radius));
+    world_.ApplyEdits(journal_->GetRecoveredEdits());
+    // the recovered edits are saved already and no client has seen the
+    // world yet, so nobody needs to hear about them
+    world_.GetChangeBus().Flush(0);
+    EditJournal* journal = journal_.get();
+    world_.GetChangeBus().Subscribe([journal](const BlockChangeBatch& batch) {
+      vector<BlockChange> changes;
+      changes.reserve(batch.GetChangesCount());
+      for (const ChunkChanges& chunk : batch.chunks) {
+        changes.insert(changes.end(), chunk.changes.begin(),
+                       chunk.changes.end());
+      }
+      journal->Append(changes);
+    });
+  }
+  world_.GetChangeBus().Subscribe(
+      [this](const BlockChangeBatch& batch) { ReplicateChanges(batch); });
+}
+
+WorldServer::~WorldServer() {
+  clients_.clear();
+  if (listener_ >= 0) {
+    close(listener_);
+  }
+  if (!unix_path_.empty()) {
+    unlink(unix_path_.c_str());
+  }
+}
+
+void WorldServer::ListenUnix(const string& path) {
+  listener_ = minecraft::ListenUnix(path);
+  unix_path_ = path;
+}
+
+uint16_t WorldServer::ListenTcp(uint16_t port) {
+  listener_ = minecraft::ListenTcp(port);
+  return GetListeningPort(listener_);
+}
+
+void WorldServer::Tick() {
+  steady_clock::time_point tick_start = steady_clock::now();
+  AcceptClients();
+
+  vector<unique_ptr<Client>> connected_clients;
+  for (unique_ptr<Client>& client : clients_) {
+    steady_clock::time_point start = steady_clock::now();
+    bool connected = ReadClient(client.get());
+    client->stats.service_seconds +=
+        duration<double>(steady_clock::now() - start).count();
+    if (connected) {
+      connected_clients.push_back(std::move(client));
+    }
+  }
+  clients_.swap(connected_clients);
+
+  vector<ChunkDelta> deltas = ApplyPendingEdits();
+
+  for (unique_ptr<Client>& client : clients_) {
+    steady_clock::time_point start = steady_clock::now();
+    if (client->greeted) {
+      SendDeltas(client.get(), deltas);
+      StreamChunks(client.get());
+    }
+    client->connection->Flush();
+    client->stats.bytes_sent = client->connection->GetBytesSent();
+    client->stats.bytes_received = client->connection->GetBytesReceived();
+    client->stats.chunks_held = client->sent_chunks.size();
+    client->stats.memory_bytes =
+        sizeof(Client) + client->sent_chunks.size() * kSentChunkBytes +
+        client->connection->GetBufferCapacity();
+    ++client->stats.ticks;
+    client->stats.service_seconds +=
+        duration<double>(steady_clock::now() - start).count();
+  }
+
+  ++tick_;
+  last_tick_seconds_ =
+      duration<double>(steady_clock::now() - tick_start).count();
+}
+
+uint32_t WorldServer::GetTick() const {
+  return tick_;
+}
+
+double WorldServer::GetLastTickSeconds() const {
+  return last_tick_seconds_;
+}
+
+vector<ClientStats> WorldServer::GetClientStats() const {
+  vector<ClientStats> stats;
+  for (const unique_ptr<Client>& client : clients_) {
+    stats.push_back(client->stats);
+  }
+  return stats;
+}
+
+World& WorldServer::GetWorld() {
+  return world_;
+}
+
+const EditJournal* WorldServer::GetJournal() const {
+  return journal_.get();
+}
+
+void WorldServer::AcceptClients() {
+  if (listener_ < 0) {
+    return;
+  }
+  while (true) {
+    int descriptor = accept(listener_, nullptr, nullptr);
+    if (descriptor < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    unique_ptr<Client> client(new Client());
+    client->connection.reset(new Connection(descriptor));
+    client->greeted = false;
+    client->view_radius = 0;
+    client->stats = ClientStats();
+    client->stats.client_id = next_client_id_++;
+    clients_.push_back(std::move(client));
+  }
+}
+
+bool WorldServer::ReadClient(Client* client) {
+  if (!client->connection->Receive()) {
+    return false;
+  }
+  Message message;
+  try {
+    while (client->connection->NextMessage(&message)) {
+      HandleMessage(client, message);
+    }
+  } catch (const std::exception&) {
+    // a malformed stream cannot be resynchronized
+    return false;
+  }
+  return true;
+}
+
+void WorldServer::HandleMessage(Client* client, const Message& message) {
+  ByteReader reader(message.payload);
+  if (message.type == protocol::kHello) {
+    if (reader.ReadU8() != protocol::kProtocolVersion) {
+      throw std::runtime_error("client speaks another protocol version");
+    }
+    client->view_radius = int(std::min<uint32_t>(
+        reader.ReadU32(), uint32_t(settings_.max_view_radius)));
+    client->greeted = true;
+
+    vector<uint8_t> welcome;
+    ByteWriter writer(&welcome);
+    writer.WriteU32(client->stats.client_id);
+    writer.WriteI32(settings_.seed);
+    writer.WriteU32(uint32_t(settings_.chunk_radius));
+    writer.WriteU32(uint32_t(client->view_radius));
+    client->connection->Send(protocol::kWelcome, welcome);
+  } else if (message.type == protocol::kPosition) {
+    client->position.x = reader.ReadF32();
+    client->position.y = reader.ReadF32();
+    client->position.z = reader.ReadF32();
+  } else if (message.type == protocol::kEditRequest) {
+    BlockEdit edit;
+    edit.position.x = reader.ReadI32();
+    edit.position.y = reader.ReadI32();
+    edit.position.z = reader.ReadI32();
+    uint8_t block_type = reader.ReadU8();
+    if (block_type >= BlockRegistry::kBlockTypesCount) {
+      throw std::runtime_error("unknown block type");
+    }
+    edit.block_type = BlockTypes(block_type);
+    pending_edits_.push_back(edit);
+    ++client->stats.edits_received;
+  }
+}
+
+vector<ChunkDelta> WorldServer::ApplyPendingEdits() {
+  world_.ApplyEdits(pending_edits_);
+  pending_edits_.clear();
+  world_.Tick();
+  vector<ChunkDelta> deltas;
+  deltas.swap(tick_deltas_);
+  return deltas;
+}
+
+void WorldServer::ReplicateChanges(const BlockChangeBatch& batch) {
+  int width = 2 * int(settings_.chunk_radius);
+  for (const ChunkChanges& chunk : batch.chunks) {
+    ChunkDelta delta;
+    delta.chunk = ChunkKey{chunk.chunk.x, chunk.chunk.y, chunk.chunk.z};
+    glm::ivec3 min_corner = GetChunkMinCorner(delta.chunk);
+    for (const BlockChange& change : chunk.changes) {
+      glm::ivec3 local = change.position - min_corner;
+      delta.indices.push_back(
+          uint32_t((local.x * width + local.y) * width + local.z));
+      delta.block_types.push_back(change.block_type);
+    }
+    tick_deltas_.push_back(std::move(delta));
+  }
+}
+
+void WorldServer::StreamChunks(Client* client) {
+  ChunkKey center = GetChunkKey(client->position);
+  int radius = client->view_radius;
+
+  // chunks are kept until they are one chunk beyond the view, so that walking
+  // back and forth over a border does not resend them
+  for (auto it = client->sent_chunks.begin();
+       it != client->sent_chunks.end();) {
+    if (std::abs(it->x - center.x) > radius + 1 ||
+        std::abs(it->y - center.y) > radius + 1 ||
+        std::abs(it->z - center.z) > radius + 1) {
+      vector<uint8_t> unload;
+      ByteWriter writer(&unload);
+      writer.WriteI32(it->x);
+      writer.WriteI32(it->y);
+      writer.WriteI32(it->z);
+      client->connection->Send(protocol::kChunkUnload, unload);
+      it = client->sent_chunks.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  vector<pair<int, ChunkKey>> missing;
+  for (int x = -radius; x <= radius; ++x) {
+    for (int y = -radius; y <= radius; ++y) {
+      for (int z = -radius; z <= radius; ++z) {
+        ChunkKey key = {center.x + x, center.y + y, center.z + z};
+        if (client->sent_chunks.count(key) == 0) {
+          missing.push_back(pair<int, ChunkKey>(x * x + y * y + z * z, key));
+        }
+      }
+    }
+  }
+  size_t budget = std::min(missing.size(), settings_.chunks_per_tick);
+  std::partial_sort(missing.begin(), missing.begin() + budget, missing.end());
+  for (size_t i = 0; i < budget; ++i) {
+    const ChunkKey& key = missing[i].second;
+    ChunkSnapshot snapshot =
+        world_.GetChunkSnapshot(ChunkCoordinates{key.x, key.y, key.z});
+    const VoxelArray& voxels = snapshot.GetVoxels();
+    client->connection->Send(
+        protocol::kChunkData,
+        protocol::EncodeChunk(key, voxels.data(), voxels.size()));
+    client->sent_chunks.insert(key);
+    ++client->stats.chunks_sent;
+  }
+}
+
+void WorldServer::SendDeltas(Client* client, const vector<ChunkDelta>& deltas) {
+  vector<ChunkDelta> visible_deltas;
+  for (const ChunkDelta& delta : deltas) {
+    if (client->sent_chunks.count(delta.chunk) != 0) {
+      visible_deltas.push_back(delta);
+    }
+  }
+  if (!visible_deltas.empty()) {
+    client->connection->Send(protocol::kBlockDeltas,
+                             protocol::EncodeDeltas(tick_, visible_deltas));
+  }
+}
+
+ChunkKey WorldServer::GetChunkKey(const vec3& point) const {
+  ChunkCoordinates chunk = world_.GetChunk(point);
+  ChunkKey key = {chunk.x, chunk.y, chunk.z};
+  return key;
+}
+
+glm::ivec3 WorldServer::GetChunkMinCorner(const ChunkKey& key) const {
+  int half_width = int(settings_.chunk_radius);
+  return glm::ivec3(key.x, key.y, key.z) * (2 * half_width) -
+         glm::ivec3(half_width);
+}
+
+}  // namespace minecraft
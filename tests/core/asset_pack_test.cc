@@ -0,0 +1,131 @@
+#include "core/asset_pack.h"
+
+#include <unistd.h>
+
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using minecraft::AssetImage;
+using minecraft::AssetPack;
+using minecraft::PackedImage;
+using std::string;
+using std::vector;
+
+namespace {
+
+/// a path under /tmp, removed on destruction
+class TemporaryFile {
+ public:
+  TemporaryFile() {
+    char path[] = "/tmp/minecraft-pack-XXXXXX";
+    int descriptor = mkstemp(path);
+    close(descriptor);
+    path_ = path;
+  }
+  ~TemporaryFile() {
+    std::remove(path_.c_str());
+  }
+  const string& GetPath() const {
+    return path_;
+  }
+
+ private:
+  string path_;
+};
+
+/// \return an image whose pixels are all `value`
+AssetImage MakeImage(const string& name, uint32_t width, uint32_t height,
+                     uint8_t value) {
+  return AssetImage{name, width, height,
+                    vector<uint8_t>(size_t(width) * height * 4, value)};
+}
+
+void WriteFile(const string& path, const string& contents) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << contents;
+}
+
+}  // namespace
+
+TEST_CASE("Asset packs") {
+  TemporaryFile file;
+
+  SECTION("Images are mapped as they were packed") {
+    AssetImage atlas = MakeImage("atlas", 6, 3, 0);
+    for (size_t byte = 0; byte < atlas.pixels.size(); ++byte) {
+      atlas.pixels[byte] = uint8_t(byte);
+    }
+    AssetPack::Write(file.GetPath(),
+                     {atlas, MakeImage("grass_icon.png", 5, 5, 200)}, false);
+    AssetPack pack(file.GetPath());
+
+    REQUIRE(pack.GetNames() == vector<string>{"atlas", "grass_icon.png"});
+    const PackedImage* packed = pack.Find("atlas");
+    REQUIRE(packed != nullptr);
+    REQUIRE(packed->width == 6);
+    REQUIRE(packed->height == 3);
+    REQUIRE(packed->levels_count == 1);
+    REQUIRE(vector<uint8_t>(packed->pixels,
+                            packed->pixels + packed->GetBytes()) ==
+            atlas.pixels);
+    // pixels are aligned for the upload
+    REQUIRE(reinterpret_cast<uintptr_t>(pack.Find("grass_icon.png")->pixels) %
+                64 ==
+            0);
+    REQUIRE(pack.Find("dirt_icon.png") == nullptr);
+  }
+
+  SECTION("Mipmaps are box filtered down to 1x1") {
+    AssetImage image = MakeImage("checker", 4, 2, 0);
+    for (size_t pixel = 0; pixel < 8; ++pixel) {
+      for (size_t channel = 0; channel < 4; ++channel) {
+        image.pixels[pixel * 4 + channel] = pixel % 2 == 0 ? 0 : 100;
+      }
+    }
+    AssetPack::Write(file.GetPath(), {image}, true);
+    AssetPack pack(file.GetPath());
+
+    const PackedImage* packed = pack.Find("checker");
+    REQUIRE(packed->levels_count == 3);
+    REQUIRE(packed->GetWidth(1) == 2);
+    REQUIRE(packed->GetHeight(1) == 1);
+    REQUIRE(packed->GetWidth(2) == 1);
+    REQUIRE(packed->GetBytes() == (8 + 2 + 1) * 4);
+    REQUIRE(packed->GetLevel(1)[0] == 50);
+    REQUIRE(packed->GetLevel(2)[4 - 1] == 50);
+  }
+
+  SECTION("Invalid images are not packed") {
+    REQUIRE_THROWS_AS(AssetPack::Write(file.GetPath(),
+                                       {AssetImage{"short", 2, 2, {1, 2, 3}}},
+                                       false),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(AssetPack::Write(file.GetPath(),
+                                       {MakeImage(string(44, 'x'), 1, 1, 0)},
+                                       false),
+                      std::invalid_argument);
+  }
+
+  SECTION("Files that are not packs are rejected") {
+    WriteFile(file.GetPath(), "PNG\r\n\x1a\n this is not a pack at all");
+    REQUIRE_THROWS_AS(AssetPack(file.GetPath()), std::runtime_error);
+  }
+
+  SECTION("Truncated packs are rejected") {
+    AssetPack::Write(file.GetPath(), {MakeImage("atlas", 64, 64, 1)}, false);
+    std::ifstream stream(file.GetPath(), std::ios::binary);
+    string contents((std::istreambuf_iterator<char>(stream)),
+                    std::istreambuf_iterator<char>());
+    WriteFile(file.GetPath(), contents.substr(0, contents.size() / 2));
+    REQUIRE_THROWS_AS(AssetPack(file.GetPath()), std::runtime_error);
+  }
+
+  SECTION("Missing packs are rejected") {
+    REQUIRE_THROWS_AS(AssetPack("/nonexistent/assets.pack"),
+                      std::runtime_error);
+  }
+}
@@ -0,0 +1,154 @@
+#include "core/block_change_bus.h"
+
+#include <catch2/catch.hpp>
+
+#include "core/world.h"
+
+using ci::vec3;
+using glm::ivec3;
+using minecraft::BlockBox;
+using minecraft::BlockChange;
+using minecraft::BlockChangeBatch;
+using minecraft::BlockChangeBus;
+using minecraft::BlockTypes;
+using minecraft::ChunkCoordinates;
+using minecraft::TerrainGenerator;
+using minecraft::World;
+using std::vector;
+
+TEST_CASE("Block change bus") {
+  BlockChangeBus bus(2);
+  vector<BlockChangeBatch> received;
+  bus.Subscribe([&received](const BlockChangeBatch& batch) {
+    received.push_back(batch);
+  });
+
+  SECTION("A tick's changes arrive as one batch grouped by chunk") {
+    bus.Publish({BlockChange{ivec3(0, 0, 0), BlockTypes::kDirt,
+                             BlockTypes::kNone},
+                 BlockChange{ivec3(5, 0, 0), BlockTypes::kNone,
+                             BlockTypes::kStone}});
+    bus.Publish({BlockChange{ivec3(1, -1, 1), BlockTypes::kStone,
+                             BlockTypes::kNone}});
+    REQUIRE(received.empty());
+    bus.Flush(7);
+
+    REQUIRE(received.size() == 1);
+    const BlockChangeBatch& batch = received.front();
+    REQUIRE(batch.tick == 7);
+    REQUIRE(batch.GetChangesCount() == 3);
+    REQUIRE(batch.chunks.size() == 2);
+    REQUIRE(batch.chunks[0].chunk == ChunkCoordinates{0, 0, 0});
+    REQUIRE(batch.chunks[0].changes.size() == 2);
+    REQUIRE(batch.chunks[0].bounds.min_corner == ivec3(0, -1, 0));
+    REQUIRE(batch.chunks[0].bounds.max_corner == ivec3(1, 0, 1));
+    REQUIRE(batch.chunks[1].chunk == ChunkCoordinates{1, 0, 0});
+
+    bus.Flush(8);
+    REQUIRE(received.size() == 1);
+  }
+
+  SECTION("Repeated changes of a block coalesce") {
+    bus.Publish({BlockChange{ivec3(0, 0, 0), BlockTypes::kDirt,
+                             BlockTypes::kNone}});
+    bus.Publish({BlockChange{ivec3(0, 0, 0), BlockTypes::kNone,
+                             BlockTypes::kStone}});
+    // and a block that ends the tick as it started is dropped
+    bus.Publish({BlockChange{ivec3(3, 0, 0), BlockTypes::kGrass,
+                             BlockTypes::kNone},
+                 BlockChange{ivec3(3, 0, 0), BlockTypes::kNone,
+                             BlockTypes::kGrass}});
+    REQUIRE(bus.GetPendingCount() == 2);
+    bus.Flush(0);
+
+    REQUIRE(received.size() == 1);
+    REQUIRE(received[0].GetChangesCount() == 1);
+    const BlockChange& change = received[0].chunks[0].changes[0];
+    REQUIRE(change.previous_block_type == BlockTypes::kDirt);
+    REQUIRE(change.block_type == BlockTypes::kStone);
+    REQUIRE(bus.GetStats().published_changes == 4);
+    REQUIRE(bus.GetStats().coalesced_changes == 1);
+    REQUIRE(bus.GetStats().notifications == 1);
+  }
+
+  SECTION("Ticks that change nothing notify nobody") {
+    bus.Publish({BlockChange{ivec3(0, 0, 0), BlockTypes::kDirt,
+                             BlockTypes::kNone},
+                 BlockChange{ivec3(0, 0, 0), BlockTypes::kNone,
+                             BlockTypes::kDirt}});
+    bus.Flush(0);
+    REQUIRE(received.empty());
+  }
+
+  SECTION("Subscribers can filter by region") {
+    vector<BlockChangeBatch> nearby;
+    bus.Subscribe(
+        [&nearby](const BlockChangeBatch& batch) { nearby.push_back(batch); },
+        BlockBox{ivec3(-1), ivec3(1)});
+    bus.Publish({BlockChange{ivec3(10, 0, 0), BlockTypes::kNone,
+                             BlockTypes::kStone}});
+    bus.Flush(0);
+    REQUIRE(received.size() == 1);
+    REQUIRE(nearby.empty());
+
+    bus.Publish({BlockChange{ivec3(1, 1, 1), BlockTypes::kNone,
+                             BlockTypes::kStone},
+                 BlockChange{ivec3(1, 1, 2), BlockTypes::kNone,
+                             BlockTypes::kStone}});
+    bus.Flush(1);
+    REQUIRE(received.back().GetChangesCount() == 2);
+    REQUIRE(nearby.size() == 1);
+    REQUIRE(nearby[0].GetChangesCount() == 1);
+    REQUIRE(nearby[0].chunks[0].changes[0].position == ivec3(1, 1, 1));
+    REQUIRE(nearby[0].chunks[0].bounds.max_corner == ivec3(1, 1, 1));
+  }
+
+  SECTION("Unsubscribed subscribers are not notified") {
+    size_t calls = 0;
+    size_t subscription =
+        bus.Subscribe([&calls](const BlockChangeBatch&) { ++calls; });
+    bus.Unsubscribe(subscription);
+    bus.Publish({BlockChange{ivec3(0), BlockTypes::kNone, BlockTypes::kDirt}});
+    bus.Flush(0);
+    REQUIRE(calls == 0);
+    REQUIRE(received.size() == 1);
+  }
+
+  SECTION("Changes made while notifying belong to the next tick") {
+    bus.Subscribe([&bus](const BlockChangeBatch& batch) {
+      if (batch.tick == 0) {
+        bus.Publish(
+            {BlockChange{ivec3(9), BlockTypes::kNone, BlockTypes::kDirt}});
+      }
+    });
+    bus.Publish({BlockChange{ivec3(0), BlockTypes::kNone, BlockTypes::kDirt}});
+    bus.Flush(0);
+    REQUIRE(received.size() == 1);
+    REQUIRE(bus.GetPendingCount() == 1);
+    bus.Flush(1);
+    REQUIRE(received.size() == 2);
+    REQUIRE(received[1].chunks[0].changes[0].position == ivec3(9));
+  }
+}
+
+TEST_CASE("World change notifications") {
+  TerrainGenerator terrain_generator(-3, 2, 10.0f, 7);
+  World world(&terrain_generator, vec3(0, 0, 0), 2);
+  vector<BlockChangeBatch> received;
+  world.GetChangeBus().Subscribe([&received](const BlockChangeBatch& batch) {
+    received.push_back(batch);
+  });
+
+  SECTION("One action notifies once per tick however many blocks it touches") {
+    vector<BlockChange> changes =
+        world.FillBox(BlockBox{ivec3(-4, -4, -4), ivec3(4, 4, 4)},
+                      BlockTypes::kStone);
+    world.SetBlockAt(vec3(0, 10, 0), BlockTypes::kDirt);
+    REQUIRE(received.empty());
+    world.Tick();
+
+    REQUIRE(received.size() == 1);
+    REQUIRE(received[0].GetChangesCount() >= changes.size());
+    REQUIRE(received[0].chunks.size() > 1);
+  }
+}
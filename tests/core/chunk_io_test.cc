@@ -0,0 +1,139 @@
+#include "core/chunk_io.h"
+
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <stdexcept>
+
+using minecraft::ChunkIo;
+using minecraft::ChunkIoStats;
+using std::string;
+using std::vector;
+
+namespace {
+
+int RemoveChunkFile(const char* path, const struct stat*, int, struct FTW*) {
+  return std::remove(path);
+}
+
+/// a fresh directory under /tmp, removed on destruction
+class ChunkDirectory {
+ public:
+  ChunkDirectory() {
+    char path[] = "/tmp/minecraft-chunk-io-XXXXXX";
+    path_ = mkdtemp(path);
+  }
+  ~ChunkDirectory() {
+    nftw(path_.c_str(), RemoveChunkFile, 16, FTW_DEPTH | FTW_PHYS);
+  }
+  string GetPath(size_t file) const {
+    return path_ + "/" + std::to_string(file);
+  }
+
+ private:
+  string path_;
+};
+
+/// \return distinct contents for each file, some empty and one larger than a
+/// single transfer is likely to be
+vector<vector<uint8_t>> MakeContents(size_t count) {
+  vector<vector<uint8_t>> contents(count);
+  for (size_t file = 0; file < count; ++file) {
+    size_t size = file % 7 == 0 ? 0 : file * 37;
+    if (file == 5) {
+      size = 3 << 20;
+    }
+    for (size_t i = 0; i < size; ++i) {
+      contents[file].push_back(uint8_t(file * 31 + i));
+    }
+  }
+  return contents;
+}
+
+}  // namespace
+
+TEST_CASE("Chunk I/O") {
+  for (ChunkIo::Backend backend :
+       {ChunkIo::Backend::kIoUring, ChunkIo::Backend::kThreadPool}) {
+    ChunkDirectory directory;
+    ChunkIo chunk_io(backend, 8);
+    if (backend == ChunkIo::Backend::kThreadPool) {
+      REQUIRE(chunk_io.GetBackend() == ChunkIo::Backend::kThreadPool);
+    }
+    REQUIRE(chunk_io.GetQueueDepth() == 8);
+    vector<string> paths;
+    for (size_t file = 0; file < 100; ++file) {
+      paths.push_back(directory.GetPath(file));
+    }
+    vector<vector<uint8_t>> contents = MakeContents(paths.size());
+
+    SECTION("Files are written and read back") {
+      chunk_io.WriteFiles(paths, contents);
+      vector<vector<uint8_t>> read(paths.size());
+      vector<int> times_read(paths.size(), 0);
+      chunk_io.ReadFiles(paths, [&](size_t index, vector<uint8_t>* bytes) {
+        read[index].swap(*bytes);
+        ++times_read[index];
+      });
+      REQUIRE(read == contents);
+      REQUIRE(times_read == vector<int>(paths.size(), 1));
+
+      ChunkIoStats stats = chunk_io.GetStats();
+      REQUIRE(stats.reads == 100);
+      REQUIRE(stats.writes == 100);
+      REQUIRE(stats.bytes_read == stats.bytes_written);
+      REQUIRE(stats.max_queue_depth > 1);
+      REQUIRE(stats.max_queue_depth <= 8);
+      REQUIRE(stats.p50_read_seconds <= stats.p99_read_seconds);
+    }
+
+    SECTION("Writing replaces the contents") {
+      chunk_io.WriteFiles(paths, contents);
+      vector<vector<uint8_t>> shorter(paths.size(), vector<uint8_t>(3, 1));
+      chunk_io.WriteFiles(paths, shorter);
+      vector<vector<uint8_t>> read(paths.size());
+      chunk_io.ReadFiles(paths, [&](size_t index, vector<uint8_t>* bytes) {
+        read[index] = *bytes;
+      });
+      REQUIRE(read == shorter);
+    }
+
+    SECTION("A missing file fails the batch after the others are done") {
+      chunk_io.WriteFiles(paths, contents);
+      paths[50] = directory.GetPath(1000);
+      REQUIRE_THROWS_AS(
+          chunk_io.ReadFiles(paths, [](size_t, vector<uint8_t>*) {}),
+          std::runtime_error);
+      // still usable afterwards
+      size_t read_count = 0;
+      chunk_io.ReadFiles({directory.GetPath(1)},
+                         [&](size_t, vector<uint8_t>*) { ++read_count; });
+      REQUIRE(read_count == 1);
+    }
+
+    SECTION("Exceptions of the handler are passed on") {
+      chunk_io.WriteFiles(paths, contents);
+      REQUIRE_THROWS_AS(chunk_io.ReadFiles(paths,
+                                           [](size_t index, vector<uint8_t>*) {
+                                             if (index == 20) {
+                                               throw std::runtime_error(
+                                                   "corrupt");
+                                             }
+                                           }),
+                        std::runtime_error);
+    }
+
+    SECTION("Mismatched batches are rejected") {
+      REQUIRE_THROWS_AS(chunk_io.WriteFiles(paths, {}),
+                        std::invalid_argument);
+    }
+  }
+
+  SECTION("The queue depth must be positive") {
+    REQUIRE_THROWS_AS(ChunkIo(ChunkIo::Backend::kThreadPool, 0),
+                      std::invalid_argument);
+  }
+}
@@ -0,0 +1,138 @@
+#include "core/chunk_prefetcher.h"
+
+#include <catch2/catch.hpp>
+
+#include "core/world.h"
+
+using ci::vec3;
+using minecraft::BlockTypes;
+using minecraft::ChunkCoordinates;
+using minecraft::ChunkPrefetcher;
+using minecraft::PrefetchStats;
+using minecraft::TerrainGenerator;
+using minecraft::ThreadPool;
+using minecraft::World;
+using std::vector;
+
+namespace {
+
+/// moves the player in steps of 1/60 s, recentering the world whenever it
+/// crosses into another chunk, like the game loop does
+///
+/// \param world world to move in
+/// \param prefetcher the world's prefetcher
+/// \param position the player's position, updated
+/// \param velocity blocks per second
+/// \param steps number of frames
+void Walk(World* world, ChunkPrefetcher* prefetcher, vec3* position,
+          const vec3& velocity, int steps) {
+  const float seconds = 1.0f / 60.0f;
+  for (int step = 0; step < steps; ++step) {
+    *position += velocity * seconds;
+    prefetcher->Update(*position, velocity, seconds);
+    ChunkCoordinates center = world->GetWindowCenter();
+    if (world->HasMovedChunks(center, *position)) {
+      world->MoveToChunk(center, world->GetChunk(*position));
+    }
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Chunk prefetching") {
+  TerrainGenerator terrain_generator(-3, 2, 10.0f, 7);
+  World world(&terrain_generator, vec3(0, 0, 0), 4);
+  ThreadPool thread_pool(2);
+  ChunkPrefetcher prefetcher(&world, &thread_pool);
+  vec3 position(0, 0, 0);
+
+  SECTION("Sprinting never waits for a chunk to be built on the spot") {
+    // a block per frame, eight chunks a second
+    Walk(&world, &prefetcher, &position, vec3(60, 0, 0), 240);
+    const PrefetchStats& stats = prefetcher.GetStats();
+    REQUIRE(world.GetWindowCenter().x >= 28);
+    REQUIRE(stats.misses == 0);
+    REQUIRE(stats.useful >= 28 * 9);
+  }
+
+  SECTION("Prefetched chunks match chunks built on the spot") {
+    world.SetBlockAt(vec3(30, 0, 0), BlockTypes::kStone);
+    Walk(&world, &prefetcher, &position, vec3(0, 0, 30), 20);
+    // edits made after a chunk was queued make it stale
+    world.SetBlockAt(vec3(2, 1, 20), BlockTypes::kDirt);
+    Walk(&world, &prefetcher, &position, vec3(0, 0, 30), 40);
+    REQUIRE(prefetcher.GetStats().useful > 0);
+
+    TerrainGenerator reference_generator(-3, 2, 10.0f, 7);
+    World reference(&reference_generator, vec3(0, 0, 0), 4);
+    reference.SetBlockAt(vec3(30, 0, 0), BlockTypes::kStone);
+    reference.SetBlockAt(vec3(2, 1, 20), BlockTypes::kDirt);
+    reference.MoveToChunk(reference.GetWindowCenter(),
+                          world.GetWindowCenter());
+    for (int x = -1; x <= 1; ++x) {
+      for (int z = -1; z <= 1; ++z) {
+        ChunkCoordinates chunk = world.GetWindowCenter();
+        chunk.x += x;
+        chunk.z += z;
+        REQUIRE(world.GetChunkBlocks(chunk) ==
+                reference.GetChunkBlocks(chunk));
+      }
+    }
+    REQUIRE(world.GetBlockAt(vec3(2, 1, 20)) == BlockTypes::kDirt);
+  }
+
+  SECTION("Standing still prefetches nothing") {
+    for (int step = 0; step < 30; ++step) {
+      prefetcher.Update(position, vec3(1, 0, 0), 1.0f / 60.0f);
+    }
+    REQUIRE(prefetcher.GetStats().requested == 0);
+    REQUIRE(prefetcher.GetPrefetchedCount() == 0);
+  }
+
+  SECTION("Turning back wastes the chunks prefetched ahead") {
+    Walk(&world, &prefetcher, &position, vec3(20, 0, 0), 30);
+    REQUIRE(prefetcher.GetPrefetchedCount() > 0);
+    Walk(&world, &prefetcher, &position, vec3(-20, 0, 0), 120);
+    const PrefetchStats& stats = prefetcher.GetStats();
+    REQUIRE(stats.wasted > 0);
+    REQUIRE(stats.useful + stats.wasted + prefetcher.GetPrefetchedCount() ==
+            stats.requested);
+  }
+}
+
+TEST_CASE("Progressive spawn with prefetching") {
+  TerrainGenerator terrain_generator(-3, 2, 10.0f, 7);
+  World world(&terrain_generator, vec3(1, 1, 1), 4,
+              World::SpawnMode::kProgressive);
+  ThreadPool thread_pool(2);
+  ChunkPrefetcher prefetcher(&world, &thread_pool);
+  size_t pending_count = world.GetPendingChunks().size();
+  REQUIRE(pending_count == 26);
+
+  // standing still, the pending chunks are built on the workers and streamed
+  // in without waiting for them
+  size_t frames = 0;
+  while (!world.GetPendingChunks().empty()) {
+    prefetcher.Update(vec3(1, 1, 1), vec3(1, 0, 0), 1.0f / 60.0f);
+    world.StreamChunks(4);
+    ++frames;
+  }
+  const PrefetchStats& stats = prefetcher.GetStats();
+  REQUIRE(stats.requested == pending_count);
+  REQUIRE(stats.useful == pending_count);
+  REQUIRE(stats.late == 0);
+  REQUIRE(stats.wasted == 0);
+  REQUIRE(frames >= pending_count / 4);
+
+  TerrainGenerator reference_generator(-3, 2, 10.0f, 7);
+  World reference(&reference_generator, vec3(1, 1, 1), 4);
+  for (int x = -1; x <= 1; ++x) {
+    for (int y = -1; y <= 1; ++y) {
+      for (int z = -1; z <= 1; ++z) {
+        ChunkCoordinates chunk{x, y, z};
+        REQUIRE(world.GetChunkBlocks(chunk) ==
+                reference.GetChunkBlocks(chunk));
+      }
+    }
+  }
+}
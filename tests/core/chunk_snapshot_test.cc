@@ -0,0 +1,126 @@
+#include "core/chunk_snapshot.h"
+
+#include <catch2/catch.hpp>
+#include <thread>
+
+#include "core/chunk.h"
+#include "core/world.h"
+
+using ci::vec3;
+using glm::ivec3;
+using minecraft::BlockTypes;
+using minecraft::Chunk;
+using minecraft::ChunkCoordinates;
+using minecraft::ChunkSnapshot;
+using minecraft::TerrainGenerator;
+using minecraft::World;
+using minecraft::WorldSnapshot;
+using std::vector;
+
+typedef std::pair<const ChunkCoordinates, ChunkSnapshot> ChunkEntry;
+
+TEST_CASE("Chunk snapshots") {
+  Chunk chunk(ivec3(-2), 4);
+  chunk.SetBlock(chunk.GetIndex(ivec3(0, 0, 0)), BlockTypes::kStone);
+
+  SECTION("A snapshot shares the voxels until the next write") {
+    ChunkSnapshot snapshot = chunk.GetSnapshot();
+    REQUIRE(&snapshot.GetVoxels() == &chunk.GetSnapshot().GetVoxels());
+    REQUIRE(chunk.GetCopiesCount() == 0);
+
+    chunk.SetBlock(chunk.GetIndex(ivec3(0, 0, 0)), BlockTypes::kDirt);
+    chunk.SetBlock(chunk.GetIndex(ivec3(1, 0, 0)), BlockTypes::kDirt);
+    REQUIRE(chunk.GetCopiesCount() == 1);
+    REQUIRE(snapshot.GetBlockAt(ivec3(0, 0, 0)) == BlockTypes::kStone);
+    REQUIRE(snapshot.GetBlockAt(ivec3(1, 0, 0)) == BlockTypes::kNone);
+    REQUIRE(chunk.GetBlockAt(ivec3(0, 0, 0)) == BlockTypes::kDirt);
+    REQUIRE(chunk.GetBlockAt(ivec3(1, 0, 0)) == BlockTypes::kDirt);
+  }
+
+  SECTION("Writes without a live snapshot do not copy") {
+    { ChunkSnapshot released = chunk.GetSnapshot(); }
+    chunk.SetBlock(chunk.GetIndex(ivec3(1, 1, 1)), BlockTypes::kGrass);
+    chunk.GetVoxels()[0] = BlockTypes::kDirt;
+    REQUIRE(chunk.GetCopiesCount() == 0);
+  }
+
+  SECTION("Moving a shared chunk does not copy the old voxels") {
+    ChunkSnapshot snapshot = chunk.GetSnapshot();
+    chunk.MoveTo(ivec3(2, -2, -2));
+    chunk.SetBlock(0, BlockTypes::kGrass);
+    REQUIRE(chunk.GetCopiesCount() == 0);
+    REQUIRE(chunk.GetBlockAt(ivec3(2, -2, -2)) == BlockTypes::kGrass);
+    REQUIRE(snapshot.GetMinCorner() == ivec3(-2));
+    REQUIRE(snapshot.GetBlockAt(ivec3(0, 0, 0)) == BlockTypes::kStone);
+  }
+}
+
+TEST_CASE("World snapshots") {
+  TerrainGenerator terrain_generator(-3, 2, 10.0f, 7);
+  World world(&terrain_generator, vec3(0, 0, 0), 2);
+  WorldSnapshot snapshot = world.GetSnapshot();
+  REQUIRE(snapshot.GetChunks().size() == 27);
+  BlockTypes before;
+  REQUIRE(snapshot.GetBlockAt(ivec3(1, 0, 1), &before));
+  BlockTypes ignored;
+  REQUIRE_FALSE(snapshot.GetBlockAt(ivec3(100, 0, 0), &ignored));
+
+  SECTION("Edits after a snapshot copy only the chunks they touch") {
+    BlockTypes edited = before == BlockTypes::kStone ? BlockTypes::kDirt
+                                                     : BlockTypes::kStone;
+    world.SetBlockAt(vec3(1, 0, 1), edited);
+    world.SetBlockAt(vec3(0, 1, 0), BlockTypes::kNone);
+    REQUIRE(world.GetChunkCopiesCount() == 1);
+    world.SetBlockAt(vec3(5, 0, 0), BlockTypes::kStone);
+    REQUIRE(world.GetChunkCopiesCount() == 2);
+
+    BlockTypes after;
+    REQUIRE(snapshot.GetBlockAt(ivec3(1, 0, 1), &after));
+    REQUIRE(after == before);
+    REQUIRE(world.GetBlockAt(vec3(1, 0, 1)) == edited);
+    REQUIRE(world.GetSnapshot().GetBlockAt(ivec3(1, 0, 1), &after));
+    REQUIRE(after == edited);
+  }
+
+  SECTION("A reader thread sees the snapshot while the world is edited") {
+    size_t solid = 0;
+    for (const ChunkEntry& chunk : snapshot.GetChunks()) {
+      for (BlockTypes block_type : chunk.second.GetVoxels()) {
+        solid += block_type != BlockTypes::kNone;
+      }
+    }
+    size_t read_solid = 0;
+    std::thread reader([&snapshot, &read_solid]() {
+      for (int pass = 0; pass < 20; ++pass) {
+        size_t count = 0;
+        for (const ChunkEntry& chunk : snapshot.GetChunks()) {
+          for (BlockTypes block_type : chunk.second.GetVoxels()) {
+            count += block_type != BlockTypes::kNone;
+          }
+        }
+        read_solid = count;
+      }
+    });
+    world.FillBox(minecraft::BlockBox{ivec3(-6), ivec3(5)}, BlockTypes::kNone);
+    reader.join();
+    REQUIRE(read_solid == solid);
+
+    // exactly the chunks that changed were copied
+    WorldSnapshot filled = world.GetSnapshot();
+    uint64_t changed_chunks = 0;
+    for (const ChunkEntry& chunk : snapshot.GetChunks()) {
+      changed_chunks += chunk.second.GetVoxels() !=
+                        filled.Find(chunk.first)->GetVoxels();
+    }
+    REQUIRE(changed_chunks > 0);
+    REQUIRE(world.GetChunkCopiesCount() == changed_chunks);
+  }
+
+  SECTION("Snapshots of unloaded chunks are generated") {
+    ChunkSnapshot far = world.GetChunkSnapshot(ChunkCoordinates{10, 0, 0});
+    REQUIRE(far.GetMinCorner() == ivec3(38, -2, -2));
+    vector<BlockTypes> blocks = world.GetChunkBlocks({10, 0, 0});
+    REQUIRE(vector<BlockTypes>(far.GetVoxels().begin(),
+                               far.GetVoxels().end()) == blocks);
+  }
+}
@@ -0,0 +1,100 @@
+#include "core/chunk_window.h"
+
+#include <catch2/catch.hpp>
+#include <set>
+
+using glm::ivec3;
+using minecraft::Chunk;
+using minecraft::ChunkCoordinates;
+using minecraft::ChunkWindow;
+using std::set;
+
+TEST_CASE("Chunk window recentering") {
+  ChunkWindow window(1, 2);
+  set<ChunkCoordinates> loaded;
+  size_t loads = 0;
+  ChunkWindow::Loader load = [&loaded, &loads](
+                                 const ChunkCoordinates& coordinates,
+                                 Chunk* chunk) {
+    REQUIRE(chunk->GetMinCorner() ==
+            ivec3(coordinates.x, coordinates.y, coordinates.z) * 4 - ivec3(2));
+    REQUIRE(loaded.insert(coordinates).second);
+    ++loads;
+  };
+
+  window.Recenter({0, 0, 0}, load);
+  REQUIRE(loads == 27);
+  REQUIRE(window.Find({1, 1, 1}) != nullptr);
+  REQUIRE(window.Find({2, 0, 0}) == nullptr);
+
+  SECTION("Moving one chunk loads one slab") {
+    loaded.clear();
+    loads = 0;
+    window.Recenter({1, 0, 0}, load);
+    REQUIRE(loads == 9);
+    for (const ChunkCoordinates& coordinates : loaded) {
+      REQUIRE(coordinates.x == 2);
+    }
+    REQUIRE(window.Find({2, 0, 0}) != nullptr);
+    REQUIRE(window.Find({-1, 0, 0}) == nullptr);
+    REQUIRE(window.Find({0, 0, 0}) != nullptr);
+  }
+
+  SECTION("Moving diagonally loads each new chunk once") {
+    loaded.clear();
+    loads = 0;
+    window.Recenter({1, -1, 1}, load);
+    REQUIRE(loads == 27 - 2 * 2 * 2);
+    REQUIRE(window.Find({2, -2, 2}) != nullptr);
+    REQUIRE(window.Find({-1, 0, 0}) == nullptr);
+  }
+
+  SECTION("Jumping past the window reloads everything") {
+    loads = 0;
+    loaded.clear();
+    window.Recenter({-10, 0, 5}, load);
+    REQUIRE(loads == 27);
+    REQUIRE(window.Find({-11, 1, 4}) != nullptr);
+  }
+}
+
+TEST_CASE("Chunk window deferred loading") {
+  ChunkWindow window(1, 2);
+  size_t loads = 0;
+  ChunkWindow::Loader load = [&loads](const ChunkCoordinates&, Chunk*) {
+    ++loads;
+  };
+  ChunkWindow::Deferral defer_all_but_center =
+      [](const ChunkCoordinates& coordinates) {
+        return coordinates != ChunkCoordinates{0, 0, 0};
+      };
+
+  window.Recenter({0, 0, 0}, load, defer_all_but_center);
+  REQUIRE(loads == 1);
+  REQUIRE(window.Find({0, 0, 0}) != nullptr);
+  REQUIRE(window.Find({1, 0, 0}) == nullptr);
+  REQUIRE(window.GetPending().size() == 26);
+
+  SECTION("Pending chunks are loaded once") {
+    REQUIRE(window.LoadPending({1, 0, 0}, load));
+    REQUIRE(loads == 2);
+    REQUIRE(window.Find({1, 0, 0}) != nullptr);
+    REQUIRE_FALSE(window.LoadPending({1, 0, 0}, load));
+    REQUIRE_FALSE(window.LoadPending({0, 0, 0}, load));
+    REQUIRE_FALSE(window.LoadPending({5, 0, 0}, load));
+    REQUIRE(window.GetPending().size() == 25);
+  }
+
+  SECTION("Pending chunks stay pending as the window moves") {
+    loads = 0;
+    window.Recenter({1, 0, 0}, load);
+    REQUIRE(loads == 9);
+    set<ChunkCoordinates> pending;
+    for (const ChunkCoordinates& coordinates : window.GetPending()) {
+      pending.insert(coordinates);
+      REQUIRE(coordinates.x >= 0);
+      REQUIRE(coordinates.x <= 1);
+    }
+    REQUIRE(pending.size() == 17);
+  }
+}
@@ -0,0 +1,200 @@
+#include "core/edit_journal.h"
+
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+
+using glm::ivec3;
+using minecraft::BlockChange;
+using minecraft::BlockEdit;
+using minecraft::BlockTypes;
+using minecraft::EditJournal;
+using minecraft::JournalStats;
+using std::string;
+using std::vector;
+
+namespace {
+
+int RemoveEntry(const char* path, const struct stat*, int, struct FTW*) {
+  return std::remove(path);
+}
+
+void RemoveDirectory(const string& path) {
+  nftw(path.c_str(), RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+/// a fresh directory under /tmp, removed on destruction
+class TemporaryDirectory {
+ public:
+  TemporaryDirectory() {
+    char path[] = "/tmp/minecraft-journal-XXXXXX";
+    path_ = mkdtemp(path);
+  }
+  ~TemporaryDirectory() {
+    RemoveDirectory(path_);
+  }
+  const string& GetPath() const {
+    return path_;
+  }
+
+ private:
+  string path_;
+};
+
+string ReadFile(const string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return string(std::istreambuf_iterator<char>(file),
+                std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const string& path, const string& contents) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << contents;
+}
+
+BlockChange MakeChange(const ivec3& position, BlockTypes block_type) {
+  return BlockChange{position, minecraft::kNone, block_type};
+}
+
+/// \return edits sorted by position, so saves can be compared
+vector<BlockEdit> Sorted(vector<BlockEdit> edits) {
+  std::sort(edits.begin(), edits.end(),
+            [](const BlockEdit& first, const BlockEdit& second) {
+              return std::tie(first.position.x, first.position.y,
+                              first.position.z) <
+                     std::tie(second.position.x, second.position.y,
+                              second.position.z);
+            });
+  return edits;
+}
+
+}  // namespace
+
+namespace minecraft {
+
+bool operator==(const BlockEdit& first, const BlockEdit& second) {
+  return first.position == second.position &&
+         first.block_type == second.block_type;
+}
+
+}  // namespace minecraft
+
+TEST_CASE("Edit journal") {
+  TemporaryDirectory directory;
+  const string& save = directory.GetPath();
+  vector<BlockEdit> expected = {BlockEdit{ivec3(-5, 0, 0), minecraft::kNone},
+                                BlockEdit{ivec3(0, 1, 0), minecraft::kGrass},
+                                BlockEdit{ivec3(7, -3, 2), minecraft::kStone}};
+
+  SECTION("Edits survive reopening, later edits win") {
+    {
+      EditJournal journal(save, 2);
+      REQUIRE(journal.GetRecoveredEdits().empty());
+      journal.Append({MakeChange(ivec3(0, 1, 0), minecraft::kStone),
+                      MakeChange(ivec3(-5, 0, 0), minecraft::kNone)});
+      journal.Append({MakeChange(ivec3(0, 1, 0), minecraft::kGrass)});
+      journal.Append({MakeChange(ivec3(7, -3, 2), minecraft::kStone)});
+    }
+    EditJournal journal(save, 2);
+    REQUIRE(Sorted(journal.GetRecoveredEdits()) == expected);
+  }
+
+  SECTION("Flushed edits are durable before any checkpoint") {
+    EditJournal journal(save, 2);
+    journal.Append({MakeChange(ivec3(0, 1, 0), minecraft::kGrass)});
+    journal.Flush();
+
+    JournalStats stats = journal.GetStats();
+    REQUIRE(stats.edits_appended == 1);
+    REQUIRE(stats.edits_durable == 1);
+    REQUIRE(stats.syncs >= 1);
+    REQUIRE(stats.checkpoints == 0);
+    REQUIRE(stats.bytes_written == 8 + 13);
+    REQUIRE(stats.p99_durable_seconds > 0);
+    REQUIRE(stats.GetThroughput() > 0);
+    REQUIRE(ReadFile(save + "/journal").size() == 8 + 13);
+  }
+
+  SECTION("A checkpoint folds the journal into the chunk store") {
+    EditJournal journal(save, 2);
+    journal.Append({MakeChange(ivec3(0, 1, 0), minecraft::kGrass),
+                    MakeChange(ivec3(7, -3, 2), minecraft::kStone)});
+    journal.Checkpoint();
+
+    REQUIRE(ReadFile(save + "/journal").empty());
+    REQUIRE(journal.GetStats().checkpoints == 1);
+    // (0, 1, 0) is in chunk (0, 0, 0), (7, -3, 2) in chunk (2, -1, 1)
+    REQUIRE(ReadFile(save + "/chunks/0_0_0").size() == 4 + 13 + 4);
+    REQUIRE(ReadFile(save + "/chunks/2_-1_1").size() == 4 + 13 + 4);
+  }
+
+  SECTION("The journal checkpoints itself once it is large enough") {
+    EditJournal journal(save, 2, EditJournal::kSyncInterval, 64);
+    for (int x = 0; x < 10; ++x) {
+      journal.Append({MakeChange(ivec3(x, 0, 0), minecraft::kStone)});
+    }
+    journal.Flush();
+    REQUIRE(journal.GetStats().checkpoints >= 1);
+    REQUIRE(ReadFile(save + "/journal").size() < 64);
+  }
+
+  SECTION("Recovery replays the journal up to a torn record") {
+    string journal_contents;
+    {
+      EditJournal journal(save, 2);
+      journal.Append({MakeChange(ivec3(0, 1, 0), minecraft::kStone),
+                      MakeChange(ivec3(-5, 0, 0), minecraft::kNone)});
+      journal.Append({MakeChange(ivec3(0, 1, 0), minecraft::kGrass),
+                      MakeChange(ivec3(7, -3, 2), minecraft::kStone)});
+      journal.Append({MakeChange(ivec3(9, 9, 9), minecraft::kDirt)});
+      journal.Flush();
+      journal_contents = ReadFile(save + "/journal");
+    }
+    // a crash right after the sync: no checkpoint, and half of the last
+    // record made it to disk
+    RemoveDirectory(save + "/chunks");
+    WriteFile(save + "/journal",
+              journal_contents.substr(0, journal_contents.size() - 6));
+
+    {
+      EditJournal journal(save, 2);
+      REQUIRE(Sorted(journal.GetRecoveredEdits()) == expected);
+      REQUIRE(journal.GetStats().checkpoints == 1);
+      REQUIRE(ReadFile(save + "/journal").empty());
+    }
+    EditJournal journal(save, 2);
+    REQUIRE(Sorted(journal.GetRecoveredEdits()) == expected);
+  }
+
+  SECTION("A corrupt record ends the replay") {
+    string journal_contents;
+    {
+      EditJournal journal(save, 2);
+      journal.Append({MakeChange(ivec3(0, 1, 0), minecraft::kGrass)});
+      journal.Append({MakeChange(ivec3(1, 1, 0), minecraft::kGrass)});
+      journal.Flush();
+      journal_contents = ReadFile(save + "/journal");
+    }
+    RemoveDirectory(save + "/chunks");
+    journal_contents[journal_contents.size() - 1] ^= 0x7F;
+    WriteFile(save + "/journal", journal_contents);
+
+    EditJournal journal(save, 2);
+    REQUIRE(journal.GetRecoveredEdits().size() == 1);
+    REQUIRE(journal.GetRecoveredEdits().front().position == ivec3(0, 1, 0));
+  }
+
+  SECTION("A corrupt chunk file is an error") {
+    mkdir((save + "/chunks").c_str(), 0755);
+    WriteFile(save + "/chunks/0_0_0", "garbage");
+    REQUIRE_THROWS_AS(EditJournal(save, 2), std::runtime_error);
+  }
+}
@@ -0,0 +1,106 @@
+#include "core/entity_physics.h"
+
+#include <catch2/catch.hpp>
+
+using glm::vec3;
+using minecraft::BlockTypes;
+using minecraft::Entity;
+using minecraft::EntityPhysics;
+using minecraft::EntityScheduler;
+using minecraft::EntityStore;
+using minecraft::TerrainGenerator;
+using minecraft::World;
+
+namespace {
+
+/// flat ground at y = 0, with a wall 3 blocks high along x = 3
+class WalledTerrainGenerator : public TerrainGenerator {
+ public:
+  WalledTerrainGenerator() : TerrainGenerator(0, 0, 0, 0) {
+  }
+
+  BlockTypes GetBlockAt(const ci::vec3& transform) {
+    if (transform.y <= 0) {
+      return BlockTypes::kStone;
+    } else if (transform.x == 3 && transform.y <= 3) {
+      return BlockTypes::kStone;
+    }
+    return BlockTypes::kNone;
+  }
+};
+
+WalledTerrainGenerator walled_terrain_generator;
+
+/// half the size of the entities of the tests
+const vec3 kHalfExtents(0.3f, 0.9f, 0.3f);
+
+/// height of the entities of the tests standing on the ground
+const float kStandingY = 0.5f + kHalfExtents.y + EntityPhysics::kSkin;
+
+}  // namespace
+
+TEST_CASE("Entity physics") {
+  // loads the blocks from -6 to 5 along each axis
+  World world(&walled_terrain_generator, vec3(0, 0, 0), 2);
+  EntityPhysics physics(&world, 2.0f);
+  EntityScheduler scheduler(0.05f, 10);
+  physics.AddSystems(&scheduler);
+  EntityStore store;
+
+  SECTION("Entities fall onto the ground and stay there") {
+    Entity entity = store.Create(vec3(0, 4, 0), kHalfExtents);
+    scheduler.Advance(&store, 2);
+    size_t slot = store.GetSlot(entity);
+    REQUIRE(store.GetPositions()[slot].y == Approx(kStandingY));
+    REQUIRE(store.GetOnGround()[slot] == 1);
+
+    scheduler.Step(&store);
+    REQUIRE(store.GetPositions()[slot].y == Approx(kStandingY));
+    REQUIRE(store.GetOnGround()[slot] == 1);
+  }
+
+  SECTION("Fast entities do not go through blocks") {
+    store.Create(vec3(0, 4, 0), kHalfExtents);
+    store.GetVelocities()[0] = vec3(0, -1000, 0);
+    physics.Move(&store, 0.05f);
+    REQUIRE(store.GetPositions()[0].y == Approx(kStandingY));
+    REQUIRE(store.GetVelocities()[0].y == 0);
+  }
+
+  SECTION("Walls stop entities") {
+    store.Create(vec3(0, kStandingY, 0), kHalfExtents);
+    store.GetVelocities()[0] = vec3(5, 0, 0);
+    scheduler.Advance(&store, 1);
+    REQUIRE(store.GetPositions()[0].x ==
+            Approx(3 - 0.5f - kHalfExtents.x - EntityPhysics::kSkin));
+    REQUIRE(store.GetVelocities()[0].x == 0);
+  }
+
+  SECTION("Entities wait at the edge of the loaded world") {
+    store.Create(vec3(0, kStandingY, 0), kHalfExtents);
+    store.GetVelocities()[0] = vec3(0, 0, 20);
+    scheduler.Advance(&store, 1);
+    REQUIRE(store.GetPositions()[0].z ==
+            Approx(6 - 0.5f - kHalfExtents.z - EntityPhysics::kSkin));
+  }
+
+  SECTION("Overlapping entities are pushed apart") {
+    store.Create(vec3(0, kStandingY, 0), kHalfExtents);
+    store.Create(vec3(0.2f, kStandingY, 0.1f), kHalfExtents);
+    physics.Separate(&store);
+    REQUIRE(physics.GetPairsCount() == 1);
+    REQUIRE(store.GetPositions()[0].x == Approx(-0.2f));
+    REQUIRE(store.GetPositions()[0].z == 0);
+    REQUIRE(store.GetPositions()[1].x == Approx(0.4f));
+    REQUIRE(store.GetPositions()[1].z == 0.1f);
+  }
+
+  SECTION("Entities are not pushed into blocks") {
+    float against_wall = 3 - 0.5f - kHalfExtents.x - EntityPhysics::kSkin;
+    store.Create(vec3(against_wall - 0.4f, kStandingY, 0), kHalfExtents);
+    store.Create(vec3(against_wall, kStandingY, 0), kHalfExtents);
+    physics.Separate(&store);
+    REQUIRE(store.GetPositions()[0].x == Approx(against_wall - 0.5f));
+    REQUIRE(store.GetPositions()[1].x == Approx(against_wall));
+  }
+}
@@ -0,0 +1,52 @@
+#include "core/entity_scheduler.h"
+
+#include <catch2/catch.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using minecraft::EntityScheduler;
+using minecraft::EntityStore;
+using std::string;
+using std::vector;
+
+TEST_CASE("Entity scheduling") {
+  EntityScheduler scheduler(0.25f, 4);
+  EntityStore store;
+  vector<string> runs;
+  scheduler.AddSystem("first", [&runs](EntityStore*, float seconds) {
+    REQUIRE(seconds == 0.25f);
+    runs.push_back("first");
+  });
+  scheduler.AddSystem("second", [&runs](EntityStore*, float) {
+    runs.push_back("second");
+  });
+
+  SECTION("Systems run in order, once per step") {
+    REQUIRE(scheduler.Advance(&store, 0.25f) == 1);
+    REQUIRE(runs == vector<string>{"first", "second"});
+    REQUIRE(scheduler.GetSystemNames() == vector<string>{"first", "second"});
+    REQUIRE(scheduler.GetSystemSeconds("second") >= 0);
+    REQUIRE_THROWS_AS(scheduler.GetSystemSeconds("third"),
+                      std::invalid_argument);
+  }
+
+  SECTION("Time left over is carried into the next advance") {
+    REQUIRE(scheduler.Advance(&store, 0.375f) == 1);
+    REQUIRE(scheduler.GetInterpolation() == Approx(0.5f));
+    REQUIRE(scheduler.Advance(&store, 0.125f) == 1);
+    REQUIRE(scheduler.Advance(&store, 0.125f) == 0);
+    REQUIRE(scheduler.GetStepsCount() == 2);
+  }
+
+  SECTION("Long stalls are skipped") {
+    REQUIRE(scheduler.Advance(&store, 10) == 4);
+    REQUIRE(scheduler.GetInterpolation() == 0);
+    REQUIRE(scheduler.Advance(&store, 0.25f) == 1);
+  }
+
+  SECTION("Steps must move time forward") {
+    REQUIRE_THROWS_AS(EntityScheduler(0, 1), std::invalid_argument);
+    REQUIRE_THROWS_AS(EntityScheduler(0.25f, 0), std::invalid_argument);
+  }
+}
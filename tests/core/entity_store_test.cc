@@ -0,0 +1,50 @@
+#include "core/entity_store.h"
+
+#include <catch2/catch.hpp>
+#include <stdexcept>
+
+using glm::vec3;
+using minecraft::Entity;
+using minecraft::EntityStore;
+
+TEST_CASE("Entity storage") {
+  EntityStore store;
+  Entity first = store.Create(vec3(1, 0, 0), vec3(0.5f));
+  Entity second = store.Create(vec3(2, 0, 0), vec3(0.25f));
+  Entity third = store.Create(vec3(3, 0, 0), vec3(0.125f));
+
+  SECTION("Components of new entities are stored in order") {
+    REQUIRE(store.GetCount() == 3);
+    REQUIRE(store.GetSlot(second) == 1);
+    REQUIRE(store.GetEntity(2) == third);
+    REQUIRE(store.GetPositions()[1] == vec3(2, 0, 0));
+    REQUIRE(store.GetHalfExtents()[2] == vec3(0.125f));
+    REQUIRE(store.GetVelocities()[0] == vec3(0));
+    REQUIRE(store.GetOnGround()[0] == 0);
+  }
+
+  SECTION("Destroying an entity fills its slot with the last one") {
+    store.GetVelocities()[2] = vec3(0, 1, 0);
+    REQUIRE(store.Destroy(first));
+    REQUIRE(store.GetCount() == 2);
+    REQUIRE_FALSE(store.IsAlive(first));
+    REQUIRE(store.GetSlot(third) == 0);
+    REQUIRE(store.GetPositions()[0] == vec3(3, 0, 0));
+    REQUIRE(store.GetVelocities()[0] == vec3(0, 1, 0));
+    REQUIRE(store.GetSlot(second) == 1);
+  }
+
+  SECTION("Handles of destroyed entities stay invalid") {
+    store.Destroy(second);
+    REQUIRE_FALSE(store.Destroy(second));
+    REQUIRE_THROWS_AS(store.GetSlot(second), std::invalid_argument);
+
+    // the index is reused, with another generation
+    Entity fourth = store.Create(vec3(4, 0, 0), vec3(0.5f));
+    REQUIRE(fourth.index == second.index);
+    REQUIRE(fourth != second);
+    REQUIRE_FALSE(store.IsAlive(second));
+    REQUIRE(store.IsAlive(fourth));
+    REQUIRE(store.GetPositions()[store.GetSlot(fourth)] == vec3(4, 0, 0));
+  }
+}
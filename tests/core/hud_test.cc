@@ -0,0 +1,49 @@
+#include "core/hud.h"
+
+#include <catch2/catch.hpp>
+
+#include "core/headless_renderer.h"
+
+using ci::Color;
+using ci::Font;
+using ci::vec2;
+using minecraft::HeadlessRenderer;
+using minecraft::Hud;
+
+TEST_CASE("Retained HUD") {
+  HeadlessRenderer renderer;
+  Hud hud(Font("Courier-Bold", 18.0f), Color(0, 255, 0));
+  size_t label = hud.AddText(vec2(10, 10), "label");
+  size_t counter = hud.AddText(vec2(10, 30), "x: ");
+  hud.SetValue(counter, 4);
+
+  SECTION("Elements are rasterized once") {
+    hud.Draw(&renderer);
+    REQUIRE(hud.GetRasterizedCount() == 2);
+    hud.Draw(&renderer);
+    hud.Draw(&renderer);
+    REQUIRE(hud.GetRasterizedCount() == 2);
+  }
+
+  SECTION("Only changed values are rasterized again") {
+    hud.Draw(&renderer);
+    hud.SetValue(counter, 4);
+    hud.Draw(&renderer);
+    REQUIRE(hud.GetRasterizedCount() == 2);
+    hud.SetValue(counter, 5);
+    hud.Draw(&renderer);
+    REQUIRE(hud.GetRasterizedCount() == 3);
+  }
+
+  SECTION("Hidden elements are not rasterized until shown") {
+    hud.SetVisible(label, false);
+    hud.Draw(&renderer);
+    REQUIRE(hud.GetRasterizedCount() == 1);
+    hud.SetVisible(label, true);
+    hud.Draw(&renderer);
+    hud.SetVisible(label, false);
+    hud.SetVisible(label, true);
+    hud.Draw(&renderer);
+    REQUIRE(hud.GetRasterizedCount() == 2);
+  }
+}
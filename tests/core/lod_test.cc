@@ -0,0 +1,116 @@
+#include "core/lod.h"
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <thread>
+
+using ci::TriMesh;
+using ci::vec3;
+using glm::ivec3;
+using minecraft::BlockBox;
+using minecraft::BlockEdit;
+using minecraft::BlockTypes;
+using minecraft::LodManager;
+using minecraft::TerrainGenerator;
+using minecraft::ThreadPool;
+using minecraft::World;
+using std::vector;
+
+/// grass at y = 0 over dirt
+class FlatTerrainGenerator : public TerrainGenerator {
+ public:
+  FlatTerrainGenerator() : TerrainGenerator(0, 0, 0, 0) {
+  }
+
+  BlockTypes GetBlockAt(const ci::vec3& transform) {
+    if (transform.y == 0) {
+      return BlockTypes::kGrass;
+    } else if (transform.y < 0) {
+      return BlockTypes::kDirt;
+    }
+    return BlockTypes::kNone;
+  }
+};
+
+FlatTerrainGenerator flat_terrain_generator;
+
+/// an empty box
+const BlockBox kNothing{ivec3(0), ivec3(-1)};
+
+TEST_CASE("LOD tile meshes") {
+  SECTION("Flat terrain is a surface of cells with skirts") {
+    // level 1 cells are 2 voxels wide; the cell layer holding y = 0 and 1 is
+    // half grass, so it is the surface
+    TriMesh mesh = LodManager::BuildTileMesh(&flat_terrain_generator, {}, 1,
+                                             ivec3(0, -8, 0), kNothing);
+    // 8 x 8 tops and 4 x 8 boundary skirts, 2 triangles each
+    REQUIRE(mesh.getNumTriangles() == 2 * (8 * 8 + 4 * 8));
+  }
+
+  SECTION("Excluded cells are left empty") {
+    TriMesh mesh = LodManager::BuildTileMesh(
+        &flat_terrain_generator, {}, 1, ivec3(0, -8, 0),
+        BlockBox{ivec3(0, -8, 0), ivec3(15, 7, 15)});
+    REQUIRE(mesh.getNumTriangles() == 0);
+  }
+
+  SECTION("Edits are part of the cells") {
+    vector<BlockEdit> edits;
+    for (int x = 0; x < 2; ++x) {
+      for (int z = 0; z < 2; ++z) {
+        edits.push_back(BlockEdit{ivec3(x, 0, z), BlockTypes::kNone});
+      }
+    }
+    TriMesh mesh = LodManager::BuildTileMesh(&flat_terrain_generator, edits, 1,
+                                             ivec3(0, -8, 0), kNothing);
+    // the corner cell is gone: one top less, the cell below shows its top and
+    // two skirts, and two neighbors show a side each
+    REQUIRE(mesh.getNumTriangles() == 2 * (8 * 8 + 4 * 8 + 2));
+  }
+}
+
+TEST_CASE("LOD tile selection") {
+  World world(&flat_terrain_generator, vec3(0, 0, 0), 2);
+  ThreadPool thread_pool(2);
+  LodManager lod(&world, &thread_pool, 160.0f);
+
+  lod.Update(vec3(0, 2, 0));
+  REQUIRE(lod.GetTilesCount() > 0);
+  REQUIRE(lod.GetPendingBuildsCount() == lod.GetTilesCount());
+  for (int i = 0; i < 1000 && lod.GetPendingBuildsCount() > 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    lod.Update(vec3(0, 2, 0));
+  }
+  REQUIRE(lod.GetPendingBuildsCount() == 0);
+
+  // the full-detail surface within the same distance would be at least
+  // pi * 160^2 top faces
+  size_t full_detail_triangles = 2 * 3 * 160 * 160;
+  REQUIRE(lod.GetTrianglesCount() > 0);
+  REQUIRE(lod.GetTrianglesCount() * 10 < full_detail_triangles);
+
+  SECTION("Up-to-date tiles are not rebuilt") {
+    lod.Update(vec3(0, 2, 0));
+    REQUIRE(lod.GetPendingBuildsCount() == 0);
+  }
+
+  SECTION("Invalidated tiles are rebuilt") {
+    lod.Invalidate(BlockBox{ivec3(100, 0, 0), ivec3(100, 0, 0)});
+    lod.Update(vec3(0, 2, 0));
+    REQUIRE(lod.GetPendingBuildsCount() == 1);
+  }
+
+  SECTION("Builds are queued within the budget per update") {
+    lod.SetMaxBuildsPerUpdate(2);
+    lod.Invalidate(BlockBox{ivec3(-160), ivec3(160)});
+    lod.Update(vec3(0, 2, 0));
+    REQUIRE(lod.GetPendingBuildsCount() == 2);
+  }
+
+  SECTION("A shorter view distance picks fewer tiles") {
+    size_t tiles_count = lod.GetTilesCount();
+    lod.SetViewDistance(80.0f);
+    lod.Update(vec3(0, 2, 0));
+    REQUIRE(lod.GetTilesCount() < tiles_count);
+  }
+}
@@ -0,0 +1,97 @@
+#include "core/memory_pool.h"
+
+#include <catch2/catch.hpp>
+
+#include "core/chunk.h"
+#include "core/world.h"
+
+using ci::vec3;
+using glm::ivec3;
+using minecraft::BlockTypes;
+using minecraft::Chunk;
+using minecraft::ChunkCoordinates;
+using minecraft::ChunkSnapshot;
+using minecraft::MemoryPool;
+using minecraft::MemoryStats;
+using minecraft::TerrainGenerator;
+using minecraft::World;
+
+TEST_CASE("Memory pool") {
+  MemoryPool pool;
+
+  SECTION("Requests are rounded up to size classes") {
+    void* block = pool.Allocate(100);
+    REQUIRE(pool.GetStats().live_bytes == 128);
+    pool.Deallocate(block, 100);
+    REQUIRE(pool.GetStats().live_bytes == 0);
+    REQUIRE(pool.GetCachedBytes() == 128);
+  }
+
+  SECTION("Freed blocks are reused instead of returned to the heap") {
+    void* first = pool.Allocate(4096);
+    pool.Deallocate(first, 4096);
+    void* second = pool.Allocate(3000);
+    REQUIRE(second == first);
+    MemoryStats stats = pool.GetStats();
+    REQUIRE(stats.allocations == 2);
+    REQUIRE(stats.heap_allocations == 1);
+    pool.Deallocate(second, 3000);
+  }
+
+  SECTION("Peak bytes survive frees") {
+    void* first = pool.Allocate(1000);
+    void* second = pool.Allocate(1000);
+    pool.Deallocate(first, 1000);
+    pool.Deallocate(second, 1000);
+    REQUIRE(pool.GetStats().live_bytes == 0);
+    REQUIRE(pool.GetStats().peak_bytes == 2048);
+  }
+
+  SECTION("Requests above the largest class bypass the free lists") {
+    size_t bytes = MemoryPool::kMaxBlockSize + 1;
+    void* block = pool.Allocate(bytes);
+    REQUIRE(pool.GetStats().live_bytes == bytes);
+    pool.Deallocate(block, bytes);
+    REQUIRE(pool.GetCachedBytes() == 0);
+  }
+}
+
+TEST_CASE("Chunk memory is recycled") {
+  MemoryPool& pool = MemoryPool::GetDefault();
+  TerrainGenerator terrain_generator(-3, 2, 10.0f, 7);
+  World world(&terrain_generator, vec3(0, 0, 0), 4);
+  world.SetBlockAt(vec3(20, 3, 0), BlockTypes::kStone);
+
+  // walks the window along x and back, loading and unloading chunks
+  auto stream = [&world]() {
+    ChunkCoordinates chunk{0, 0, 0};
+    for (int step = 0; step < 12; ++step) {
+      ChunkCoordinates next{step < 6 ? chunk.x + 1 : chunk.x - 1, 0, 0};
+      world.MoveToChunk(chunk, next);
+      chunk = next;
+    }
+  };
+
+  SECTION("Steady-state streaming allocates nothing from the heap") {
+    stream();
+    MemoryStats warm = pool.GetStats();
+    stream();
+    MemoryStats streamed = pool.GetStats();
+    REQUIRE(streamed.allocations > warm.allocations);
+    REQUIRE(streamed.heap_allocations == warm.heap_allocations);
+    REQUIRE(streamed.live_bytes == warm.live_bytes);
+  }
+
+  SECTION("Arrays freed by snapshots are reused by later chunks") {
+    Chunk chunk(ivec3(0), 8);
+    {
+      ChunkSnapshot snapshot = chunk.GetSnapshot();
+      // shared with the snapshot, so the chunk takes a fresh array
+      chunk.MoveTo(ivec3(8, 0, 0));
+    }
+    uint64_t heap_allocations = pool.GetStats().heap_allocations;
+    ChunkSnapshot snapshot = chunk.GetSnapshot();
+    chunk.MoveTo(ivec3(16, 0, 0));
+    REQUIRE(pool.GetStats().heap_allocations == heap_allocations);
+  }
+}
@@ -0,0 +1,190 @@
+#include "core/metrics.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "core/metrics_exporter.h"
+
+using minecraft::Counter;
+using minecraft::Gauge;
+using minecraft::Histogram;
+using minecraft::HistogramSnapshot;
+using minecraft::MetricsExporter;
+using minecraft::MetricsRegistry;
+using std::string;
+using std::vector;
+
+namespace {
+
+/// \param port a loopback port
+/// \param request_line e.g. `GET /metrics HTTP/1.1`
+/// \return the whole response
+string FetchMetrics(uint16_t port, const string& request_line) {
+  sockaddr_in address = sockaddr_in();
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  int descriptor = socket(AF_INET, SOCK_STREAM, 0);
+  REQUIRE(connect(descriptor, reinterpret_cast<sockaddr*>(&address),
+                  sizeof(address)) == 0);
+  string request = request_line + "\r\nHost: localhost\r\n\r\n";
+  REQUIRE(send(descriptor, request.data(), request.size(), 0) ==
+          ssize_t(request.size()));
+  string response;
+  char buffer[1024];
+  ssize_t received;
+  while ((received = recv(descriptor, buffer, sizeof(buffer), 0)) > 0) {
+    response.append(buffer, size_t(received));
+  }
+  close(descriptor);
+  return response;
+}
+
+}  // namespace
+
+TEST_CASE("Metrics") {
+  SECTION("Counters add up across threads") {
+    Counter counter;
+    vector<std::thread> threads;
+    for (int thread = 0; thread < 8; ++thread) {
+      threads.emplace_back([&counter]() {
+        for (int i = 0; i < 10000; ++i) {
+          counter.Add();
+        }
+        counter.Add(5);
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    REQUIRE(counter.GetValue() == 8 * 10005);
+  }
+
+  SECTION("Gauges keep the last value") {
+    Gauge gauge;
+    REQUIRE(gauge.GetValue() == 0);
+    gauge.Set(2.5);
+    gauge.Set(-1.25);
+    REQUIRE(gauge.GetValue() == -1.25);
+  }
+
+  SECTION("Histograms count into buckets") {
+    Histogram histogram({1, 2, 4});
+    for (double value : {0.5, 1.0, 1.5, 3.0, 10.0, 10.0}) {
+      histogram.Observe(value);
+    }
+    HistogramSnapshot snapshot = histogram.GetSnapshot();
+    REQUIRE(snapshot.counts == vector<uint64_t>{2, 1, 1, 2});
+    REQUIRE(snapshot.count == 6);
+    REQUIRE(snapshot.sum == Approx(26.0));
+
+    REQUIRE_THROWS_AS(Histogram({}), std::invalid_argument);
+    REQUIRE_THROWS_AS(Histogram({1, 1}), std::invalid_argument);
+  }
+
+  SECTION("Histograms add up across threads") {
+    Histogram histogram({0.5});
+    vector<std::thread> threads;
+    for (int thread = 0; thread < 8; ++thread) {
+      threads.emplace_back([&histogram]() {
+        for (int i = 0; i < 1000; ++i) {
+          histogram.Observe(i % 2 == 0 ? 0.25 : 1);
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    HistogramSnapshot snapshot = histogram.GetSnapshot();
+    REQUIRE(snapshot.counts == vector<uint64_t>{4000, 4000});
+    REQUIRE(snapshot.sum == Approx(8 * (500 * 0.25 + 500)));
+  }
+
+  SECTION("The registry formats the text exposition format") {
+    MetricsRegistry registry;
+    registry.AddCounter("test_edits_total", "Edits")->Add(3);
+    registry.AddGauge("test_bytes", "Bytes", "subsystem=\"voxels\"")->Set(1.5);
+    registry.AddGauge("test_bytes", "Bytes", "subsystem=\"meshes\"")->Set(2);
+    Histogram* histogram =
+        registry.AddHistogram("test_seconds", "Time", {0.1, 1});
+    histogram->Observe(0.05);
+    histogram->Observe(0.5);
+    histogram->Observe(5);
+
+    REQUIRE(registry.Format() ==
+            "# HELP test_edits_total Edits\n"
+            "# TYPE test_edits_total counter\n"
+            "test_edits_total 3\n"
+            "# HELP test_bytes Bytes\n"
+            "# TYPE test_bytes gauge\n"
+            "test_bytes{subsystem=\"voxels\"} 1.5\n"
+            "test_bytes{subsystem=\"meshes\"} 2\n"
+            "# HELP test_seconds Time\n"
+            "# TYPE test_seconds histogram\n"
+            "test_seconds_bucket{le=\"0.1\"} 1\n"
+            "test_seconds_bucket{le=\"1\"} 2\n"
+            "test_seconds_bucket{le=\"+Inf\"} 3\n"
+            "test_seconds_sum 5.55\n"
+            "test_seconds_count 3\n");
+  }
+
+  SECTION("Names and labels are registered once") {
+    MetricsRegistry registry;
+    registry.AddGauge("test_bytes", "Bytes", "subsystem=\"voxels\"");
+    REQUIRE_THROWS_AS(registry.AddCounter("test_bytes", "Bytes"),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        registry.AddGauge("test_bytes", "Bytes", "subsystem=\"voxels\""),
+        std::invalid_argument);
+    REQUIRE_THROWS_AS(registry.AddHistogram("test_seconds", "Time", {}),
+                      std::invalid_argument);
+    REQUIRE(registry.Format().find("test_seconds") == string::npos);
+  }
+}
+
+TEST_CASE("Metrics export") {
+  MetricsRegistry registry;
+  registry.AddCounter("test_edits_total", "Edits")->Add(7);
+  MetricsExporter exporter(&registry);
+
+  SECTION("Metrics are served over HTTP") {
+    uint16_t port = exporter.ServeHttp(0);
+    REQUIRE(port != 0);
+    string response = FetchMetrics(port, "GET /metrics HTTP/1.1");
+    REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+    REQUIRE(response.find("Content-Type: text/plain; version=0.0.4") !=
+            string::npos);
+    REQUIRE(response.find("\r\n\r\n" + registry.Format()) != string::npos);
+    REQUIRE(exporter.GetScrapesCount() == 1);
+
+    response = FetchMetrics(port, "GET /other HTTP/1.1");
+    REQUIRE(response.find("HTTP/1.1 404 Not Found\r\n") == 0);
+    REQUIRE(exporter.GetScrapesCount() == 1);
+
+    REQUIRE_THROWS_AS(exporter.ServeHttp(0), std::logic_error);
+  }
+
+  SECTION("Metrics are dumped to a file") {
+    char path[] = "/tmp/minecraft-metrics-XXXXXX";
+    close(mkstemp(path));
+    exporter.DumpToFile(path, 60);
+    while (exporter.GetScrapesCount() == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    REQUIRE(contents.str() == registry.Format());
+    std::remove(path);
+  }
+}
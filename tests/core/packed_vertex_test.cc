@@ -0,0 +1,108 @@
+#include "core/packed_vertex.h"
+
+#include <catch2/catch.hpp>
+
+#include "core/block.h"
+#include "core/block_registry.h"
+#include "core/headless_renderer.h"
+#include "core/world.h"
+
+using ci::TriMesh;
+using ci::vec2;
+using ci::vec3;
+using glm::ivec3;
+using minecraft::Block;
+using minecraft::BlockRegistry;
+using minecraft::BlockTypes;
+using minecraft::HeadlessRenderer;
+using minecraft::PackedMesh;
+using minecraft::PackedVertex;
+using minecraft::TerrainGenerator;
+using minecraft::World;
+
+TEST_CASE("Packed vertices round trip") {
+  SECTION("Every field survives packing") {
+    const int last = PackedVertex::kMaxChunkWidth - 1;
+    ivec3 blocks[] = {ivec3(0), ivec3(last), ivec3(last, 0, 17),
+                      ivec3(5, last, 0), ivec3(1, 2, last)};
+    for (const ivec3& block : blocks) {
+      for (size_t face = 0; face < Block::kCubeFacesCount; ++face) {
+        for (size_t corner = 0; corner < Block::kSquareVerticesCount;
+             ++corner) {
+          for (int layer : {0, 1, 17, 255}) {
+            PackedVertex vertex(block, face, corner, uint8_t(layer));
+            REQUIRE(vertex.GetBlock() == block);
+            REQUIRE(vertex.GetFace() == face);
+            REQUIRE(vertex.GetCorner() == corner);
+            REQUIRE(vertex.GetLayer() == layer);
+          }
+        }
+      }
+    }
+  }
+
+  SECTION("A packed block unpacks to the mesh Block::AppendFace builds") {
+    TriMesh expected(TriMesh::Format().positions().texCoords(2));
+    PackedMesh packed(ivec3(-16, 0, 32));
+    for (size_t face = 0; face < Block::kCubeFacesCount; ++face) {
+      Block::AppendFace(&expected, BlockTypes::kGrass, face,
+                        vec3(-16 + 3, 0 + 9, 32 + 4), 1.0f);
+      packed.AppendFace(ivec3(3, 9, 4), BlockTypes::kGrass, face);
+    }
+    TriMesh actual = packed.Unpack();
+
+    REQUIRE(actual.getNumVertices() == expected.getNumVertices());
+    REQUIRE(actual.getIndices() == expected.getIndices());
+    const vec3* expected_positions = expected.getPositions<3>();
+    const vec3* actual_positions = actual.getPositions<3>();
+    const vec2* expected_tex_coords = expected.getTexCoords0<2>();
+    const vec2* actual_tex_coords = actual.getTexCoords0<2>();
+    for (size_t vertex = 0; vertex < expected.getNumVertices(); ++vertex) {
+      REQUIRE(actual_positions[vertex] == expected_positions[vertex]);
+      REQUIRE(actual_tex_coords[vertex] == expected_tex_coords[vertex]);
+    }
+  }
+
+  SECTION("Changing a mesh changes its revision") {
+    PackedMesh first;
+    PackedMesh second;
+    REQUIRE(first.GetRevision() != second.GetRevision());
+    uint64_t revision = first.GetRevision();
+    first.AppendBlock(ivec3(0), BlockTypes::kDirt);
+    REQUIRE(first.GetRevision() != revision);
+    REQUIRE(first.GetTrianglesCount() == 12);
+  }
+}
+
+TEST_CASE("Packed chunk geometry") {
+  TerrainGenerator terrain_generator(-3, 2, 10.0f, 7);
+  World world(&terrain_generator, vec3(0, 0, 0), 4);
+
+  SECTION("Packed geometry is several times smaller than float meshes") {
+    HeadlessRenderer packed_renderer;
+    HeadlessRenderer unpacked_renderer;
+    world.Render(&packed_renderer, vec3(0, 30, 0), vec3(0, -1, 0), 3.2f, 1000);
+    REQUIRE(packed_renderer.GetStats().triangles > 0);
+    // one draw call per chunk instead of one per block
+    REQUIRE(packed_renderer.GetStats().draw_calls <= 27);
+
+    Block(BlockTypes::kStone, vec3(0)).Render(&packed_renderer);
+    TriMesh block(TriMesh::Format().positions().texCoords(2));
+    for (size_t face = 0; face < Block::kCubeFacesCount; ++face) {
+      Block::AppendFace(&block, BlockTypes::kStone, face, vec3(0), 1.0f);
+    }
+    unpacked_renderer.DrawMesh(block);
+    packed_renderer.ResetStats();
+    Block(BlockTypes::kStone, vec3(0)).Render(&packed_renderer);
+    REQUIRE(packed_renderer.GetStats().vertices ==
+            unpacked_renderer.GetStats().vertices);
+    REQUIRE(packed_renderer.GetStats().geometry_bytes * 6 <=
+            unpacked_renderer.GetStats().geometry_bytes);
+  }
+
+  SECTION("Chunks too wide for packed positions are rejected") {
+    REQUIRE_THROWS_AS(
+        minecraft::Chunk(ivec3(0), PackedVertex::kMaxChunkWidth + 1),
+        std::invalid_argument);
+  }
+}
@@ -0,0 +1,133 @@
+#include "core/pathfinder.h"
+
+#include <catch2/catch.hpp>
+#include <cstdlib>
+#include <vector>
+
+using glm::ivec3;
+using minecraft::BlockTypes;
+using minecraft::Pathfinder;
+using minecraft::PathRequest;
+using minecraft::PathResult;
+using minecraft::TerrainGenerator;
+using minecraft::ThreadPool;
+using minecraft::World;
+using minecraft::WorldSnapshot;
+using std::vector;
+
+namespace {
+
+/// flat ground at y = 0, split by a wall 3 blocks high along x = 1 with a
+/// gap at z = 4
+class WallTerrainGenerator : public TerrainGenerator {
+ public:
+  WallTerrainGenerator() : TerrainGenerator(0, 0, 0, 0) {
+  }
+
+  BlockTypes GetBlockAt(const ci::vec3& transform) {
+    if (transform.y <= 0 || (transform.x == 1 && transform.y <= 3 &&
+                             transform.z != 4)) {
+      return BlockTypes::kStone;
+    }
+    return BlockTypes::kNone;
+  }
+};
+
+WallTerrainGenerator wall_terrain_generator;
+
+/// checks that a path is made of moves between points a mob can stand at
+void RequireWalkable(const WorldSnapshot& snapshot, const PathRequest& request,
+                     const vector<ivec3>& path) {
+  REQUIRE(path.front() == request.start);
+  REQUIRE(path.back() == request.goal);
+  for (size_t step = 0; step < path.size(); ++step) {
+    REQUIRE(Pathfinder::CanStandAt(snapshot, path[step]));
+    if (step > 0) {
+      ivec3 move = path[step] - path[step - 1];
+      REQUIRE(std::abs(move.x) + std::abs(move.z) == 1);
+      REQUIRE(move.y <= 1);
+      REQUIRE(move.y >= -Pathfinder::kMaxDrop);
+    }
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Pathfinding") {
+  // loads the blocks from -6 to 5 along each axis, in chunks 4 blocks wide
+  World world(&wall_terrain_generator, ci::vec3(0, 0, 0), 2);
+  ThreadPool thread_pool(2);
+  Pathfinder pathfinder(&world, &thread_pool);
+  WorldSnapshot snapshot = world.GetSnapshot();
+  PathRequest around_wall{ivec3(-4, 1, 0), ivec3(4, 1, 0)};
+
+  SECTION("Paths go around walls through the gap") {
+    PathResult result = pathfinder.FindPath(snapshot, around_wall);
+    REQUIRE(result.found);
+    RequireWalkable(snapshot, around_wall, result.path);
+    REQUIRE(std::find(result.path.begin(), result.path.end(),
+                      ivec3(1, 1, 4)) != result.path.end());
+
+    PathResult shortest = Pathfinder::FindBlockPath(snapshot, around_wall);
+    REQUIRE(shortest.found);
+    RequireWalkable(snapshot, around_wall, shortest.path);
+    REQUIRE(result.path.size() >= shortest.path.size());
+    REQUIRE(result.path.size() <= shortest.path.size() * 3 / 2);
+    REQUIRE(pathfinder.GetClustersCount() > 0);
+  }
+
+  SECTION("Paths within a chunk") {
+    PathRequest request{ivec3(-2, 1, -2), ivec3(-1, 1, -1)};
+    PathResult result = pathfinder.FindPath(snapshot, request);
+    REQUIRE(result.found);
+    REQUIRE(result.path.size() == 3);
+    RequireWalkable(snapshot, request, result.path);
+
+    request.goal = request.start;
+    REQUIRE(pathfinder.FindPath(snapshot, request).path ==
+            vector<ivec3>{request.start});
+  }
+
+  SECTION("Unreachable goals are not found") {
+    // on top of the wall, too high to step onto
+    PathRequest request{ivec3(-4, 1, 0), ivec3(1, 4, 0)};
+    REQUIRE(Pathfinder::CanStandAt(snapshot, request.goal));
+    REQUIRE_FALSE(pathfinder.FindPath(snapshot, request).found);
+    REQUIRE_FALSE(Pathfinder::FindBlockPath(snapshot, request).found);
+
+    // inside the wall
+    request.goal = ivec3(1, 1, 0);
+    PathResult result = pathfinder.FindPath(snapshot, request);
+    REQUIRE_FALSE(result.found);
+    REQUIRE(result.path.empty());
+  }
+
+  SECTION("Block edits invalidate the cached graphs") {
+    REQUIRE(pathfinder.FindPath(snapshot, around_wall).found);
+    world.SetBlockAt(ci::vec3(1, 1, 4), BlockTypes::kStone);
+    world.SetBlockAt(ci::vec3(1, 2, 4), BlockTypes::kStone);
+    world.Tick();
+    REQUIRE(pathfinder.GetStats().clusters_invalidated > 0);
+
+    WorldSnapshot walled = world.GetSnapshot();
+    REQUIRE_FALSE(pathfinder.FindPath(walled, around_wall).found);
+    REQUIRE_FALSE(Pathfinder::FindBlockPath(walled, around_wall).found);
+  }
+
+  SECTION("Batches are answered on the thread pool") {
+    vector<PathRequest> requests;
+    for (int z = -5; z <= 4; ++z) {
+      requests.push_back(PathRequest{ivec3(-5, 1, z), ivec3(5, 1, -z)});
+      requests.push_back(PathRequest{ivec3(4, 1, z), ivec3(-3, 1, z)});
+    }
+    vector<PathResult> results = pathfinder.FindPaths(requests).Get();
+    REQUIRE(results.size() == requests.size());
+    for (size_t request = 0; request < requests.size(); ++request) {
+      PathResult expected = pathfinder.FindPath(snapshot, requests[request]);
+      REQUIRE(results[request].found);
+      REQUIRE(results[request].path == expected.path);
+    }
+    REQUIRE(pathfinder.GetStats().queries == 2 * requests.size());
+    REQUIRE(pathfinder.GetStats().nodes_expanded > 0);
+  }
+}
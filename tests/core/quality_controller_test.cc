@@ -0,0 +1,106 @@
+#include "core/quality_controller.h"
+
+#include <catch2/catch.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using minecraft::QualityController;
+using minecraft::QualitySettings;
+
+namespace {
+
+/// records a window's worth of frames of the same times
+///
+/// \return whether the settings changed
+bool RecordWindow(QualityController* controller, float frame_seconds,
+                  float update_seconds) {
+  bool changed = false;
+  for (size_t frame = 0; frame < QualityController::kWindowFrames; ++frame) {
+    changed = controller->Record(frame_seconds, update_seconds) || changed;
+  }
+  return changed;
+}
+
+}  // namespace
+
+TEST_CASE("Quality presets") {
+  SECTION("Presets get more expensive") {
+    QualitySettings previous = QualityController::GetPreset("low");
+    for (size_t preset = 1; preset < QualityController::kPresetNames.size();
+         ++preset) {
+      QualitySettings settings =
+          QualityController::GetPreset(QualityController::kPresetNames[preset]);
+      REQUIRE(settings.render_radius > previous.render_radius);
+      REQUIRE(settings.lod_view_distance > previous.lod_view_distance);
+      previous = settings;
+    }
+  }
+
+  SECTION("Unknown presets are rejected") {
+    REQUIRE_THROWS_AS(QualityController::GetPreset("cinematic"),
+                      std::invalid_argument);
+  }
+}
+
+TEST_CASE("Quality controller") {
+  const float target = 1.0f / 60.0f;
+  QualitySettings highest = QualityController::GetPreset("high");
+  std::ostringstream log;
+  QualityController controller(highest, target, &log);
+
+  SECTION("Frames on target keep the settings") {
+    for (int window = 0; window < 10; ++window) {
+      REQUIRE_FALSE(RecordWindow(&controller, target * 1.1f, target * 0.1f));
+      REQUIRE_FALSE(RecordWindow(&controller, target * 0.9f, target * 0.1f));
+    }
+    REQUIRE(controller.GetSettings().render_radius == highest.render_radius);
+    REQUIRE(log.str().empty());
+  }
+
+  SECTION("Slow drawing lowers the detail") {
+    REQUIRE(RecordWindow(&controller, target * 2, target * 0.1f));
+    REQUIRE(controller.GetDetailLevel() ==
+            QualityController::kLevelsCount - 2);
+    REQUIRE(controller.GetStreamingLevel() ==
+            QualityController::kLevelsCount - 1);
+    REQUIRE(controller.GetSettings().render_radius < highest.render_radius);
+    REQUIRE(controller.GetSettings().lod_view_distance <
+            highest.lod_view_distance);
+    REQUIRE(log.str().find("render radius 12 -> ") != std::string::npos);
+  }
+
+  SECTION("Slow updates lower the streaming budget") {
+    REQUIRE(RecordWindow(&controller, target * 2, target * 1.5f));
+    REQUIRE(controller.GetDetailLevel() ==
+            QualityController::kLevelsCount - 1);
+    REQUIRE(controller.GetSettings().lod_builds_per_update <
+            highest.lod_builds_per_update);
+  }
+
+  SECTION("Settings bottom out at the cheapest level") {
+    for (size_t window = 0; window < 2 * QualityController::kLevelsCount;
+         ++window) {
+      RecordWindow(&controller, target * 3, target * 0.1f);
+    }
+    REQUIRE_FALSE(RecordWindow(&controller, target * 3, target * 0.1f));
+    REQUIRE(controller.GetSettings().render_radius ==
+            QualityController::kMinRenderRadius);
+    REQUIRE(controller.GetSettings().lod_view_distance ==
+            QualityController::kMinLodViewDistance);
+    REQUIRE(controller.GetSettings().lod_builds_per_update == 1);
+    REQUIRE(controller.GetSettings().chunk_radius == highest.chunk_radius);
+  }
+
+  SECTION("Fast frames raise the settings back, slowly") {
+    RecordWindow(&controller, target * 2, target * 0.1f);
+    for (size_t window = 1; window < QualityController::kRaiseWindows;
+         ++window) {
+      REQUIRE_FALSE(RecordWindow(&controller, target * 0.5f, target * 0.1f));
+    }
+    REQUIRE(RecordWindow(&controller, target * 0.5f, target * 0.1f));
+    REQUIRE(controller.GetSettings().render_radius == highest.render_radius);
+    REQUIRE(controller.GetSettings().lod_view_distance ==
+            highest.lod_view_distance);
+  }
+}
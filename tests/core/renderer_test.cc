@@ -0,0 +1,72 @@
+#include <catch2/catch.hpp>
+
+#include "core/block.h"
+#include "core/camera.h"
+#include "core/headless_renderer.h"
+
+using ci::vec3;
+using glm::ivec2;
+using minecraft::Block;
+using minecraft::BlockTypes;
+using minecraft::Camera;
+using minecraft::HeadlessRenderer;
+using minecraft::RenderStats;
+
+TEST_CASE("Headless rendering counts draw calls") {
+  HeadlessRenderer renderer;
+  Block first(BlockTypes::kGrass, vec3(0, 0, -5));
+  Block second(BlockTypes::kStone, vec3(0, 0, -10));
+
+  first.Render(&renderer);
+  second.Render(&renderer);
+  renderer.DrawStrokedCube(vec3(0, 0, -5), vec3(1, 1, 1));
+  first.Render(&renderer);
+
+  const RenderStats& stats = renderer.GetStats();
+  REQUIRE(stats.draw_calls == 4);
+  REQUIRE(stats.triangles == 3 * 12);
+  REQUIRE(stats.vertices == 3 * 24 + 24);
+  // atlas, lines, atlas
+  REQUIRE(stats.state_changes == 3);
+  // nothing is rasterized without a raster
+  REQUIRE(stats.fragments == 0);
+
+  renderer.ResetStats();
+  REQUIRE(renderer.GetStats().draw_calls == 0);
+}
+
+TEST_CASE("Software raster measures overdraw") {
+  HeadlessRenderer renderer(ivec2(64, 48));
+  Camera camera(vec3(0, 0, 0));
+  camera.RotateXZ(-3.14159265f / 2);
+  Block near_block(BlockTypes::kGrass, vec3(0, 0, -5));
+  Block far_block(BlockTypes::kDirt, vec3(0, 0, -10));
+
+  SECTION("Drawing back to front overdraws more than front to back") {
+    renderer.Clear();
+    camera.Render(&renderer);
+    near_block.Render(&renderer);
+    far_block.Render(&renderer);
+    RenderStats front_to_back = renderer.GetStats();
+    REQUIRE(front_to_back.covered_pixels > 0);
+    // no culling: the hidden sides and the far block still produce fragments
+    REQUIRE(front_to_back.GetDepthComplexity() > 2.0);
+
+    renderer.ResetStats();
+    renderer.Clear();
+    far_block.Render(&renderer);
+    near_block.Render(&renderer);
+    RenderStats back_to_front = renderer.GetStats();
+    REQUIRE(back_to_front.fragments == front_to_back.fragments);
+    REQUIRE(back_to_front.GetOverdraw() > front_to_back.GetOverdraw());
+  }
+
+  SECTION("Blocks behind the camera produce no fragments") {
+    renderer.Clear();
+    camera.Render(&renderer);
+    Block behind(BlockTypes::kStone, vec3(0, 0, 5));
+    behind.Render(&renderer);
+    REQUIRE(renderer.GetStats().fragments == 0);
+    REQUIRE(renderer.GetStats().draw_calls == 1);
+  }
+}
@@ -0,0 +1,79 @@
+#include "core/spatial_hash.h"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using glm::vec3;
+using minecraft::SpatialHash;
+using std::pair;
+using std::vector;
+
+namespace {
+
+typedef vector<pair<uint32_t, uint32_t>> Pairs;
+
+/// \return the overlapping pairs, found by testing every pair
+Pairs FindPairsOneByOne(const vector<vec3>& centers,
+                        const vector<vec3>& half_extents) {
+  Pairs pairs;
+  for (uint32_t first = 0; first < centers.size(); ++first) {
+    for (uint32_t second = first + 1; second < centers.size(); ++second) {
+      vec3 gap = glm::abs(centers[first] - centers[second]) -
+                 half_extents[first] - half_extents[second];
+      if (gap.x < 0 && gap.y < 0 && gap.z < 0) {
+        pairs.push_back(std::make_pair(first, second));
+      }
+    }
+  }
+  return pairs;
+}
+
+}  // namespace
+
+TEST_CASE("Spatial hash broadphase") {
+  SpatialHash hash(1.0f);
+  Pairs pairs;
+
+  SECTION("Pairs are those found by testing every pair") {
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> coordinate(-20, 20);
+    std::uniform_real_distribution<float> extent(0.05f, 0.5f);
+    vector<vec3> centers;
+    vector<vec3> half_extents;
+    for (int box = 0; box < 2000; ++box) {
+      centers.push_back(
+          vec3(coordinate(random), coordinate(random) / 8, coordinate(random)));
+      half_extents.push_back(
+          vec3(extent(random), extent(random), extent(random)));
+    }
+    hash.Build(centers.data(), half_extents.data(), centers.size());
+    hash.FindPairs(&pairs);
+    std::sort(pairs.begin(), pairs.end());
+
+    Pairs expected = FindPairsOneByOne(centers, half_extents);
+    REQUIRE(!expected.empty());
+    REQUIRE(pairs == expected);
+    REQUIRE(hash.GetBucketsCount() >= 2 * centers.size());
+  }
+
+  SECTION("Touching boxes do not overlap") {
+    vector<vec3> centers = {vec3(0.5f, 0, 0), vec3(1.5f, 0, 0),
+                            vec3(1.5f, 0.9f, 0)};
+    vector<vec3> half_extents(3, vec3(0.5f));
+    hash.Build(centers.data(), half_extents.data(), centers.size());
+    hash.FindPairs(&pairs);
+    REQUIRE(pairs == Pairs{std::make_pair(1u, 2u)});
+  }
+
+  SECTION("Boxes wider than a cell are rejected") {
+    vec3 center(0);
+    vec3 half_extents(0.25f, 0.75f, 0.25f);
+    REQUIRE_THROWS_AS(hash.Build(&center, &half_extents, 1),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(SpatialHash(0), std::invalid_argument);
+  }
+}
@@ -0,0 +1,82 @@
+#include "core/terrain_generator.h"
+
+#include <catch2/catch.hpp>
+#include <vector>
+
+using ci::vec3;
+using glm::ivec3;
+using minecraft::BlockTypes;
+using minecraft::PerlinTerrain;
+using minecraft::PolymorphicTerrain;
+using minecraft::TerrainGenerator;
+using std::vector;
+
+namespace {
+
+/// stone below y = 0
+class FloorTerrainGenerator : public TerrainGenerator {
+ public:
+  FloorTerrainGenerator() : TerrainGenerator(0, 0, 0, 0) {
+  }
+
+  BlockTypes GetBlockAt(const vec3& transform) {
+    return transform.y < 0 ? BlockTypes::kStone : BlockTypes::kNone;
+  }
+};
+
+/// dirt wherever x + y + z is even
+struct CheckerTerrain {
+  BlockTypes GetBlockAt(int x, int y, int z) const {
+    return (x + y + z) % 2 == 0 ? BlockTypes::kDirt : BlockTypes::kNone;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("Chunk filling") {
+  const int width = 4;
+  vector<BlockTypes> fast(width * width * width);
+  vector<BlockTypes> slow(width * width * width);
+
+  SECTION("The column fill matches the per-voxel terrain") {
+    TerrainGenerator generator(-3, 2, 10.0f, 7);
+    for (const ivec3& min_corner :
+         {ivec3(-2, -2, -2), ivec3(-6, -6, 38), ivec3(10, 2, -14)}) {
+      generator.FillChunk(min_corner, width, fast.data());
+      minecraft::FillChunk(PolymorphicTerrain(&generator), min_corner, width,
+                           slow.data());
+      REQUIRE(fast == slow);
+    }
+  }
+
+  SECTION("The column fill produces every kind of block") {
+    PerlinTerrain terrain(-3, 2, 10.0f, 7);
+    bool seen[4] = {false, false, false, false};
+    vector<BlockTypes> voxels(16 * 16 * 16);
+    minecraft::FillChunk(terrain, ivec3(-8), 16, voxels.data());
+    for (BlockTypes block_type : voxels) {
+      seen[block_type] = true;
+    }
+    REQUIRE(seen[BlockTypes::kNone]);
+    REQUIRE(seen[BlockTypes::kGrass]);
+    REQUIRE(seen[BlockTypes::kDirt]);
+    REQUIRE(seen[BlockTypes::kStone]);
+  }
+
+  SECTION("Subclasses that override GetBlockAt are honored") {
+    FloorTerrainGenerator generator;
+    TerrainGenerator* polymorphic = &generator;
+    polymorphic->FillChunk(ivec3(-2), width, fast.data());
+    for (int y = 0; y < width; ++y) {
+      BlockTypes expected = y < 2 ? BlockTypes::kStone : BlockTypes::kNone;
+      REQUIRE(fast[size_t((1 * width + y) * width + 3)] == expected);
+    }
+  }
+
+  SECTION("Any generator with integer GetBlockAt can fill a chunk") {
+    minecraft::FillChunk(CheckerTerrain(), ivec3(0), width, fast.data());
+    REQUIRE(fast[0] == BlockTypes::kDirt);
+    REQUIRE(fast[1] == BlockTypes::kNone);
+    REQUIRE(fast[size_t((1 * width + 1) * width + 0)] == BlockTypes::kDirt);
+  }
+}
@@ -0,0 +1,42 @@
+#include "core/tick_scheduler.h"
+
+#include <catch2/catch.hpp>
+
+using glm::ivec3;
+using minecraft::TickScheduler;
+using std::vector;
+
+TEST_CASE("Tick scheduling") {
+  TickScheduler scheduler;
+
+  SECTION("Updates come out when they are due, in order") {
+    REQUIRE(scheduler.Schedule(ivec3(1, 0, 0), 2));
+    REQUIRE(scheduler.Schedule(ivec3(2, 0, 0), 1));
+    REQUIRE(scheduler.Schedule(ivec3(3, 0, 0), 2));
+    REQUIRE(scheduler.GetPendingCount() == 3);
+
+    REQUIRE(scheduler.Advance() == vector<ivec3>{ivec3(2, 0, 0)});
+    REQUIRE(scheduler.Advance() ==
+            vector<ivec3>{ivec3(1, 0, 0), ivec3(3, 0, 0)});
+    REQUIRE(scheduler.Advance().empty());
+    REQUIRE(scheduler.GetTick() == 3);
+    REQUIRE(scheduler.GetPendingCount() == 0);
+  }
+
+  SECTION("A block has at most one pending update") {
+    REQUIRE(scheduler.Schedule(ivec3(1, 0, 0), 5));
+    REQUIRE_FALSE(scheduler.Schedule(ivec3(1, 0, 0), 1));
+    REQUIRE(scheduler.GetPendingCount() == 1);
+    for (int tick = 0; tick < 4; ++tick) {
+      REQUIRE(scheduler.Advance().empty());
+    }
+    REQUIRE(scheduler.Advance().size() == 1);
+    // and can be scheduled again once it ran
+    REQUIRE(scheduler.Schedule(ivec3(1, 0, 0), 1));
+  }
+
+  SECTION("Zero delays wait for the next tick") {
+    scheduler.Schedule(ivec3(0, 0, 0), 0);
+    REQUIRE(scheduler.Advance().size() == 1);
+  }
+}
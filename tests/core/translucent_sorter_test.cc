@@ -0,0 +1,206 @@
+#include "core/translucent_sorter.h"
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <limits>
+#include <thread>
+
+#include "core/headless_renderer.h"
+#include "core/world.h"
+
+using ci::vec3;
+using glm::ivec2;
+using glm::ivec3;
+using minecraft::BlockTypes;
+using minecraft::ChunkCoordinates;
+using minecraft::HeadlessRenderer;
+using minecraft::PackedMesh;
+using minecraft::PackedVertices;
+using minecraft::RenderStats;
+using minecraft::SortStats;
+using minecraft::TerrainGenerator;
+using minecraft::ThreadPool;
+using minecraft::TranslucentSorter;
+using minecraft::World;
+using std::vector;
+
+namespace {
+
+/// \param mesh packed quads
+/// \param eye world position
+/// \return whether no quad is farther from the eye than the quad before it
+bool IsSortedBackToFront(const PackedMesh& mesh, const vec3& eye) {
+  const PackedVertices& vertices = mesh.GetVertices();
+  float previous = std::numeric_limits<float>::max();
+  for (size_t first = 0; first + 3 < vertices.size(); first += 4) {
+    vec3 center = vec3(mesh.GetOrigin()) +
+                  (vertices[first].GetPosition() +
+                   vertices[first + 2].GetPosition()) *
+                      0.5f;
+    float distance = glm::distance(center, eye);
+    if (distance > previous + 1e-4f) {
+      return false;
+    }
+    previous = distance;
+  }
+  return true;
+}
+
+/// updates the sorter until its sorts are done
+void FinishSorting(TranslucentSorter* sorter, const vec3& eye) {
+  sorter->Update(eye);
+  while (sorter->GetSortingCount() > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    sorter->Update(eye);
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Translucent sorting") {
+  TerrainGenerator terrain_generator(-3, 2, 10.0f, 7);
+  World world(&terrain_generator, vec3(0, 0, 0), 4);
+
+  SECTION("Meshes sort their quads from the farthest to the nearest") {
+    PackedMesh mesh(ivec3(-8, 0, 0));
+    for (int x = 0; x < 4; ++x) {
+      mesh.AppendBlock(ivec3(x, 0, 2 * x), BlockTypes::kGlass);
+    }
+    uint64_t revision = mesh.GetRevision();
+    vec3 eye(-20, 3, 1);
+    REQUIRE(!IsSortedBackToFront(mesh, eye));
+    mesh.SortBackToFront(eye);
+    REQUIRE(IsSortedBackToFront(mesh, eye));
+    REQUIRE(mesh.GetTrianglesCount() == 4 * 12);
+    REQUIRE(mesh.GetRevision() != revision);
+  }
+
+  SECTION("Chunks keep their translucent faces apart") {
+    REQUIRE(world.GetTranslucentMeshes().empty());
+    world.SetBlockAt(vec3(1, 6, 1), BlockTypes::kGlass);
+    vector<const PackedMesh*> meshes = world.GetTranslucentMeshes();
+    REQUIRE(meshes.size() == 1);
+    REQUIRE(meshes[0]->GetTrianglesCount() == 12);
+
+    // the opaque pass draws no glass, the translucent pass only glass
+    HeadlessRenderer renderer;
+    world.Render(&renderer, vec3(1, 20, 1), vec3(0, -1, 0), 3.2f, 1000);
+    size_t opaque_triangles = renderer.GetStats().triangles;
+    REQUIRE(opaque_triangles > 0);
+    renderer.ResetStats();
+    world.RenderTranslucent(&renderer, vec3(1, 20, 1), vec3(0, -1, 0), 3.2f,
+                            1000);
+    REQUIRE(renderer.GetStats().draw_calls == 1);
+    REQUIRE(renderer.GetStats().triangles == 12);
+
+    world.SetBlockAt(vec3(1, 6, 1), BlockTypes::kNone);
+    REQUIRE(world.GetTranslucentMeshes().empty());
+  }
+
+  SECTION("Translucent faces do not hide what is behind them") {
+    HeadlessRenderer renderer(ivec2(64, 48));
+    PackedMesh glass(ivec3(0, 0, -5));
+    glass.AppendBlock(ivec3(0), BlockTypes::kGlass);
+    PackedMesh stone(ivec3(0, 0, -10));
+    stone.AppendBlock(ivec3(0), BlockTypes::kStone);
+    renderer.Clear();
+    renderer.SetCamera(vec3(0), vec3(0, 0, -1));
+    renderer.DrawTranslucentPackedMesh(glass);
+    renderer.ResetStats();
+    renderer.DrawPackedMesh(stone);
+    RenderStats behind_glass = renderer.GetStats();
+
+    renderer.Clear();
+    renderer.ResetStats();
+    renderer.DrawPackedMesh(stone);
+    REQUIRE(behind_glass.visible_fragments ==
+            renderer.GetStats().visible_fragments);
+
+    // but they are hidden by what is in front of them
+    renderer.ResetStats();
+    renderer.DrawTranslucentPackedMesh(glass);
+    REQUIRE(renderer.GetStats().blended_fragments > 0);
+    PackedMesh near_stone(ivec3(0, 0, -2));
+    near_stone.AppendBlock(ivec3(0), BlockTypes::kStone);
+    renderer.Clear();
+    renderer.DrawPackedMesh(near_stone);
+    renderer.ResetStats();
+    renderer.DrawTranslucentPackedMesh(glass);
+    REQUIRE(renderer.GetStats().fragments > 0);
+    REQUIRE(renderer.GetStats().blended_fragments == 0);
+  }
+
+  SECTION("Chunks are re-sorted only when the eye moves enough") {
+    ThreadPool thread_pool(2);
+    TranslucentSorter sorter(&world, &thread_pool);
+    for (int x = 0; x < 3; ++x) {
+      world.SetBlockAt(vec3(x, 6, 3 - x), BlockTypes::kGlass);
+    }
+    const PackedMesh& mesh = *world.GetTranslucentMeshes().at(0);
+    vec3 eye(2.2f, 6.1f, 0.2f);
+    REQUIRE(&sorter.GetSorted(mesh) == &mesh);
+    FinishSorting(&sorter, eye);
+    REQUIRE(sorter.GetStats().completed == 1);
+    const PackedMesh& sorted = sorter.GetSorted(mesh);
+    REQUIRE(&sorted != &mesh);
+    REQUIRE(sorted.GetTrianglesCount() == mesh.GetTrianglesCount());
+    REQUIRE(IsSortedBackToFront(sorted, eye));
+
+    // within the same block
+    SortStats before = sorter.GetStats();
+    sorter.Update(eye + vec3(0.2f, 0, 0.2f));
+    REQUIRE(sorter.GetStats().requested == before.requested);
+    REQUIRE(sorter.GetStats().skipped == before.skipped + 1);
+
+    // into the next block, inside the chunk
+    eye += vec3(0, 0, 1);
+    FinishSorting(&sorter, eye);
+    REQUIRE(sorter.GetStats().completed == 2);
+    REQUIRE(IsSortedBackToFront(sorter.GetSorted(mesh), eye));
+
+    // far away, small moves matter less
+    eye = vec3(2, 6, 60);
+    FinishSorting(&sorter, eye);
+    sorter.Update(eye + vec3(3, 0, 0));
+    REQUIRE(sorter.GetSortingCount() == 0);
+    sorter.Update(eye + vec3(10, 0, 0));
+    REQUIRE(sorter.GetSortingCount() == 1);
+    FinishSorting(&sorter, eye + vec3(10, 0, 0));
+
+    // an edit shows unsorted until it is sorted again
+    world.SetBlockAt(vec3(0, 6, 0), BlockTypes::kGlass);
+    REQUIRE(&sorter.GetSorted(mesh) == &mesh);
+    FinishSorting(&sorter, eye);
+    REQUIRE(&sorter.GetSorted(mesh) != &mesh);
+    REQUIRE(sorter.GetSorted(mesh).GetTrianglesCount() == 4 * 12);
+  }
+
+  SECTION("Sorts are spread over updates") {
+    ThreadPool thread_pool(1);
+    TranslucentSorter sorter(&world, &thread_pool);
+    for (int x = -1; x <= 1; ++x) {
+      for (int z = -1; z <= 1; ++z) {
+        ChunkCoordinates chunk = world.GetWindowCenter();
+        chunk.x += x;
+        chunk.z += z;
+        world.SetBlockAt(vec3(world.GetChunkMinCorner(chunk) + 1),
+                         BlockTypes::kGlass);
+      }
+    }
+    REQUIRE(world.GetTranslucentMeshes().size() == 9);
+    vec3 eye(world.GetChunkMinCorner(world.GetWindowCenter()) + 1);
+    sorter.Update(eye);
+    SortStats stats = sorter.GetStats();
+    REQUIRE(stats.requested == TranslucentSorter::kMaxSortsPerUpdate);
+    REQUIRE(stats.deferred == 9 - TranslucentSorter::kMaxSortsPerUpdate);
+
+    while (sorter.GetStats().completed < 9) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      sorter.Update(eye);
+    }
+    REQUIRE(sorter.GetStats().requested == 9);
+    for (const PackedMesh* mesh : world.GetTranslucentMeshes()) {
+      REQUIRE(&sorter.GetSorted(*mesh) != mesh);
+    }
+  }
+}
@@ -5,10 +5,19 @@
 #include "glm/gtx/string_cast.hpp"
 
 using ci::vec3;
+using glm::ivec3;
 using minecraft::Block;
+using minecraft::BlockBox;
+using minecraft::BlockChange;
+using minecraft::BlockEdit;
+using minecraft::BlockSphere;
 using minecraft::BlockTypes;
+using minecraft::Chunk;
+using minecraft::ChunkCoordinates;
+using minecraft::MetricsRegistry;
 using minecraft::TerrainGenerator;
 using minecraft::World;
+using minecraft::WorldMetrics;
 using std::to_string;
 using std::unordered_map;
 using std::vector;
@@ -37,16 +46,29 @@ class TestingTerrainGenerator : public TerrainGenerator {
 class TestableWorld : public World {
  public:
   TestableWorld(TerrainGenerator* terrainGenerator, const vec3& originPosition,
-                size_t chunkRadius)
-      : World(terrainGenerator, originPosition, chunkRadius) {
+                size_t chunkRadius, SpawnMode spawnMode = SpawnMode::kFull)
+      : World(terrainGenerator, originPosition, chunkRadius, spawnMode) {
   }
 
   vector<Block> GetBlocks() {
-    return blocks_;
+    vector<Block> blocks;
+    for (const auto& slot : chunks_.GetSlots()) {
+      blocks.insert(blocks.end(), slot.chunk.GetBlocks().begin(),
+                    slot.chunk.GetBlocks().end());
+    }
+    return blocks;
   }
 
   unordered_map<ci::vec3, BlockTypes, BlockHasher> GetPlayerMapEdits() {
-    return player_map_edits_;
+    unordered_map<ci::vec3, BlockTypes, BlockHasher> edits;
+    for (const auto& chunk_edits : player_map_edits_) {
+      Chunk chunk(GetChunkMinCorner(chunk_edits.first),
+                  2 * int(GetChunkRadius()));
+      for (const auto& edit : chunk_edits.second) {
+        edits[vec3(chunk.GetPosition(edit.first))] = edit.second;
+      }
+    }
+    return edits;
   }
 };
 
@@ -245,7 +267,264 @@ TEST_CASE("World edits is preserve through chunk movement") {
   }
 }
 
+TEST_CASE("Region queries") {
+  TestableWorld world(&testing_terrain_generator, vec3(0, 0, 0), 2);
+
+  SECTION("Boxes visit every block, loaded or not") {
+    size_t visited = 0;
+    size_t grass = 0;
+    // spans loaded chunks and the unloaded chunks at x >= 6
+    world.ForEachBlockIn(BlockBox{ivec3(0, -1, 0), ivec3(9, 0, 1)},
+                         [&visited, &grass](const ivec3&, BlockTypes type) {
+                           ++visited;
+                           grass += type == BlockTypes::kGrass ? 1 : 0;
+                         });
+    REQUIRE(visited == 10 * 2 * 2);
+    REQUIRE(grass == 10 * 2);
+  }
+
+  SECTION("Spheres visit only blocks within their radius") {
+    size_t visited = 0;
+    world.ForEachBlockIn(BlockSphere{ivec3(0, 0, 0), 1.0f},
+                         [&visited](const ivec3& position, BlockTypes) {
+                           REQUIRE(glm::dot(position, position) <= 1);
+                           ++visited;
+                         });
+    REQUIRE(visited == 7);
+  }
+}
+
+TEST_CASE("Column tops") {
+  TestableWorld world(&testing_terrain_generator, vec3(0, 0, 0), 2);
+
+  SECTION("Tops of generated columns") {
+    REQUIRE(world.GetColumnTop(0, 0) == 0);
+    REQUIRE(world.GetColumnTop(-5, 5) == 0);
+    REQUIRE(world.GetColumnTop(100, 0) == World::kNoColumnTop);
+  }
+
+  SECTION("Edits raise and lower the top") {
+    world.SetBlockAt(vec3(1, 3, 1), BlockTypes::kStone);
+    REQUIRE(world.GetColumnTop(1, 1) == 3);
+    world.SetBlockAt(vec3(1, 3, 1), BlockTypes::kNone);
+    REQUIRE(world.GetColumnTop(1, 1) == 0);
+    world.SetBlockAt(vec3(1, 0, 1), BlockTypes::kNone);
+    REQUIRE(world.GetColumnTop(1, 1) == -1);
+    world.SetBlockAt(vec3(1, -1, 1), BlockTypes::kNone);
+    REQUIRE(world.GetColumnTop(1, 1) == World::kNoColumnTop);
+  }
+
+  SECTION("Tops match a scan of the column") {
+    world.SetBlockAt(vec3(-2, 4, 3), BlockTypes::kStone);
+    world.SetBlockAt(vec3(-2, -4, 3), BlockTypes::kStone);
+    world.SetBlockAt(vec3(-2, 4, 3), BlockTypes::kNone);
+    world.SetBlockAt(vec3(-2, 0, 3), BlockTypes::kNone);
+    world.SetBlockAt(vec3(-2, -1, 3), BlockTypes::kNone);
+    for (int x = -6; x < 6; ++x) {
+      for (int z = -6; z < 6; ++z) {
+        int top = World::kNoColumnTop;
+        for (int y = 5; y >= -6 && top == World::kNoColumnTop; --y) {
+          if (world.GetBlockAt(vec3(x, y, z)) != BlockTypes::kNone) {
+            top = y;
+          }
+        }
+        REQUIRE(world.GetColumnTop(x, z) == top);
+      }
+    }
+    REQUIRE(world.GetColumnTop(-2, 3) == -4);
+  }
+}
+
+TEST_CASE("Region edits") {
+  TestableWorld world(&testing_terrain_generator, vec3(0, 0, 0), 2);
+
+  SECTION("Filling a box only reports blocks that changed") {
+    vector<BlockChange> changes =
+        world.FillBox(BlockBox{ivec3(-3, -1, -3), ivec3(2, 0, 2)},
+                      BlockTypes::kStone);
+    REQUIRE(changes.size() == 6 * 6 * 2);
+    REQUIRE(world.GetBlockAt(vec3(-3, -1, 2)) == BlockTypes::kStone);
+    REQUIRE(world.FillBox(BlockBox{ivec3(-3, -1, -3), ivec3(2, 0, 2)},
+                          BlockTypes::kStone)
+                .empty());
+    REQUIRE(world.GetBlocks().size() == 12 * 12 * 2);
+  }
+
+  SECTION("Replacing in a box leaves other types alone") {
+    vector<BlockChange> changes =
+        world.ReplaceInBox(BlockBox{ivec3(-6, -6, -6), ivec3(5, 5, 5)},
+                           BlockTypes::kDirt, BlockTypes::kNone);
+    REQUIRE(changes.size() == 12 * 12);
+    REQUIRE(world.GetBlocks().size() == 12 * 12);
+    REQUIRE(world.GetBlockAt(vec3(0, 0, 0)) == BlockTypes::kGrass);
+  }
+
+  SECTION("Edits to unloaded chunks appear once they load") {
+    world.ApplyEdits({BlockEdit{ivec3(7, 3, 0), BlockTypes::kDirt}});
+    REQUIRE(world.GetBlockAt(vec3(7, 3, 0)) == BlockTypes::kNone);
+    world.MoveToChunk({0, 0, 0}, {1, 0, 0});
+    REQUIRE(world.GetBlockAt(vec3(7, 3, 0)) == BlockTypes::kDirt);
+  }
+
+  SECTION("Transactions collapse repeated edits") {
+    vector<BlockChange> changes =
+        world.ApplyEdits({BlockEdit{ivec3(1, 1, 1), BlockTypes::kStone},
+                          BlockEdit{ivec3(-5, 0, 4), BlockTypes::kNone},
+                          BlockEdit{ivec3(1, 1, 1), BlockTypes::kDirt},
+                          BlockEdit{ivec3(2, 2, 2), BlockTypes::kDirt},
+                          BlockEdit{ivec3(2, 2, 2), BlockTypes::kNone}});
+    REQUIRE(changes.size() == 2);
+    REQUIRE(world.GetBlockAt(vec3(1, 1, 1)) == BlockTypes::kDirt);
+    REQUIRE(world.GetBlockAt(vec3(-5, 0, 4)) == BlockTypes::kNone);
+    REQUIRE(world.GetBlockAt(vec3(2, 2, 2)) == BlockTypes::kNone);
+  }
+
+  SECTION("Invalid transactions change nothing") {
+    REQUIRE_THROWS_AS(
+        world.ApplyEdits({BlockEdit{ivec3(1, 1, 1), BlockTypes::kStone},
+                          BlockEdit{ivec3(1, 2, 1), BlockTypes(200)}}),
+        std::invalid_argument);
+    REQUIRE(world.GetBlockAt(vec3(1, 1, 1)) == BlockTypes::kNone);
+    REQUIRE(world.GetPlayerMapEdits().empty());
+  }
+}
+
+TEST_CASE("Block ticks") {
+  TestableWorld world(&testing_terrain_generator, vec3(0, 0, 0), 2);
+
+  SECTION("Only chunks with ticking blocks are active") {
+    REQUIRE(world.Tick().empty());
+    REQUIRE(world.GetTickStats().tick == 1);
+    REQUIRE(world.GetTickStats().active_chunks == 9);
+    REQUIRE(world.GetTickStats().pending_updates == 0);
+
+    world.ReplaceInBox(BlockBox{ivec3(-6, -6, -6), ivec3(5, 5, 5)},
+                       BlockTypes::kGrass, BlockTypes::kStone);
+    REQUIRE(world.Tick().empty());
+    REQUIRE(world.GetTickStats().active_chunks == 0);
+    REQUIRE(world.GetTickStats().random_ticks == 0);
+  }
+
+  SECTION("Neighbor changes schedule updates") {
+    world.SetBlockAt(vec3(0, 1, 0), BlockTypes::kStone);
+    REQUIRE(world.GetTickStats().pending_updates == 0);
+    REQUIRE(world.Tick().empty());
+    REQUIRE(world.GetTickStats().pending_updates == 1);
+
+    // a random tick may get to the covered grass first
+    for (uint32_t tick = 1; tick < World::kGrassDecayDelay; ++tick) {
+      world.Tick();
+    }
+    REQUIRE(world.GetBlockAt(vec3(0, 0, 0)) == BlockTypes::kDirt);
+    REQUIRE(world.GetTickStats().pending_updates == 0);
+  }
+
+  SECTION("Random ticks spread grass") {
+    world.SetBlockAt(vec3(1, 0, 0), BlockTypes::kDirt);
+    size_t ticks = 0;
+    while (world.GetBlockAt(vec3(1, 0, 0)) == BlockTypes::kDirt &&
+           ticks < 100000) {
+      world.Tick();
+      ++ticks;
+    }
+    REQUIRE(world.GetBlockAt(vec3(1, 0, 0)) == BlockTypes::kGrass);
+  }
+}
+
+TEST_CASE("Progressive spawn") {
+  // the origin is on a chunk corner, so the blocks within reach of it span
+  // two chunks on each axis
+  TestableWorld world(&testing_terrain_generator, vec3(0, 0, 0), 2,
+                      World::SpawnMode::kProgressive);
+  TestableWorld full(&testing_terrain_generator, vec3(0, 0, 0), 2);
+  REQUIRE(world.GetPendingChunks().size() == 27 - 2 * 2 * 2);
+  REQUIRE(full.GetPendingChunks().empty());
+
+  SECTION("The blocks around the player are there at once") {
+    for (int x = -World::kCollisionReach; x <= World::kCollisionReach; ++x) {
+      for (int z = -World::kCollisionReach; z <= World::kCollisionReach;
+           ++z) {
+        REQUIRE(world.GetBlockAt(vec3(x, 0, z)) ==
+                full.GetBlockAt(vec3(x, 0, z)));
+      }
+    }
+    REQUIRE(world.GetBlockAt(vec3(-3, 0, 0)) == BlockTypes::kNone);
+  }
+
+  SECTION("Pending chunks are ordered nearest first") {
+    vector<ChunkCoordinates> pending = world.GetPendingChunks();
+    for (size_t i = 1; i < pending.size(); ++i) {
+      const ChunkCoordinates& previous = pending[i - 1];
+      const ChunkCoordinates& next = pending[i];
+      REQUIRE(previous.x * previous.x + previous.y * previous.y +
+                  previous.z * previous.z <=
+              next.x * next.x + next.y * next.y + next.z * next.z);
+    }
+  }
+
+  SECTION("Streaming fills in the rest of the window") {
+    REQUIRE(world.StreamChunks(5) == 5);
+    REQUIRE(world.GetPendingChunks().size() == 14);
+    REQUIRE(world.StreamChunks(100) == 14);
+    REQUIRE(world.StreamChunks(100) == 0);
+    REQUIRE(world.GetBlocks().size() == full.GetBlocks().size());
+    REQUIRE(world.GetBlockAt(vec3(-3, 0, 0)) == BlockTypes::kGrass);
+  }
+
+  SECTION("Edits of pending chunks are kept") {
+    world.SetBlockAt(vec3(-3, 1, 0), BlockTypes::kStone);
+    world.StreamChunks(100);
+    REQUIRE(world.GetBlockAt(vec3(-3, 1, 0)) == BlockTypes::kStone);
+  }
+
+  SECTION("Moving loads the new chunks, and the rest stay pending") {
+    world.MoveToChunk({0, 0, 0}, {1, 0, 0});
+    REQUIRE(world.GetBlockAt(vec3(7, 1, 0)) == BlockTypes::kGrass);
+    REQUIRE(world.GetPendingChunks().size() == 2 * 3 * 3 - 2 * 2 * 2);
+  }
+}
+
+TEST_CASE("World metrics") {
+  TestableWorld world(&testing_terrain_generator, vec3(0, 0, 0), 2);
+  REQUIRE(world.GetMetrics() == nullptr);
+  MetricsRegistry registry;
+  world.SetMetrics(&registry);
+  const WorldMetrics* metrics = world.GetMetrics();
+  REQUIRE(metrics != nullptr);
+
+  SECTION("Gauges describe the loaded chunks") {
+    REQUIRE(metrics->loaded_chunks->GetValue() == 27);
+    REQUIRE(metrics->blocks->GetValue() == world.GetBlocks().size());
+    REQUIRE(metrics->voxel_bytes->GetValue() ==
+            27 * 4 * 4 * 4 * sizeof(BlockTypes));
+    REQUIRE(metrics->edit_bytes->GetValue() == 0);
+  }
+
+  SECTION("Chunk movement is timed") {
+    world.MoveToChunk({0, 0, 0}, {1, 0, 0});
+    REQUIRE(metrics->move_to_chunk_seconds->GetSnapshot().count == 1);
+    // one new slab of 3 by 3 chunks
+    REQUIRE(metrics->load_generation_seconds->GetSnapshot().count == 9);
+    REQUIRE(metrics->prefetch_generation_seconds->GetSnapshot().count == 0);
+  }
+
+  SECTION("Edits are counted and the gauges follow ticks") {
+    world.ApplyEdits({BlockEdit{ivec3(0, 1, 0), BlockTypes::kStone},
+                      BlockEdit{ivec3(1, 1, 0), BlockTypes::kStone},
+                      BlockEdit{ivec3(0, 0, 0), BlockTypes::kGrass}});
+    REQUIRE(metrics->edits->GetValue() == 2);
+    REQUIRE(metrics->blocks->GetValue() != world.GetBlocks().size());
+    world.Tick();
+    REQUIRE(metrics->blocks->GetValue() == world.GetBlocks().size());
+    REQUIRE(metrics->edit_bytes->GetValue() > 0);
+  }
+
+  SECTION("The metrics are registered once") {
+    REQUIRE_THROWS_AS(world.SetMetrics(&registry), std::invalid_argument);
+  }
+}
+
 // note: if `CreateBlockInDirectionOf` and `DeleteBlockInDirectionOf` pass, the
 // underlying implementation of the more difficult-to-test
 // `OutlineBlockInDirectionOf` is assumed to work. this should be manually
-// tested in gameplay.
\ No newline at end of file
+// tested in gameplay.
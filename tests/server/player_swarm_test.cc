@@ -0,0 +1,138 @@
+#include "server/player_swarm.h"
+
+#include <unistd.h>
+
+#include <catch2/catch.hpp>
+
+#include "server/world_server.h"
+
+using ci::vec3;
+using minecraft::PlayerSwarm;
+using minecraft::SwarmMovement;
+using minecraft::SwarmStats;
+using minecraft::WorldServer;
+using std::string;
+
+string MakeSwarmSocketPath() {
+  return "/tmp/minecraft-swarm-test-" + std::to_string(getpid()) + ".sock";
+}
+
+PlayerSwarm::Settings MakeSwarmSettings() {
+  PlayerSwarm::Settings settings;
+  settings.socket_path = MakeSwarmSocketPath();
+  settings.movement = SwarmMovement::kScripted;
+  settings.waypoints = {vec3(0, 0, 0), vec3(8, 0, 0)};
+  settings.view_radius = 1;
+  settings.speed = 4.0f;
+  settings.height = 1.0f;
+  settings.spawn_spread = 0.0f;
+  settings.edits_per_second = 0.0;
+  settings.reach = 3;
+  settings.edit_timeout_seconds = 10.0;
+  settings.seed = 3;
+  return settings;
+}
+
+TEST_CASE("Player swarm") {
+  WorldServer::Settings server_settings;
+  server_settings.seed = 7;
+  server_settings.chunk_radius = 2;
+  server_settings.min_terrain_height = -3;
+  server_settings.max_terrain_height = 2;
+  server_settings.terrain_variance = 10.0f;
+  server_settings.max_view_radius = 1;
+  server_settings.chunks_per_tick = 27;  // the whole view in one tick
+  WorldServer server(server_settings);
+  server.ListenUnix(MakeSwarmSocketPath());
+  PlayerSwarm::Settings settings = MakeSwarmSettings();
+
+  SECTION("Players are streamed their view") {
+    PlayerSwarm swarm(settings);
+    swarm.AddPlayers(3);
+    REQUIRE(swarm.Step(0));
+    server.Tick();
+    REQUIRE(swarm.Step(0));
+
+    REQUIRE(server.GetClientStats().size() == 3);
+    SwarmStats stats = swarm.GetStats();
+    REQUIRE(stats.players == 3);
+    REQUIRE(stats.chunks_received == 3 * 27);
+    REQUIRE(stats.chunks_held == 3 * 27);
+    for (size_t player = 0; player < 3; ++player) {
+      REQUIRE(swarm.GetClient(player).IsWelcomed());
+    }
+
+    swarm.ResetStats();
+    REQUIRE(swarm.GetStats().chunks_received == 0);
+    REQUIRE(swarm.GetStats().chunks_held == 3 * 27);
+  }
+
+  SECTION("Scripted players walk their loop") {
+    PlayerSwarm swarm(settings);
+    swarm.AddPlayers(1);
+    REQUIRE(swarm.Step(1.0f));
+    REQUIRE(swarm.GetPosition(0) == vec3(4, 1, 0));
+    REQUIRE(swarm.Step(1.0f));
+    REQUIRE(swarm.GetPosition(0) == vec3(8, 1, 0));
+    // turns around at the last waypoint
+    REQUIRE(swarm.Step(1.5f));
+    REQUIRE(swarm.GetPosition(0) == vec3(2, 1, 0));
+  }
+
+  SECTION("Random walkers keep their speed and height") {
+    settings.movement = SwarmMovement::kRandomWalk;
+    PlayerSwarm swarm(settings);
+    swarm.AddPlayers(2);
+    REQUIRE(swarm.Step(0.5f));
+    for (size_t player = 0; player < 2; ++player) {
+      REQUIRE(swarm.GetPosition(player).y == 1.0f);
+      REQUIRE(glm::length(swarm.GetPosition(player) - vec3(0, 1, 0)) ==
+              Approx(2.0f));
+    }
+  }
+
+  SECTION("Edits come back in the server's change batch") {
+    settings.edits_per_second = 1e6;  // one edit every step
+    PlayerSwarm swarm(settings);
+    swarm.AddPlayers(1);
+    REQUIRE(swarm.Step(0));
+    server.Tick();
+    REQUIRE(swarm.Step(0));
+    for (int round = 0; round < 20; ++round) {
+      REQUIRE(swarm.Step(0.05f));
+      server.Tick();
+      REQUIRE(swarm.Step(0));
+    }
+
+    SwarmStats stats = swarm.GetStats();
+    REQUIRE(stats.edits_sent > 0);
+    REQUIRE(stats.edits_confirmed == stats.edits_sent);
+    REQUIRE(stats.edits_dropped == 0);
+    REQUIRE(stats.p50_edit_seconds > 0);
+    REQUIRE(stats.p50_edit_seconds <= stats.p99_edit_seconds);
+    REQUIRE(stats.p99_edit_seconds <= stats.max_edit_seconds);
+  }
+
+  SECTION("Edits that do not come back in time are dropped") {
+    settings.edits_per_second = 1e6;
+    settings.edit_timeout_seconds = 0.0;
+    PlayerSwarm swarm(settings);
+    swarm.AddPlayers(1);
+    REQUIRE(swarm.Step(0));
+    server.Tick();
+    REQUIRE(swarm.Step(0));
+    for (int round = 0; round < 20; ++round) {
+      REQUIRE(swarm.Step(0.05f));
+    }
+
+    SwarmStats stats = swarm.GetStats();
+    REQUIRE(stats.edits_sent > 0);
+    REQUIRE(stats.edits_confirmed == 0);
+    REQUIRE(stats.edits_dropped == stats.edits_sent);
+  }
+
+  SECTION("Negative reach is rejected") {
+    settings.reach = -1;
+    REQUIRE_THROWS_AS(PlayerSwarm(settings), std::invalid_argument);
+  }
+}
@@ -0,0 +1,200 @@
+#include "server/world_server.h"
+
+#include <unistd.h>
+
+#include <catch2/catch.hpp>
+#include <cstdlib>
+
+#include "server/protocol.h"
+#include "server/world_client.h"
+
+using ci::vec3;
+using minecraft::BlockTypes;
+using minecraft::WorldClient;
+using minecraft::WorldServer;
+using minecraft::BlockEdit;
+using minecraft::protocol::ChunkDelta;
+using minecraft::protocol::ChunkKey;
+using minecraft::protocol::Message;
+using std::string;
+using std::vector;
+
+WorldServer::Settings MakeServerSettings() {
+  WorldServer::Settings settings;
+  settings.seed = 7;
+  settings.chunk_radius = 2;
+  settings.min_terrain_height = -3;
+  settings.max_terrain_height = 2;
+  settings.terrain_variance = 10.0f;
+  settings.max_view_radius = 1;
+  settings.chunks_per_tick = 27;  // the whole view in one tick
+  return settings;
+}
+
+string MakeSocketPath() {
+  return "/tmp/minecraft-test-" + std::to_string(getpid()) + ".sock";
+}
+
+/// lets requests reach the server and the replies come back
+void RoundTrip(WorldServer* server, vector<WorldClient*> clients) {
+  for (WorldClient* client : clients) {
+    REQUIRE(client->Poll());
+  }
+  server->Tick();
+  for (WorldClient* client : clients) {
+    REQUIRE(client->Poll());
+  }
+}
+
+TEST_CASE("Protocol encoding") {
+  SECTION("Chunks survive run-length encoding") {
+    vector<BlockTypes> blocks(64, BlockTypes::kNone);
+    blocks[0] = BlockTypes::kStone;
+    blocks[10] = BlockTypes::kDirt;
+    blocks[11] = BlockTypes::kDirt;
+    blocks[63] = BlockTypes::kGrass;
+    ChunkKey key = {-3, 0, 12};
+    vector<uint8_t> payload = minecraft::protocol::EncodeChunk(key, blocks);
+    // 12 bytes of coordinates and 5 runs of 2 bytes each
+    REQUIRE(payload.size() == 12 + 5 * 2);
+
+    ChunkKey decoded_key;
+    vector<BlockTypes> decoded_blocks;
+    minecraft::protocol::DecodeChunk(payload, 64, &decoded_key,
+                                     &decoded_blocks);
+    REQUIRE(decoded_key == key);
+    REQUIRE(decoded_blocks == blocks);
+  }
+
+  SECTION("Chunks of the wrong volume are rejected") {
+    vector<BlockTypes> blocks(8, BlockTypes::kDirt);
+    ChunkKey key = {0, 0, 0};
+    vector<uint8_t> payload = minecraft::protocol::EncodeChunk(key, blocks);
+    vector<BlockTypes> decoded_blocks;
+    REQUIRE_THROWS(minecraft::protocol::DecodeChunk(payload, 64, &key,
+                                                    &decoded_blocks));
+  }
+
+  SECTION("Deltas round trip") {
+    ChunkDelta delta;
+    delta.chunk = {1, -1, 2};
+    delta.indices = {0, 300, 63};
+    delta.block_types = {BlockTypes::kNone, BlockTypes::kStone,
+                         BlockTypes::kGrass};
+    uint32_t tick;
+    vector<ChunkDelta> decoded;
+    minecraft::protocol::DecodeDeltas(
+        minecraft::protocol::EncodeDeltas(42, {delta}), &tick, &decoded);
+    REQUIRE(tick == 42);
+    REQUIRE(decoded.size() == 1);
+    REQUIRE(decoded[0].chunk == delta.chunk);
+    REQUIRE(decoded[0].indices == delta.indices);
+    REQUIRE(decoded[0].block_types == delta.block_types);
+  }
+
+  SECTION("Frames are only extracted once complete") {
+    vector<uint8_t> stream;
+    minecraft::protocol::AppendFrame(minecraft::protocol::kPosition,
+                                     {1, 2, 3}, &stream);
+    vector<uint8_t> partial(stream.begin(), stream.end() - 1);
+    size_t offset = 0;
+    Message message;
+    REQUIRE_FALSE(
+        minecraft::protocol::ExtractFrame(partial, &offset, &message));
+    REQUIRE(minecraft::protocol::ExtractFrame(stream, &offset, &message));
+    REQUIRE(offset == stream.size());
+    REQUIRE(message.type == minecraft::protocol::kPosition);
+    REQUIRE(message.payload == vector<uint8_t>({1, 2, 3}));
+  }
+}
+
+TEST_CASE("Loopback clients") {
+  WorldServer server(MakeServerSettings());
+  server.ListenUnix(MakeSocketPath());
+  WorldClient first;
+  WorldClient second;
+  first.ConnectUnix(MakeSocketPath());
+  second.ConnectUnix(MakeSocketPath());
+  first.SendHello(1);
+  second.SendHello(1);
+  RoundTrip(&server, {&first, &second});
+
+  SECTION("Clients are welcomed and sent their view") {
+    REQUIRE(first.IsWelcomed());
+    REQUIRE(first.GetSeed() == 7);
+    REQUIRE(first.GetClientId() != second.GetClientId());
+    REQUIRE(first.GetChunks().size() == 27);
+    REQUIRE(first.GetChunksReceivedCount() == 27);
+    REQUIRE(first.HoldsBlockAt(-6, -6, -6));
+    REQUIRE_FALSE(first.HoldsBlockAt(6, 0, 0));
+    for (int x = -6; x < 6; ++x) {
+      for (int y = -6; y < 6; ++y) {
+        REQUIRE(first.GetBlockAt(x, y, 0) ==
+                server.GetWorld().GetBlockAt(vec3(x, y, 0)));
+      }
+    }
+  }
+
+  SECTION("Edits of a tick reach every client as one batch") {
+    BlockEdit dig = {glm::ivec3(1, -1, 1), BlockTypes::kNone};
+    BlockEdit build = {glm::ivec3(1, 5, 1), BlockTypes::kStone};
+    BlockEdit rebuild = {glm::ivec3(1, 5, 1), BlockTypes::kDirt};
+    first.SendEdit(dig);
+    first.SendEdit(build);
+    second.SendEdit(rebuild);
+    RoundTrip(&server, {&first, &second});
+
+    for (WorldClient* client : {&first, &second}) {
+      REQUIRE(client->GetDeltaBatchCount() == 1);
+      REQUIRE(client->GetBlockAt(1, -1, 1) == BlockTypes::kNone);
+      REQUIRE(client->GetBlockAt(1, 5, 1) == BlockTypes::kDirt);
+    }
+    REQUIRE(server.GetWorld().GetBlockAt(vec3(1, 5, 1)) == BlockTypes::kDirt);
+  }
+
+  SECTION("Moving streams new chunks and unloads old ones") {
+    first.SendPosition(vec3(12, 0, 0));  // three chunks in +x
+    RoundTrip(&server, {&first, &second});
+    // the new view, plus the slab one chunk behind it which is kept in case
+    // the player turns around
+    REQUIRE(first.GetChunks().size() == 27 + 9);
+    REQUIRE(first.GetChunks().count({0, 0, 0}) == 0);
+    REQUIRE(first.GetChunks().count({1, 0, 0}) == 1);
+    REQUIRE(first.GetChunks().count({4, 0, 0}) == 1);
+  }
+
+  SECTION("Traffic is accounted per client") {
+    vector<minecraft::ClientStats> stats = server.GetClientStats();
+    REQUIRE(stats.size() == 2);
+    REQUIRE(stats[0].chunks_sent == 27);
+    REQUIRE(stats[0].bytes_sent == first.GetBytesReceived());
+    REQUIRE(stats[0].bytes_received == first.GetBytesSent());
+    REQUIRE(stats[0].chunks_held == 27);
+    REQUIRE(stats[0].memory_bytes > 27 * sizeof(ChunkKey));
+  }
+}
+
+TEST_CASE("Saved worlds") {
+  char directory[] = "/tmp/minecraft-save-XXXXXX";
+  REQUIRE(mkdtemp(directory) != nullptr);
+  WorldServer::Settings settings = MakeServerSettings();
+  settings.save_directory = directory;
+
+  {
+    WorldServer server(settings);
+    REQUIRE(server.GetJournal()->GetRecoveredEdits().empty());
+    server.GetWorld().ApplyEdits(
+        {BlockEdit{glm::ivec3(1, 5, 1), BlockTypes::kStone},
+         BlockEdit{glm::ivec3(40, 5, 0), BlockTypes::kDirt}});
+    server.Tick();
+    REQUIRE(server.GetJournal()->GetStats().edits_appended == 2);
+  }
+
+  WorldServer server(settings);
+  REQUIRE(server.GetJournal()->GetRecoveredEdits().size() == 2);
+  REQUIRE(server.GetWorld().GetBlockAt(vec3(1, 5, 1)) == BlockTypes::kStone);
+  // an unloaded chunk: (40, 5, 0) is voxel (2, 3, 2) of chunk (10, 1, 0)
+  REQUIRE(server.GetWorld().GetChunkBlocks({10, 1, 0})[(2 * 4 + 3) * 4 + 2] ==
+          BlockTypes::kDirt);
+  std::system(("rm -rf " + string(directory)).c_str());
+}